@@ -2,17 +2,225 @@
 // FILENAME: RealEstateTracker.CPP
 // DESCRIPTION: This program will maintain records of real estate listings 
 // DESIGNER: Robert Stokan
-// FUNCTIONS: readFile - Reads input file into dynamically allocated linked list 
-// displayAll - Displays all listings currently in linked list  
-// AddListing - Allows user to manually add new listing(s) to list  
+// FUNCTIONS: readFile - Reads input file into the column-oriented listing store 
+// displayAll - Displays all listings currently in the store  
+// displayListingHeader - Displays the column headings of a table of listings 
+// displayListingRows - Displays listings as rows of a table, a block at a time 
+// formatListingRow - Formats one listing as a row of a table of listings 
+// padColumn - Pads a column of a table row with spaces 
+// selectListings - Finds the listings of a page in the order to show them 
+// parsePageText - Reads the listings to display written as name=value terms 
+// parseSortKey - Converts the name of the order to display listings in 
+// displayMlsNumbers - Displays the MLS numbers of all listings 
+// AddListing - Allows user to manually add new listing(s) to the store  
 // ValidateMLS - Validates format of MLS number entered by user
 // ValidatePrice - Validates price entered by user 
 // ValidateZip - Validates format of zip code entered by user 
 // ValidateStatus - Validates status entered by user 
 // ValidateCompanyName - Validates format of company name entered by user
-// DeleteRecord - Allows user to remove listing(s) from the list  
+// DeleteRecord - Allows user to remove listing(s) from the store  
+// BulkDeleteListings - Allows user to remove the listings of many MLS numbers at once 
+// QueryListings - Allows user to display the listings matching a query 
+// runQuery - Finds the listings matching a query using the secondary indexes 
+// queryMatches - Checks a listing against every condition of a query 
+// queryCompanyIds - Finds the ids of the company names matching a name 
+// sameCompanyName - Compares two realty company names, ignoring case 
+// parseQueryText - Reads a query written as name=value conditions 
+// parseStatusCode - Converts a status letter to a status for a query 
+// parseZipPattern - Converts a zip code or zip code prefix for a query 
+// parsePriceRange - Converts a price range for a query 
+// parseListingOrder - Converts the number and order of listings a query shows 
+// MarketStatistics - Allows user to display price statistics by group 
+// computeMarketStats - Computes price statistics of groups of listings 
+// groupListingKeys - Finds the group of every row of the store 
+// displayMarketStats - Displays price statistics of groups of listings 
+// compareGroupNames - Orders groups of listings by name 
+// parseGroupBy - Converts the name of a grouping of listings 
 // SaveToFile - Allows user to save changes to the file before exiting program  
 // ChangeAskingPrices - Allows user to apply price changes from file 
+// readChangesFile - Reads all records of a changes file 
+// applyPriceChanges - Joins a batch of price changes against the listings 
+// compareChangeMLS - Orders change records by MLS number 
+// displayChangeSummary - Displays the results of applying a changes file 
+// writeListingsFile - Writes all listings to a listings file 
+// syncFile - Writes a file's buffered output and waits for it to reach the disk 
+// replaceFile - Renames a completed temporary file over the file it replaces 
+// formatListingLine - Formats one line of a listings file 
+// dollarsToCents - Converts an amount in dollars to cents 
+// formatPrice - Formats an amount in cents as dollars 
+// streamPriceChanges - Applies a changes file to a listings file in bounded memory 
+// sortChangesExternal - Sorts and sums a changes file within a memory budget 
+// sumSortedChanges - Sums the reductions of each MLS number in sorted changes 
+// writeChangeRun - Writes a sorted run of changes to a spill file 
+// mergeChangeRuns - Merges sorted runs of changes into one 
+// compareMergeHead - Orders the runs being merged by their next MLS number 
+// streamListingsPass - Copies a listings file, repricing a batch of changes 
+// tempFileBase - Returns the start of the names of a job's temporary files 
+// fileSize - Returns the size of a file 
+// loadListingsFile - Loads a listings file, from its snapshot when current 
+// loadListingsMapped - Loads a listings file through a memory mapping 
+// appendListingsMapped - Adds the listings of a file through a memory mapping 
+// appendListingsParallel - Adds the listings of a mapped file using several threads 
+// parseListingsWorker - Parses chunks of a listings file on a worker thread 
+// parseListingsChunk - Parses one chunk of a listings file 
+// mergeListingsChunk - Adds the listings parsed from a chunk to the store 
+// loadThreadCount - Returns the number of threads to parse a file with 
+// parseListingLine - Parses one line of a listings file in place 
+// reportLoadError - Reports a line of a listings file that was skipped 
+// ImportListings - Allows user to import a file of new listings 
+// importListingsFile - Validates and adds the new listings of a file 
+// validateImportBatch - Checks the lines of an import file against the listing rules 
+// checkCompanyName - Checks a realty company name against the listing rules 
+// titleCaseCompany - Capitalizes the first letter of each word of a company name 
+// writeRejectsFile - Writes the rejected lines of an import file with their reasons 
+// mapFile - Maps a whole file into memory for reading 
+// unmapFile - Releases a file mapped by mapFile 
+// writeSnapshotFile - Writes the store to a binary snapshot file 
+// writeSnapshotSection - Writes one section of a snapshot file 
+// loadSnapshotFile - Loads the store from a binary snapshot file 
+// isSnapshotFile - Checks whether a file begins with the snapshot magic 
+// snapshotIsCurrent - Checks whether a listings file has an up-to-date snapshot 
+// snapshotChecksum - Adds bytes to the checksum of a snapshot 
+// snapshotAlign - Rounds a section size up to the snapshot alignment 
+// journalOpen - Replays a listings file's journal and starts journaling changes 
+// journalReplay - Applies the records of a journal to the store 
+// journalRecord - Adds a record of a change to the journal's buffer 
+// journalAppend - Adds a record of the given fields to the journal's buffer 
+// journalCommit - Makes the changes recorded so far durable 
+// journalFlush - Writes the journal's buffer to the journal file 
+// journalReset - Empties the journal once the listings file holds every change 
+// journalClose - Commits buffered records and stops journaling 
+// fileIdentity - Returns the size of a file and the time it was last changed 
+// storeAppend - Adds a listing to the end of the store 
+// storeRemove - Marks a listing in the store as deleted 
+// storeMarkDeleted - Records the delete of a listing and marks its row deleted 
+// storeFileOrder - Puts rows of listings into the order they are saved in 
+// storeSavedRows - Lists the rows of all listings in the order they are saved in 
+// storeCompact - Drops deleted rows from the store 
+// storeClear - Empties the store and releases its memory 
+// storeReserve - Reserves room for rows within the memory budget 
+// storeFull - Checks whether the memory budget leaves room for a listing 
+// storeMemoryUsed - Returns the bytes of memory held by the store 
+// displayMemoryUsage - Displays the store's record counters and memory use 
+// runBatch - Runs the commands given on the command line without prompts 
+// readBatchScript - Reads the commands of a batch script file 
+// runBatchCommand - Runs one batch command 
+// deleteListingsFile - Deletes every listing whose MLS number is in a file 
+// deleteListings - Deletes the listings of a list of MLS numbers in one pass 
+// parseMlsList - Reads a list of whitespace-separated MLS numbers 
+// displayUsage - Displays the command-line options 
+// internCompany - Returns the id of a realty company name, adding it if new 
+// companyHash - Hashes a realty company name 
+// packZip - Packs a zip code into an integer 
+// formatZip - Formats a packed zip code as text 
+// mlsHash - Hashes an MLS number to a slot of the MLS index 
+// indexFind - Looks up the row for an MLS number in the MLS index
+// indexInsert - Adds a row to the MLS index
+// indexRemove - Removes an MLS number from the MLS index
+// indexRebuild - Rebuilds the MLS index from the rows of the store 
+// secondaryInsert - Adds a row to the zip code, status and company indexes 
+// secondaryRemove - Removes a row from the zip code, status and company indexes 
+// removeFromRowList - Removes a row from a list of rows in constant time 
+// secondaryRebuild - Rebuilds the zip code, status, company and price indexes 
+// priceIndexInsert - Adds a row's price to the price index 
+// priceIndexAdd - Adds an entry to the price index's delta buffer 
+// priceIndexRemove - Takes a row's price out of the price index 
+// priceIndexMerge - Merges the price index's delta buffer into its sorted entries 
+// priceIndexSortDelta - Sorts the price index's delta buffer 
+// priceIndexRebuild - Rebuilds the price index 
+// priceDeltaCapacity - Returns the size of the price index's delta buffer 
+// priceEntryCurrent - Checks whether a price index entry is still current 
+// comparePriceEntry - Orders price index entries by price 
+// priceRangeSize - Counts the price index entries within a price range 
+// priceScan - Finds the listings matching a query in price order 
+// storeReprice - Changes the asking price of a listing 
+// storeUpdate - Changes the fields of a listing in place 
+// generateListings - Writes synthetic listings, changes, delete and import files 
+// generateListing - Makes up the fields of one synthetic listing 
+// generatedMls - Returns the MLS number of a synthetic listing 
+// generatedCompanies - Makes up the realty company names of synthetic listings 
+// writeGeneratedText - Writes the text of a synthetic file a block at a time 
+// nextRandom - Returns the next number of a seeded random sequence 
+// randomSkewed - Returns a random number favoring small values 
+// parseGeneratorText - Reads the sizes and names of synthetic files to generate 
+// runBenchmark - Times the main operations on synthetic files of several sizes 
+// reportBenchmarkStep - Writes the timing of one benchmark step as JSON 
+// peakMemoryKB - Returns the most memory the program has held at once 
+// parseBenchSizes - Reads the record counts to benchmark 
+// operationTimer::~operationTimer - Adds a finished operation to the metrics 
+// latencyBucket - Finds the latency histogram bucket of an elapsed time 
+// writeMetricsFile - Writes the operation metrics in Prometheus text or JSON 
+// formatMetricsPrometheus - Formats the metrics in the Prometheus text format 
+// formatMetricsJson - Formats the metrics as a JSON object 
+// WriteMetrics - Writes the metrics on request from the menu 
+// writeRunMetrics - Writes the metrics at the end of a batch run if asked 
+// appendImportLine - Adds one line of new listings to an import batch 
+// addListingText - Adds one listing given as a listings file line 
+// parseRepriceText - Reads MLS numbers and reductions given in a request 
+// appendListingLines - Formats listings as listings file lines 
+// runServer - Serves queries and changes to the store over a local socket 
+// openServerSocket - Creates and binds the listening socket of a server 
+// serveConnection - Answers the requests of one client connection 
+// handleServerRequest - Answers one request line of a client 
+// serverWriter - Applies queued write requests, one group at a time 
+// applyServerWrite - Applies one write request to the server's store 
+// publishSnapshot - Publishes a copy of the store for readers to query 
+// swapWriterMembers - Swaps the members of a store only the server's writer uses 
+// sendAll - Sends a whole response to a client 
+// reloadListingsFile - Applies the changes in a new version of the loaded listings file 
+// fingerprintListingsFile - Checksums the chunks of a listings file 
+// chunkListings - Splits listings file text into checksummed chunks of lines 
+// watchOpen - Starts watching a listings file for changes 
+// watchChanged - Waits for a watched file to change 
+// watchEvents - Reads the inotify events of a watched file 
+// watchClose - Stops watching a file 
+// serverWatcher - Queues a reload each time the served listings file changes 
+// ReloadListings - Reloads the listings file when another program changes it 
+// historyReserve - Makes room to record one more price change 
+// historyRecord - Records a price change in the price history 
+// appendVarint - Appends a number packed seven bits to a byte 
+// readVarint - Reads a number packed seven bits to a byte 
+// readHistoryChange - Reads one packed price change 
+// encodeHistoryBlock - Packs a block of price changes for the history file 
+// saveHistoryFile - Writes the price history beside a listings file 
+// loadHistoryFile - Reads the price history of a listings file 
+// parseHistoryText - Reads a price history query 
+// displayPriceHistory - Displays the price changes matching a history query 
+// formatHistoryTime - Formats the time of a price change 
+// PriceHistory - Displays price histories on request from the menu 
+// deltaMark - Notes that a listing changed since the last save 
+// writeDeltaFile - Appends the changes since the last export to a delta file 
+// ExportChanges - Writes the changes since the last save on request from the menu 
+// shardMark - Notes that the shard of a zip code changed since the last save 
+// isShardDirectory - Checks whether a name is a directory of listings shards 
+// isShardTarget - Checks whether listings saved under a name go to shards 
+// shardFileName - Names the shard file of a zip code prefix 
+// parseShardList - Reads the zip code prefixes of the shards to load 
+// readShardManifest - Reads the listings counts of a shard directory 
+// loadShardDirectory - Loads the chosen shards of a shard directory 
+// writeShardDirectory - Saves the listings to a shard directory 
+// writeShardsWorker - Writes shard files on a worker thread 
+// writeShardFile - Writes the listings of one shard 
+// splitListingsChunks - Splits a mapped listings file into chunks to parse 
+// parseIoBackend - Reads the name of a file I/O backend 
+// ioBackendName - Names the file I/O backend in use 
+// ioRingAcquire - Takes the io_uring ring for one file, setting it up if needed 
+// ioRingRelease - Gives back the io_uring ring 
+// ioRingOpen - Sets up an io_uring ring and registers its buffers 
+// ioRingClose - Releases a ring that could not be fully set up 
+// ioRingQueue - Queues a read or write of one ring buffer 
+// ioRingSubmit - Hands the queued reads and writes to the kernel 
+// ioRingWait - Waits for the next read or write of the ring to finish 
+// ioReaderOpen - Opens a file to be read a block at a time 
+// ioReaderQueue - Queues the read of the next block of a file 
+// ioReaderNext - Hands out the next block of a file 
+// ioReaderClose - Closes a file being read a block at a time 
+// ioWriterOpen - Creates a file to be written a block at a time 
+// ioWriterWrite - Adds bytes to a file being written 
+// ioWriterFlush - Queues the write of the buffer being filled 
+// ioWriterWait - Waits for one write of a file to finish 
+// ioWriterClose - Finishes and closes a file being written 
+// parseChangeRecords - Reads change records from part of a changes file 
 //*****************************************************************************  
 
 #include <iostream>         // for I/O
@@ -20,6 +228,48 @@
 #include <cstdlib>          // for using PAUSE statement
 #include <string>           // for using string variable 
 #include <fstream>          // for file I/O 
+#include <vector>           // for MLS index storage 
+#include <algorithm>        // for sorting change records 
+#include <cstring>          // for finding line ends in mapped files 
+#include <string_view>      // for parsing mapped files in place 
+#include <charconv>         // for parsing numbers in mapped files 
+#include <cstdint>          // for fixed-width store columns 
+#include <new>              // for detecting failed allocations 
+#include <chrono>           // for timing batch commands 
+#include <cstdio>           // for appending to journal files 
+#include <thread>           // for parsing listings files in parallel 
+#include <mutex>            // for handing chunks to parsing threads 
+#include <condition_variable>   // for waiting on parsing threads 
+#include <sstream>          // for splitting batch script arguments 
+#include <cmath>            // for rounding prices to cents 
+#include <atomic>           // for counting operations from any thread 
+#include <memory>           // for sharing store snapshots between threads 
+#include <deque>            // for queueing server write requests 
+#include <future>           // for handing write results back to clients 
+#include <ctime>            // for dating price changes 
+#include <cerrno>           // for retrying interrupted io_uring calls 
+
+#include <sys/stat.h>       // for the size and age of files 
+
+#ifndef _WIN32
+#include <sys/mman.h>       // for memory-mapping input files 
+#include <fcntl.h>          // for opening mapped files 
+#include <unistd.h>         // for closing mapped files 
+#include <sys/resource.h>   // for measuring peak memory use 
+#include <sys/socket.h>     // for serving clients over a local socket 
+#include <sys/un.h>         // for naming the server socket 
+#include <poll.h>           // for waking server threads to shut down 
+#include <csignal>          // for ignoring clients that hang up
+#ifdef __linux__
+#include <sys/inotify.h>    // for noticing changes to a loaded listings file
+#include <sys/syscall.h>    // for the io_uring system calls 
+#include <sys/uio.h>        // for registering io_uring buffers 
+#include <linux/io_uring.h> // for the layout of io_uring queues 
+#endif
+#else
+#include <io.h>             // for syncing journal files to disk 
+#include <direct.h>         // for creating shard directories 
+#endif
 
 using namespace std;
 
@@ -29,6 +279,8 @@ const char YES = 'Y'; 							// "Yes" response to user prompt
 const char NO = 'N'; 							// "No" response to user prompt 
 const string FILE_NAME = "LISTINGS.TXT"; 		// Input/Output file name
 const string FILE_CHANGES = "CHANGES.TXT"; 		// Name of changes file  
+const string FILE_IMPORT = "NEWLISTINGS.TXT"; 	// Name of file of new listings to import 
+const string FILE_METRICS = "METRICS"; 		// Name of metrics file, without its extension 
 const int ZIP_CODE_LENGTH = 10;					// Length of zip code  
 const int COMPANY_LENGTH = 20; 					// Maximum length of company name 
 const char FILE_CHAR = 'F'; 					// Character to enter another file name 
@@ -38,6 +290,162 @@ const char EXISTING_FILE = 'E'; 				// Character to overwrite existing file
 const char ANOTHER_FILE = 'A'; 					// Character to choose another file 
 const int MLS_MAX = 999999; 					// Maximum size of MLS number 
 const int MLS_MIN = 100000; 					// Minimum size of MLS number 
+const int MLS_DIGITS = 6; 						// Digits in an MLS number 
+const uint32_t MLS_COUNT = MLS_MAX - MLS_MIN + 1; 	// Distinct MLS numbers 
+const int INDEX_MIN_BITS = 10; 					// log2 of the initial MLS index capacity 
+const int COMPANY_MIN_BITS = 6; 				// log2 of the initial company name table capacity 
+const uint32_t NO_ROW = 0xFFFFFFFF; 			// Row number meaning no listing / unused slot 
+const uint8_t STATUS_DELETED = 0xFF; 			// Status column value of a deleted row 
+const int COMPACT_DIVISOR = 4; 					// Store is compacted once 1/4 of its rows are deleted 
+const int ZIP_DASH_POSITION = 5; 				// Position of the '-' in a zip code 
+const uint32_t ZIP4_COUNT = 10000; 				// Zip+4 codes within each 5-digit zip code 
+const uint32_t ZIP5_COUNT = 100000; 			// 5-digit zip codes 
+const uint32_t ZIP3_COUNT = 1000; 				// 3-digit zip code prefixes 
+const int STATUS_COUNT = 3; 					// Listing status values, each with a bitmap 
+const int QUERY_ANY_STATUS = -1; 				// Query status matching every listing 
+const int QUERY_ALL_ROWS = 0; 					// Query candidates are every row 
+const int QUERY_COMPANY = 1; 					// Query candidates are the rows of a company 
+const int QUERY_ZIP = 2; 						// Query candidates are the rows of a zip code prefix 
+const int QUERY_STATUS = 3; 					// Query candidates are the rows of a status 
+const int QUERY_PRICE = 4; 						// Query candidates are the rows of a price range 
+const int QUERY_ROW_ORDER = 0; 					// Query results are in row order 
+const int QUERY_LOWEST = 1; 					// Query results are the lowest priced first 
+const int QUERY_HIGHEST = 2; 					// Query results are the highest priced first 
+const size_t PRICE_DELTA_MIN = 1024; 			// Smallest delta buffer of the price index 
+const size_t PRICE_DELTA_DIVISOR = 8; 			// Delta buffer holds up to 1/8 of the rows 
+const size_t PRICE_STALE_DIVISOR = 2; 			// Price index is merged once half of it is stale 
+const int64_t CENTS_PER_DOLLAR = 100; 			// Prices are held in whole cents 
+const double MAX_PRICE_DOLLARS = 1e9; 			// Largest price or reduction accepted 
+const int GROUP_ALL = 0; 						// Statistics of all listings together 
+const int GROUP_ZIP = 1; 						// Statistics by 5-digit zip code 
+const int GROUP_ZIP3 = 2; 						// Statistics by 3-digit zip code prefix 
+const int GROUP_STATUS = 3; 					// Statistics by status 
+const int GROUP_COMPANY = 4; 					// Statistics by realty company 
+const int SORT_FILE_ORDER = 0; 					// Listings displayed in file order 
+const int SORT_MLS = 1; 						// Listings displayed by MLS number 
+const int SORT_PRICE = 2; 						// Listings displayed by asking price 
+const int SORT_ZIP = 3; 						// Listings displayed by zip code 
+const size_t DISPLAY_PAGE_ROWS = 50; 			// Listings shown per page when there are more 
+const size_t DISPLAY_BUFFER_BYTES = 256 * 1024; 	// Text formatted before each write to the screen 
+const size_t MEGABYTE = 1024 * 1024; 			// Bytes in a megabyte 
+const size_t DEFAULT_MEMORY_BUDGET_MB = 1024; 	// Memory budget of the store unless configured 
+const char MEMORY_BUDGET_VARIABLE[] = "REALESTATE_MEMORY_MB"; 	// Environment variable setting the budget 
+const uint32_t STORE_MIN_ROWS = 1024; 			// Rows reserved when the store first grows 
+const size_t STORE_ROW_BYTES = 14 * sizeof(uint32_t) + 2 * sizeof(int64_t) + sizeof(uint8_t); 	// Column and index bytes per row 
+const int ESTIMATED_LINE_BYTES = 40; 			// Average listings line length used to presize the store 
+const size_t CHUNK_BYTES = 16 * MEGABYTE; 		// Bytes of a listings file parsed by a thread at a time 
+const size_t PARALLEL_MIN_BYTES = 2 * CHUNK_BYTES; 	// Smallest listings file parsed in parallel 
+const int CHUNKS_AHEAD_PER_THREAD = 2; 			// Parsed chunks that may wait for the merge, per thread 
+const char THREADS_VARIABLE[] = "REALESTATE_THREADS"; 	// Environment variable setting the parsing threads 
+const int EXIT_USAGE = 1; 						// Exit code for a malformed command line or script 
+const int EXIT_FAILED = 2; 						// Exit code for a batch command that failed 
+const char SCRIPT_COMMENT = '#'; 				// Starts a comment line in a batch script 
+const string BATCH_COMMANDS = " load add reload import apply delete save snapshot stream list query stats history delta generate bench metrics serve memory-mb threads shards io "; 	// Names of the batch commands 
+const int MAX_ERRORS_SHOWN = 20; 				// Skipped lines reported individually per load 
+const size_t WRITE_BUFFER_BYTES = 4 * MEGABYTE; 	// Listings formatted before each write 
+const size_t LINE_RESERVE_BYTES = 512; 			// Room for a listings line without its company name 
+const string TEMP_EXTENSION = ".tmp"; 			// Added to a file name while the file is written 
+const string REJECTS_EXTENSION = ".rejects"; 	// Added to an import file name to name its rejected lines 
+const size_t STREAM_BLOCK_BYTES = 4 * MEGABYTE; 	// Bytes of a listings file read at a time when streaming 
+const size_t STREAM_INITIAL_RECORDS = 65536; 	// Change records reserved before a run grows 
+const size_t MAX_MERGE_RUNS = 64; 				// Spill files merged at once 
+const int STREAM_EXTRA_ARGUMENTS = 2; 			// Arguments of the stream command after the first 
+const char TEMP_DIRECTORY_VARIABLE[] = "REALESTATE_TEMP_DIR"; 	// Environment variable naming the spill directory 
+const char SNAPSHOT_MAGIC[8] = {'R', 'E', 'S', 'N', 'A', 'P', '\r', '\n'}; 	// First bytes of a snapshot file 
+const uint32_t SNAPSHOT_VERSION = 2; 			// Layout version of snapshot files written 
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304; 	// Written natively to detect a foreign byte order 
+const string SNAPSHOT_EXTENSION = ".snap"; 		// Added to a listings file name to name its snapshot 
+const size_t SNAPSHOT_ALIGNMENT = 8; 			// Every snapshot section starts on this boundary 
+const int SNAPSHOT_SECTIONS = 8; 				// Sections after the header of a snapshot file 
+const uint64_t CHECKSUM_SEED = 14695981039346656037ull; 	// Starting value of a snapshot checksum 
+const uint64_t CHECKSUM_PRIME = 1099511628211ull; 			// Multiplier of a snapshot checksum 
+const char JOURNAL_MAGIC[8] = {'R', 'E', 'J', 'O', 'U', 'R', '\r', '\n'}; 	// First bytes of a journal file 
+const uint32_t JOURNAL_VERSION = 2; 			// Layout version of journal files written 
+const uint32_t JOURNAL_MIN_VERSION = 1; 		// Oldest layout version of journal files replayed 
+const string JOURNAL_EXTENSION = ".journal"; 	// Added to a listings file name to name its journal 
+const string JOURNAL_STALE_EXTENSION = ".stale"; 	// Added to the name of a journal set aside 
+const char JOURNAL_ADD = 'A'; 					// Journal record of an added listing 
+const char JOURNAL_DELETE = 'D'; 				// Journal record of a deleted listing 
+const char JOURNAL_PRICE = 'P'; 				// Journal record of a new asking price 
+const char JOURNAL_CHANGE = 'C'; 				// Journal record of a listing changed in place 
+const size_t JOURNAL_RECORD_BYTES = 24; 		// Bytes in a journal record without a company name 
+const size_t JOURNAL_BUFFER_BYTES = MEGABYTE; 	// Buffered journal records written at once 
+const string HISTORY_EXTENSION = ".history"; 	// Added to a listings file name to name its price history 
+const char HISTORY_MAGIC[8] = {'R', 'E', 'H', 'I', 'S', 'T', '\r', '\n'}; 	// First bytes of a price history file 
+const uint32_t HISTORY_VERSION = 1; 			// Layout version of price history files written 
+const size_t HISTORY_CHANGE_MAX_BYTES = 30; 	// Most bytes one packed price change can take 
+const size_t HISTORY_MIN_BYTES = 64 * 1024; 	// Smallest buffer of packed price changes 
+const size_t HISTORY_MIN_BLOCKS = 64; 			// Smallest table of price change blocks 
+const int HISTORY_DEFAULT_DAYS = 30; 			// Days a reductions query looks back unless told otherwise 
+const int64_t SECONDS_PER_DAY = 86400; 			// Seconds in a day 
+const string DELTA_EXTENSION = ".delta"; 		// Added to a listings file name to name its delta file 
+const string DELTA_SIGNATURE = "#DELTA "; 		// Start of the first line of a delta file 
+const int DELTA_SEQUENCE_DIGITS = 20; 			// Digits of the sequence number on that line 
+const string SHARD_MANIFEST = "MANIFEST"; 		// Name of the manifest in a shard directory 
+const string SHARD_SIGNATURE = "#SHARDS 1"; 	// First line of a shard manifest 
+const string SHARD_EXTENSION = ".TXT"; 			// Added to a zip code prefix to name its shard file 
+const int SHARD_WORDS = ZIP3_COUNT / 64 + 1; 	// Words of a bitmap of zip code prefixes 
+const uint64_t GENERATOR_DEFAULT_SEED = 1; 		// Seed of synthetic files unless one is given 
+const uint32_t MLS_SCRAMBLE = 386117; 			// Spreads synthetic MLS numbers; prime to MLS_COUNT 
+const uint32_t ZIP3_SCRAMBLE = 389; 			// Spreads popular zip code prefixes; prime to ZIP3_COUNT 
+const int DUPLICATE_PERCENT = 1; 				// Synthetic listings repeating an earlier MLS number 
+const int MISSING_PERCENT = 10; 				// Synthetic changes and deletes of MLS numbers not on file 
+const int INVALID_PERCENT = 3; 					// Synthetic import lines breaking a listing rule 
+const uint64_t LISTINGS_PER_COMPANY = 200; 		// Synthetic listings per realty company 
+const uint64_t MIN_COMPANIES = 20; 				// Fewest realty companies of synthetic listings 
+const int CHANGES_DIVISOR = 10; 				// Synthetic changes are 1/10 of the listings 
+const int DELETES_DIVISOR = 20; 				// Synthetic deletes are 1/20 of the listings 
+const int IMPORTS_DIVISOR = 20; 				// Synthetic import lines are 1/20 of the listings 
+const char *const COMPANY_WORDS[] = {"Metro", "North Shore", "Hometown", "City", "Avon", "Stokan", 
+                                     "Springfield", "Waterfront", "White Oak", "South Hills", "Martin", 
+                                     "Johnson", "Jones", "Wayne", "Lakeside", "Summit", "Pioneer", 
+                                     "Heritage", "Cedar", "Maple", "Prairie", "Mountain", "River", 
+                                     "Harbor", "Golden", "Keystone", "Liberty", "Frontier", "Sunrise", 
+                                     "Valley"}; 	// First words of synthetic company names 
+const char *const COMPANY_SUFFIXES[] = {"Realty", "Brokers", "Company", "Homes", "Properties", "Group", 
+                                        "Real Estate", "Associates"}; 	// Last words of synthetic company names 
+const uint64_t BENCH_DEFAULT_SIZES[] = {1000, 10000, 100000, 1000000, 10000000}; 	// Record counts of "bench *" 
+const string BENCH_FILE_BASE = "RealEstateBench"; 	// Start of the names of benchmark files 
+const int TOP_LISTINGS = 100; 					// Listings of the highest-priced benchmark query 
+const int OPERATION_LOAD = 0; 					// Loading a listings or snapshot file 
+const int OPERATION_SAVE = 1; 					// Saving the listings file 
+const int OPERATION_READ_CHANGES = 2; 			// Parsing a changes file 
+const int OPERATION_APPLY = 3; 					// Applying parsed price changes 
+const int OPERATION_DELETE = 4; 				// Deleting listings by MLS number 
+const int OPERATION_IMPORT = 5; 				// Importing new listings 
+const int OPERATION_QUERY = 6; 					// Finding the listings matching a query 
+const int OPERATION_STATS = 7; 					// Computing market statistics 
+const int OPERATION_DISPLAY = 8; 				// Formatting listings for the screen 
+const int OPERATION_SNAPSHOT_SAVE = 9; 			// Writing a snapshot file 
+const int OPERATION_SNAPSHOT_LOAD = 10; 		// Reading a snapshot file 
+const int OPERATION_STREAM = 11; 				// Streaming changes through a listings file 
+const int OPERATION_RELOAD = 12; 				// Reloading a changed listings file 
+const int OPERATION_DELTA = 13; 				// Exporting the changes since the last save 
+const int OPERATION_COUNT = 14; 				// Kinds of operation measured 
+const char *const OPERATION_NAMES[OPERATION_COUNT] = {"load", "save", "read_changes", "apply", "delete",
+                                                      "import", "query", "stats", "display", "snapshot_save",
+                                                      "snapshot_load", "stream", "reload", "delta"}; 	// Metric labels of the operations 
+const uint64_t LATENCY_BOUNDS_US[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 
+                                      250000, 500000, 1000000, 2500000, 5000000, 10000000}; 	// Upper bounds of the latency buckets, in microseconds 
+const int LATENCY_BUCKETS = sizeof(LATENCY_BOUNDS_US) / sizeof(LATENCY_BOUNDS_US[0]) + 1; 	// Latency buckets, the last unbounded 
+const string METRICS_JSON_EXTENSION = ".json"; 	// Ending of metrics files written as JSON 
+const string METRICS_PROMETHEUS_EXTENSION = ".prom"; 	// Ending of metrics files in the Prometheus text format 
+const char METRICS_FILE_VARIABLE[] = "REALESTATE_METRICS_FILE"; 	// Environment variable naming the file a batch run leaves its metrics in 
+const string SERVER_READ_REQUESTS = " query list stats metrics history "; 	// Server requests answered from a snapshot 
+const string SERVER_WRITE_REQUESTS = " add remove reprice import apply delete save snapshot reload delta "; 	// Server requests made by the writer 
+const int SERVER_POLL_MS = 200; 				// Longest a server thread waits before checking for shutdown 
+const int SERVER_BACKLOG = 64; 					// Connections waiting to be accepted 
+const size_t SERVER_LINE_LIMIT = MEGABYTE; 		// Longest request line a client may send 
+const size_t SERVER_RECEIVE_BYTES = 64 * 1024; 	// Bytes received from a client at once 
+const uint64_t RELOAD_CHUNK_MASK = 63; 			// A chunk of a listings file ends after a line whose checksum has these bits clear 
+const int RELOAD_CHUNK_MAX_LINES = 1024; 		// Most lines in a chunk of a listings file 
+const int WATCH_SETTLE_MS = 100; 				// Quiet time after a watched file changes before it is read 
+const size_t WATCH_EVENT_BYTES = 4096; 			// Bytes of inotify events read at once 
+const int IO_BLOCKING = 0; 						// Files read and written with blocking calls 
+const int IO_URING = 1; 						// Files read and written through io_uring where the system has it 
+const char IO_BACKEND_VARIABLE[] = "REALESTATE_IO"; 	// Environment variable choosing how files are read and written 
+const size_t IO_BLOCK_BYTES = MEGABYTE; 		// Bytes of each read or write queued on the io_uring ring 
+const int IO_BLOCKS = 8; 						// Reads or writes in flight at once, each with its own buffer 
 
 
 // enumerated data type
@@ -45,55 +453,799 @@ enum statusOptions {AVAILABLE, CONTRACT, SOLD};    // Enumerated data type for l
 
 
 // struct 
-struct listingsInfo			    // Struct to store listing data in linked list  
+struct listingsInfo			    // Struct to hold the fields of one listing  
 {
 	int numberMLS;				// MLS number
 	double price;				// Listing price 
 	statusOptions status; 		// Listing status 
 	string zipCode;				// Zip Code 
 	string realtyCompany; 		// Realty company for listing 
-	listingsInfo *link; 		// Link to next node in linked list 
 	
 }; 
 
+struct listingJournal			// Append-only log of the changes made to a listings 
+{								// file since it was last saved 
+	FILE *output; 				// Open journal file, or NULL while changes are not journaled 
+	string fileName; 			// Name of the journal file 
+	string baseName; 			// Listings file the journal applies to 
+	uint64_t baseSize; 			// Size of the listings file when the journal was started 
+	int64_t baseModified; 		// Time the listings file was last changed then 
+	vector<char> pending; 		// Records not yet written to the file 
+	bool unsynced; 				// Whether written records may not be on disk yet 
+	vector<uint64_t> changed; 	// Bit set for each MLS number with a record in the journal 
+	
+	listingJournal() : output(NULL), baseSize(0), baseModified(0), unsynced(false) {}
+}; 
+
+struct fileFingerprint			// Checksums of the chunks of lines of the listings file 
+{								// loaded, to find the lines a new version of it changes 
+	string fileName; 			// Listings file fingerprinted, or empty if none 
+	uint64_t size; 				// Size of the file when it was fingerprinted 
+	int64_t modified; 			// Time the file was last changed then 
+	vector<uint64_t> chunkHashes; 	// Checksum of each chunk, in file order 
+	vector<uint32_t> chunkStart; 	// Place in chunkMls of each chunk's MLS numbers, then the 
+									// end; empty if the chunks are not known 
+	vector<uint32_t> chunkMls; 		// MLS numbers at the start of the lines of each chunk 
+
+	fileFingerprint() : size(0), modified(0) {}
+}; 
+
+struct fileWatch				// Listings file watched for changes 
+{
+	string fileName; 			// File watched 
+	string baseName; 			// Name of the file within its directory 
+	int descriptor; 			// inotify instance watching the directory, or -1 to poll the file 
+	uint64_t size; 				// Size of the file when last checked 
+	int64_t modified; 			// Time the file was last changed when last checked 
+
+	fileWatch() : descriptor(-1), size(0), modified(0) {}
+}; 
+
+struct historyBlock				// Price changes made together, from one source within 
+{								// one second 
+	int64_t time; 				// When the changes were made, in seconds since 1970 
+	uint32_t source; 			// Place in sources of the name of their source 
+	uint32_t changes; 			// Price changes in the block 
+	size_t offset; 				// Offset of the block's first change in encoded 
+}; 
+
+struct priceHistory				// Every change of asking price, oldest first, kept apart 
+{								// from the listing columns 
+	vector<uint8_t> encoded; 		// Changes of every block, each packed as described in 
+									// historyRecord 
+	vector<historyBlock> blocks; 	// Blocks in the order they were made 
+	vector<string> sources; 		// Names of the changes files and clients changes came from 
+	string source; 				// Source of the changes now being made 
+	uint32_t sourceId; 			// Place of source in sources, once it is there 
+	uint32_t lastMls; 			// MLS number of the newest block's last change 
+	string fileName; 			// History file holding the saved blocks, or empty 
+	size_t savedBlocks; 		// Blocks in that file 
+	uint64_t savedBytes; 		// Bytes of that file holding them 
+
+	priceHistory() : sourceId(0), lastMls(0), savedBlocks(0), savedBytes(0) {}
+}; 
+
+struct historyQuery				// Price changes to display 
+{
+	uint32_t mls; 				// MLS number whose history to show, or 0 to find reduced listings 
+	int reductions; 			// Fewest reductions a listing must have had to be shown 
+	int days; 					// Days back the reductions are counted 
+
+	historyQuery() : mls(0), reductions(1), days(HISTORY_DEFAULT_DAYS) {}
+}; 
+
+struct deltaTracker				// Listings changed since the listings file was last saved, 
+{								// as bitmaps over MLS numbers rather than copies of them 
+	vector<uint64_t> dirty; 		// Bit set for each MLS number added, deleted or repriced 
+	vector<uint64_t> added; 		// Bit set for each of those not on file at the last save 
+	uint32_t count; 			// MLS numbers whose dirty bit is set 
+	bool paused; 				// Whether changes go untracked, while the saved file is reloaded 
+	bool incomplete; 			// Whether memory ran out and changes went untracked 
+	string fileName; 			// Listings file the changes are to, or empty 
+
+	deltaTracker() : count(0), paused(false), incomplete(false) {}
+}; 
+
+struct shardLayout				// Listings kept as a directory of shard files, one per 
+{								// 3-digit zip code prefix, with a manifest 
+	string directory; 			// Shard directory loaded, or empty for a single file 
+	bool partial; 				// Whether only the selected prefixes are to be loaded 
+	uint64_t selected[SHARD_WORDS]; 	// Prefixes to load, if partial 
+	uint64_t loaded[SHARD_WORDS]; 	// Prefixes loaded from the directory 
+	uint64_t dirty[SHARD_WORDS]; 	// Prefixes with listings changed since the load or save 
+	vector<uint32_t> merged; 	// MLS numbers saved to shards not loaded, in order 
+
+	shardLayout() : partial(false), selected(), loaded(), dirty() {}
+}; 
+
+struct deltaSummary				// Results of writing a delta file 
+{
+	uint64_t sequence; 			// Sequence number of the changes written, or 0 if none 
+	uint32_t inserted; 			// Listings added 
+	uint32_t updated; 			// Listings changed 
+	uint32_t deleted; 			// Listings deleted 
+}; 
+
+struct priceEntry				// Entry of the price index 
+{
+	int64_t price; 				// Asking price of the row in cents when the entry was made 
+	uint32_t row; 				// Row of the listing 
+	uint32_t generation; 		// Entry is current while the row has this generation 
+}; 
+
+struct listingStore				// Column-oriented storage for all listings; row r of 
+{								// every column holds one listing 
+	vector<uint32_t> mls; 				// MLS number of each row 
+	vector<int64_t> price; 				// Asking price of each row, in cents 
+	vector<uint8_t> status; 			// Status of each row, or STATUS_DELETED 
+	vector<uint32_t> zip; 				// Zip code of each row, packed by packZip 
+	vector<uint32_t> company; 			// Realty company name id of each row 
+	vector<string> companyNames; 		// Interned realty company names by id 
+	vector<uint32_t> companySlots; 		// Hash table of company name ids 
+	int companyBits; 					// log2 of the number of company slots 
+	vector<uint32_t> indexSlots; 		// Hash table of rows keyed on MLS number 
+	int indexBits; 						// log2 of the number of index slots 
+	uint32_t liveRows; 					// Rows holding a listing 
+	uint32_t deletedRows; 				// Rows marked as deleted 
+	vector<uint32_t> freeRows; 			// Deleted rows to reuse, most recently freed last 
+	vector<uint32_t> addedRows; 		// Rows added since a freed row was reused, in the order added 
+	uint32_t peakRows; 					// Most rows ever holding a listing at once 
+	vector<uint64_t> statusBits[STATUS_COUNT]; 	// Bitmap of the rows of each status 
+	uint32_t statusCounts[STATUS_COUNT]; 		// Rows of each status 
+	vector<vector<uint32_t> > zipRows; 		// Rows of each 5-digit zip code, in no order 
+	vector<uint32_t> zipPosition; 			// Place of each row in its zipRows list 
+	vector<vector<uint32_t> > companyRows; 	// Rows of each realty company id, in no order 
+	vector<uint32_t> companyPosition; 		// Place of each row in its companyRows list 
+	vector<priceEntry> priceSorted; 		// Price index entries in price order, some stale 
+	vector<priceEntry> priceDelta; 			// Price index entries added since the last merge 
+	bool priceDeltaSorted; 					// Whether priceDelta is in price order 
+	vector<uint32_t> priceGeneration; 		// Generation of each row's current price entry 
+	size_t priceStale; 						// Price index entries no longer current 
+	size_t memoryBudget; 				// Bytes the columns and MLS index may grow to 
+	listingJournal journal; 			// Journal of changes to the file loaded 
+	fileFingerprint fingerprint; 		// Chunks of the listings file loaded, to reload it 
+	priceHistory history; 				// Changes of asking price, kept out of the columns 
+	deltaTracker delta; 				// Listings changed since the file was last saved 
+	shardLayout shards; 				// Shards loaded and changed, if the listings are sharded 
+	int loadThreads; 					// Threads to parse large files with; 0 for one per core 
+	
+	listingStore() : companyBits(0), indexBits(0), liveRows(0), deletedRows(0), peakRows(0), 
+	                 statusCounts(), priceDeltaSorted(true), priceStale(0), 
+	                 memoryBudget(DEFAULT_MEMORY_BUDGET_MB * MEGABYTE), loadThreads(0) {}
+}; 
+
+struct listingQuery				// Conditions a listing must meet to match a query 
+{
+	int status; 				// Status to match, or QUERY_ANY_STATUS 
+	uint32_t zipPrefix; 		// Leading digits of the zip code to match 
+	int zipDigits; 				// Digits in zipPrefix: 3, 5, 9, or 0 for any zip code 
+	string company; 			// Realty company to match, ignoring case; empty for any 
+	int64_t minPrice; 			// Lowest asking price to match, in cents 
+	int64_t maxPrice; 			// Highest asking price to match, in cents 
+	int order; 					// QUERY_ROW_ORDER, QUERY_LOWEST or QUERY_HIGHEST 
+	size_t limit; 				// Most listings to return, or 0 for every match 
+	
+	listingQuery() : status(QUERY_ANY_STATUS), zipPrefix(0), zipDigits(0), minPrice(INT64_MIN), 
+	                 maxPrice(INT64_MAX), order(QUERY_ROW_ORDER), limit(0) {}
+}; 
+
+struct listingPage				// Listings to display and the order to show them in 
+{
+	int sortKey; 				// SORT_FILE_ORDER, SORT_MLS, SORT_PRICE or SORT_ZIP 
+	bool descending; 			// Whether the largest key is shown first 
+	size_t offset; 				// Listings passed over before the first shown 
+	size_t limit; 				// Most listings shown, or 0 for the rest 
+	
+	listingPage() : sortKey(SORT_FILE_ORDER), descending(false), offset(0), limit(0) {}
+}; 
+
+struct parsedListing			// Fields of one listings file line, viewed in place 
+{
+	int numberMLS; 				// MLS number, or 0 for a blank line 
+	int64_t price; 				// Listing price, in cents 
+	statusOptions status; 		// Listing status 
+	string_view zipCode; 		// Zip code 
+	string_view realtyCompany; 	// Realty company for listing 
+}; 
+
+struct loadSummary				// Results of loading a listings file 
+{
+	int recordsLoaded; 			// Records added to the store 
+	int recordsRejected; 		// Malformed or duplicate records skipped 
+	bool memoryFull; 			// Whether loading stopped for lack of memory 
+	bool fromSnapshot; 			// Whether the listings came from a snapshot file 
+}; 
+
+struct reloadSummary			// Results of reloading a changed listings file 
+{
+	int listingsAdded; 			// Listings new to the file 
+	int listingsRemoved; 		// Listings no longer in the file 
+	int listingsChanged; 		// Listings whose price, status, zip code or company changed 
+	int recordsRejected; 		// Malformed or duplicate lines skipped 
+	size_t chunksParsed; 		// Chunks of lines parsed because they changed 
+	size_t chunkCount; 			// Chunks of lines in the file 
+	bool memoryFull; 			// Whether listings could not be added for lack of memory 
+	int unsavedKept; 			// Listings changed since the last save whose changes were kept 
+}; 
+
+struct historyHeader			// Fixed header at the start of a price history file; the 
+{								// blocks described in encodeHistoryBlock follow it 
+	char magic[8]; 				// HISTORY_MAGIC 
+	uint32_t version; 			// HISTORY_VERSION of the writer 
+	uint32_t reserved; 			// Always zero 
+}; 
+
+struct snapshotHeader			// Fixed header at the start of a snapshot file; the 
+{								// sections listed in writeSnapshotFile follow it 
+	char magic[8]; 				// SNAPSHOT_MAGIC 
+	uint32_t version; 			// SNAPSHOT_VERSION of the writer 
+	uint32_t byteOrder; 		// SNAPSHOT_BYTE_ORDER as stored by the writer 
+	uint64_t recordCount; 		// Listings in the snapshot 
+	uint64_t companyCount; 		// Names in the company name table 
+	uint64_t companyBytes; 		// Characters in all company names 
+	uint64_t indexBits; 		// log2 of the number of MLS index slots 
+	uint64_t payloadBytes; 		// Bytes following the header 
+	uint64_t checksum; 			// snapshotChecksum of the bytes following the header 
+}; 
+
+struct journalHeader			// Fixed header at the start of a journal file; the 
+{								// records described in journalRecord follow it 
+	char magic[8]; 				// JOURNAL_MAGIC 
+	uint32_t version; 			// JOURNAL_VERSION of the writer 
+	uint32_t reserved; 			// Always zero 
+	uint64_t baseSize; 			// Size of the listings file the journal applies to 
+	int64_t baseModified; 		// Time that listings file was last changed 
+}; 
+
+struct mappedFile				// Read-only view of a whole file 
+{
+	const char *data; 			// First byte of the file 
+	size_t size; 				// Number of bytes in the file 
+	bool mapped; 				// Whether data is a memory mapping 
+	vector<char> buffer; 		// File contents where mapping is unavailable 
+}; 
+
+struct ioRing					// io_uring instance: queues shared with the kernel and the 
+{								// buffers its reads and writes use 
+	int descriptor; 			// The ring, or -1 if it is not set up 
+	char *sqRing; 				// Mapping of the submission queue 
+	char *cqRing; 				// Mapping of the completion queue 
+	size_t sqRingBytes; 		// Size of the submission queue mapping 
+	size_t cqRingBytes; 		// Size of the completion queue mapping 
+	size_t sqeBytes; 			// Size of the submission entries mapping 
+	unsigned *sqHead; 			// Next submission the kernel will take 
+	unsigned *sqTail; 			// Next submission entry to fill 
+	unsigned sqMask; 			// Turns a submission position into an entry number 
+	unsigned *sqArray; 			// Entry number of each submission 
+	unsigned *cqHead; 			// Next completion to take 
+	unsigned *cqTail; 			// Completion after the last the kernel added 
+	unsigned cqMask; 			// Turns a completion position into an entry number 
+	char *buffers; 				// IO_BLOCKS buffers of IO_BLOCK_BYTES, one after another 
+	bool registered; 			// Whether the buffers are registered with the kernel 
+	unsigned pending; 			// Entries queued but not yet submitted 
+#ifdef __linux__
+	io_uring_sqe *sqes; 		// Submission entries 
+	io_uring_cqe *cqes; 		// Completion entries 
+#endif
+
+	ioRing() : descriptor(-1), sqRing(NULL), cqRing(NULL), sqRingBytes(0), cqRingBytes(0), sqeBytes(0), 
+	           sqHead(NULL), sqTail(NULL), sqMask(0), sqArray(NULL), cqHead(NULL), cqTail(NULL), cqMask(0), 
+	           buffers(NULL), registered(false), pending(0)
+#ifdef __linux__
+	           , sqes(NULL), cqes(NULL)
+#endif
+	           {}
+}; 
+
+struct ioBackend				// How files are read and written; the io_uring ring is set 
+{								// up the first time a file uses it 
+	int kind; 					// IO_URING or IO_BLOCKING 
+	mutex lock; 				// Held by the file using the ring; guards the fields below 
+	bool ready; 				// Whether the ring is set up 
+	bool failed; 				// Whether the ring could not be set up or stopped working 
+	ioRing ring; 				// The ring 
+
+	ioBackend() : kind(IO_URING), ready(false), failed(false) {}
+}; 
+
+struct ioReader					// File being read a block at a time 
+{
+	FILE *file; 				// File read with blocking calls, or NULL 
+	int descriptor; 			// File read through the ring, or -1 
+	uint64_t size; 				// Size of the file read through the ring 
+	uint64_t queued; 			// Bytes whose reads have been queued 
+	uint64_t delivered; 		// Bytes handed to the caller 
+	int block; 					// Ring buffer handed to the caller last, or -1 
+	int length[IO_BLOCKS]; 		// Bytes read into each ring buffer, or -1 while its read is in flight 
+	int inFlight; 				// Reads queued but not yet finished 
+	vector<char> buffer; 		// Block read with blocking calls 
+	bool failed; 				// Whether a read failed 
+}; 
+
+struct ioWriter					// File being written a block at a time 
+{
+	FILE *file; 				// File written with blocking calls, or NULL 
+	int descriptor; 			// File written through the ring, or -1 
+	uint64_t offset; 			// Where in the file the buffer being filled goes 
+	int block; 					// Ring buffer being filled 
+	size_t used; 				// Bytes in the buffer being filled 
+	uint64_t blockOffset[IO_BLOCKS]; 	// Where in the file each buffer in flight goes 
+	size_t blockBytes[IO_BLOCKS]; 		// Bytes of each buffer in flight, or 0 if it is free 
+	int inFlight; 				// Writes queued but not yet finished 
+	bool failed; 				// Whether a write failed 
+}; 
+
+struct parsedChunk				// Listings parsed from one chunk of a listings file 
+{
+	const char *begin; 					// First byte of the chunk 
+	const char *end; 					// Byte after the last line of the chunk 
+	int lines; 							// Lines in the chunk 
+	bool failed; 						// Whether parsing ran out of memory 
+	bool fileStart; 					// Whether the chunk starts its file 
+	vector<uint32_t> mls; 				// MLS number of each listing parsed 
+	vector<int64_t> price; 				// Asking price of each listing, in cents 
+	vector<uint8_t> status; 			// Status of each listing 
+	vector<uint32_t> zip; 				// Packed zip code of each listing 
+	vector<string_view> company; 		// Realty company of each listing, in the mapped file 
+	vector<int> recordLines; 			// Line of each listing, counted from 0 within the chunk 
+	vector<int> errorLines; 			// Lines within the chunk that were skipped 
+	vector<const char*> errorReasons; 	// Why each of those lines was skipped 
+	
+	parsedChunk() : begin(NULL), end(NULL), lines(0), failed(false), fileStart(false) {}
+}; 
+
+struct importBatch				// Lines of an import file, column by column, as they 
+{								// are validated 
+	vector<uint32_t> mls; 				// MLS number of each line 
+	vector<int64_t> price; 				// Asking price of each line, in cents 
+	vector<uint8_t> status; 			// Status of each line 
+	vector<uint32_t> zip; 				// Packed zip code of each line 
+	vector<string_view> company; 		// Realty company of each line, in the mapped file 
+	vector<string_view> text; 			// Text of each line, in the mapped file 
+	vector<int> lines; 					// Line number of each line 
+	vector<const char*> reason; 		// Why each line is rejected, or NULL while it is valid 
+}; 
+
+struct chunkSchedule			// Hands the chunks of a listings file to parsing threads 
+{
+	mutex lock; 						// Guards the other fields 
+	condition_variable changed; 		// Signalled when a chunk is parsed or merged 
+	size_t nextChunk; 					// First chunk not yet taken by a thread 
+	size_t mergedChunks; 				// Chunks merged into the store so far 
+	size_t window; 						// Chunks that may be taken beyond those merged 
+	vector<bool> parsed; 				// Whether each chunk has been parsed 
+}; 
+
+struct shardSave				// Shard files being written by worker threads 
+{
+	const listingStore *store; 	// Store holding the listings 
+	string directory; 			// Shard directory 
+	vector<uint32_t> prefixes; 	// Zip code prefix of each shard to write 
+	vector<vector<uint32_t> > rows; 	// Rows of each shard's listings, in row order 
+	vector<char> merge; 		// Whether each shard keeps the listings of its file not loaded 
+	vector<int64_t> listings; 	// Listings written to each shard 
+	vector<uint64_t> bytes; 		// Bytes written to each shard 
+	vector<char> written; 		// Whether each shard was written 
+	mutex lock; 				// Guards next 
+	size_t next; 				// Next shard to hand to a worker 
+}; 
+
+struct batchCommand				// One command of a batch run 
+{
+	string name; 				// Command name, such as "load" 
+	string argument; 			// File name or value the command acts on 
+	vector<string> extraArguments; 	// Further file names of the stream command 
+}; 
+
+struct priceChange				// One record of a changes file 
+{
+	int numberMLS; 				// MLS number to reprice 
+	int64_t reduction; 			// Amount to subtract from the asking price, in cents 
+}; 
+
+struct changeSummary			// Results of applying a batch of price changes 
+{
+	int recordsRead; 			// Change records in the file 
+	int distinctMLS; 			// Distinct MLS numbers in the file 
+	int listingsChanged; 		// Listings whose price was reduced 
+	vector<int> unmatchedMLS; 	// MLS numbers with no listing, in ascending order 
+	int recordsRejected; 		// Change records skipped for a reduction out of range 
+
+	changeSummary() : recordsRead(0), distinctMLS(0), listingsChanged(0), recordsRejected(0) {}
+}; 
+
+struct streamSummary			// Results of applying a changes file by streaming 
+{
+	int changesRead; 			// Change records in the changes file 
+	int changesRejected; 		// Change records skipped for a reduction out of range 
+	int distinctMLS; 			// Distinct MLS numbers in the changes file 
+	int listingsWritten; 		// Listings written to the output file 
+	int listingsChanged; 		// Listings whose price was reduced 
+	int unmatchedMLS; 			// Changed MLS numbers with no listing 
+	int runsSpilled; 			// Sorted runs of changes written to spill files 
+	int passes; 				// Passes made over the listings 
+	loadSummary listings; 		// Malformed or duplicate listings skipped 
+	
+	streamSummary() : changesRead(0), changesRejected(0), distinctMLS(0), listingsWritten(0), listingsChanged(0), 
+	                  unmatchedMLS(0), runsSpilled(0), passes(0), listings() {}
+}; 
+
+struct marketGroup				// Price statistics of one group of listings 
+{
+	uint32_t key; 				// Zip code, prefix, status or company id of the group 
+	uint32_t count; 			// Listings in the group 
+	int64_t total; 				// Sum of their asking prices, in cents 
+	int64_t low; 				// Lowest asking price, in cents 
+	int64_t high; 				// Highest asking price, in cents 
+	int64_t median; 			// Median asking price, in cents 
+	string name; 				// Company name, when grouped by company 
+}; 
+
+struct mergeHead				// Next record of one run being merged 
+{
+	priceChange change; 		// Record read from the run 
+	size_t run; 				// Position of the run in the runs merged 
+}; 
+
+struct generatorSpec			// Sizes and names of the synthetic files to generate 
+{
+	uint64_t records; 			// Lines of the listings file 
+	uint64_t seed; 				// Seed of the random numbers; one seed always gives the same files 
+	string listingsFile; 		// Listings file to write 
+	string changesFile; 		// Changes file to write, or empty for none 
+	string deleteFile; 			// File of MLS numbers to delete to write, or empty for none 
+	string importFile; 			// File of new listings to import to write, or empty for none 
+	uint64_t changeRecords; 	// Lines of the changes file 
+	uint64_t deleteRecords; 	// MLS numbers of the delete file 
+	uint64_t importRecords; 	// Lines of the import file 
+	
+	generatorSpec() : records(0), seed(GENERATOR_DEFAULT_SEED), changeRecords(0), deleteRecords(0), 
+	                  importRecords(0) {}
+}; 
+
+struct discardBuffer : public streambuf		// Stream buffer dropping what is written, to time 
+{											// formatting for the screen without a screen 
+	int overflow(int character) { return traits_type::not_eof(character); }
+	streamsize xsputn(const char*, streamsize count) { return count; }
+}; 
+
+struct operationMetrics			// Counters of one kind of operation since the program started; 
+{								// atomic so operations on any thread may add to them 
+	atomic<uint64_t> calls; 				// Operations run 
+	atomic<uint64_t> failures; 				// Operations that failed 
+	atomic<uint64_t> nanoseconds; 			// Time spent in the operations 
+	atomic<uint64_t> latency[LATENCY_BUCKETS]; 	// Operations by time taken, bucketed by LATENCY_BOUNDS_US 
+	atomic<uint64_t> bytesRead; 			// Bytes of files read 
+	atomic<uint64_t> bytesWritten; 			// Bytes of files or screen output written 
+	atomic<uint64_t> recordsParsed; 		// Records read, including those rejected 
+	atomic<uint64_t> recordsRejected; 		// Records rejected as malformed, duplicate or unmatched 
+}; 
+
+struct operationTimer			// One operation being measured; its time and counts are added 
+{								// to the metrics when it goes out of scope, on every return path 
+	int operation; 							// OPERATION_ constant of the operation 
+	chrono::steady_clock::time_point start; 	// When the operation began 
+	bool succeeded; 						// Whether the operation succeeded 
+	uint64_t bytesRead; 					// Bytes of files read 
+	uint64_t bytesWritten; 					// Bytes written 
+	uint64_t recordsParsed; 				// Records read 
+	uint64_t recordsRejected; 				// Records rejected 
+	
+	operationTimer(int kind, bool canFail) : operation(kind), start(chrono::steady_clock::now()), 
+	                                         succeeded(!canFail), bytesRead(0), bytesWritten(0), 
+	                                         recordsParsed(0), recordsRejected(0) {}
+	~operationTimer(); 
+}; 
+
+struct serverWrite				// Write request waiting for the server's writer thread 
+{
+	string request; 			// Request line 
+	promise<string> response; 	// Response, given once the write is published 
+}; 
+
+struct serverState				// State shared by the threads of a listings server 
+{
+	listingStore *master; 					// Store only the writer thread reads or changes 
+	shared_ptr<listingStore> published; 	// Copy of the store readers query; replaced, never changed, 
+											// once published 
+	shared_ptr<listingStore> retired; 		// Copy replaced last, overwritten by the next copy once 
+											// its last reader is done 
+	mutex queueLock; 						// Guards queue and writerStop 
+	condition_variable queueReady; 			// Signalled when a write is queued or the writer must stop 
+	deque<serverWrite*> queue; 				// Write requests in the order they arrived 
+	bool writerStop; 						// Whether the writer should stop once the queue is empty 
+	atomic<bool> stopping; 					// Whether a client asked the server to shut down 
+	atomic<uint64_t> requests; 				// Requests answered 
+	mutex connectionLock; 					// Guards connections 
+	condition_variable connectionClosed; 	// Signalled when a connection closes 
+	int connections; 						// Connections open 
+	
+	serverState() : master(NULL), writerStop(false), stopping(false), requests(0), connections(0) {}
+}; 
+
+// Operation metrics of the whole program; they outlive every listing store, 
+// so they are kept here rather than in one 
+operationMetrics metrics[OPERATION_COUNT]; 
+
+// How files are read and written, and the io_uring ring they share; kept 
+// here with the metrics, as every listing store reads and writes through it 
+ioBackend fileIO; 
+
 
 // Function prototypes
-void readFile(ifstream& file, bool& exists, listingsInfo* &first, listingsInfo* &last); 
-void displayAll(listingsInfo* first, listingsInfo* last);
-void AddListing(listingsInfo* &first, listingsInfo* &last); 
+void readFile(ifstream& file, bool& exists, listingStore& store); 
+void displayAll(listingStore& store);
+void displayListingHeader(); 
+void displayListingRows(ostream& out, const listingStore& store, const vector<uint32_t>& rows, 
+                        size_t first, size_t last); 
+char* formatListingRow(char* position, const listingStore& store, uint32_t row); 
+char* padColumn(char* start, char* position, size_t width); 
+void selectListings(listingStore& store, const listingPage& page, vector<uint32_t>& rows); 
+bool parsePageText(const string& text, listingPage& page, string& error); 
+bool parseSortKey(string_view text, int& sortKey, bool& descending); 
+void displayMlsNumbers(ostream& out, const listingStore& store); 
+void AddListing(listingStore& store); 
 int ValidateMLS();
 double ValidatePrice();  
 string ValidateZip(); 
 statusOptions ValidateStatus(); 
 string ValidateCompanyName(); 
-void DeleteRecord(listingsInfo* &first, listingsInfo* last); 
-void SaveToFile(ofstream& outputFile, listingsInfo* first);
-void ChangeAskingPrices(listingsInfo* first, listingsInfo* last); 
-
+void DeleteRecord(listingStore& store); 
+void BulkDeleteListings(listingStore& store); 
+void QueryListings(listingStore& store); 
+void runQuery(listingStore& store, const listingQuery& query, vector<uint32_t>& rows); 
+bool queryMatches(const listingStore& store, uint32_t row, const listingQuery& query); 
+void queryCompanyIds(const listingStore& store, const string& name, vector<uint32_t>& ids); 
+bool sameCompanyName(const string& left, const string& right); 
+bool parseQueryText(const string& text, listingQuery& query, string& error); 
+bool parseStatusCode(char code, int& status); 
+bool parseZipPattern(string_view text, uint32_t& prefix, int& digits); 
+bool parsePriceRange(string_view text, int64_t& low, int64_t& high); 
+void MarketStatistics(const listingStore& store); 
+void computeMarketStats(const listingStore& store, int groupBy, vector<marketGroup>& groups); 
+size_t groupListingKeys(const listingStore& store, int groupBy, vector<uint32_t>& keys); 
+void displayMarketStats(ostream& out, const listingStore& store, int groupBy, vector<marketGroup>& groups); 
+bool compareGroupNames(const marketGroup& left, const marketGroup& right); 
+bool parseGroupBy(const string& text, int& groupBy); 
+bool parseListingOrder(string_view text, int& order, size_t& limit); 
+void SaveToFile(listingStore& store);
+void ChangeAskingPrices(listingStore& store); 
+bool readChangesFile(const string& fileName, vector<priceChange>& changes, int& rejected); 
+void applyPriceChanges(listingStore& store, vector<priceChange>& changes, changeSummary& summary); 
+bool compareChangeMLS(const priceChange& left, const priceChange& right); 
+void displayChangeSummary(ostream& out, const changeSummary& summary); 
+bool writeListingsFile(const string& fileName, const listingStore& store); 
+bool syncFile(FILE* file); 
+bool replaceFile(const string& tempName, const string& fileName); 
+char* formatListingLine(char* position, uint32_t mls, int64_t price, int status, uint32_t zip, string_view company); 
+bool dollarsToCents(double dollars, int64_t& cents); 
+char* formatPrice(char* position, int64_t cents, bool showCents); 
+bool streamPriceChanges(const string& listingsFile, const string& changesFile, const string& outputFile, 
+                        size_t budget, streamSummary& summary, string& error); 
+bool sortChangesExternal(const string& changesFile, size_t budget, const string& tempBase, 
+                         vector<priceChange>& sorted, string& sortedFile, streamSummary& summary, 
+                         string& error); 
+void sumSortedChanges(vector<priceChange>& changes); 
+bool writeChangeRun(const string& fileName, vector<priceChange>& changes); 
+bool mergeChangeRuns(const vector<string>& runs, const string& fileName); 
+bool compareMergeHead(const mergeHead& left, const mergeHead& right); 
+bool streamListingsPass(const string& inputFile, const string& outputFile, const vector<priceChange>& batch, 
+                        bool firstPass, streamSummary& summary, string& error); 
+string tempFileBase(const string& outputFile); 
+uint64_t fileSize(const string& fileName); 
+bool loadListingsFile(const string& fileName, listingStore& store, loadSummary& summary); 
+bool loadListingsMapped(const string& fileName, listingStore& store, loadSummary& summary); 
+bool appendListingsMapped(const string& fileName, listingStore& store, loadSummary& summary); 
+void appendListingsParallel(vector<parsedChunk>& chunks, int threads, listingStore& store, loadSummary& summary); 
+void parseListingsWorker(vector<parsedChunk>& chunks, chunkSchedule& schedule); 
+void parseListingsChunk(parsedChunk& chunk); 
+void mergeListingsChunk(listingStore& store, const parsedChunk& chunk, int firstLine, loadSummary& summary); 
+int loadThreadCount(const listingStore& store); 
+bool parseListingLine(string_view line, parsedListing& record, const char* &error); 
+void reportLoadError(loadSummary& summary, int lineNumber, const char* reason); 
+void ImportListings(listingStore& store); 
+bool importListingsFile(const string& fileName, listingStore& store, loadSummary& summary, string& error); 
+void validateImportBatch(const listingStore& store, importBatch& batch); 
+const char* checkCompanyName(string_view name); 
+void titleCaseCompany(string& name); 
+bool writeRejectsFile(const string& fileName, const importBatch& batch); 
+bool mapFile(const string& fileName, mappedFile& file); 
+void unmapFile(mappedFile& file); 
+bool writeSnapshotFile(const string& fileName, listingStore& store); 
+bool writeSnapshotSection(ioWriter& output, const void* data, size_t size); 
+bool loadSnapshotFile(const string& fileName, listingStore& store, const char* &error); 
+bool isSnapshotFile(const string& fileName); 
+bool snapshotIsCurrent(const string& fileName); 
+uint64_t snapshotChecksum(uint64_t checksum, const char* data, size_t size); 
+size_t snapshotAlign(size_t size); 
+bool journalOpen(listingStore& store, const string& baseName, int& replayed, const char* &error); 
+int journalReplay(listingStore& store, const char* data, size_t size, size_t& validBytes); 
+void journalRecord(listingStore& store, char type, uint32_t row); 
+void journalAppend(listingStore& store, char type, uint32_t mls, int64_t price, uint32_t zip, uint8_t status, string_view company); 
+void journalCommit(listingStore& store); 
+void journalFlush(listingStore& store, bool sync); 
+bool journalReset(listingStore& store); 
+void journalClose(listingStore& store); 
+bool fileIdentity(const string& fileName, uint64_t& size, int64_t& modified); 
+uint32_t storeAppend(listingStore& store, int mls, int64_t price, statusOptions status, uint32_t zip, string_view company); 
+void storeRemove(listingStore& store, uint32_t row); 
+void storeMarkDeleted(listingStore& store, uint32_t row); 
+size_t storeFileOrder(const listingStore& store, vector<uint32_t>& rows); 
+size_t storeSavedRows(const listingStore& store, vector<uint32_t>& rows); 
+void storeCompact(listingStore& store); 
+void storeClear(listingStore& store); 
+bool storeReserve(listingStore& store, size_t rows); 
+bool storeFull(const listingStore& store); 
+size_t storeMemoryUsed(const listingStore& store); 
+void displayMemoryUsage(const listingStore& store); 
+int runBatch(int argc, char* argv[], listingStore& store); 
+bool readBatchScript(const string& fileName, vector<batchCommand>& commands); 
+bool runBatchCommand(listingStore& store, const batchCommand& command, string& detail); 
+bool deleteListingsFile(const string& fileName, listingStore& store, int& deleted, int& notFound); 
+void deleteListings(listingStore& store, const vector<uint32_t>& mlsNumbers, int& deleted, int& notFound); 
+void parseMlsList(string_view text, vector<uint32_t>& mlsNumbers); 
+void displayUsage(); 
+uint32_t internCompany(listingStore& store, string_view name); 
+uint32_t companyHash(string_view name); 
+bool packZip(string_view text, uint32_t& packed); 
+void formatZip(uint32_t packed, char* text); 
+unsigned int mlsHash(uint32_t mls, int bits); 
+uint32_t indexFind(const listingStore& store, int mls); 
+void indexInsert(listingStore& store, uint32_t row); 
+void indexRemove(listingStore& store, int mls); 
+void indexRebuild(listingStore& store, uint32_t expectedRows); 
+void secondaryInsert(listingStore& store, uint32_t row); 
+void secondaryRemove(listingStore& store, uint32_t row); 
+void removeFromRowList(vector<uint32_t>& rows, vector<uint32_t>& positions, uint32_t row); 
+void secondaryRebuild(listingStore& store); 
+void priceIndexInsert(listingStore& store, uint32_t row); 
+void priceIndexAdd(listingStore& store, const priceEntry& entry); 
+void priceIndexRemove(listingStore& store, uint32_t row); 
+void priceIndexMerge(listingStore& store); 
+void priceIndexSortDelta(listingStore& store); 
+void priceIndexRebuild(listingStore& store); 
+size_t priceDeltaCapacity(size_t rows); 
+bool priceEntryCurrent(const listingStore& store, const priceEntry& entry); 
+bool comparePriceEntry(const priceEntry& left, const priceEntry& right); 
+size_t priceRangeSize(listingStore& store, int64_t low, int64_t high); 
+void priceScan(listingStore& store, const listingQuery& query, vector<uint32_t>& rows); 
+bool storeReprice(listingStore& store, uint32_t row, int64_t price); 
+bool storeUpdate(listingStore& store, uint32_t row, int64_t price, statusOptions status, uint32_t zip, string_view company); 
+bool generateListings(const generatorSpec& spec, string& error); 
+void generateListing(uint64_t& state, size_t companies, uint32_t& zip, int64_t& price, int& status, size_t& company); 
+uint32_t generatedMls(uint64_t index); 
+void generatedCompanies(uint64_t records, vector<string>& names); 
+bool writeGeneratedText(FILE* file, string& text, bool finish); 
+uint64_t nextRandom(uint64_t& state); 
+uint64_t randomSkewed(uint64_t& state, uint64_t count); 
+bool parseGeneratorText(const string& text, generatorSpec& spec, string& error); 
+bool runBenchmark(const vector<uint64_t>& sizes, const listingStore& settings, ostream& out, string& error); 
+void reportBenchmarkStep(ostream& out, uint64_t records, const char* step, uint64_t items, 
+                         chrono::steady_clock::time_point start, uint32_t listings); 
+long peakMemoryKB(); 
+bool parseBenchSizes(const string& text, vector<uint64_t>& sizes); 
+int latencyBucket(uint64_t nanoseconds); 
+bool writeMetricsFile(const string& fileName, const listingStore& store); 
+void formatMetricsPrometheus(ostream& out, const listingStore& store); 
+void formatMetricsJson(ostream& out, const listingStore& store); 
+void WriteMetrics(const listingStore& store); 
+void writeRunMetrics(const listingStore& store); 
+bool appendImportLine(importBatch& batch, string_view line, int lineNumber); 
+bool addListingText(listingStore& store, string_view text, string& error); 
+bool parseRepriceText(const string& text, vector<priceChange>& changes); 
+void appendListingLines(string& out, const listingStore& store, const vector<uint32_t>& rows); 
+bool runServer(const string& socketPath, listingStore& store, uint64_t& requests, string& error); 
+int openServerSocket(const string& socketPath, string& error); 
+void serveConnection(serverState* server, int socket); 
+void handleServerRequest(serverState& server, const string& line, string& response); 
+void serverWriter(serverState* server); 
+bool applyServerWrite(listingStore& store, const string& line, string& response); 
+void publishSnapshot(serverState& server); 
+void swapWriterMembers(listingStore& store, listingStore& aside); 
+bool sendAll(int socket, const string& data); 
+bool reloadListingsFile(const string& fileName, listingStore& store, reloadSummary& summary); 
+bool fingerprintListingsFile(const string& fileName, fileFingerprint& fingerprint); 
+void chunkListings(const char* data, size_t size, fileFingerprint& fingerprint, vector<size_t>& offsets,
+                   vector<int>& firstLines); 
+void watchOpen(const string& fileName, fileWatch& watch); 
+bool watchChanged(fileWatch& watch, int timeoutMs); 
+bool watchEvents(fileWatch& watch, int timeoutMs); 
+void watchClose(fileWatch& watch); 
+void serverWatcher(serverState* server, string fileName); 
+void ReloadListings(listingStore& store); 
+void historyReserve(priceHistory& history); 
+void historyRecord(priceHistory& history, uint32_t mls, int64_t oldPrice, int64_t newPrice); 
+void appendVarint(vector<uint8_t>& bytes, uint64_t value); 
+bool readVarint(const uint8_t*& position, const uint8_t* end, uint64_t& value); 
+bool readHistoryChange(const uint8_t*& position, const uint8_t* end, uint32_t& mls, int64_t& oldPrice,
+                       int64_t& newPrice); 
+void encodeHistoryBlock(const priceHistory& history, size_t block, vector<uint8_t>& bytes); 
+bool saveHistoryFile(const string& fileName, listingStore& store); 
+bool loadHistoryFile(const string& fileName, priceHistory& history); 
+bool parseHistoryText(const string& text, historyQuery& query, string& error); 
+size_t displayPriceHistory(ostream& out, const listingStore& store, const historyQuery& query); 
+char* formatHistoryTime(char* position, int64_t seconds); 
+void PriceHistory(const listingStore& store); 
+void deltaMark(deltaTracker& delta, uint32_t mls, char change); 
+bool writeDeltaFile(const string& fileName, listingStore& store, deltaSummary& summary, string& error); 
+void ExportChanges(listingStore& store); 
+void shardMark(shardLayout& shards, uint32_t zip); 
+bool isShardDirectory(const string& name); 
+bool isShardTarget(const string& name); 
+string shardFileName(const string& directory, uint32_t prefix); 
+bool parseShardList(const string& text, shardLayout& shards, string& error); 
+bool readShardManifest(const string& directory, vector<int64_t>& counts); 
+bool loadShardDirectory(const string& directory, listingStore& store, loadSummary& summary); 
+bool writeShardDirectory(const string& directory, listingStore& store, string& error); 
+void writeShardsWorker(shardSave& job); 
+bool writeShardFile(const string& fileName, const listingStore& store, const vector<uint32_t>& rows, bool merge, int64_t& listings, uint64_t& bytes); 
+void splitListingsChunks(const mappedFile& input, vector<parsedChunk>& chunks); 
+bool parseIoBackend(const string& text, int& kind); 
+const char* ioBackendName(); 
+bool ioRingAcquire(); 
+void ioRingRelease(); 
+bool ioRingOpen(ioRing& ring); 
+void ioRingClose(ioRing& ring); 
+void ioRingQueue(ioRing& ring, bool write, int descriptor, int block, size_t bytes, uint64_t offset); 
+bool ioRingSubmit(ioRing& ring); 
+bool ioRingWait(ioRing& ring, int& block, int& result); 
+bool ioReaderOpen(const string& fileName, ioReader& reader); 
+void ioReaderQueue(ioReader& reader); 
+bool ioReaderNext(ioReader& reader, const char*& data, size_t& size); 
+void ioReaderClose(ioReader& reader); 
+bool ioWriterOpen(const string& fileName, bool binary, ioWriter& writer); 
+bool ioWriterWrite(ioWriter& writer, const char* data, size_t size); 
+void ioWriterFlush(ioWriter& writer); 
+void ioWriterWait(ioWriter& writer); 
+bool ioWriterClose(ioWriter& writer, bool sync); 
+bool parseChangeRecords(const char* position, const char* end, bool last, priceChange& change, bool& haveMLS, vector<priceChange>& changes, int& rejected, const char*& rest); 
 
 
 //*****************************************************************************
 // FUNCTION: main
 // DESCRIPTION: Prompts user whether to open file, whether to proceed,
 // provides menu options if user chooses to proceed, calls other functions
-// to execute menu options.    
-// CALLS TO: readFile, displayAll, AddListing, DeleteRecord, SaveToFile 
-//*****************************************************************************  
-int main()
+// to execute menu options. When command-line arguments are given, runs 
+// them as batch commands instead, without prompts.    
+// INPUT: Parameters: argc, argv - command-line arguments 
+// OUTPUT: Return value: exit code 
+// CALLS TO: readFile, displayAll, AddListing, DeleteRecord, 
+// BulkDeleteListings, SaveToFile, 
+// ChangeAskingPrices, ImportListings, QueryListings, MarketStatistics, displayMemoryUsage, 
+// WriteMetrics, storeClear, runBatch, watchOpen, watchChanged, ReloadListings, 
+// watchClose, PriceHistory, ExportChanges 
+//*****************************************************************************
+int main(int argc, char* argv[])
 {
 	// variables 
 	char loadData;				// For user input to load data 
-	char proceed;  				// For user prompt to proceed with empty record 
 	ifstream inputFile;			// Variable for input file 
-	ofstream outputFile;		// Variable for output file   
 	bool fileExists;			// To check if file exists 
 	char menuOption;  			// To receive user input for menu option 
 	
-	listingsInfo *head; 		// To store first node in list 
-	listingsInfo *last;			// To store last node in list 
+	listingStore store; 		// To store all listings 
+	fileWatch watch; 			// To notice the listings file changing on disk 
+	const char *budgetText; 	// Memory budget in megabytes from the environment 
+	const char *threadsText; 	// Parsing threads from the environment 
+	const char *ioText; 			// File I/O backend from the environment 
+	
+	budgetText = getenv(MEMORY_BUDGET_VARIABLE); 
+	
+	if (budgetText != NULL && atol(budgetText) > 0)
+		store.memoryBudget = atol(budgetText) * MEGABYTE; 
+	
+	threadsText = getenv(THREADS_VARIABLE); 
+	
+	if (threadsText != NULL && atoi(threadsText) > 0)
+		store.loadThreads = atoi(threadsText); 
+	
+	ioText = getenv(IO_BACKEND_VARIABLE); 
+	
+	if (ioText != NULL)
+		parseIoBackend(ioText, fileIO.kind); 
 	
-	head = NULL;
-	last = NULL;  
+	if (argc > 1)
+		return runBatch(argc, argv, store); 
 	
 	
 	// Program introduction
@@ -118,16 +1270,31 @@ int main()
 	
 	
 	if (loadData == YES)
-		readFile(inputFile, fileExists, head, last);
-		
+		readFile(inputFile, fileExists, store); 
+
+	// A listings file changed by another program is reloaded between choices 
+	if (!store.fingerprint.fileName.empty())
+		watchOpen(store.fingerprint.fileName, watch); 
+
 
 		do
 		{
+			if (!watch.fileName.empty() && watchChanged(watch, 0))
+				ReloadListings(store); 
+
 			cout << "Please choose from the options given below:" << endl << endl; 
 			cout << "D - Display All Listings" << endl; 
 			cout << "A - Add Listing" << endl; 
 			cout << "R - Remove Listing" << endl;
+			cout << "B - Bulk Remove Listings" << endl; 
 			cout << "C - Apply Changes File" << endl; 
+			cout << "I - Import New Listings File" << endl; 
+			cout << "Q - Query Listings" << endl; 
+			cout << "S - Market Statistics" << endl; 
+			cout << "H - Price History" << endl; 
+			cout << "X - Export Changes Since Last Save" << endl; 
+			cout << "U - Show Memory Usage" << endl; 
+			cout << "M - Write Metrics File" << endl; 
 			cout << "E - Exit from Program" << endl << endl; 
 	
 			cout << "Enter selection: "; 
@@ -139,19 +1306,43 @@ int main()
 		switch(menuOption)
 		{
 		case 'D':
-			displayAll(head, last);
+			displayAll(store);
 			break; 
 		case 'A':
-			AddListing(head, last);
+			AddListing(store);
 			break; 
 		case 'R': 
-			DeleteRecord(head, last);
+			DeleteRecord(store);
 			break;
+		case 'B':
+			BulkDeleteListings(store); 
+			break; 
 		case 'C':
-			ChangeAskingPrices(head, last); 
+			ChangeAskingPrices(store); 
+			break; 
+		case 'I':
+			ImportListings(store); 
+			break; 
+		case 'Q':
+			QueryListings(store); 
+			break; 
+		case 'S':
+			MarketStatistics(store); 
+			break; 
+		case 'H':
+			PriceHistory(store); 
+			break; 
+		case 'X':
+			ExportChanges(store); 
+			break; 
+		case 'U':
+			displayMemoryUsage(store); 
+			break; 
+		case 'M':
+			WriteMetrics(store); 
 			break; 
 		case 'E':
-			SaveToFile(outputFile, head);
+			SaveToFile(store);
 			break; 
 		default:
 			cout << "Invalid Input - Must be from menu." << endl << endl; 	
@@ -159,8 +1350,11 @@ int main()
 		
 	}
 	while(menuOption != 'E'); 
-	
-	
+
+	watchClose(watch); 
+
+	// To release every listing at once 
+	storeClear(store); 
 	
 	system ("PAUSE"); 
 	
@@ -170,21 +1364,24 @@ int main()
 
 //*****************************************************************************
 // FUNCTION: readFile
-// DESCRIPTION: Reads input file data into linked list    
+// DESCRIPTION: Reads input file data into the listing store    
 // INPUT: Parameters: file - variable for input file containing listing information  
 // exists - Boolean variable to return whether file exists. 
-// first - Pointer variable for first node in linked list 
-// last - Pointer variable for last node in linked list  
-// OUTPUT: reference parameters: file, exists, first, last  
+// store - listing store to fill 
+// OUTPUT: reference parameters: file, exists, store  
+// CALLS TO: isShardDirectory, parseShardList, loadListingsFile, journalOpen 
 //***************************************************************************** 
-void readFile(ifstream& file, bool& exists, listingsInfo* &first, listingsInfo* &last)
+void readFile(ifstream& file, bool& exists, listingStore& store)
 {
 	// function local variable
-	int tempStatus; 		// to temporarily hold status digit while converting to enumerated type. 
 	string fileName; 		// to receive user input for file name 
 	char enterAnother; 		// to receive user choice for whether to enter another file name
-	int tempMLS; 			// to store MLS outside of loop to use priming read 
-	bool memoryFull; 		// to track when memory can no longer be allocated  
+	loadSummary summary; 	// to receive the results of loading the file 
+	int replayed; 			// to receive the number of journaled changes recovered 
+	const char *error; 		// to receive the reason the journal could not be used 
+	string shardList; 		// to receive user input for the shards to load 
+	string shardError; 		// to receive the reason the shards could not be chosen 
+	bool chosen; 			// whether the shards to load were chosen 
 	 
 	
 	do
@@ -232,64 +1429,42 @@ void readFile(ifstream& file, bool& exists, listingsInfo* &first, listingsInfo*
     
     if (enterAnother != MENU_CHAR)
     {
+    	// The file is parsed through a memory mapping rather than the stream 
+    	file.close(); 
+
+    	// A regional session loads only the shards it needs 
+    	if (isShardDirectory(fileName))
+    		do
+    		{
+    			cout << "Please enter the zip code prefixes of the shards to load (such as 800-809,972, or * for all): "; 
+    			cin >> shardList; 
+    			cout << endl; 
+
+    			chosen = parseShardList(shardList, store.shards, shardError); 
+
+    			if (!chosen)
+    				cout << "Invalid input: " << shardError << "." << endl << endl; 
+    		}
+    		while (!chosen); 
     	
-      	// Allocating memory for new node.   
-      	listingsInfo *newNode; 
-      
-      	last = NULL; 
-      
-      	first = NULL; 
-      
-      	memoryFull = false; 
-      	file >> tempMLS; 
-    		
+    	loadListingsFile(fileName, store, summary); 
     	
-      while (file && memoryFull == false)               
-      {
-      	
-         newNode = new (nothrow) listingsInfo; 
-         
-         if(newNode == NULL)
-         	memoryFull = true; 
-         else
-         {
-         	
-         	newNode->numberMLS = tempMLS;
-		     	
-      	 	file >> newNode->price; 
-      	 
-      	 
-      	 	file >> tempStatus;
-      	
- 		 	newNode->status = static_cast<statusOptions>(tempStatus); 
-		  
-		 	file >> newNode->zipCode; 
-		 
-		 	getline(file, newNode->realtyCompany); 
-		 
-		 	newNode->realtyCompany.erase(0, 1);
-		     	
-		 	newNode->link = NULL; 
-		 
-		 	if (first == NULL)
-		 	{
-		 		first = newNode;
-				last = newNode;  			  
-		 	}
-		 	else
-		 	{
-		 		last->link = newNode;
-		 		last = newNode; 	
-		 	}
-		 
-		 	file >> tempMLS; 
-		 
-		 }
-	
-	     exists = true;
-	  
-	  }
-	   		 
+    	if (summary.fromSnapshot)
+    		cout << summary.recordsLoaded << " listings loaded from snapshot." << endl << endl; 
+    	
+    	if (summary.memoryFull)
+    		cout << "Memory is full. Only " << summary.recordsLoaded 
+    		     << " listings were loaded." << endl << endl; 
+    	
+    	if (summary.recordsRejected > 0)
+    		cout << summary.recordsRejected << " record(s) were skipped." << endl << endl; 
+    	
+    	// Changes from a session that ended without saving are recovered 
+    	if (!journalOpen(store, fileName, replayed, error))
+    		cout << "Warning: " << error << "." << endl << endl; 
+    	
+    	if (replayed > 0)
+    		cout << replayed << " unsaved change(s) recovered from the journal." << endl << endl; 
     }
     
     
@@ -299,167 +1474,626 @@ void readFile(ifstream& file, bool& exists, listingsInfo* &first, listingsInfo*
 
 //*****************************************************************************
 // FUNCTION: displayAll
-// DESCRIPTION: Formats and displays to screen all listings currently in list    
-// INPUT: Parameters: first - Pointer variable for first node in linked list  
-// last - Pointer variable for last node in linked list. 
-// OUTPUT: Outputs list contents directly to screen.   
+// DESCRIPTION: Formats and displays to screen all listings currently in store. 
+// A store of more than DISPLAY_PAGE_ROWS listings is shown a page at a time, 
+// in file order or sorted by MLS number, price or zip code, so only the 
+// pages asked for are formatted.    
+// INPUT: Parameters: store - listing store to display  
+// OUTPUT: Outputs store contents directly to screen.   
+// CALLS TO: selectListings, displayListingHeader, displayListingRows 
 //***************************************************************************** 
-void displayAll(listingsInfo* first, listingsInfo* last)
+void displayAll(listingStore& store)
 {
 	
 	// function local variables 
-	int counter; 				// to track and control number of lines of output
-	listingsInfo *current; 		// to hold the current node during each pass through loop 
+	listingPage page; 						// Order to show the listings in 
+	vector<uint32_t> rows; 					// Rows of the listings in that order 
+	char sortChoice; 						// To receive user input for the order 
+	char pageChoice; 						// To receive user input for the next page 
+	size_t first; 							// Position of the first listing of the page 
+	size_t last; 							// Position after the last listing of the page 
 	
-		
-	current = first;  
-			
 	
-	if (current == NULL)
+	if (store.liveRows == 0)
 		cout << "There are no listings currently stored." << endl; 
+	else if (store.liveRows <= DISPLAY_PAGE_ROWS)
+	{
+		selectListings(store, page, rows); 
+		displayListingHeader(); 
+		displayListingRows(cout, store, rows, 0, rows.size()); 
+		
+	cout << endl; 	
+		
+	}	
 	else
 	{
-		cout << right; 
-		cout << setw(15) << "Asking" << setw(11) << "Listing" << endl; 
-		cout << "MLS#" << setw(10) << "Price" << setw(11) << "Status" << setw(14) << "Zip Code" << setw(12) << "Realtor" << endl; 
-		cout << "------" << setw(10) << "-------" << setw(12) << "---------" << setw(13) << "----------" << setw(15) << "------------" << endl; 
- 		
+		do
+		{
+			cout << "Show the " << store.liveRows << " listings in (F)ile order, by (M)LS number, "
+			     << "(L)owest or (H)ighest price first, or by (Z)ip code: "; 
+			cin >> sortChoice; 
+			cout << endl << endl; 
+			
+			sortChoice = toupper(sortChoice); 
+			
+			if (sortChoice != 'F' && sortChoice != 'M' && sortChoice != 'L' && sortChoice != 'H' && sortChoice != 'Z')
+				cout << "Invalid input - Must be 'F', 'M', 'L', 'H' or 'Z'." << endl << endl; 
+		}
+		while (sortChoice != 'F' && sortChoice != 'M' && sortChoice != 'L' && sortChoice != 'H' && sortChoice != 'Z'); 
 		
-		while (current != NULL)
-		{
-		
-		cout << setprecision(0) << fixed; 
-		
-		
-			cout << left; 
-			cout << setw(10) << current->numberMLS
-       		     << setw(9) << current->price; 
-       		
-			cout << setw(12);         
-       	    switch(current->status) 
-       	    {
-       	    case AVAILABLE:
-			   cout << "Available"; 
-			   break;
-			case CONTRACT:
-			   cout << "Contract";
-			   break;
-			case SOLD:
-			   cout << "Sold"; 
-			   break;  
-       	    }
-       	    
-       	    cout << setw(13) << current->zipCode
-      	    	 << current->realtyCompany; 
-				   
-			current = current->link;	    
-       	    	 
-      	    cout << endl; 
+		switch (sortChoice)
+		{
+		case 'M':
+			page.sortKey = SORT_MLS; 
+			break; 
+		case 'L':
+		case 'H':
+			page.sortKey = SORT_PRICE; 
+			page.descending = (sortChoice == 'H'); 
+			break; 
+		case 'Z':
+			page.sortKey = SORT_ZIP; 
+			break; 
 		}
 		
-	cout << endl; 	
+		selectListings(store, page, rows); 
 		
-	}	
+		first = 0; 
+		pageChoice = 'N'; 
+		
+		while (pageChoice != MENU_CHAR)
+		{
+			last = (pageChoice == 'A') ? rows.size() : min(first + DISPLAY_PAGE_ROWS, rows.size()); 
+			
+			displayListingHeader(); 
+			displayListingRows(cout, store, rows, first, last); 
+			
+			cout << endl << "Listings " << first + 1 << " to " << last << " of " << rows.size() << "." << endl << endl; 
+			
+			if (last == rows.size())
+				break; 
+			
+			do
+			{
+				cout << "(N)ext page, (P)revious page, (A)ll remaining listings, or (M)enu: "; 
+				cin >> pageChoice; 
+				cout << endl << endl; 
+				
+				pageChoice = toupper(pageChoice); 
+				
+				if (pageChoice != 'N' && pageChoice != 'P' && pageChoice != 'A' && pageChoice != MENU_CHAR)
+					cout << "Invalid input - Must be 'N', 'P', 'A' or 'M'." << endl << endl; 
+			}
+			while (pageChoice != 'N' && pageChoice != 'P' && pageChoice != 'A' && pageChoice != MENU_CHAR); 
+			
+			if (pageChoice == 'P')
+				first = (first > DISPLAY_PAGE_ROWS) ? first - DISPLAY_PAGE_ROWS : 0; 
+			else
+				first = last; 
+		}
+	}
 	
 	
 }
 
 //*****************************************************************************
-// FUNCTION: AddListing
-// DESCRIPTION: Allows user to add new listings to linked list.    
-// INPUT: Parameters: first - Pointer variable for first node in linked list  
-// last - Pointer variable for last node in linked list. 
-// OUTPUT: reference parameters: first, last 
-// CALLS TO: ValidateMLS, ValidatePrice, ValidateZip, ValidateStatus, 
-// ValidateCompanyName 
+// FUNCTION: displayListingHeader
+// DESCRIPTION: Displays the column headings of a table of listings    
+// OUTPUT: Outputs headings directly to screen.   
 //***************************************************************************** 
-void AddListing(listingsInfo* &first, listingsInfo* &last)
+void displayListingHeader()
 {
-	char continueOption;       // For user prompt to add another listing 
-	listingsInfo *newNode; 	   // Pointer variable for new node
-	
-	do
-	{
-		 
-		 // To allocate memory for new node 
-		 newNode = new (nothrow) listingsInfo; 
-
-		 if(newNode == NULL)
-		 {
-		 	cout << "Memory is full. No more listings can be added." << endl << endl; 
-		 	
-		 	continueOption = NO; 
-		 	
-		 }
-		 else
-		 {
-		 
-	        // Function call to validate MLS number 
-	        newNode->numberMLS = ValidateMLS();
-	
-	        // Function call to validate price 
-	        newNode->price = ValidatePrice(); 
-	     
-	        // Function call to validate status 
-            newNode->status = ValidateStatus(); 
-         
-            // Function call to validate zip code 
-	        newNode->zipCode = ValidateZip(); 
-         
-            // Function call to validate zip code 
-	        newNode->realtyCompany = ValidateCompanyName(); 
-	     
-	        newNode->link = NULL; 
-	     
-	     
-	        if (first == NULL)
-	        {
-	     	   first = newNode;
-	     	
-	     	   last = newNode;	
-	     	
-	        }
-	        else
-	        {
-	     	   last->link = newNode;
-	     	
-	     	   last = newNode; 
-	     	
-	        }
-	     
-	 	}
-	  
-	
-		 if(newNode != NULL)
-	     	do
-	     	{
-	     		cout << "Do you wish to add another listing (Y/N)?: ";
-	     		cin >> continueOption; 
-	     		cout << endl << endl; 
-	
-	     		continueOption = toupper(continueOption); 
-	
-	     		if (continueOption != YES && continueOption != NO)
-		     		cout << "Invalid Input: Must be 'Y' or 'N'." << endl << endl; 
-	     	}
-	     while(continueOption != YES && continueOption != NO); 
-	
-    }
-	while(continueOption != NO);
-	
+		cout << right; 
+		cout << setw(15) << "Asking" << setw(11) << "Listing" << endl; 
+		cout << "MLS#" << setw(10) << "Price" << setw(11) << "Status" << setw(14) << "Zip Code" << setw(12) << "Realtor" << endl; 
+		cout << "------" << setw(10) << "-------" << setw(12) << "---------" << setw(13) << "----------" << setw(15) << "------------" << endl; 
+ 		
 }
 
-
 //*****************************************************************************
-// FUNCTION: ValidateMLS
-// DESCRIPTION: Validates formatting of MLS number input by user.    
-// INPUT: Prompts for input directly from user. 
-// OUTPUT: Return value: inputMLS - validated MLS number 
+// FUNCTION: displayListingRows
+// DESCRIPTION: Displays listings as rows of a table. Rows are formatted into 
+// a large buffer and written a block at a time, so the screen is not 
+// flushed for every listing.    
+// INPUT: Parameters: out - stream to write to 
+// store - listing store holding the listings 
+// rows - rows of the listings 
+// first, last - positions in rows of the first listing and after the last 
+// OUTPUT: Outputs the listings to out.   
+// CALLS TO: formatListingRow 
 //***************************************************************************** 
-int ValidateMLS()
+void displayListingRows(ostream& out, const listingStore& store, const vector<uint32_t>& rows, 
+                        size_t first, size_t last)
+{
+	// variables 
+	operationTimer timer(OPERATION_DISPLAY, false); 	// Adds the display to the metrics 
+	vector<char> buffer; 			// Rows formatted since the last write 
+	char *position; 				// Where the next row goes 
+	char *bufferEnd; 				// End of the buffer 
+	size_t rowBytes; 				// Room needed for the next row 
+	size_t match; 					// Position in rows of the listing being formatted 
+
+	buffer.resize(min(DISPLAY_BUFFER_BYTES, (last - first + 1) * LINE_RESERVE_BYTES)); 
+	position = buffer.data(); 
+	bufferEnd = buffer.data() + buffer.size(); 
+
+	for (match = first; match < last; match++)
+	{
+		// Every column but the company name fits in LINE_RESERVE_BYTES 
+		rowBytes = LINE_RESERVE_BYTES + store.companyNames[store.company[rows[match]]].size(); 
+
+		if (bufferEnd - position < static_cast<ptrdiff_t>(rowBytes))
+		{
+			out.write(buffer.data(), position - buffer.data()); 
+			timer.bytesWritten += position - buffer.data(); 
+
+			if (rowBytes > buffer.size())
+				buffer.resize(rowBytes); 
+
+			position = buffer.data(); 
+			bufferEnd = buffer.data() + buffer.size(); 
+		}
+
+		position = formatListingRow(position, store, rows[match]); 
+	}
+
+	out.write(buffer.data(), position - buffer.data()); 
+	out.flush(); 
+
+	timer.bytesWritten += position - buffer.data(); 
+	timer.recordsParsed = last - first; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: formatListingRow
+// DESCRIPTION: Formats one listing as a row of a table of listings, in the 
+// columns under displayListingHeader, with the price in whole dollars. The 
+// caller provides LINE_RESERVE_BYTES plus the length of the company name.    
+// INPUT: Parameters: position - where the row goes 
+// store - listing store holding the listing  
+// row - row of the listing 
+// OUTPUT: Return value: the position after the row 
+// CALLS TO: padColumn, formatZip 
+//***************************************************************************** 
+char* formatListingRow(char* position, const listingStore& store, uint32_t row)
+{
+	// variables 
+	char *start; 				// Start of the column being formatted 
+	const char *statusText; 	// Status of the listing as text 
+	const string *company; 		// Company name of the listing 
+
+	start = position; 
+	position = to_chars(position, start + LINE_RESERVE_BYTES, store.mls[row]).ptr; 
+	position = padColumn(start, position, 10); 
+
+	start = position; 
+	position = to_chars(position, start + LINE_RESERVE_BYTES, static_cast<double>(store.price[row]) / CENTS_PER_DOLLAR, 
+	                    chars_format::fixed, 0).ptr; 
+	position = padColumn(start, position, 9); 
+
+	switch (store.status[row])
+	{
+	case AVAILABLE:
+		statusText = "Available"; 
+		break; 
+	case CONTRACT:
+		statusText = "Contract"; 
+		break; 
+	default:
+		statusText = "Sold"; 
+		break; 
+	}
+
+	start = position; 
+	memcpy(position, statusText, strlen(statusText)); 
+	position = padColumn(start, position + strlen(statusText), 12); 
+
+	start = position; 
+	formatZip(store.zip[row], position); 
+	position = padColumn(start, position + strlen(position), 13); 
+
+	company = &store.companyNames[store.company[row]]; 
+	memcpy(position, company->data(), company->size()); 
+	position += company->size(); 
+	*position++ = '\n'; 
+
+	return position; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: padColumn
+// DESCRIPTION: Pads a column of a table row with spaces to its width, as 
+// left << setw(width) did. A column already as wide is left as it is. 
+// INPUT: Parameters: start - start of the column 
+// position - end of the text of the column 
+// width - width of the column 
+// OUTPUT: Return value: the position after the column 
+//***************************************************************************** 
+char* padColumn(char* start, char* position, size_t width)
+{
+	if (static_cast<size_t>(position - start) < width)
+	{
+		memset(position, ' ', width - (position - start)); 
+		position = start + width; 
+	}
+
+	return position; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: selectListings
+// DESCRIPTION: Finds the rows of the listings on a page, in the order to 
+// show them. File order walks the store only as far as the page; listings 
+// added in freed rows come after the rest, as they are saved. Price 
+// order walks the price index, again only as far as the page. MLS and zip 
+// code order sort a key for each listing, putting only the listings up to 
+// the end of the page in order. Listings with equal keys are shown in file 
+// order, and a descending order is the ascending order reversed. 
+// INPUT: Parameters: store - listing store to display 
+// page - order, offset and number of the listings to show 
+// rows - receives the rows of the listings on the page 
+// OUTPUT: reference parameters: store, rows 
+// CALLS TO: storeSavedRows, priceScan 
+//***************************************************************************** 
+void selectListings(listingStore& store, const listingPage& page, vector<uint32_t>& rows)
+{
+	// variables 
+	size_t wanted; 					// Listings on the page 
+	size_t passed; 					// Listings passed over before the page 
+	size_t step; 					// Rows walked so far 
+	vector<uint32_t> order; 		// Rows in saved order, if listings were added in freed rows 
+	size_t rowCount; 				// Rows in file order 
+	size_t place; 					// Place in file order of the row 
+	uint32_t row; 					// Row being checked 
+	uint64_t key; 					// Sort key of the row above its place in file order 
+	listingQuery query; 			// Price order to walk the price index in 
+	vector<uint64_t> keys; 			// Sort key of each listing above its place in file order 
+	size_t index; 					// Key being copied to rows 
+
+	rows.clear(); 
+
+	if (page.offset >= store.liveRows)
+		return; 
+
+	wanted = store.liveRows - page.offset; 
+
+	if (page.limit > 0 && page.limit < wanted)
+		wanted = page.limit; 
+
+	rows.reserve(wanted); 
+
+	if (page.sortKey != SORT_PRICE && !store.addedRows.empty())
+		storeSavedRows(store, order); 
+
+	rowCount = order.empty() ? store.mls.size() : order.size(); 
+
+	if (page.sortKey == SORT_FILE_ORDER)
+	{
+		passed = 0; 
+
+		for (step = 0; step < rowCount && rows.size() < wanted; step++)
+		{
+			place = page.descending ? rowCount - 1 - step : step; 
+			row = order.empty() ? place : order[place]; 
+
+			if (store.status[row] == STATUS_DELETED)
+				continue; 
+
+			if (passed < page.offset)
+				passed++; 
+			else
+				rows.push_back(row); 
+		}
+	}
+	else if (page.sortKey == SORT_PRICE)
+	{
+		query.order = page.descending ? QUERY_HIGHEST : QUERY_LOWEST; 
+		query.limit = page.offset + wanted; 
+
+		priceScan(store, query, rows); 
+		rows.erase(rows.begin(), rows.begin() + min(page.offset, rows.size())); 
+	}
+	else
+	{
+		keys.reserve(store.liveRows); 
+
+		for (place = 0; place < rowCount; place++)
+		{
+			row = order.empty() ? place : order[place]; 
+
+			if (store.status[row] == STATUS_DELETED)
+				continue; 
+
+			key = static_cast<uint64_t>((page.sortKey == SORT_MLS) ? store.mls[row] : store.zip[row]) << 32 | place; 
+
+			// Complementing the key reverses the order, ties included 
+			keys.push_back(page.descending ? ~key : key); 
+		}
+
+		if (page.offset + wanted < keys.size())
+			nth_element(keys.begin(), keys.begin() + page.offset + wanted, keys.end()); 
+
+		if (page.offset > 0)
+			nth_element(keys.begin(), keys.begin() + page.offset, keys.begin() + page.offset + wanted); 
+
+		sort(keys.begin() + page.offset, keys.begin() + page.offset + wanted); 
+
+		for (index = page.offset; index < page.offset + wanted; index++)
+		{
+			place = static_cast<uint32_t>(page.descending ? ~keys[index] : keys[index]); 
+			rows.push_back(order.empty() ? place : order[place]); 
+		}
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: parsePageText
+// DESCRIPTION: Reads the listings to display written as "name=value" terms 
+// separated by spaces, such as "sort=-price offset=100 limit=50", or "*" 
+// for every listing in file order. 
+// INPUT: Parameters: text - page text 
+// page - receives the order, offset and number of listings 
+// error - receives the reason the text is not understood 
+// OUTPUT: reference parameters: page, error 
+// Return value: false if the text is not understood 
+// CALLS TO: parseSortKey 
+//***************************************************************************** 
+bool parsePageText(const string& text, listingPage& page, string& error)
+{
+	// variables 
+	istringstream words; 		// To split the text into words 
+	string word; 				// Word being read 
+	string name; 				// Name of the term 
+	string_view value; 			// Value of the term 
+	size_t equals; 				// Position of '=' in the word 
+	from_chars_result result; 	// Result of converting a number 
+	size_t number; 				// Number converted 
+
+	page = listingPage(); 
+
+	if (text == "*")
+		return true; 
+
+	words.str(text); 
+
+	while (words >> word)
+	{
+		equals = word.find('='); 
+
+		if (equals == string::npos)
+		{
+			error = "expected name=value, found \"" + word + "\""; 
+			return false; 
+		}
+
+		name = word.substr(0, equals); 
+		value = string_view(word).substr(equals + 1); 
+
+		if (name == "sort")
+		{
+			if (!parseSortKey(value, page.sortKey, page.descending))
+			{
+				error = "sort must be file, mls, price or zip, with '-' for largest first"; 
+				return false; 
+			}
+		}
+		else if (name == "offset" || name == "limit")
+		{
+			result = from_chars(value.data(), value.data() + value.size(), number); 
+
+			if (value.empty() || result.ec != errc() || result.ptr != value.data() + value.size())
+			{
+				error = name + " must be a number of listings"; 
+				return false; 
+			}
+
+			(name == "offset" ? page.offset : page.limit) = number; 
+		}
+		else
+		{
+			error = "unknown term \"" + name + "\""; 
+			return false; 
+		}
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseSortKey
+// DESCRIPTION: Converts the name of the order to display listings in: file, 
+// mls, price or zip, with a leading '-' for the largest first. 
+// INPUT: Parameters: text - name of the order 
+// sortKey - receives SORT_FILE_ORDER, SORT_MLS, SORT_PRICE or SORT_ZIP 
+// descending - receives whether the largest key is shown first 
+// OUTPUT: reference parameters: sortKey, descending 
+// Return value: false if the name is not understood 
+//***************************************************************************** 
+bool parseSortKey(string_view text, int& sortKey, bool& descending)
+{
+	descending = !text.empty() && text[0] == '-'; 
+
+	if (descending)
+		text.remove_prefix(1); 
+
+	if (text == "file")
+		sortKey = SORT_FILE_ORDER; 
+	else if (text == "mls")
+		sortKey = SORT_MLS; 
+	else if (text == "price")
+		sortKey = SORT_PRICE; 
+	else if (text == "zip")
+		sortKey = SORT_ZIP; 
+	else
+		return false; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: displayMlsNumbers
+// DESCRIPTION: Displays the MLS numbers of all listings, MAX_PER_LINE to a 
+// line, formatted into a buffer and written a block at a time. They are 
+// shown in file order, with listings added in freed rows after the rest. 
+// INPUT: Parameters: out - stream to write to 
+// store - listing store holding the listings 
+// OUTPUT: Outputs the MLS numbers to out. 
+// CALLS TO: storeSavedRows 
+//***************************************************************************** 
+void displayMlsNumbers(ostream& out, const listingStore& store)
+{
+	// variables 
+	vector<char> buffer; 		// MLS numbers formatted since the last write 
+	char *position; 			// Where the next MLS number goes 
+	char *bufferEnd; 			// End of the buffer 
+	int lineCounter = 0; 		// Counter to control number of MLS numbers per line 
+	vector<uint32_t> order; 	// Rows in saved order, if listings were added in freed rows 
+	size_t index; 				// Place in file order of the row 
+	uint32_t row; 				// Row being displayed 
+
+	buffer.resize(DISPLAY_BUFFER_BYTES); 
+	position = buffer.data(); 
+	bufferEnd = buffer.data() + buffer.size(); 
+
+	if (!store.addedRows.empty())
+		storeSavedRows(store, order); 
+
+	for (index = 0; index < (order.empty() ? store.mls.size() : order.size()); index++)
+	{
+		row = order.empty() ? index : order[index]; 
+
+		if (store.status[row] == STATUS_DELETED)
+			continue; 
+
+		if (bufferEnd - position < static_cast<ptrdiff_t>(LINE_RESERVE_BYTES))
+		{
+			out.write(buffer.data(), position - buffer.data()); 
+			position = buffer.data(); 
+		}
+
+		position = to_chars(position, bufferEnd, store.mls[row]).ptr; 
+		lineCounter++; 
+
+		if (lineCounter < MAX_PER_LINE)
+			*position++ = ' '; 
+		else
+		{
+			*position++ = '\n'; 
+			lineCounter = 0; 
+		}
+	}
+
+	out.write(buffer.data(), position - buffer.data()); 
+	out.flush(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: AddListing
+// DESCRIPTION: Allows user to add new listings to the store.    
+// INPUT: Parameters: store - listing store to add to  
+// OUTPUT: reference parameter: store 
+// CALLS TO: ValidateMLS, ValidatePrice, ValidateZip, ValidateStatus, 
+// ValidateCompanyName, indexFind, packZip, dollarsToCents, storeAppend, storeFull, 
+// journalCommit 
+//***************************************************************************** 
+void AddListing(listingStore& store)
+{
+	char continueOption;       // For user prompt to add another listing 
+	listingsInfo newListing;   // To hold the fields entered for the new listing 
+	uint32_t packedZip; 	   // Zip code of the new listing packed for the store 
+	int64_t priceCents = 0;    // Price of the new listing in cents for the store 
+	bool duplicateMLS; 		   // To track whether MLS number is already on file 
+	
+	do
+	{
+		 // To check that the memory budget leaves room before prompting 
+		 if (storeFull(store))
+		 {
+		 	cout << "Memory is full. No more listings can be added." << endl << endl; 
+		 	
+		 	continueOption = NO; 
+		 }
+		 else
+		 {
+		 
+		     // Function call to validate MLS number, which must not already be on file 
+		     do
+		     {
+		     	newListing.numberMLS = ValidateMLS();
+	     	
+		     	duplicateMLS = (indexFind(store, newListing.numberMLS) != NO_ROW); 
+	     	
+		     	if (duplicateMLS)
+		     		cout << "A listing with MLS number " << newListing.numberMLS 
+		     		     << " already exists." << endl << endl; 
+		     }
+		     while (duplicateMLS); 
+	
+		     // Function call to validate price 
+		     newListing.price = ValidatePrice(); 
+	  
+		     // Function call to validate status 
+	         newListing.status = ValidateStatus(); 
+      
+	         // Function call to validate zip code 
+		     newListing.zipCode = ValidateZip(); 
+      
+	         // Function call to validate zip code 
+		     newListing.realtyCompany = ValidateCompanyName(); 
+	     
+		     packZip(newListing.zipCode, packedZip); 
+		     dollarsToCents(newListing.price, priceCents); 
+	     
+			 if (storeAppend(store, newListing.numberMLS, priceCents, newListing.status, 
+			                 packedZip, newListing.realtyCompany) == NO_ROW)
+			 {
+			 	cout << "Memory is full. No more listings can be added." << endl << endl; 
+		 	
+			 	continueOption = NO; 
+		 	
+			 }
+			 else
+			 {
+			 	journalCommit(store); 
+			 	
+		     	do
+		     	{
+		     		cout << "Do you wish to add another listing (Y/N)?: ";
+		     		cin >> continueOption; 
+		     		cout << endl << endl; 
+	
+		     		continueOption = toupper(continueOption); 
+	
+		     		if (continueOption != YES && continueOption != NO)
+			     		cout << "Invalid Input: Must be 'Y' or 'N'." << endl << endl; 
+		     	}
+		     	while(continueOption != YES && continueOption != NO); 
+			 }
+	
+		 }
+	
+    }
+	while(continueOption != NO);
+	
+}
+
+//*****************************************************************************
+// FUNCTION: ValidateMLS
+// DESCRIPTION: Validates formatting of MLS number input by user.    
+// INPUT: Prompts for input directly from user. 
+// OUTPUT: Return value: inputMLS - validated MLS number 
+//***************************************************************************** 
+int ValidateMLS()
 {
 	// Local variable 
-	int inputMLS; 		// To receive MLS number input by user 
+	int inputMLS = 0; 	// To receive MLS number input by user 
 	
 		
 		while (inputMLS < MLS_MIN || inputMLS > MLS_MAX)
@@ -487,7 +2121,8 @@ int ValidateMLS()
 
 //*****************************************************************************
 // FUNCTION: ValidatePrice
-// DESCRIPTION: Validates that price entered by user is greater than "0.00".     
+// DESCRIPTION: Validates that price entered by user is greater than "0.00" 
+// and no more than MAX_PRICE_DOLLARS.     
 // INPUT: Prompts for input directly from user. 
 // OUTPUT: Return value: price - validated price of listing 
 //***************************************************************************** 
@@ -496,7 +2131,7 @@ double ValidatePrice()
 	// local variable 
 	double price = 0.00;		// To receive price from user 
 	
-	while (price <= 0.00)
+	while (price <= 0.00 || price > MAX_PRICE_DOLLARS)
 	{
 	cout << "Please enter price of listing: ";
 	cin >> price; 
@@ -504,6 +2139,9 @@ double ValidatePrice()
 	
 	if (price <= 0.00)
 		cout << "Price must be greater than $0.00. Try again." << endl; 
+	else if (price > MAX_PRICE_DOLLARS)
+		cout << "Price must be no more than $" << fixed << setprecision(0) << MAX_PRICE_DOLLARS 
+		     << ". Try again." << endl; 
 	}
 	
 	return price; 
@@ -628,6 +2266,7 @@ statusOptions ValidateStatus()
 // DESCRIPTION: Validates formatting of company name input by user.     
 // INPUT: Prompts for input directly from user. 
 // OUTPUT: Return value: companyName - validated company name.  
+// CALLS TO: titleCaseCompany 
 //*****************************************************************************  
 string ValidateCompanyName()
 {
@@ -669,17 +2308,7 @@ string ValidateCompanyName()
 	
 	
 	// To format user input correctly into uppercase and lowercase characters 
-	index = 0; 
-	companyName[index] = toupper(companyName[index]); 
-	
-	for(index = 1; index < lengthOfName; index++) 
-	{
-		if(isspace(companyName[index - 1]))
-			companyName[index] = toupper(companyName[index]); 
-		else
-		  	companyName[index] = tolower(companyName[index]); 	
-		
-	}
+	titleCaseCompany(companyName); 
 	
 	
 	return companyName; 
@@ -688,91 +2317,45 @@ string ValidateCompanyName()
 
 //*****************************************************************************
 // FUNCTION: DeleteRecord
-// DESCRIPTION: Allows user to delete listing from linked list.    
-// INPUT: Parameters: first - Pointer variable for first node in linked list
-// last - Pointer variable for last node in linked list.   
-// OUTPUT: reference parameter: first 
+// DESCRIPTION: Allows user to delete listing from the store.    
+// INPUT: Parameters: store - listing store to delete from 
+// OUTPUT: reference parameter: store 
+// CALLS TO: displayMlsNumbers, ValidateMLS, indexFind, storeRemove, journalCommit, storeCompact 
 //***************************************************************************** 
-void DeleteRecord(listingsInfo* &first, listingsInfo* last)
+void DeleteRecord(listingStore& store)
 {
 	
 	// variables		
-	int lineCounter = 0;		// Counter to control number of MLS numbers per line
 	int mlsToSearch; 			// To receive input from user 
-	bool found; 				// To track whether node node to delete has been found  
-	listingsInfo *current; 		// To hold current node in loop to display MLS numbers to screen
-	listingsInfo *searchNode;	// To hold current node in loop to search for Node to delete 
-	listingsInfo *previous; 	// To hold previous node in loop to search for Node to delete 
-		
-	current = first; 
+	uint32_t searchRow;			// To hold row to delete 
 	
-	if(current == NULL)
+	if(store.liveRows == 0)
 		cout << "There are no records currently on file." << endl << endl; 
 	else
 	{
 	    
 	   cout << "Please select MLS number from the choices below:" << endl << endl;   
 	
-	   while(current != NULL)
-	   {
-	      lineCounter++; 
-		
-		   if (lineCounter < MAX_PER_LINE)
-			   cout << current->numberMLS << " "; 
-		   else
-		   { 
-			   cout << current->numberMLS << endl;
-			
-			   lineCounter = 0; 
-		   }
-				
-		   current = current->link;
-	   }
+	   displayMlsNumbers(cout, store); 
 	   
 	   cout << endl << endl; 
 	   
 	   // Function call to validate MLS number to search 
 	   mlsToSearch = ValidateMLS();  
 	   
-	   // To set found to false prior to search 
-	   found = false; 
-	   
-	   searchNode = first; 
-	   
-	   while (searchNode != NULL && !found)
-	   		if (searchNode->numberMLS == mlsToSearch)
-	   			found = true; 
-	   		else 
-	   		{
-	   			previous = searchNode; 
-	   			searchNode = searchNode->link;	   
-			}
+	   searchRow = indexFind(store, mlsToSearch); 
 	
-	   if (!found)
+	   if (searchRow == NO_ROW)
 	   	  cout << "Listing not found in records." << endl << endl;
-		
-		 	 
-	
-	   if (found)
+	   else
 	   {
-	   	
-	   		if(searchNode == first && first == last)
-	   			first = NULL; 
-	   		else if (searchNode == first && first != last)
-	   		{
-	   			first = searchNode->link; 
-	   			
-	   			delete searchNode; 
-	   			
-	   		}
-	   		else
-	   		{
-	   	
-	   		previous->link = previous->link->link; 
+	   		// The row is kept on the free list for the next listing added 
+	   		storeRemove(store, searchRow); 
+	   		journalCommit(store); 
 	   		
-	   		delete searchNode;
-			   
-			}
+	   		// Deleted rows are only reclaimed once they are a large share of the store 
+	   		if (store.deletedRows * COMPACT_DIVISOR > store.mls.size())
+	   			storeCompact(store); 
 	   
 	   
 	   cout << "The listing for MLS Number " << mlsToSearch << " has been deleted." << endl << endl;
@@ -784,206 +2367,11039 @@ void DeleteRecord(listingsInfo* &first, listingsInfo* last)
 }
 
 //*****************************************************************************
-// FUNCTION: SaveToFile
-// DESCRIPTION: Allows user to save changes to file before exiting program.    
-// INPUT: Parameters: outputFile - variable for output file to save changes 
-// first - Pointer variable for first node in linked list 
-// OUTPUT: reference parameters: outputFile, first 
+// FUNCTION: BulkDeleteListings
+// DESCRIPTION: Allows user to delete the listings of many MLS numbers at 
+// once, typed on one line or listed in a file.    
+// INPUT: Parameters: store - listing store to delete from 
+// OUTPUT: reference parameter: store 
+// CALLS TO: parseMlsList, deleteListings, deleteListingsFile 
 //***************************************************************************** 
-void SaveToFile(ofstream& outputFile, listingsInfo* first)
+void BulkDeleteListings(listingStore& store)
 {
-	// variable 
-	int counter;			// To provide index during loop for output to file 
-	char saveOption;		// For user input to save changes or not 
-	char confirm;   		// To confirm if user wishes to exit 
-	string fileName;		// To receive user input for file name 
-	char fileOption; 		// To recieve user confirmation to write over file 
-	ifstream testFile; 		// To open file as an ifstream to test if it already exists.
-	listingsInfo *current;  // To track current node during output loop   
+	// variables 
+	string input; 				// MLS numbers or file name entered by user 
+	vector<uint32_t> mlsNumbers; 	// MLS numbers entered 
+	int deleted; 				// Listings deleted 
+	int notFound; 				// MLS numbers that were not on file 
 	
-	do
-	{
-	do
+	if (store.liveRows == 0)
 	{
-	cout << "Do you wish to save changes to the file before exiting (Y/N)?: "; 
-	cin >> saveOption; 
-	cout << endl; 
-	
-	saveOption = toupper(saveOption); 
+		cout << "There are no records currently on file." << endl << endl; 
+		return; 
+	}
 	
+	cin.ignore(); 
+	cout << "Enter the MLS numbers to delete, separated by spaces, or the name of a file of MLS numbers: "; 
+	getline(cin, input); 
+	cout << endl << endl; 
 	
-	if (saveOption != YES && saveOption != NO) 
-		cout << "Invalid Input - Must be 'Y' or 'N'" << endl << endl;
+	if (!input.empty() && isdigit(static_cast<unsigned char>(input[0])))
+	{
+		parseMlsList(input, mlsNumbers); 
+		deleteListings(store, mlsNumbers, deleted, notFound); 
+	}
+	else if (!deleteListingsFile(input, store, deleted, notFound))
+	{
+		cout << "Error: file of MLS numbers not found." << endl << endl; 
+		return; 
 	}
-	while (saveOption != YES && saveOption != NO); 
 	
+	cout << deleted << " listing(s) deleted."; 
 	
-	if(saveOption == YES)
+	if (notFound > 0)
+		cout << " " << notFound << " MLS number(s) were not on file."; 
+	
+	cout << endl << endl; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: QueryListings
+// DESCRIPTION: Allows user to display the listings matching a status, a zip 
+// code or zip code prefix, a realty company and a price range, any of which 
+// may be left open, either all in file order or a number of the highest or 
+// lowest priced.    
+// INPUT: Parameters: store - listing store to search 
+// OUTPUT: Outputs matching listings directly to screen. 
+// CALLS TO: parseStatusCode, parseZipPattern, parsePriceRange, 
+// parseListingOrder, runQuery, displayListingHeader, displayListingRows 
+//***************************************************************************** 
+void QueryListings(listingStore& store)
+{
+	// variables 
+	listingQuery query; 		// Conditions entered by the user 
+	char inputStatus; 			// To receive user input for status 
+	string zipInput; 			// To receive user input for zip code 
+	string priceInput; 			// To receive user input for price range 
+	string orderInput; 			// To receive user input for listings to show 
+	vector<uint32_t> rows; 		// Rows of the matching listings 
+
+	if (store.liveRows == 0)
 	{
-		do
-		{
-		cout << "Please enter the name of the file to which to save: "; 
-		cin >> fileName; 
-		cout << endl; 
-		
-		fileOption = EXISTING_FILE; 
+		cout << "There are no listings currently stored." << endl << endl; 
+		return; 
+	}
+
+	do
+	{
+		cout << "Status to match ('A', 'C', 'S', or '*' for any): "; 
+		cin >> inputStatus; 
+		cout << endl; 
+
+		inputStatus = toupper(inputStatus); 
+
+		if (!parseStatusCode(inputStatus, query.status))
+			cout << "Invalid input - Must be 'A', 'C', 'S' or '*'." << endl << endl; 
+	}
+	while (!parseStatusCode(inputStatus, query.status)); 
+
+	do
+	{
+		cout << "Zip code or prefix to match (such as 80513-2918, 80513 or 805, or '*' for any): "; 
+		cin >> zipInput; 
+		cout << endl; 
+
+		if (!parseZipPattern(zipInput, query.zipPrefix, query.zipDigits))
+			cout << "Invalid input - Must be a zip code, its first 5 or 3 digits, or '*'." << endl << endl; 
+	}
+	while (!parseZipPattern(zipInput, query.zipPrefix, query.zipDigits)); 
+
+	cin.ignore(); 
+	cout << "Realty company to match (or '*' for any): "; 
+	getline(cin, query.company); 
+	cout << endl; 
+
+	if (query.company == "*")
+		query.company.clear(); 
+
+	do
+	{
+		cout << "Price range to match (such as 150000-250000, or '*' for any): "; 
+		cin >> priceInput; 
+		cout << endl; 
+
+		if (!parsePriceRange(priceInput, query.minPrice, query.maxPrice))
+			cout << "Invalid input - Must be a price, a range of prices, or '*'." << endl << endl; 
+	}
+	while (!parsePriceRange(priceInput, query.minPrice, query.maxPrice)); 
+
+	do
+	{
+		cout << "Listings to show ('*' for all, or such as H20 or L20 for the 20 highest or lowest priced): "; 
+		cin >> orderInput; 
+		cout << endl << endl; 
+
+		if (!parseListingOrder(orderInput, query.order, query.limit))
+			cout << "Invalid input - Must be '*', or 'H' or 'L' followed by a number." << endl << endl; 
+	}
+	while (!parseListingOrder(orderInput, query.order, query.limit)); 
+
+	runQuery(store, query, rows); 
+
+	if (rows.empty())
+		cout << "No listings match." << endl << endl; 
+	else
+	{
+		displayListingHeader(); 
+
+		displayListingRows(cout, store, rows, 0, rows.size()); 
+
+		cout << endl << rows.size() << " listing(s) found." << endl << endl; 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: runQuery
+// DESCRIPTION: Finds the rows of the listings matching a query. Of the 
+// conditions given, the one whose secondary index holds the fewest rows 
+// supplies the candidates, and the other conditions are checked against 
+// the columns of each candidate, so a selective query takes time in 
+// proportion to the rows of its most selective condition. A query with no 
+// conditions returns every listing. Rows are returned in file order, with 
+// listings added in freed rows after the rest, unless the query asks for 
+// the highest or lowest priced listings, which are found by walking the 
+// price index and returned in price order. 
+// INPUT: Parameters: store - listing store to search 
+// query - conditions to match 
+// rows - receives the rows of the matching listings 
+// OUTPUT: reference parameters: store, rows 
+// CALLS TO: queryCompanyIds, queryMatches, priceRangeSize, priceScan, 
+// storeFileOrder 
+//***************************************************************************** 
+void runQuery(listingStore& store, const listingQuery& query, vector<uint32_t>& rows)
+{
+	// variables 
+	operationTimer timer(OPERATION_QUERY, false); 	// Adds the query to the metrics 
+	vector<uint32_t> companyIds; 		// Ids of the company names matched 
+	size_t fewest; 						// Rows of the most selective condition so far 
+	size_t candidates; 					// Rows of the condition being weighed 
+	int source; 						// Condition supplying the candidates 
+	size_t zip5; 						// 5-digit zip code being gathered 
+	size_t zip5Count; 					// 5-digit zip codes the zip condition covers 
+	size_t list; 						// Row list being gathered 
+	size_t member; 						// Row of the list being checked 
+	size_t word; 						// Word of the status bitmap being scanned 
+	uint64_t bits; 						// Rows of the word still to check 
+	uint32_t row; 						// Candidate row 
+
+	rows.clear(); 
+
+	if (query.order != QUERY_ROW_ORDER)
+	{
+		priceScan(store, query, rows); 
+		return; 
+	}
+
+	fewest = store.liveRows; 
+	source = QUERY_ALL_ROWS; 
+
+	if (!query.company.empty())
+	{
+		queryCompanyIds(store, query.company, companyIds); 
+
+		fewest = 0; 
+		source = QUERY_COMPANY; 
+
+		for (list = 0; list < companyIds.size(); list++)
+			if (companyIds[list] < store.companyRows.size())
+				fewest += store.companyRows[companyIds[list]].size(); 
+	}
+
+	zip5 = 0; 
+	zip5Count = (query.zipDigits == 3) ? ZIP5_COUNT / ZIP3_COUNT : 1; 
+
+	if (query.zipDigits > 0 && !store.zipRows.empty())
+	{
+		zip5 = (query.zipDigits == 3) ? query.zipPrefix * zip5Count 
+		                              : (query.zipDigits == 5 ? query.zipPrefix : query.zipPrefix / ZIP4_COUNT); 
+		candidates = 0; 
+
+		for (list = 0; list < zip5Count; list++)
+			candidates += store.zipRows[zip5 + list].size(); 
+
+		if (candidates < fewest)
+		{
+			fewest = candidates; 
+			source = QUERY_ZIP; 
+		}
+	}
+
+	if (query.status != QUERY_ANY_STATUS && static_cast<size_t>(store.statusCounts[query.status]) < fewest)
+	{
+		fewest = store.statusCounts[query.status]; 
+		source = QUERY_STATUS; 
+	}
+
+	if (query.minPrice > INT64_MIN || query.maxPrice < INT64_MAX)
+	{
+		// Stale entries are counted too, so this may overstate the range 
+		if (priceRangeSize(store, query.minPrice, query.maxPrice) < fewest)
+			source = QUERY_PRICE; 
+	}
+
+	if (source == QUERY_COMPANY)
+	{
+		for (list = 0; list < companyIds.size(); list++)
+			if (companyIds[list] < store.companyRows.size())
+				for (member = 0; member < store.companyRows[companyIds[list]].size(); member++)
+					if (queryMatches(store, store.companyRows[companyIds[list]][member], query))
+						rows.push_back(store.companyRows[companyIds[list]][member]); 
+	}
+	else if (source == QUERY_ZIP)
+	{
+		for (list = 0; list < zip5Count; list++)
+			for (member = 0; member < store.zipRows[zip5 + list].size(); member++)
+				if (queryMatches(store, store.zipRows[zip5 + list][member], query))
+					rows.push_back(store.zipRows[zip5 + list][member]); 
+	}
+	else if (source == QUERY_STATUS)
+	{
+		for (word = 0; word < store.statusBits[query.status].size(); word++)
+		{
+			bits = store.statusBits[query.status][word]; 
+
+			while (bits != 0)
+			{
+				row = word * 64 + __builtin_ctzll(bits); 
+				bits &= bits - 1; 
+
+				if (queryMatches(store, row, query))
+					rows.push_back(row); 
+			}
+		}
+	}
+	else if (source == QUERY_PRICE)
+		priceScan(store, query, rows); 
+	else
+	{
+		for (row = 0; row < store.mls.size(); row++)
+			if (store.status[row] != STATUS_DELETED && queryMatches(store, row, query))
+				rows.push_back(row); 
+	}
+
+	// Row lists and the price index are not kept in row order 
+	if (source == QUERY_COMPANY || source == QUERY_ZIP || source == QUERY_PRICE)
+		sort(rows.begin(), rows.end()); 
+
+	storeFileOrder(store, rows); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: queryMatches
+// DESCRIPTION: Checks a listing against every condition of a query. 
+// INPUT: Parameters: store - listing store holding the listing 
+// row - row of the listing 
+// query - conditions to match 
+// OUTPUT: Return value: true if the listing matches 
+// CALLS TO: sameCompanyName 
+//***************************************************************************** 
+bool queryMatches(const listingStore& store, uint32_t row, const listingQuery& query)
+{
+	if (query.status != QUERY_ANY_STATUS && store.status[row] != query.status)
+		return false; 
+
+	if (query.zipDigits == 3 && store.zip[row] / (ZIP4_COUNT * ZIP5_COUNT / ZIP3_COUNT) != query.zipPrefix)
+		return false; 
+
+	if (query.zipDigits == 5 && store.zip[row] / ZIP4_COUNT != query.zipPrefix)
+		return false; 
+
+	if (query.zipDigits == 9 && store.zip[row] != query.zipPrefix)
+		return false; 
+
+	if (store.price[row] < query.minPrice || store.price[row] > query.maxPrice)
+		return false; 
+
+	return query.company.empty() || sameCompanyName(store.companyNames[store.company[row]], query.company); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: queryCompanyIds
+// DESCRIPTION: Finds the ids of the realty company names equal to a name, 
+// ignoring case. Only the name table is searched, not the listings. 
+// INPUT: Parameters: store - listing store holding the name table 
+// name - company name to find 
+// ids - receives the ids of the matching names 
+// OUTPUT: reference parameter: ids 
+// CALLS TO: sameCompanyName 
+//***************************************************************************** 
+void queryCompanyIds(const listingStore& store, const string& name, vector<uint32_t>& ids)
+{
+	// variables 
+	uint32_t id; 				// Company name being compared 
+
+	ids.clear(); 
+
+	for (id = 0; id < store.companyNames.size(); id++)
+		if (sameCompanyName(store.companyNames[id], name))
+			ids.push_back(id); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: sameCompanyName
+// DESCRIPTION: Compares two realty company names, ignoring case. 
+// INPUT: Parameters: left, right - names to compare 
+// OUTPUT: Return value: true if the names are the same 
+//***************************************************************************** 
+bool sameCompanyName(const string& left, const string& right)
+{
+	// variables 
+	size_t index; 				// Character being compared 
+
+	if (left.size() != right.size())
+		return false; 
+
+	for (index = 0; index < left.size(); index++)
+		if (tolower(static_cast<unsigned char>(left[index])) != tolower(static_cast<unsigned char>(right[index])))
+			return false; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseQueryText
+// DESCRIPTION: Reads a query written as "name=value" conditions separated by 
+// spaces, such as "status=available zip=80513-* company=Metro Brokers". The 
+// names are status, zip, company and price, with top=N or bottom=N asking 
+// for the N highest or lowest priced matches; a value runs until the next 
+// condition, so company names may hold spaces. 
+// INPUT: Parameters: text - query text 
+// query - receives the conditions 
+// error - receives the reason the text is not a valid query 
+// OUTPUT: reference parameters: query, error 
+// Return value: false if the text is not a valid query 
+// CALLS TO: parseStatusCode, parseZipPattern, parsePriceRange, 
+// parseListingOrder 
+//***************************************************************************** 
+bool parseQueryText(const string& text, listingQuery& query, string& error)
+{
+	// variables 
+	istringstream words; 		// To split the text into words 
+	string word; 				// Word being read 
+	vector<string> names; 		// Name of each condition 
+	vector<string> values; 		// Value of each condition 
+	size_t equals; 				// Position of '=' in the word 
+	size_t term; 				// Condition being checked 
+
+	query = listingQuery(); 
+	words.str(text); 
+
+	while (words >> word)
+	{
+		equals = word.find('='); 
+
+		if (equals != string::npos)
+		{
+			names.push_back(word.substr(0, equals)); 
+			values.push_back(word.substr(equals + 1)); 
+		}
+		else if (!values.empty())
+			values.back() += " " + word; 
+		else
+		{
+			error = "expected name=value, found \"" + word + "\""; 
+			return false; 
+		}
+	}
+
+	for (term = 0; term < names.size(); term++)
+	{
+		if (names[term] == "status")
+		{
+			if (values[term].empty() || !parseStatusCode(toupper(values[term][0]), query.status))
+			{
+				error = "status must be available, contract or sold"; 
+				return false; 
+			}
+		}
+		else if (names[term] == "zip")
+		{
+			if (!parseZipPattern(values[term], query.zipPrefix, query.zipDigits))
+			{
+				error = "zip must be a zip code or its first 5 or 3 digits"; 
+				return false; 
+			}
+		}
+		else if (names[term] == "company")
+			query.company = (values[term] == "*") ? "" : values[term]; 
+		else if (names[term] == "price")
+		{
+			if (!parsePriceRange(values[term], query.minPrice, query.maxPrice))
+			{
+				error = "price must be a price or a range such as 150000-250000"; 
+				return false; 
+			}
+		}
+		else if (names[term] == "top" || names[term] == "bottom")
+		{
+			if (!parseListingOrder((names[term] == "top" ? "H" : "L") + values[term], query.order, query.limit))
+			{
+				error = names[term] + " must be a positive number of listings"; 
+				return false; 
+			}
+		}
+		else
+		{
+			error = "unknown condition \"" + names[term] + "\""; 
+			return false; 
+		}
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parsePriceRange
+// DESCRIPTION: Converts a price range for a query: "150000-250000", an open 
+// range "150000-" or "-250000", a single price "200000", or "*" for any 
+// price. 
+// INPUT: Parameters: text - price range 
+// low - receives the lowest price of the range, in cents 
+// high - receives the highest price of the range, in cents 
+// OUTPUT: reference parameters: low, high 
+// Return value: false if the text is not a price range 
+// CALLS TO: dollarsToCents 
+//***************************************************************************** 
+bool parsePriceRange(string_view text, int64_t& low, int64_t& high)
+{
+	// variables 
+	size_t dash; 				// Position of the '-' between the prices 
+	string_view lowText; 		// Text of the lowest price 
+	string_view highText; 		// Text of the highest price 
+	from_chars_result result; 	// Result of each number conversion 
+	double dollars; 			// Price converted 
+
+	low = INT64_MIN; 
+	high = INT64_MAX; 
+
+	if (text == "*")
+		return true; 
+
+	dash = text.find('-'); 
+	lowText = text.substr(0, dash); 
+	highText = (dash == string_view::npos) ? lowText : text.substr(dash + 1); 
+
+	if (lowText.empty() && highText.empty())
+		return false; 
+
+	if (!lowText.empty())
+	{
+		result = from_chars(lowText.data(), lowText.data() + lowText.size(), dollars); 
+
+		if (result.ec != errc() || result.ptr != lowText.data() + lowText.size() || !dollarsToCents(dollars, low))
+			return false; 
+	}
+
+	if (!highText.empty())
+	{
+		result = from_chars(highText.data(), highText.data() + highText.size(), dollars); 
+
+		if (result.ec != errc() || result.ptr != highText.data() + highText.size() || !dollarsToCents(dollars, high))
+			return false; 
+	}
+
+	return low <= high; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseListingOrder
+// DESCRIPTION: Converts the listings a query should show: "*" for every 
+// match in file order, or 'H' or 'L' followed by a count, such as "H20", 
+// for that many of the highest or lowest priced matches. 
+// INPUT: Parameters: text - listings to show 
+// order - receives QUERY_ROW_ORDER, QUERY_HIGHEST or QUERY_LOWEST 
+// limit - receives the count, or 0 for every match 
+// OUTPUT: reference parameters: order, limit 
+// Return value: false if the text is not understood 
+//***************************************************************************** 
+bool parseListingOrder(string_view text, int& order, size_t& limit)
+{
+	// variables 
+	from_chars_result result; 	// Result of converting the count 
+
+	order = QUERY_ROW_ORDER; 
+	limit = 0; 
+
+	if (text == "*")
+		return true; 
+
+	if (text.size() < 2 || (toupper(text[0]) != 'H' && toupper(text[0]) != 'L'))
+		return false; 
+
+	order = (toupper(text[0]) == 'H') ? QUERY_HIGHEST : QUERY_LOWEST; 
+	result = from_chars(text.data() + 1, text.data() + text.size(), limit); 
+
+	return result.ec == errc() && result.ptr == text.data() + text.size() && limit > 0; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseStatusCode
+// DESCRIPTION: Converts a status letter to a status value for a query. 
+// INPUT: Parameters: code - 'A', 'C', 'S', or '*' for any status 
+// status - receives the status, or QUERY_ANY_STATUS 
+// OUTPUT: reference parameter: status 
+// Return value: false if the letter is not a status 
+//***************************************************************************** 
+bool parseStatusCode(char code, int& status)
+{
+	switch (code)
+	{
+	case 'A':
+		status = AVAILABLE; 
+		break; 
+	case 'C':
+		status = CONTRACT; 
+		break; 
+	case 'S':
+		status = SOLD; 
+		break; 
+	case '*':
+		status = QUERY_ANY_STATUS; 
+		break; 
+	default:
+		return false; 
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseZipPattern
+// DESCRIPTION: Converts a zip code pattern for a query: a whole zip code 
+// "80513-2918", its first 5 digits "80513", its first 3 digits "805", or 
+// "*" for any zip code. A trailing "*" or "-*" is allowed after a prefix. 
+// INPUT: Parameters: text - zip code pattern 
+// prefix - receives the digits given 
+// digits - receives the number of digits given, 0 for any zip code 
+// OUTPUT: reference parameters: prefix, digits 
+// Return value: false if the text is not a zip code pattern 
+// CALLS TO: packZip 
+//***************************************************************************** 
+bool parseZipPattern(string_view text, uint32_t& prefix, int& digits)
+{
+	// variables 
+	size_t index; 				// Character being read 
+
+	if (text.size() > 1 && text.back() == '*')
+		text.remove_suffix(text.back() == '*' && text[text.size() - 2] == '-' ? 2 : 1); 
+
+	if (text == "*")
+	{
+		prefix = 0; 
+		digits = 0; 
+		return true; 
+	}
+
+	if (text.size() == ZIP_CODE_LENGTH)
+	{
+		digits = 9; 
+		return packZip(text, prefix); 
+	}
+
+	if (text.size() != 3 && text.size() != ZIP_DASH_POSITION)
+		return false; 
+
+	prefix = 0; 
+
+	for (index = 0; index < text.size(); index++)
+	{
+		if (!isdigit(static_cast<unsigned char>(text[index])))
+			return false; 
+
+		prefix = prefix * 10 + (text[index] - '0'); 
+	}
+
+	digits = text.size(); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: MarketStatistics
+// DESCRIPTION: Allows user to display the count, total, mean, median, 
+// lowest and highest asking price of the listings, grouped by zip code, 
+// 3-digit zip code prefix, status or realty company, or for all listings. 
+// INPUT: Parameters: store - listing store to report on 
+// OUTPUT: Outputs the statistics directly to screen. 
+// CALLS TO: parseGroupBy, computeMarketStats, displayMarketStats 
+//***************************************************************************** 
+void MarketStatistics(const listingStore& store)
+{
+	// variables 
+	char inputGroup; 				// To receive user input for grouping 
+	int groupBy; 					// Grouping chosen 
+	vector<marketGroup> groups; 	// Statistics of each group 
+
+	if (store.liveRows == 0)
+	{
+		cout << "There are no listings currently stored." << endl << endl; 
+		return; 
+	}
+
+	do
+	{
+		cout << "Group by (Z)ip code, zip (P)refix, (S)tatus, (C)ompany, or (A)ll listings: "; 
+		cin >> inputGroup; 
+		cout << endl << endl; 
+
+		inputGroup = toupper(inputGroup); 
+
+		if (!parseGroupBy(string(1, inputGroup), groupBy))
+			cout << "Invalid input - Must be 'Z', 'P', 'S', 'C' or 'A'." << endl << endl; 
+	}
+	while (!parseGroupBy(string(1, inputGroup), groupBy)); 
+
+	computeMarketStats(store, groupBy, groups); 
+	displayMarketStats(cout, store, groupBy, groups); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: computeMarketStats
+// DESCRIPTION: Computes the count, total, lowest, highest and median asking 
+// price of the listings in each group. Each pass is a loop over contiguous 
+// columns without branches: deleted rows are sent to an extra group that is 
+// ignored, the totals and extremes are gathered in one pass over the price 
+// column, and the prices are then placed group by group in one array so 
+// each group's median is found by selection rather than by sorting. 
+// INPUT: Parameters: store - listing store to report on 
+// groupBy - GROUP_ALL, GROUP_ZIP, GROUP_ZIP3, GROUP_STATUS or GROUP_COMPANY 
+// groups - receives the statistics of each group holding listings, in key order 
+// OUTPUT: reference parameter: groups 
+// CALLS TO: groupListingKeys 
+//***************************************************************************** 
+void computeMarketStats(const listingStore& store, int groupBy, vector<marketGroup>& groups)
+{
+	// variables 
+	operationTimer timer(OPERATION_STATS, false); 	// Adds the statistics to the metrics 
+	vector<uint32_t> keys; 			// Group of each row 
+	size_t groupCount; 				// Groups, not counting the one for deleted rows 
+	vector<marketGroup> all; 		// Statistics of every group, by key 
+	vector<uint32_t> offsets; 		// Place of each group's prices in grouped 
+	vector<int64_t> grouped; 		// Prices of the listings, group by group 
+	size_t rows; 					// Rows in the store 
+	size_t row; 					// Row being added 
+	size_t key; 					// Group being summed 
+	marketGroup *group; 			// Statistics of the row's group 
+	int64_t *first; 				// First price of the group being examined 
+	uint32_t middle; 				// Place of the upper median in the group 
+
+	rows = store.mls.size(); 
+	groupCount = groupListingKeys(store, groupBy, keys); 
+
+	all.resize(groupCount + 1); 
+
+	for (key = 0; key <= groupCount; key++)
+	{
+		all[key].key = key; 
+		all[key].count = 0; 
+		all[key].total = 0; 
+		all[key].low = INT64_MAX; 
+		all[key].high = INT64_MIN; 
+	}
+
+	for (row = 0; row < rows; row++)
+	{
+		group = &all[keys[row]]; 
+		group->count++; 
+		group->total += store.price[row]; 
+		group->low = min(group->low, store.price[row]); 
+		group->high = max(group->high, store.price[row]); 
+	}
+
+	offsets.resize(groupCount + 2); 
+	offsets[0] = 0; 
+
+	for (key = 0; key <= groupCount; key++)
+		offsets[key + 1] = offsets[key] + all[key].count; 
+
+	grouped.resize(rows); 
+
+	for (row = 0; row < rows; row++)
+		grouped[offsets[keys[row]]++] = store.price[row]; 
+
+	groups.clear(); 
+
+	for (key = 0; key < groupCount; key++)
+	{
+		if (all[key].count == 0)
+			continue; 
+
+		// offsets[key] now marks the end of the group's prices 
+		first = grouped.data() + offsets[key] - all[key].count; 
+		middle = all[key].count / 2; 
+
+		nth_element(first, first + middle, first + all[key].count); 
+		all[key].median = first[middle]; 
+
+		// An even count averages the two middle prices, rounded down to the cent 
+		if (all[key].count % 2 == 0)
+			all[key].median = (*max_element(first, first + middle) + all[key].median) / 2; 
+
+		groups.push_back(all[key]); 
+	}
+
+	timer.recordsParsed = store.liveRows; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: groupListingKeys
+// DESCRIPTION: Finds the group of every row of the store. Rows marked as 
+// deleted are given the group after the last. 
+// INPUT: Parameters: store - listing store to group 
+// groupBy - GROUP_ALL, GROUP_ZIP, GROUP_ZIP3, GROUP_STATUS or GROUP_COMPANY 
+// keys - receives the group of each row 
+// OUTPUT: reference parameter: keys 
+// Return value: number of groups, not counting the one for deleted rows 
+//***************************************************************************** 
+size_t groupListingKeys(const listingStore& store, int groupBy, vector<uint32_t>& keys)
+{
+	// variables 
+	size_t groupCount; 				// Groups, not counting the one for deleted rows 
+	uint32_t rows; 					// Rows in the store 
+	uint32_t row; 					// Row being grouped 
+	uint32_t key; 					// Group of the row, if it holds a listing 
+
+	rows = store.mls.size(); 
+	keys.resize(rows); 
+
+	switch (groupBy)
+	{
+	case GROUP_ZIP:
+		groupCount = ZIP5_COUNT; 
+		break; 
+	case GROUP_ZIP3:
+		groupCount = ZIP3_COUNT; 
+		break; 
+	case GROUP_STATUS:
+		groupCount = STATUS_COUNT; 
+		break; 
+	case GROUP_COMPANY:
+		groupCount = store.companyNames.size(); 
+		break; 
+	default:
+		groupCount = 1; 
+	}
+
+	// One loop per grouping keeps each free of branches 
+	if (groupBy == GROUP_ZIP)
+	{
+		for (row = 0; row < rows; row++)
+		{
+			key = store.zip[row] / ZIP4_COUNT; 
+			keys[row] = (store.status[row] == STATUS_DELETED) ? groupCount : key; 
+		}
+	}
+	else if (groupBy == GROUP_ZIP3)
+	{
+		for (row = 0; row < rows; row++)
+		{
+			key = store.zip[row] / (ZIP4_COUNT * (ZIP5_COUNT / ZIP3_COUNT)); 
+			keys[row] = (store.status[row] == STATUS_DELETED) ? groupCount : key; 
+		}
+	}
+	else if (groupBy == GROUP_STATUS)
+	{
+		for (row = 0; row < rows; row++)
+			keys[row] = min<uint32_t>(store.status[row], groupCount); 
+	}
+	else if (groupBy == GROUP_COMPANY)
+	{
+		for (row = 0; row < rows; row++)
+			keys[row] = (store.status[row] == STATUS_DELETED) ? groupCount : store.company[row]; 
+	}
+	else
+	{
+		for (row = 0; row < rows; row++)
+			keys[row] = (store.status[row] == STATUS_DELETED) ? 1 : 0; 
+	}
+
+	return groupCount; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: displayMarketStats
+// DESCRIPTION: Displays the statistics of each group as a table, prices in 
+// dollars and cents. Realty companies are listed by name. 
+// INPUT: Parameters: out - stream to display on 
+// store - listing store the statistics describe 
+// groupBy - grouping of the statistics 
+// groups - statistics of each group 
+// OUTPUT: Outputs the table to the stream. 
+// CALLS TO: formatPrice, compareGroupNames 
+//***************************************************************************** 
+void displayMarketStats(ostream& out, const listingStore& store, int groupBy, vector<marketGroup>& groups)
+{
+	// variables 
+	size_t index; 						// Group being displayed 
+	char groupText[ZIP_CODE_LENGTH + 1]; 	// Zip code of a group as text 
+	char priceText[LINE_RESERVE_BYTES]; 	// Price being displayed 
+	string name; 						// Name of the group being displayed 
+	uint32_t listings; 					// Listings in every group 
+
+	if (groupBy == GROUP_COMPANY)
+	{
+		for (index = 0; index < groups.size(); index++)
+			groups[index].name = store.companyNames[groups[index].key]; 
+
+		sort(groups.begin(), groups.end(), compareGroupNames); 
+	}
+
+	out << left << setw(22) << "Group" << right << setw(10) << "Listings"; 
+	out << setw(16) << "Mean" << setw(16) << "Median" << setw(16) << "Lowest" << setw(16) << "Highest"; 
+	out << setw(20) << "Total" << endl; 
+	out << string(22 + 10 + 4 * 16 + 20, '-') << endl; 
+
+	listings = 0; 
+
+	for (index = 0; index < groups.size(); index++)
+	{
+		switch (groupBy)
+		{
+		case GROUP_ZIP:
+			snprintf(groupText, sizeof(groupText), "%05u", groups[index].key); 
+			name = groupText; 
+			break; 
+		case GROUP_ZIP3:
+			snprintf(groupText, sizeof(groupText), "%03u", groups[index].key); 
+			name = groupText; 
+			break; 
+		case GROUP_STATUS:
+			name = (groups[index].key == AVAILABLE) ? "Available" 
+			     : (groups[index].key == CONTRACT ? "Contract" : "Sold"); 
+			break; 
+		case GROUP_COMPANY:
+			name = groups[index].name; 
+			break; 
+		default:
+			name = "All listings"; 
+		}
+
+		out << left << setw(22) << name << right << setw(10) << groups[index].count; 
+
+		*formatPrice(priceText, llround(static_cast<double>(groups[index].total) / groups[index].count), true) = '\0'; 
+		out << setw(16) << priceText; 
+		*formatPrice(priceText, groups[index].median, true) = '\0'; 
+		out << setw(16) << priceText; 
+		*formatPrice(priceText, groups[index].low, true) = '\0'; 
+		out << setw(16) << priceText; 
+		*formatPrice(priceText, groups[index].high, true) = '\0'; 
+		out << setw(16) << priceText; 
+		*formatPrice(priceText, groups[index].total, true) = '\0'; 
+		out << setw(20) << priceText << endl; 
+
+		listings += groups[index].count; 
+	}
+
+	out << endl << groups.size() << " group(s), " << listings << " listing(s)." << endl << endl; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: compareGroupNames
+// DESCRIPTION: Orders groups of listings by name. 
+// INPUT: Parameters: left, right - groups to compare 
+// OUTPUT: Return value: true if left sorts before right 
+//***************************************************************************** 
+bool compareGroupNames(const marketGroup& left, const marketGroup& right)
+{
+	return left.name < right.name; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseGroupBy
+// DESCRIPTION: Converts the name or first letter of a grouping: zip, zip3 
+// or prefix, status, company, or all. 
+// INPUT: Parameters: text - grouping 
+// groupBy - receives the grouping 
+// OUTPUT: reference parameter: groupBy 
+// Return value: false if the text is not a grouping 
+//***************************************************************************** 
+bool parseGroupBy(const string& text, int& groupBy)
+{
+	if (text == "zip" || text == "Z")
+		groupBy = GROUP_ZIP; 
+	else if (text == "zip3" || text == "prefix" || text == "P")
+		groupBy = GROUP_ZIP3; 
+	else if (text == "status" || text == "S")
+		groupBy = GROUP_STATUS; 
+	else if (text == "company" || text == "C")
+		groupBy = GROUP_COMPANY; 
+	else if (text == "all" || text == "A")
+		groupBy = GROUP_ALL; 
+	else
+		return false; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: SaveToFile
+// DESCRIPTION: Allows user to save changes to file before exiting program.    
+// The user may also write a binary snapshot beside the file, which later 
+// loads of the file use while it is newer than the file. The price history 
+// is saved beside the file too. Saving over the file that was loaded, or 
+// choosing not to save, empties its journal; saving over it also adds the 
+// listings changed since the last save to its delta file. A name that is 
+// a directory, or ends in '/', saves the listings as shards. 
+// INPUT: Parameters: store - listing store to save 
+// OUTPUT: Output direct to file. 
+// CALLS TO: writeListingsFile, writeSnapshotFile, journalReset, 
+// saveHistoryFile, writeDeltaFile, isShardTarget, writeShardDirectory 
+//***************************************************************************** 
+void SaveToFile(listingStore& store)
+{
+	// variable 
+	int counter;			// To provide index during loop for output to file 
+	char saveOption;		// For user input to save changes or not 
+	char confirm;   		// To confirm if user wishes to exit 
+	string fileName;		// To receive user input for file name 
+	char fileOption; 		// To recieve user confirmation to write over file 
+	ifstream testFile; 		// To open file as an ifstream to test if it already exists.
+	char snapshotOption; 	// For user input to also write a snapshot 
+	deltaSummary exported; 	// To receive the changes written to the delta file 
+	string deltaError; 		// To receive the reason the delta file was not written 
+	bool sharded; 			// Whether the listings are saved as shards 
+	bool saved; 			// Whether the listings were saved 
+	string shardError; 		// To receive the reason the shards were not saved 
+	
+	do
+	{
+	do
+	{
+	cout << "Do you wish to save changes to the file before exiting (Y/N)?: "; 
+	cin >> saveOption; 
+	cout << endl; 
+	
+	saveOption = toupper(saveOption); 
+	
+	
+	if (saveOption != YES && saveOption != NO) 
+		cout << "Invalid Input - Must be 'Y' or 'N'" << endl << endl;
+	}
+	while (saveOption != YES && saveOption != NO); 
+	
+	
+	if(saveOption == YES)
+	{
+		do
+		{
+		cout << "Please enter the name of the file to which to save: "; 
+		cin >> fileName; 
+		cout << endl; 
+		
+		fileOption = EXISTING_FILE; 
+		
+		testFile.open(fileName.c_str());
+		
+		
+		if (testFile)
+		{
+			cout << "File already exists." << endl;  
+			cout << "Do you wish to overwrite existing file ('E') or choose another file ('A')?" 
+			<< endl << endl; 
+			
+			do
+			{
+				cout << "Please enter choice: "; 
+				cin >> fileOption; 
+				cout << endl; 
+			
+				fileOption = toupper(fileOption); 
+			
+				if (fileOption != EXISTING_FILE && fileOption != ANOTHER_FILE) 
+					cout << "Invalid Input - Must be 'E' or 'A'" << endl << endl;
+			}
+			while (fileOption != EXISTING_FILE && fileOption != ANOTHER_FILE); 
+			
+		}
+		
+		testFile.close();
+		testFile.clear(); 	
+		
+		}
+		while(fileOption == ANOTHER_FILE); 
+		
+		
+		if(fileOption == EXISTING_FILE)
+		{
+			sharded = isShardTarget(fileName); 
+
+			while (fileName.size() > 1 && fileName.back() == '/')
+				fileName.pop_back(); 
+
+			if (sharded)
+				saved = writeShardDirectory(fileName, store, shardError); 
+			else
+				saved = writeListingsFile(fileName, store); 
+
+			if (!saved && sharded)
+				cout << "Error: shards could not be saved - " << shardError << "." << endl << endl; 
+			else if (!saved)
+				cout << "Error: file could not be written." << endl << endl; 
+			else
+			{
+				// The file now holds every journaled change 
+				if (fileName == store.journal.baseName && store.journal.output != NULL)
+					journalReset(store); 
+
+				if (!saveHistoryFile(fileName, store))
+					cout << "Error: price history could not be written." << endl << endl; 
+
+				if (fileName == store.delta.fileName 
+				    && !writeDeltaFile(fileName + DELTA_EXTENSION, store, exported, deltaError))
+					cout << "Error: changes could not be exported - " << deltaError << "." << endl << endl; 
+				
+				// Shard directories are always loaded from their shards 
+				if (sharded)
+					snapshotOption = NO; 
+				else
+					do
+					{
+						cout << "Also write a snapshot for faster loading (Y/N)?: "; 
+						cin >> snapshotOption; 
+						cout << endl; 
+
+						snapshotOption = toupper(snapshotOption); 
+
+						if (snapshotOption != YES && snapshotOption != NO)
+							cout << "Invalid Input - Must be 'Y' or 'N'" << endl << endl; 
+					}
+					while (snapshotOption != YES && snapshotOption != NO); 
+
+				if (snapshotOption == YES && !writeSnapshotFile(fileName + SNAPSHOT_EXTENSION, store))
+					cout << "Error: snapshot could not be written." << endl << endl; 
+			}
+		}
+			    
+	}
+	else
+		do
+		{
+			cout << "All changes will be lost. Proceed (Y/N)?: "; 
+			cin >> confirm; 
+			cout << endl << endl; 
+	
+			confirm = toupper(confirm); 
+	
+			if (confirm != YES && confirm != NO) 
+			cout << "Invalid Input - Must be 'Y' or 'N'" << endl << endl;
+		}
+		while (confirm != YES && confirm != NO);
+	
+	if (saveOption == NO && confirm == YES && store.journal.output != NULL)
+		journalReset(store); 
+	
+	}
+	while (confirm != YES && saveOption != YES); 	
+	
+}
+
+//*****************************************************************************
+// FUNCTION: writeListingsFile
+// DESCRIPTION: Writes every listing in the store to a listings file, one 
+// "MLS price status zip company" line per listing, replacing the file. Lines 
+// are formatted into a large buffer with to_chars, which prints prices just 
+// as fixed << setprecision(0) did, and written in a few large blocks. The 
+// listings go to a temporary file that is synced to disk and then renamed 
+// over the file, so a crash leaves either the old file or the new one. The 
+// blocks are written through the file I/O backend; with io_uring each is 
+// written while the next is formatted. Listings added in freed rows are 
+// written after the rest, in the order they were added. 
+// INPUT: Parameters: fileName - name of the file to write 
+// store - listing store to save 
+// OUTPUT: Output direct to file. 
+// Return value: false if the file could not be written 
+// CALLS TO: storeSavedRows, formatListingLine, ioWriterOpen, ioWriterWrite, 
+// ioWriterClose, replaceFile 
+//***************************************************************************** 
+bool writeListingsFile(const string& fileName, const listingStore& store)
+{
+	// variables 
+	operationTimer timer(OPERATION_SAVE, true); 	// Adds the save to the metrics 
+	string tempName;					// Name of the file written before the rename 
+	ioWriter outputFile;				// Variable for output file 
+	vector<char> buffer;				// Lines waiting to be written 
+	char *position;						// Where the next character goes in the buffer 
+	char *bufferEnd;					// End of the buffer 
+	vector<uint32_t> order;				// Rows in saved order, if listings were added in freed rows 
+	size_t index;						// Place in the file of the current row 
+	uint32_t row;						// To track current row during output loop 
+	const string *company;				// Company name of the current row 
+	bool written;						// Whether every write succeeded 
+
+	tempName = fileName + TEMP_EXTENSION; 
+
+	if (!ioWriterOpen(tempName, false, outputFile))
+		return false; 
+
+	buffer.resize(WRITE_BUFFER_BYTES); 
+	position = buffer.data(); 
+	bufferEnd = buffer.data() + buffer.size(); 
+	written = true; 
+
+	// Listings added in freed rows are saved after the rest, in the order added 
+	if (!store.addedRows.empty())
+		storeSavedRows(store, order); 
+
+	for (index = 0; index < (order.empty() ? store.mls.size() : order.size()); index++)
+	{
+		row = order.empty() ? index : order[index]; 
+
+		if (store.status[row] == STATUS_DELETED)
+			continue; 
+
+		company = &store.companyNames[store.company[row]]; 
+
+		// Every field but the company name fits in LINE_RESERVE_BYTES 
+		if (bufferEnd - position < static_cast<ptrdiff_t>(LINE_RESERVE_BYTES + company->size()))
+		{
+			written = written && ioWriterWrite(outputFile, buffer.data(), position - buffer.data()); 
+			timer.bytesWritten += position - buffer.data(); 
+
+			if (LINE_RESERVE_BYTES + company->size() > buffer.size())
+				buffer.resize(LINE_RESERVE_BYTES + company->size()); 
+
+			position = buffer.data(); 
+			bufferEnd = buffer.data() + buffer.size(); 
+		}
+
+		position = formatListingLine(position, store.mls[row], store.price[row], store.status[row], 
+		                             store.zip[row], *company); 
+	}
+
+	written = written && ioWriterWrite(outputFile, buffer.data(), position - buffer.data()); 
+	timer.bytesWritten += position - buffer.data(); 
+	written = ioWriterClose(outputFile, true) && written; 
+
+	if (!written || !replaceFile(tempName, fileName))
+	{
+		remove(tempName.c_str()); 
+		return false; 
+	}
+
+	timer.recordsParsed = store.liveRows; 
+	timer.succeeded = true; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: syncFile
+// DESCRIPTION: Writes a file's buffered output and waits for the file to 
+// reach the disk. 
+// INPUT: Parameters: file - open output file 
+// OUTPUT: Return value: false if the file could not be written or synced 
+//***************************************************************************** 
+bool syncFile(FILE* file)
+{
+	if (fflush(file) != 0)
+		return false; 
+
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0; 
+#else
+	return fsync(fileno(file)) == 0; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: replaceFile
+// DESCRIPTION: Renames a completed temporary file over the file it replaces. 
+// On POSIX systems the rename is atomic, and the directory is synced so the 
+// new name survives a crash. Windows cannot rename over an existing file, 
+// so there the old file is removed first. 
+// INPUT: Parameters: tempName - name of the completed temporary file 
+// fileName - name of the file to replace 
+// OUTPUT: Return value: false if the file could not be replaced 
+//***************************************************************************** 
+bool replaceFile(const string& tempName, const string& fileName)
+{
+#ifdef _WIN32
+	remove(fileName.c_str()); 
+
+	return rename(tempName.c_str(), fileName.c_str()) == 0; 
+#else
+	// variables 
+	string directory; 			// Directory holding the file 
+	size_t slash; 				// Position of the last '/' in the file name 
+	int descriptor; 			// Descriptor of the directory 
+
+	if (rename(tempName.c_str(), fileName.c_str()) != 0)
+		return false; 
+
+	slash = fileName.rfind('/'); 
+	directory = (slash == string::npos) ? "." : fileName.substr(0, slash + 1); 
+	descriptor = open(directory.c_str(), O_RDONLY); 
+
+	if (descriptor >= 0)
+	{
+		fsync(descriptor); 
+		close(descriptor); 
+	}
+
+	return true; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: formatListingLine
+// DESCRIPTION: Formats one line of a listings file, "MLS price status zip 
+// company" and a line end, with the price in dollars, and cents only when 
+// it is not a whole number of dollars. The caller provides 
+// LINE_RESERVE_BYTES plus the length of the company name. 
+// INPUT: Parameters: position - where the line goes 
+// mls, price, status - fields of the listing, price in cents 
+// zip - zip code of the listing, packed by packZip 
+// company - realty company name of the listing 
+// OUTPUT: Return value: the position after the line 
+// CALLS TO: formatPrice, formatZip 
+//***************************************************************************** 
+char* formatListingLine(char* position, uint32_t mls, int64_t price, int status, uint32_t zip, string_view company)
+{
+	// variables 
+	char *end; 					// Limit for the numeric fields 
+
+	end = position + LINE_RESERVE_BYTES; 
+
+	position = to_chars(position, end, mls).ptr; 
+	*position++ = ' '; 
+	position = formatPrice(position, price, false); 
+	*position++ = ' '; 
+	position = to_chars(position, end, status).ptr; 
+	*position++ = ' '; 
+	formatZip(zip, position); 
+	position += strlen(position); 
+	*position++ = ' '; 
+	memcpy(position, company.data(), company.size()); 
+	position += company.size(); 
+	*position++ = '\n'; 
+
+	return position; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: dollarsToCents
+// DESCRIPTION: Converts an amount in dollars to whole cents, rounding to 
+// the nearest cent. Amounts beyond MAX_PRICE_DOLLARS are refused so the 
+// totals of millions of listings cannot overflow. 
+// INPUT: Parameters: dollars - amount in dollars 
+// cents - receives the amount in cents 
+// OUTPUT: reference parameter: cents 
+// Return value: false if the amount is out of range 
+//***************************************************************************** 
+bool dollarsToCents(double dollars, int64_t& cents)
+{
+	if (!(fabs(dollars) <= MAX_PRICE_DOLLARS))
+		return false; 
+
+	cents = llround(dollars * CENTS_PER_DOLLAR); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: formatPrice
+// DESCRIPTION: Formats an amount in cents as dollars, such as "229700" or 
+// "229700.25". Whole-dollar amounts are written without cents unless 
+// showCents is set, so listings files keep their format. 
+// INPUT: Parameters: position - where the text goes; room for 24 characters 
+// cents - amount in cents 
+// showCents - whether to write ".00" for whole-dollar amounts 
+// OUTPUT: Return value: the position after the text 
+//***************************************************************************** 
+char* formatPrice(char* position, int64_t cents, bool showCents)
+{
+	// variables 
+	uint64_t magnitude; 		// Amount without its sign 
+
+	if (cents < 0)
+		*position++ = '-'; 
+
+	magnitude = (cents < 0) ? 0 - static_cast<uint64_t>(cents) : cents; 
+	position = to_chars(position, position + 20, magnitude / CENTS_PER_DOLLAR).ptr; 
+
+	if (showCents || magnitude % CENTS_PER_DOLLAR != 0)
+	{
+		*position++ = '.'; 
+		*position++ = '0' + magnitude % CENTS_PER_DOLLAR / 10; 
+		*position++ = '0' + magnitude % 10; 
+	}
+
+	return position; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: streamPriceChanges
+// DESCRIPTION: Applies a changes file to a listings file and writes the 
+// updated listings to an output file without loading either file, using no 
+// more memory than the budget however large the files are. The changes are 
+// sorted by MLS number and summed per number with sortChangesExternal. The 
+// listings are then read and written line by line, each pass repricing the 
+// listings whose MLS numbers are in the next batch of sorted changes that 
+// fits in the budget; one pass is needed unless the distinct changes exceed 
+// the budget. Malformed and duplicate listings are skipped and reported as 
+// a load would, so the output matches loading the file, applying the 
+// changes and saving. 
+// INPUT: Parameters: listingsFile - name of the listings file to read 
+// changesFile - name of the changes file 
+// outputFile - name of the listings file to write 
+// budget - bytes of memory the job may use 
+// summary - receives the counts of the job 
+// error - receives the reason the job failed 
+// OUTPUT: reference parameters: summary, error 
+// Output direct to file. 
+// Return value: false if the job failed 
+// CALLS TO: tempFileBase, sortChangesExternal, streamListingsPass, 
+// replaceFile, fileSize 
+//***************************************************************************** 
+bool streamPriceChanges(const string& listingsFile, const string& changesFile, const string& outputFile, 
+                        size_t budget, streamSummary& summary, string& error)
+{
+	// variables 
+	operationTimer timer(OPERATION_STREAM, true); 	// Adds the job to the metrics 
+	string tempBase; 					// Start of the names of temporary files 
+	vector<priceChange> sorted; 		// Sorted changes, when they fit in memory 
+	string sortedFile; 					// File of sorted changes, when they do not 
+	ifstream sortedInput; 				// Reader of the file of sorted changes 
+	vector<priceChange> batch; 			// Changes applied by the current pass 
+	size_t batchCapacity; 				// Most changes held by one pass 
+	priceChange change; 				// Change read from the file of sorted changes 
+	string passInput; 					// Listings read by the current pass 
+	string passOutput; 					// Listings written by the current pass 
+	bool lastPass; 						// Whether every change has been batched 
+
+	summary = streamSummary(); 
+	tempBase = tempFileBase(outputFile); 
+
+	if (!sortChangesExternal(changesFile, budget, tempBase, sorted, sortedFile, summary, error))
+		return false; 
+
+	if (!sortedFile.empty())
+	{
+		sortedInput.open(sortedFile.c_str(), ios::binary); 
+
+		if (!sortedInput)
+		{
+			error = "sorted changes could not be read"; 
+			remove(sortedFile.c_str()); 
+			return false; 
+		}
+	}
+
+	batchCapacity = max<size_t>(budget / (sizeof(priceChange) + 1), 1); 
+	passInput = listingsFile; 
+	lastPass = false; 
+
+	while (!lastPass)
+	{
+		batch.clear(); 
+
+		if (sortedFile.empty())
+		{
+			// Changes that were sorted in memory are applied in a single pass 
+			batch.swap(sorted); 
+			lastPass = true; 
+		}
+		else
+		{
+			while (batch.size() < batchCapacity 
+			       && sortedInput.read(reinterpret_cast<char*>(&change), sizeof(change)))
+				batch.push_back(change); 
+
+			lastPass = (sortedInput.peek() == char_traits<char>::eof()); 
+		}
+
+		passOutput = lastPass ? outputFile + TEMP_EXTENSION 
+		                      : tempBase + ".pass" + to_string(summary.passes + 1); 
+
+		if (!streamListingsPass(passInput, passOutput, batch, summary.passes == 0, summary, error))
+		{
+			if (passInput != listingsFile)
+				remove(passInput.c_str()); 
+
+			remove(passOutput.c_str()); 
+			break; 
+		}
+
+		if (passInput != listingsFile)
+			remove(passInput.c_str()); 
+
+		passInput = passOutput; 
+		summary.passes++; 
+	}
+
+	if (!sortedFile.empty())
+	{
+		sortedInput.close(); 
+		remove(sortedFile.c_str()); 
+	}
+
+	if (!error.empty())
+		return false; 
+
+	if (!replaceFile(passInput, outputFile))
+	{
+		remove(passInput.c_str()); 
+		error = "output file could not be written"; 
+		return false; 
+	}
+
+	// Files of passes after the first and spilled runs are not counted 
+	timer.bytesRead = fileSize(listingsFile) + fileSize(changesFile); 
+	timer.bytesWritten = fileSize(outputFile); 
+	timer.recordsParsed = summary.changesRead + summary.listingsWritten + summary.listings.recordsRejected; 
+	timer.recordsRejected = summary.listings.recordsRejected + summary.unmatchedMLS + summary.changesRejected; 
+	timer.succeeded = true; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: sortChangesExternal
+// DESCRIPTION: Sorts the records of a changes file by MLS number and sums 
+// the reductions of each number, within a memory budget. Records are read 
+// into a buffer; if the whole file fits, the result is left in memory. 
+// Otherwise each full buffer is sorted and written as a run to a spill 
+// file, and the runs are merged, MAX_MERGE_RUNS at a time, into one file of 
+// sorted changes. A record whose reduction is out of range is skipped and 
+// counted; reading stops at the first record that is not a number and a 
+// reduction. 
+// INPUT: Parameters: changesFile - name of the changes file 
+// budget - bytes of memory the sort may use 
+// tempBase - start of the names of spill files 
+// sorted - receives the sorted changes if they fit in memory 
+// sortedFile - receives the name of the file of sorted changes otherwise 
+// summary - counts of the job to update 
+// error - receives the reason the sort failed 
+// OUTPUT: reference parameters: sorted, sortedFile, summary, error 
+// Return value: false if the sort failed 
+// CALLS TO: dollarsToCents, writeChangeRun, mergeChangeRuns, 
+// compareChangeMLS, sumSortedChanges, fileSize 
+//***************************************************************************** 
+bool sortChangesExternal(const string& changesFile, size_t budget, const string& tempBase, 
+                         vector<priceChange>& sorted, string& sortedFile, streamSummary& summary, 
+                         string& error)
+{
+	// variables 
+	ifstream changesInput; 				// To receive changes file 
+	priceChange change; 				// Record read during each loop pass 
+	double reduction; 					// Reduction read, in dollars 
+	size_t runCapacity; 				// Records sorted in memory at a time 
+	vector<string> runs; 				// Spill files waiting to be merged 
+	vector<string> group; 				// Runs being merged into one 
+	string runName; 					// Name of the spill file being written 
+	size_t runIndex; 					// First run of the group being merged 
+	int spillCount; 					// Spill files named so far 
+	size_t member; 						// Run of the group being removed 
+
+	changesInput.open(changesFile.c_str()); 
+
+	if (!changesInput)
+	{
+		error = "changes file not found"; 
+		return false; 
+	}
+
+	// stable_sort may need a second buffer the size of the first 
+	runCapacity = max<size_t>(budget / (2 * sizeof(priceChange)), 1); 
+	sorted.clear(); 
+	sorted.reserve(min<size_t>(runCapacity, STREAM_INITIAL_RECORDS)); 
+	spillCount = 0; 
+
+	while (changesInput >> change.numberMLS >> reduction)
+	{
+		if (!dollarsToCents(reduction, change.reduction))
+		{
+			summary.changesRejected++; 
+			continue; 
+		}
+
+		summary.changesRead++; 
+		sorted.push_back(change); 
+
+		if (sorted.size() == runCapacity)
+		{
+			runName = tempBase + ".run" + to_string(++spillCount); 
+
+			if (!writeChangeRun(runName, sorted))
+			{
+				error = "spill file " + runName + " could not be written"; 
+				break; 
+			}
+
+			runs.push_back(runName); 
+			summary.runsSpilled++; 
+		}
+	}
+
+	if (error.empty() && !runs.empty() && !sorted.empty())
+	{
+		runName = tempBase + ".run" + to_string(++spillCount); 
+
+		if (writeChangeRun(runName, sorted))
+		{
+			runs.push_back(runName); 
+			summary.runsSpilled++; 
+		}
+		else
+			error = "spill file " + runName + " could not be written"; 
+	}
+
+	if (runs.empty())
+	{
+		if (error.empty())
+		{
+			stable_sort(sorted.begin(), sorted.end(), compareChangeMLS); 
+			sumSortedChanges(sorted); 
+			summary.distinctMLS = sorted.size(); 
+		}
+
+		return error.empty(); 
+	}
+
+	vector<priceChange>().swap(sorted); 
+
+	// Each pass merges groups of runs until a single run is left 
+	while (error.empty() && runs.size() > 1)
+	{
+		for (runIndex = 0; runIndex < runs.size() && error.empty(); runIndex += MAX_MERGE_RUNS)
+		{
+			group.assign(runs.begin() + runIndex, runs.begin() + min(runs.size(), runIndex + MAX_MERGE_RUNS)); 
+			runName = tempBase + ".run" + to_string(++spillCount); 
+
+			if (!mergeChangeRuns(group, runName))
+				error = "spill file " + runName + " could not be written"; 
+
+			runs[runIndex / MAX_MERGE_RUNS] = runName; 
+
+			for (member = 0; member < group.size(); member++)
+				remove(group[member].c_str()); 
+		}
+
+		runs.resize((runs.size() + MAX_MERGE_RUNS - 1) / MAX_MERGE_RUNS); 
+	}
+
+	if (!error.empty())
+	{
+		for (runIndex = 0; runIndex < runs.size(); runIndex++)
+			remove(runs[runIndex].c_str()); 
+
+		return false; 
+	}
+
+	sortedFile = runs[0]; 
+	summary.distinctMLS = fileSize(sortedFile) / sizeof(priceChange); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: sumSortedChanges
+// DESCRIPTION: Replaces the records of each MLS number in sorted changes 
+// with one record holding the sum of their reductions, in file order. 
+// INPUT: Parameters: changes - change records sorted by MLS number 
+// OUTPUT: reference parameter: changes 
+//***************************************************************************** 
+void sumSortedChanges(vector<priceChange>& changes)
+{
+	// variables 
+	size_t readIndex; 			// Change record being merged 
+	size_t distinct; 			// Number of distinct MLS numbers so far 
+
+	distinct = 0; 
+
+	for (readIndex = 0; readIndex < changes.size(); readIndex++)
+	{
+		if (distinct > 0 && changes[distinct - 1].numberMLS == changes[readIndex].numberMLS)
+			changes[distinct - 1].reduction += changes[readIndex].reduction; 
+		else
+			changes[distinct++] = changes[readIndex]; 
+	}
+
+	changes.resize(distinct); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeChangeRun
+// DESCRIPTION: Sorts a buffer of change records, sums the reductions of each 
+// MLS number and writes the result to a spill file as raw records. The 
+// buffer is emptied. 
+// INPUT: Parameters: fileName - name of the spill file 
+// changes - change records in file order 
+// OUTPUT: reference parameter: changes 
+// Output direct to file. 
+// Return value: false if the spill file could not be written 
+// CALLS TO: compareChangeMLS, sumSortedChanges 
+//***************************************************************************** 
+bool writeChangeRun(const string& fileName, vector<priceChange>& changes)
+{
+	// variables 
+	ofstream runFile; 			// Spill file 
+
+	stable_sort(changes.begin(), changes.end(), compareChangeMLS); 
+	sumSortedChanges(changes); 
+
+	runFile.open(fileName.c_str(), ios::binary | ios::trunc); 
+	runFile.write(reinterpret_cast<const char*>(changes.data()), changes.size() * sizeof(priceChange)); 
+	runFile.close(); 
+
+	changes.clear(); 
+
+	return !runFile.fail(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: mergeChangeRuns
+// DESCRIPTION: Merges sorted runs of change records into one sorted run, 
+// summing the reductions of an MLS number found in several runs. The next 
+// record of every run is kept in a heap ordered by MLS number, with ties 
+// taken in run order so sums keep the order of the file. 
+// INPUT: Parameters: runs - names of the spill files to merge, in file order 
+// fileName - name of the merged spill file 
+// OUTPUT: Output direct to file. 
+// Return value: false if a run could not be read or the result written 
+// CALLS TO: compareMergeHead 
+//***************************************************************************** 
+bool mergeChangeRuns(const vector<string>& runs, const string& fileName)
+{
+	// variables 
+	vector<ifstream> inputs; 			// Readers of the runs 
+	vector<mergeHead> heads; 			// Heap of the next record of each run 
+	mergeHead head; 					// Record taken from the heap 
+	priceChange merged; 				// Sum of the records for one MLS number 
+	bool haveMerged; 					// Whether merged holds a record 
+	ofstream output; 					// Merged spill file 
+	size_t run; 						// Run being opened 
+
+	inputs.resize(runs.size()); 
+
+	for (run = 0; run < runs.size(); run++)
+	{
+		inputs[run].open(runs[run].c_str(), ios::binary); 
+
+		if (!inputs[run])
+			return false; 
+
+		head.run = run; 
+
+		if (inputs[run].read(reinterpret_cast<char*>(&head.change), sizeof(head.change)))
+			heads.push_back(head); 
+	}
+
+	make_heap(heads.begin(), heads.end(), compareMergeHead); 
+
+	output.open(fileName.c_str(), ios::binary | ios::trunc); 
+	haveMerged = false; 
+
+	while (!heads.empty() && output)
+	{
+		pop_heap(heads.begin(), heads.end(), compareMergeHead); 
+		head = heads.back(); 
+		heads.pop_back(); 
+
+		if (haveMerged && merged.numberMLS == head.change.numberMLS)
+			merged.reduction += head.change.reduction; 
+		else
+		{
+			if (haveMerged)
+				output.write(reinterpret_cast<const char*>(&merged), sizeof(merged)); 
+
+			merged = head.change; 
+			haveMerged = true; 
+		}
+
+		if (inputs[head.run].read(reinterpret_cast<char*>(&head.change), sizeof(head.change)))
+		{
+			heads.push_back(head); 
+			push_heap(heads.begin(), heads.end(), compareMergeHead); 
+		}
+	}
+
+	if (haveMerged)
+		output.write(reinterpret_cast<const char*>(&merged), sizeof(merged)); 
+
+	output.close(); 
+
+	return !output.fail(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: compareMergeHead
+// DESCRIPTION: Orders the heap of mergeChangeRuns so the smallest MLS number, 
+// and among equal numbers the earliest run, is taken first. 
+// INPUT: Parameters: left, right - heap entries to compare 
+// OUTPUT: Return value: true if left is taken after right 
+//***************************************************************************** 
+bool compareMergeHead(const mergeHead& left, const mergeHead& right)
+{
+	if (left.change.numberMLS != right.change.numberMLS)
+		return left.change.numberMLS > right.change.numberMLS; 
+
+	return left.run > right.run; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: streamListingsPass
+// DESCRIPTION: Reads a listings file in fixed-size blocks and writes each 
+// listing to an output file, repriced if its MLS number is in a batch of 
+// sorted changes. On the first pass malformed and repeated listings are 
+// reported and left out; a bitmap of the MLS numbers seen finds repeats. 
+// INPUT: Parameters: inputFile - name of the listings file to read 
+// outputFile - name of the listings file to write 
+// batch - sorted, summed changes to apply 
+// firstPass - whether the input is the original listings file 
+// summary - counts of the job to update 
+// error - receives the reason the pass failed 
+// OUTPUT: reference parameters: summary, error 
+// Output direct to file. 
+// Return value: false if the pass failed 
+// CALLS TO: parseListingLine, packZip, reportLoadError, compareChangeMLS, 
+// formatListingLine, syncFile 
+//***************************************************************************** 
+bool streamListingsPass(const string& inputFile, const string& outputFile, const vector<priceChange>& batch, 
+                        bool firstPass, streamSummary& summary, string& error)
+{
+	// variables 
+	FILE *input; 						// Listings being read 
+	FILE *output; 						// Listings being written 
+	vector<char> block; 				// Bytes read from the input 
+	size_t filled; 						// Bytes of the block holding input 
+	bool atEnd; 						// Whether the input has been read to its end 
+	vector<char> lines; 				// Lines waiting to be written 
+	size_t used; 						// Bytes of lines holding output 
+	const char *position; 				// Start of the line being processed 
+	const char *end; 					// End of the input in the block 
+	const char *lineEnd; 				// End of the line being processed 
+	int lineNumber; 					// Line number of the line being processed 
+	parsedListing record; 				// Fields of the line being processed 
+	const char *reason; 				// Reason a line could not be parsed 
+	uint32_t packedZip; 				// Zip code of the line packed 
+	vector<bool> seen; 					// Whether each MLS number has been written 
+	vector<bool> matched; 				// Whether each change of the batch found a listing 
+	vector<priceChange>::const_iterator found; 	// Change located for a listing 
+	priceChange key; 					// MLS number to search the batch for 
+	bool written; 						// Whether every write succeeded 
+	size_t change; 						// Change of the batch being counted 
+
+	input = fopen(inputFile.c_str(), "rb"); 
+
+	if (input == NULL)
+	{
+		error = "listings file not found"; 
+		return false; 
+	}
+
+	output = fopen(outputFile.c_str(), "w"); 
+
+	if (output == NULL)
+	{
+		fclose(input); 
+		error = "file " + outputFile + " could not be written"; 
+		return false; 
+	}
+
+	block.resize(STREAM_BLOCK_BYTES); 
+	lines.resize(WRITE_BUFFER_BYTES); 
+	matched.assign(batch.size(), false); 
+
+	if (firstPass)
+		seen.assign(MLS_MAX + 1, false); 
+
+	filled = 0; 
+	used = 0; 
+	lineNumber = 0; 
+	written = true; 
+	atEnd = false; 
+
+	while (!atEnd)
+	{
+		filled += fread(block.data() + filled, 1, block.size() - filled, input); 
+		atEnd = (filled < block.size()); 
+
+		// A last line without a line end is given one 
+		if (atEnd && filled > 0 && block[filled - 1] != '\n')
+		{
+			if (filled == block.size())
+				block.resize(block.size() + 1); 
+
+			block[filled++] = '\n'; 
+		}
+
+		position = block.data(); 
+		end = block.data() + filled; 
+
+		while ((lineEnd = static_cast<const char*>(memchr(position, '\n', end - position))) != NULL)
+		{
+			lineNumber++; 
+
+			if (!parseListingLine(string_view(position, lineEnd - position), record, reason))
+			{
+				if (firstPass)
+					reportLoadError(summary.listings, lineNumber, reason); 
+			}
+			else if (record.numberMLS != 0)
+			{
+				if (!packZip(record.zipCode, packedZip))
+				{
+					if (firstPass)
+						reportLoadError(summary.listings, lineNumber, "invalid zip code"); 
+				}
+				else if (firstPass && seen[record.numberMLS])
+					reportLoadError(summary.listings, lineNumber, "duplicate MLS number"); 
+				else
+				{
+					if (firstPass)
+					{
+						seen[record.numberMLS] = true; 
+						summary.listingsWritten++; 
+					}
+
+					key.numberMLS = record.numberMLS; 
+					found = lower_bound(batch.begin(), batch.end(), key, compareChangeMLS); 
+
+					if (found != batch.end() && found->numberMLS == key.numberMLS)
+					{
+						record.price = record.price - found->reduction; 
+						matched[found - batch.begin()] = true; 
+					}
+
+					if (lines.size() - used < LINE_RESERVE_BYTES + record.realtyCompany.size())
+					{
+						written = written && fwrite(lines.data(), 1, used, output) == used; 
+						used = 0; 
+
+						if (LINE_RESERVE_BYTES + record.realtyCompany.size() > lines.size())
+							lines.resize(LINE_RESERVE_BYTES + record.realtyCompany.size()); 
+					}
+
+					used = formatListingLine(lines.data() + used, record.numberMLS, record.price, 
+					                         record.status, packedZip, record.realtyCompany) - lines.data(); 
+				}
+			}
+
+			position = lineEnd + 1; 
+		}
+
+		// The partial line at the end of the block moves to its start 
+		filled = end - position; 
+		memmove(block.data(), position, filled); 
+
+		if (filled == block.size())
+			block.resize(block.size() * 2); 
+	}
+
+	written = written && fwrite(lines.data(), 1, used, output) == used && !ferror(input); 
+	written = syncFile(output) && written; 
+	written = (fclose(output) == 0) && written; 
+	fclose(input); 
+
+	for (change = 0; change < batch.size(); change++)
+	{
+		if (matched[change])
+			summary.listingsChanged++; 
+		else
+			summary.unmatchedMLS++; 
+	}
+
+	if (!written)
+		error = "file " + outputFile + " could not be written"; 
+
+	return written; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: tempFileBase
+// DESCRIPTION: Returns the start of the names of the temporary files of a 
+// streaming job: the name of its output file, placed in the directory named 
+// by the TEMP_DIRECTORY_VARIABLE environment variable if that is set. 
+// INPUT: Parameters: outputFile - name of the job's output file 
+// OUTPUT: Return value: start of the temporary file names 
+//***************************************************************************** 
+string tempFileBase(const string& outputFile)
+{
+	// variables 
+	const char *directory; 		// Directory for temporary files from the environment 
+	size_t slash; 				// Position of the last '/' in the output file name 
+
+	directory = getenv(TEMP_DIRECTORY_VARIABLE); 
+
+	if (directory == NULL || *directory == '\0')
+		return outputFile; 
+
+	slash = outputFile.find_last_of("/\\"); 
+
+	return string(directory) + "/" + outputFile.substr(slash == string::npos ? 0 : slash + 1); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: fileSize
+// DESCRIPTION: Returns the size of a file. 
+// INPUT: Parameters: fileName - name of the file 
+// OUTPUT: Return value: size of the file, or 0 if it does not exist 
+// CALLS TO: fileIdentity 
+//***************************************************************************** 
+uint64_t fileSize(const string& fileName)
+{
+	// variables 
+	uint64_t size; 				// Size of the file 
+	int64_t modified; 			// Time the file was last changed 
+
+	fileIdentity(fileName, size, modified); 
+
+	return size; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ChangeAskingPrices
+// DESCRIPTION: Allows user to apply price changes from file.    
+// INPUT: Parameters: store - listing store to reprice  
+// OUTPUT: Summary of the changes applied, output to screen.   
+// CALLS TO: readChangesFile, applyPriceChanges, displayChangeSummary 
+//***************************************************************************** 
+void ChangeAskingPrices(listingStore& store)
+{
+	// Function local variables
+	vector<priceChange> changes; // To hold every record of the changes file 
+	changeSummary summary; 		 // To receive the results of applying the changes 
+	
+	if(!readChangesFile(FILE_CHANGES, changes, summary.recordsRejected))
+	   cout << "Changes file does not exist" << endl << endl;  
+	else
+	{ 
+	
+		if(store.liveRows == 0)
+			cout << "There are no records currently on file to search." << endl << endl; 
+		else
+		{		
+			store.history.source = FILE_CHANGES; 
+			applyPriceChanges(store, changes, summary); 
+			
+			displayChangeSummary(cout, summary); 
+		}
+		
+	cout << endl; 	
+		
+	}	
+}
+
+//*****************************************************************************
+// FUNCTION: readChangesFile
+// DESCRIPTION: Reads every MLS number and reduction from a changes file, 
+// stopping at the first record that is not a number and a reduction. A 
+// record whose reduction is out of range is skipped and counted. The file 
+// is read a block at a time through the file I/O backend, so with io_uring 
+// the next blocks are being read while one is parsed. 
+// INPUT: Parameters: fileName - name of the changes file 
+// changes - vector to receive the change records in file order 
+// rejected - receives the number of records skipped 
+// OUTPUT: reference parameters: changes, rejected 
+// Return value: false if the file could not be opened 
+// CALLS TO: ioReaderOpen, ioReaderNext, ioReaderClose, parseChangeRecords, 
+// fileSize 
+//***************************************************************************** 
+bool readChangesFile(const string& fileName, vector<priceChange>& changes, int& rejected)
+{
+	// variables 
+	operationTimer timer(OPERATION_READ_CHANGES, true); 	// Adds the parse to the metrics 
+	ioReader changesFile; 		// To receive changes file 
+	const char *data; 			// Block of the file being parsed 
+	size_t size; 				// Bytes in the block 
+	const char *end; 			// End of the block 
+	const char *position; 		// Where parsing the block starts 
+	const char *rest; 			// Start of a number the end of the block cuts off 
+	string carry; 				// Number cut off by the end of a block, being joined to the next 
+	priceChange change; 		// Record read during each loop pass 
+	bool haveMLS; 				// Whether the MLS number of change has been read 
+	bool reading; 				// Whether no malformed record has been found 
+	
+	if (!ioReaderOpen(fileName, changesFile))
+		return false; 
+	
+	changes.clear(); 
+	rejected = 0; 
+	haveMLS = false; 
+	reading = true; 
+	
+	while (reading && ioReaderNext(changesFile, data, size))
+	{
+		end = data + size; 
+		position = data; 
+
+		// A number cut off by the last block goes on to the first white space of this one 
+		if (!carry.empty())
+		{
+			while (position < end && !isspace(static_cast<unsigned char>(*position)))
+				position++; 
+
+			carry.append(data, position - data); 
+
+			if (position == end)
+				continue; 
+
+			reading = parseChangeRecords(carry.data(), carry.data() + carry.size(), true, change, haveMLS, 
+			                             changes, rejected, rest); 
+			carry.clear(); 
+		}
+
+		if (reading)
+		{
+			reading = parseChangeRecords(position, end, false, change, haveMLS, changes, rejected, rest); 
+			carry.assign(rest, end - rest); 
+		}
+	}
+	
+	if (reading && !carry.empty())
+		parseChangeRecords(carry.data(), carry.data() + carry.size(), true, change, haveMLS, changes, rejected, rest); 
+	
+	ioReaderClose(changesFile); 
+	
+	timer.bytesRead = fileSize(fileName); 
+	timer.recordsParsed = changes.size() + rejected; 
+	timer.recordsRejected = rejected; 
+	timer.succeeded = true; 
+	
+	return true; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: applyPriceChanges
+// DESCRIPTION: Joins a batch of price changes against the listings in one 
+// pass. The changes are sorted by MLS number and repeated numbers are summed. 
+// When there are fewer distinct changes than listings each change probes the 
+// MLS index; otherwise the price column is walked once and each listing is 
+// looked up among the sorted changes. Each new price goes into the price 
+// index's delta buffer, which is merged only when full, so a batch costs 
+// a few merges rather than one per change. The new prices are journaled 
+// and committed together; a listing that could not be repriced for lack of 
+// memory is reported as unmatched. 
+// INPUT: Parameters: store - listing store to reprice 
+// changes - change records in file order; sorted and merged on return 
+// summary - receives counts and the MLS numbers that matched no listing 
+// OUTPUT: reference parameters: store, changes, summary 
+// CALLS TO: sumSortedChanges, indexFind, storeReprice, journalCommit 
+//***************************************************************************** 
+void applyPriceChanges(listingStore& store, vector<priceChange>& changes, changeSummary& summary)
+{
+	// variables 
+	operationTimer timer(OPERATION_APPLY, false); 	// Adds the changes to the metrics 
+	size_t readIndex; 						// Change record being merged 
+	size_t distinct; 						// Number of distinct MLS numbers 
+	vector<bool> matched; 					// Whether each distinct change found a listing 
+	uint32_t row; 							// Row being repriced 
+	vector<priceChange>::iterator found; 	// Change record located for a listing 
+	priceChange key; 						// MLS number to search the changes for 
+	
+	summary.recordsRead = changes.size(); 
+	summary.listingsChanged = 0; 
+	summary.unmatchedMLS.clear(); 
+	
+	// Stable sort keeps repeated reductions for an MLS number in file order 
+	stable_sort(changes.begin(), changes.end(), compareChangeMLS); 
+	
+	sumSortedChanges(changes); 
+	
+	distinct = changes.size(); 
+	summary.distinctMLS = distinct; 
+	matched.assign(distinct, false); 
+	
+	if (distinct < store.liveRows)
+	{
+		for (readIndex = 0; readIndex < distinct; readIndex++)
+		{
+			row = indexFind(store, changes[readIndex].numberMLS); 
+			
+			if (row != NO_ROW)
+			{
+				matched[readIndex] = storeReprice(store, row, store.price[row] - changes[readIndex].reduction); 
+			}
+		}
+	}
+	else
+	{
+		for (row = 0; row < store.mls.size(); row++)
+		{
+			if (store.status[row] == STATUS_DELETED)
+				continue; 
+			
+			key.numberMLS = store.mls[row]; 
+			found = lower_bound(changes.begin(), changes.end(), key, compareChangeMLS); 
+			
+			if (found != changes.end() && found->numberMLS == key.numberMLS)
+			{
+				matched[found - changes.begin()] = storeReprice(store, row, store.price[row] - found->reduction); 
+			}
+		}
+	}
+	
+	for (readIndex = 0; readIndex < distinct; readIndex++)
+	{
+		if (matched[readIndex])
+			summary.listingsChanged++; 
+		else
+			summary.unmatchedMLS.push_back(changes[readIndex].numberMLS); 
+	}
+	
+	journalCommit(store); 
+	
+	timer.recordsParsed = summary.recordsRead; 
+	timer.recordsRejected = summary.unmatchedMLS.size(); 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: compareChangeMLS
+// DESCRIPTION: Orders change records by MLS number.     
+// INPUT: Parameters: left, right - change records to compare 
+// OUTPUT: Return value: true if left sorts before right 
+//***************************************************************************** 
+bool compareChangeMLS(const priceChange& left, const priceChange& right)
+{
+	return left.numberMLS < right.numberMLS; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: displayChangeSummary
+// DESCRIPTION: Displays the results of applying a changes file.     
+// INPUT: Parameters: out - stream to write the summary to 
+// summary - results returned by applyPriceChanges 
+// OUTPUT: Outputs summary to the stream. 
+//***************************************************************************** 
+void displayChangeSummary(ostream& out, const changeSummary& summary)
+{
+	// variables 
+	size_t counter; 			// To index unmatched MLS numbers 
+	
+	if (summary.recordsRejected > 0)
+		out << summary.recordsRejected << " change record(s) with a reduction out of range were skipped" << endl; 
+	
+	if (summary.listingsChanged == 0)
+	{
+		out << "No matches were found for the file. No price reductions were made" << endl; 
+		return; 
+	}
+	
+	out << left; 
+	out << setw(28) << "Change records read:" << summary.recordsRead << endl; 
+	out << setw(28) << "Distinct MLS numbers:" << summary.distinctMLS << endl; 
+	out << setw(28) << "Listings repriced:" << summary.listingsChanged << endl; 
+	out << setw(28) << "Unmatched MLS numbers:" << summary.unmatchedMLS.size() << endl; 
+	
+	for (counter = 0; counter < summary.unmatchedMLS.size(); counter++)
+	{
+		out << summary.unmatchedMLS[counter]; 
+		
+		if ((counter + 1) % MAX_PER_LINE == 0 || counter + 1 == summary.unmatchedMLS.size())
+			out << endl; 
+		else
+			out << " "; 
+	}
+	
+}
+
+//*****************************************************************************
+// FUNCTION: loadListingsFile
+// DESCRIPTION: Empties the store and loads a listings file into it. A shard 
+// directory has its chosen shards loaded. A snapshot file is loaded 
+// directly, and a text file is loaded from its snapshot when that is at 
+// least as new as the file. The text file is parsed if no usable snapshot 
+// is found. The chunks of a text file are 
+// checksummed so a new version of it can later be reloaded in part. The 
+// price history saved beside the file is read with it. Changes are tracked 
+// from the file as loaded. 
+// INPUT: Parameters: fileName - name of the listings or snapshot file 
+// store - listing store to fill 
+// summary - receives the counts of records loaded and skipped 
+// OUTPUT: reference parameters: store, summary 
+// Return value: false if the file could not be read 
+// CALLS TO: isShardDirectory, loadShardDirectory, isSnapshotFile, 
+// loadSnapshotFile, snapshotIsCurrent, 
+// loadListingsMapped, fileSize, fingerprintListingsFile, fileIdentity, 
+// loadHistoryFile 
+//***************************************************************************** 
+bool loadListingsFile(const string& fileName, listingStore& store, loadSummary& summary)
+{
+	// variables 
+	operationTimer timer(OPERATION_LOAD, true); 	// Adds the load to the metrics 
+	const char *error; 			// Reason a snapshot could not be loaded 
+	string source; 				// File the listings were read from 
+	bool sharded; 				// Whether the name is a shard directory 
+
+	summary.recordsLoaded = 0; 
+	summary.recordsRejected = 0; 
+	summary.memoryFull = false; 
+	summary.fromSnapshot = false; 
+	source = fileName; 
+	sharded = isShardDirectory(fileName); 
+
+	if (sharded)
+	{
+		if (!loadShardDirectory(fileName, store, summary))
+			return false; 
+	}
+	else if (isSnapshotFile(fileName))
+	{
+		if (!loadSnapshotFile(fileName, store, error))
+		{
+			cerr << "Snapshot " << fileName << ": " << error << "." << endl; 
+			return false; 
+		}
+
+		summary.fromSnapshot = true; 
+	}
+	else if (snapshotIsCurrent(fileName))
+	{
+		if (loadSnapshotFile(fileName + SNAPSHOT_EXTENSION, store, error))
+		{
+			source = fileName + SNAPSHOT_EXTENSION; 
+			summary.fromSnapshot = true; 
+		}
+		else
+			cerr << "Snapshot " << fileName + SNAPSHOT_EXTENSION << ": " << error 
+			     << " - reading " << fileName << " instead." << endl; 
+	}
+
+	if (!sharded && !summary.fromSnapshot && !loadListingsMapped(fileName, store, summary))
+		return false; 
+
+	if (summary.fromSnapshot)
+		summary.recordsLoaded = store.liveRows; 
+
+	// Without the chunks of the text file, its first reload parses every line 
+	if (sharded || isSnapshotFile(fileName))
+		store.fingerprint = fileFingerprint(); 
+	else if (summary.fromSnapshot || summary.memoryFull)
+	{
+		store.fingerprint = fileFingerprint(); 
+		store.fingerprint.fileName = fileName; 
+		fileIdentity(fileName, store.fingerprint.size, store.fingerprint.modified); 
+	}
+	else
+		fingerprintListingsFile(fileName, store.fingerprint); 
+
+	if (!loadHistoryFile(fileName, store.history))
+		cerr << "Price history " << fileName + HISTORY_EXTENSION << ": not a readable history file." << endl; 
+
+	// The listings just loaded are the file, not changes to it 
+	store.delta = deltaTracker(); 
+	store.delta.fileName = fileName; 
+
+	timer.bytesRead = fileSize(source); 
+	timer.recordsParsed = summary.recordsLoaded + summary.recordsRejected; 
+	timer.recordsRejected = summary.recordsRejected; 
+	timer.succeeded = true; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: loadListingsMapped
+// DESCRIPTION: Empties the store and loads a listings file into it. 
+// INPUT: Parameters: fileName - name of the listings file 
+// store - listing store to fill 
+// summary - receives the counts of records loaded and skipped 
+// OUTPUT: reference parameters: store, summary 
+// Return value: false if the file could not be mapped 
+// CALLS TO: storeClear, appendListingsMapped 
+//***************************************************************************** 
+bool loadListingsMapped(const string& fileName, listingStore& store, loadSummary& summary)
+{
+	storeClear(store); 
+
+	return appendListingsMapped(fileName, store, summary); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: appendListingsMapped
+// DESCRIPTION: Adds the listings of a file to the store by parsing the bytes 
+// of a memory mapping in place. Nothing is allocated per record beyond the 
+// store columns and new company names. Malformed lines and repeated MLS 
+// numbers are reported with their line numbers and skipped. Large files are 
+// parsed on several threads.   
+// INPUT: Parameters: fileName - name of the listings file 
+// store - listing store to add to 
+// summary - receives the counts of records loaded and skipped 
+// OUTPUT: reference parameters: store, summary 
+// Return value: false if the file could not be mapped 
+// CALLS TO: mapFile, unmapFile, parseListingLine, reportLoadError, 
+// packZip, indexFind, storeAppend, storeReserve, journalCommit, 
+// loadThreadCount, splitListingsChunks, appendListingsParallel 
+//***************************************************************************** 
+bool appendListingsMapped(const string& fileName, listingStore& store, loadSummary& summary)
+{
+	// variables 
+	mappedFile input; 			// Mapped bytes of the listings file 
+	const char *position; 		// Start of the line being parsed 
+	const char *end; 			// End of the mapped bytes 
+	const char *lineEnd; 		// End of the line being parsed 
+	int lineNumber; 			// Line number of the line being parsed 
+	parsedListing record; 		// Fields of the line being parsed 
+	const char *error; 			// Reason a line could not be parsed 
+	uint32_t packedZip; 		// Zip code of the line packed for the store 
+	int threads; 				// Threads to parse the file with 
+	vector<parsedChunk> chunks; 	// Chunks of the file to parse in parallel 
+	
+	summary.recordsLoaded = 0; 
+	summary.recordsRejected = 0; 
+	summary.memoryFull = false; 
+	summary.fromSnapshot = false; 
+	
+	if (!mapFile(fileName, input))
+		return false; 
+	
+	// Presizing the columns avoids copying them each time they would grow 
+	storeReserve(store, store.mls.size() + input.size / ESTIMATED_LINE_BYTES + 1); 
+	
+	threads = loadThreadCount(store); 
+	
+	if (threads > 1 && input.size >= PARALLEL_MIN_BYTES)
+	{
+		splitListingsChunks(input, chunks); 
+		appendListingsParallel(chunks, threads, store, summary); 
+		
+		unmapFile(input); 
+		journalCommit(store); 
+		
+		return true; 
+	}
+	
+	position = input.data; 
+	end = input.data + input.size; 
+	lineNumber = 0; 
+	
+	while (position < end && !summary.memoryFull)
+	{
+		lineEnd = static_cast<const char*>(memchr(position, '\n', end - position)); 
+		
+		if (lineEnd == NULL)
+			lineEnd = end; 
+		
+		lineNumber++; 
+		
+		if (!parseListingLine(string_view(position, lineEnd - position), record, error))
+			reportLoadError(summary, lineNumber, error); 
+		else if (record.numberMLS != 0)
+		{
+			if (!packZip(record.zipCode, packedZip))
+				reportLoadError(summary, lineNumber, "invalid zip code"); 
+			else if (indexFind(store, record.numberMLS) != NO_ROW)
+				reportLoadError(summary, lineNumber, "duplicate MLS number"); 
+			else if (storeAppend(store, record.numberMLS, record.price, record.status, 
+			                     packedZip, record.realtyCompany) == NO_ROW)
+				summary.memoryFull = true; 
+			else
+				summary.recordsLoaded++; 
+		}
+		
+		position = lineEnd + 1; 
+	}
+	
+	unmapFile(input); 
+	journalCommit(store); 
+	
+	return true; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: splitListingsChunks
+// DESCRIPTION: Splits a mapped listings file at line ends into chunks of 
+// about CHUNK_BYTES for appendListingsParallel to parse, after any chunks 
+// of files already split. 
+// INPUT: Parameters: input - mapped bytes of the listings file 
+// chunks - chunks to add to 
+// OUTPUT: reference parameter: chunks 
+//***************************************************************************** 
+void splitListingsChunks(const mappedFile& input, vector<parsedChunk>& chunks)
+{
+	// variables 
+	const char *position; 				// Start of the next chunk 
+	const char *end; 					// End of the mapped bytes 
+	const char *lineEnd; 				// End of the line a chunk ends on 
+
+	position = input.data; 
+	end = input.data + input.size; 
+
+	while (position < end)
+	{
+		chunks.push_back(parsedChunk()); 
+		chunks.back().begin = position; 
+		chunks.back().fileStart = (position == input.data); 
+
+		if (static_cast<size_t>(end - position) <= CHUNK_BYTES)
+			position = end; 
+		else
+		{
+			lineEnd = static_cast<const char*>(memchr(position + CHUNK_BYTES, '\n', end - position - CHUNK_BYTES)); 
+			position = (lineEnd == NULL) ? end : lineEnd + 1; 
+		}
+
+		chunks.back().end = position; 
+	}
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: appendListingsParallel
+// DESCRIPTION: Adds the listings of mapped files, split into chunks by 
+// splitListingsChunks, to the store using several threads. Worker threads 
+// parse chunks into their own buffers while this thread 
+// merges finished chunks into the store in file order, so the store is 
+// filled exactly as a single-threaded load would fill it. MLS numbers 
+// repeated within or across chunks are found during the merge. Workers stay 
+// at most a few chunks ahead of the merge, which bounds the memory used by 
+// parsed chunks. 
+// INPUT: Parameters: chunks - chunks of the listings files, in order 
+// threads - number of worker threads 
+// store - listing store to add to 
+// summary - counts of records loaded and skipped to update 
+// OUTPUT: reference parameters: chunks, store, summary 
+// CALLS TO: parseListingsWorker, mergeListingsChunk 
+//***************************************************************************** 
+void appendListingsParallel(vector<parsedChunk>& chunks, int threads, listingStore& store, loadSummary& summary)
+{
+	// variables 
+	chunkSchedule schedule; 			// Hands chunks to the workers 
+	vector<thread> workers; 			// Parsing threads 
+	size_t chunkIndex; 					// Chunk being merged 
+	int firstLine; 						// Line number of the first line of the chunk 
+	int worker; 						// Worker being started 
+
+	schedule.nextChunk = 0; 
+	schedule.mergedChunks = 0; 
+	schedule.window = threads * CHUNKS_AHEAD_PER_THREAD; 
+	schedule.parsed.assign(chunks.size(), false); 
+
+	for (worker = 0; worker < threads; worker++)
+		workers.push_back(thread(parseListingsWorker, ref(chunks), ref(schedule))); 
+
+	firstLine = 1; 
+
+	for (chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
+	{
+		{
+			unique_lock<mutex> guard(schedule.lock); 
+
+			while (!schedule.parsed[chunkIndex])
+				schedule.changed.wait(guard); 
+		}
+
+		// Lines are numbered from the start of each file 
+		if (chunks[chunkIndex].fileStart)
+			firstLine = 1; 
+
+		if (chunks[chunkIndex].failed)
+			summary.memoryFull = true; 
+		else if (!summary.memoryFull)
+			mergeListingsChunk(store, chunks[chunkIndex], firstLine, summary); 
+
+		firstLine += chunks[chunkIndex].lines; 
+		chunks[chunkIndex] = parsedChunk(); 
+
+		{
+			lock_guard<mutex> guard(schedule.lock); 
+
+			schedule.mergedChunks++; 
+
+			// Once memory is full the remaining chunks are not parsed 
+			if (summary.memoryFull)
+				schedule.nextChunk = chunks.size(); 
+		}
+
+		schedule.changed.notify_all(); 
+
+		if (summary.memoryFull)
+			break; 
+	}
+
+	for (worker = 0; worker < threads; worker++)
+		workers[worker].join(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseListingsWorker
+// DESCRIPTION: Runs on a worker thread, parsing the next chunk not yet taken 
+// until every chunk has been taken. A worker waits while it would get more 
+// than the schedule's window of chunks ahead of the merge. 
+// INPUT: Parameters: chunks - chunks of the file in order 
+// schedule - hands chunks to the workers 
+// OUTPUT: reference parameters: chunks, schedule 
+// CALLS TO: parseListingsChunk 
+//***************************************************************************** 
+void parseListingsWorker(vector<parsedChunk>& chunks, chunkSchedule& schedule)
+{
+	// variables 
+	size_t chunkIndex; 			// Chunk being parsed 
+
+	while (true)
+	{
+		{
+			unique_lock<mutex> guard(schedule.lock); 
+
+			while (schedule.nextChunk < chunks.size() 
+			       && schedule.nextChunk >= schedule.mergedChunks + schedule.window)
+				schedule.changed.wait(guard); 
+
+			if (schedule.nextChunk >= chunks.size())
+				return; 
+
+			chunkIndex = schedule.nextChunk++; 
+		}
+
+		try
+		{
+			parseListingsChunk(chunks[chunkIndex]); 
+		}
+		catch (bad_alloc&)
+		{
+			chunks[chunkIndex].failed = true; 
+		}
+
+		{
+			lock_guard<mutex> guard(schedule.lock); 
+			schedule.parsed[chunkIndex] = true; 
+		}
+
+		schedule.changed.notify_all(); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseListingsChunk
+// DESCRIPTION: Parses every line of a chunk of a listings file into the 
+// chunk's buffers, recording the lines that could not be parsed. Company 
+// names are kept as views of the mapped file. 
+// INPUT: Parameters: chunk - chunk to parse 
+// OUTPUT: reference parameter: chunk 
+// CALLS TO: parseListingLine, packZip 
+//***************************************************************************** 
+void parseListingsChunk(parsedChunk& chunk)
+{
+	// variables 
+	const char *position; 		// Start of the line being parsed 
+	const char *lineEnd; 		// End of the line being parsed 
+	parsedListing record; 		// Fields of the line being parsed 
+	const char *error; 			// Reason a line could not be parsed 
+	uint32_t packedZip; 		// Zip code of the line packed for the store 
+	size_t estimate; 			// Expected number of listings in the chunk 
+
+	estimate = (chunk.end - chunk.begin) / ESTIMATED_LINE_BYTES + 1; 
+	chunk.mls.reserve(estimate); 
+	chunk.price.reserve(estimate); 
+	chunk.status.reserve(estimate); 
+	chunk.zip.reserve(estimate); 
+	chunk.company.reserve(estimate); 
+	chunk.recordLines.reserve(estimate); 
+
+	position = chunk.begin; 
+
+	while (position < chunk.end)
+	{
+		lineEnd = static_cast<const char*>(memchr(position, '\n', chunk.end - position)); 
+
+		if (lineEnd == NULL)
+			lineEnd = chunk.end; 
+
+		if (!parseListingLine(string_view(position, lineEnd - position), record, error))
+		{
+			chunk.errorLines.push_back(chunk.lines); 
+			chunk.errorReasons.push_back(error); 
+		}
+		else if (record.numberMLS != 0 && !packZip(record.zipCode, packedZip))
+		{
+			chunk.errorLines.push_back(chunk.lines); 
+			chunk.errorReasons.push_back("invalid zip code"); 
+		}
+		else if (record.numberMLS != 0)
+		{
+			chunk.mls.push_back(record.numberMLS); 
+			chunk.price.push_back(record.price); 
+			chunk.status.push_back(record.status); 
+			chunk.zip.push_back(packedZip); 
+			chunk.company.push_back(record.realtyCompany); 
+			chunk.recordLines.push_back(chunk.lines); 
+		}
+
+		chunk.lines++; 
+		position = lineEnd + 1; 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: mergeListingsChunk
+// DESCRIPTION: Adds the listings parsed from a chunk to the store and 
+// reports the chunk's skipped lines, in line order. A listing whose MLS 
+// number is already in the store is skipped as a duplicate. 
+// INPUT: Parameters: store - listing store to add to 
+// chunk - parsed chunk 
+// firstLine - line number of the first line of the chunk 
+// summary - counts of records loaded and skipped to update 
+// OUTPUT: reference parameters: store, summary 
+// CALLS TO: reportLoadError, indexFind, storeAppend 
+//***************************************************************************** 
+void mergeListingsChunk(listingStore& store, const parsedChunk& chunk, int firstLine, loadSummary& summary)
+{
+	// variables 
+	size_t record; 				// Next listing of the chunk to add 
+	size_t error; 				// Next skipped line of the chunk to report 
+
+	record = 0; 
+	error = 0; 
+
+	while (record < chunk.mls.size() || error < chunk.errorLines.size())
+	{
+		if (error < chunk.errorLines.size() 
+		    && (record == chunk.mls.size() || chunk.errorLines[error] < chunk.recordLines[record]))
+		{
+			reportLoadError(summary, firstLine + chunk.errorLines[error], chunk.errorReasons[error]); 
+			error++; 
+		}
+		else
+		{
+			if (indexFind(store, chunk.mls[record]) != NO_ROW)
+				reportLoadError(summary, firstLine + chunk.recordLines[record], "duplicate MLS number"); 
+			else if (storeAppend(store, chunk.mls[record], chunk.price[record], 
+			                     static_cast<statusOptions>(chunk.status[record]), 
+			                     chunk.zip[record], chunk.company[record]) == NO_ROW)
+			{
+				summary.memoryFull = true; 
+				return; 
+			}
+			else
+				summary.recordsLoaded++; 
+
+			record++; 
+		}
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: loadThreadCount
+// DESCRIPTION: Returns the number of threads to parse a large listings file 
+// with: the store's setting, or one per processor core if it is 0. 
+// INPUT: Parameters: store - listing store holding the setting 
+// OUTPUT: Return value: number of threads, at least 1 
+//***************************************************************************** 
+int loadThreadCount(const listingStore& store)
+{
+	if (store.loadThreads > 0)
+		return store.loadThreads; 
+
+	return max(1u, thread::hardware_concurrency()); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseListingLine
+// DESCRIPTION: Parses one line of a listings file, laid out as 
+// "MLS price status zip company". Numbers are converted with from_chars, the 
+// price to whole cents, and the zip code and company name are returned as 
+// views into the line. The company name is everything after the single 
+// space following the zip code, less a trailing carriage return.   
+// INPUT: Parameters: line - text of the line, without its newline 
+// record - receives the fields of the line 
+// error - receives the reason the line is malformed 
+// OUTPUT: reference parameters: record, error 
+// Return value: false if the line is malformed. A blank line is valid and 
+// returns an MLS number of 0. 
+// CALLS TO: dollarsToCents 
+//***************************************************************************** 
+bool parseListingLine(string_view line, parsedListing& record, const char* &error)
+{
+	// variables 
+	const char *position; 		// Next character to parse 
+	const char *end; 			// End of the line 
+	const char *tokenStart; 	// Start of the zip code 
+	int status; 				// Status digit before conversion to enumerated type 
+	double price; 				// Price in dollars before conversion to cents 
+	from_chars_result result; 	// Result of each number conversion 
+	
+	end = line.data() + line.size(); 
+	
+	if (end > line.data() && end[-1] == '\r')
+		end--; 
+	
+	position = line.data(); 
+	
+	while (position < end && isspace(static_cast<unsigned char>(*position)))
+		position++; 
+	
+	record.numberMLS = 0; 
+	
+	if (position == end)
+		return true; 
+	
+	result = from_chars(position, end, record.numberMLS); 
+	
+	if (result.ec != errc() || record.numberMLS < MLS_MIN || record.numberMLS > MLS_MAX)
+	{
+		error = "invalid MLS number"; 
+		return false; 
+	}
+	
+	position = result.ptr; 
+	
+	while (position < end && isspace(static_cast<unsigned char>(*position)))
+		position++; 
+	
+	result = from_chars(position, end, price); 
+	
+	if (result.ec != errc() || !dollarsToCents(price, record.price))
+	{
+		error = "invalid price"; 
+		return false; 
+	}
+	
+	position = result.ptr; 
+	
+	while (position < end && isspace(static_cast<unsigned char>(*position)))
+		position++; 
+	
+	result = from_chars(position, end, status); 
+	
+	if (result.ec != errc() || status < AVAILABLE || status > SOLD)
+	{
+		error = "invalid status"; 
+		return false; 
+	}
+	
+	record.status = static_cast<statusOptions>(status); 
+	position = result.ptr; 
+	
+	while (position < end && isspace(static_cast<unsigned char>(*position)))
+		position++; 
+	
+	tokenStart = position; 
+	
+	while (position < end && !isspace(static_cast<unsigned char>(*position)))
+		position++; 
+	
+	if (position == tokenStart)
+	{
+		error = "missing zip code"; 
+		return false; 
+	}
+	
+	record.zipCode = string_view(tokenStart, position - tokenStart); 
+	
+	// To skip the single separator before the company name 
+	if (position < end)
+		position++; 
+	
+	record.realtyCompany = string_view(position, end - position); 
+	
+	return true; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: reportLoadError
+// DESCRIPTION: Reports a line of a listings file that was skipped. Only the 
+// first MAX_ERRORS_SHOWN lines are shown; the rest are only counted.    
+// INPUT: Parameters: summary - load results to update 
+// lineNumber - line number of the skipped line 
+// reason - why the line was skipped 
+// OUTPUT: reference parameter: summary 
+//***************************************************************************** 
+void reportLoadError(loadSummary& summary, int lineNumber, const char* reason)
+{
+	summary.recordsRejected++; 
+	
+	if (summary.recordsRejected <= MAX_ERRORS_SHOWN)
+		cerr << "Line " << lineNumber << ": " << reason << " - record skipped." << endl; 
+	else if (summary.recordsRejected == MAX_ERRORS_SHOWN + 1)
+		cerr << "Further skipped lines will not be shown." << endl; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: ImportListings
+// DESCRIPTION: Allows user to add the new listings of the import file. Lines 
+// breaking the rules of AddListing are written to a rejects file with the 
+// reason for each.    
+// INPUT: Parameters: store - listing store to add to  
+// OUTPUT: Summary of the import, output to screen.   
+// CALLS TO: importListingsFile 
+//***************************************************************************** 
+void ImportListings(listingStore& store)
+{
+	// Function local variables
+	loadSummary summary; 		 // To receive the counts of listings imported and rejected 
+	string error; 				 // To receive the reason the import failed 
+	
+	if (!importListingsFile(FILE_IMPORT, store, summary, error))
+		cout << "New listings file " << FILE_IMPORT << ": " << error << "." << endl << endl; 
+	else
+	{
+		cout << summary.recordsLoaded << " new listing(s) imported." << endl; 
+		
+		if (summary.recordsRejected > 0)
+			cout << summary.recordsRejected << " line(s) rejected - see " 
+			     << FILE_IMPORT + REJECTS_EXTENSION << " for the reasons." << endl; 
+		
+		if (summary.memoryFull)
+			cout << "Memory is full. The remaining listings were not imported." << endl; 
+		
+	cout << endl; 	
+		
+	}	
+}
+
+//*****************************************************************************
+// FUNCTION: importListingsFile
+// DESCRIPTION: Adds the new listings of a file, holding the same 
+// "MLS price status zip company" lines as a listings file, after checking 
+// each against the rules AddListing applies to a listing entered by hand. 
+// The file is parsed into columns, every rule is checked over the whole 
+// batch by validateImportBatch, and then the lines that passed are added in 
+// file order with their company names title-cased. Every rejected line is 
+// written to the file's rejects file, which is replaced by each import. 
+// INPUT: Parameters: fileName - name of the import file 
+// store - listing store to add to 
+// summary - receives the counts of listings imported and rejected 
+// error - receives the reason the import failed 
+// OUTPUT: reference parameters: store, summary, error 
+// Return value: false if the file could not be read or the rejects file 
+// could not be written 
+// CALLS TO: mapFile, unmapFile, appendImportLine, validateImportBatch, 
+// titleCaseCompany, storeAppend, journalCommit, writeRejectsFile 
+//***************************************************************************** 
+bool importListingsFile(const string& fileName, listingStore& store, loadSummary& summary, string& error)
+{
+	// variables 
+	operationTimer timer(OPERATION_IMPORT, true); 	// Adds the import to the metrics 
+	mappedFile input; 			// Mapped bytes of the import file 
+	const char *position; 		// Start of the line being parsed 
+	const char *end; 			// End of the mapped bytes 
+	const char *lineEnd; 		// End of the line being parsed 
+	int lineNumber; 			// Line number of the line being parsed 
+	string_view line; 			// Text of the line being parsed 
+	importBatch batch; 			// Lines of the file, column by column 
+	string companyName; 		// Company name of the listing being added 
+	size_t index; 				// Line of the batch being added 
+	
+	summary.recordsLoaded = 0; 
+	summary.recordsRejected = 0; 
+	summary.memoryFull = false; 
+	summary.fromSnapshot = false; 
+	
+	if (!mapFile(fileName, input))
+	{
+		error = "file could not be read"; 
+		return false; 
+	}
+	
+	position = input.data; 
+	end = input.data + input.size; 
+	lineNumber = 0; 
+	
+	while (position < end)
+	{
+		lineEnd = static_cast<const char*>(memchr(position, '\n', end - position)); 
+		
+		if (lineEnd == NULL)
+			lineEnd = end; 
+		
+		lineNumber++; 
+		line = string_view(position, lineEnd - position); 
+		position = lineEnd + 1; 
+		
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1); 
+		
+		appendImportLine(batch, line, lineNumber); 
+	}
+	
+	validateImportBatch(store, batch); 
+	
+	for (index = 0; index < batch.mls.size(); index++)
+	{
+		if (batch.reason[index] != NULL)
+			continue; 
+		
+		if (summary.memoryFull)
+		{
+			batch.reason[index] = "memory full"; 
+			continue; 
+		}
+		
+		companyName.assign(batch.company[index]); 
+		titleCaseCompany(companyName); 
+		
+		if (storeAppend(store, batch.mls[index], batch.price[index], 
+		                static_cast<statusOptions>(batch.status[index]), batch.zip[index], companyName) == NO_ROW)
+		{
+			summary.memoryFull = true; 
+			batch.reason[index] = "memory full"; 
+		}
+		else
+			summary.recordsLoaded++; 
+	}
+	
+	journalCommit(store); 
+	
+	summary.recordsRejected = batch.mls.size() - summary.recordsLoaded; 
+	timer.bytesRead = input.size; 
+	timer.recordsParsed = batch.mls.size(); 
+	timer.recordsRejected = summary.recordsRejected; 
+	
+	// The rejected lines are views of the mapping, so they are written first 
+	if (!writeRejectsFile(fileName + REJECTS_EXTENSION, batch))
+	{
+		unmapFile(input); 
+		error = "rejects file could not be written"; 
+		return false; 
+	}
+	
+	unmapFile(input); 
+	timer.succeeded = true; 
+	
+	return true; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: appendImportLine
+// DESCRIPTION: Parses one line of new listings and adds its fields to an 
+// import batch, with the reason it is rejected if it cannot be parsed or 
+// its zip code is malformed. Blank lines are passed over. The batch holds 
+// views of the line, so the line must outlive it. 
+// INPUT: Parameters: batch - import batch to add to 
+// line - text of the line, without its line ending 
+// lineNumber - line number to report the line by 
+// OUTPUT: reference parameter: batch 
+// Return value: false if the line is blank 
+// CALLS TO: parseListingLine, packZip 
+//***************************************************************************** 
+bool appendImportLine(importBatch& batch, string_view line, int lineNumber)
+{
+	// variables 
+	parsedListing record; 		// Fields of the line 
+	const char *reason; 		// Why the line is rejected, or NULL 
+	uint32_t packedZip; 		// Zip code of the line packed for the store 
+	
+	reason = NULL; 
+	packedZip = 0; 
+	
+	if (!parseListingLine(line, record, reason))
+		record = parsedListing(); 
+	else if (record.numberMLS == 0)
+		return false; 
+	else if (!packZip(record.zipCode, packedZip))
+		reason = "invalid zip code"; 
+	
+	batch.mls.push_back(record.numberMLS); 
+	batch.price.push_back(record.price); 
+	batch.status.push_back(record.status); 
+	batch.zip.push_back(packedZip); 
+	batch.company.push_back(record.realtyCompany); 
+	batch.text.push_back(line); 
+	batch.lines.push_back(lineNumber); 
+	batch.reason.push_back(reason); 
+	
+	return true; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: validateImportBatch
+// DESCRIPTION: Checks the lines of an import file against the rules for a 
+// new listing, giving each line that breaks one the reason. parseListingLine 
+// and packZip have already checked the MLS number range, the status and the 
+// zip code format. Each remaining rule is a pass over one column of the 
+// batch, so the checks run over contiguous arrays: the price must be more 
+// than 0, the company name must pass checkCompanyName, and the MLS number 
+// must be neither on file nor on an earlier valid line of the batch. 
+// INPUT: Parameters: store - listing store the batch is added to 
+// batch - lines of the import file 
+// OUTPUT: reference parameter: batch 
+// CALLS TO: checkCompanyName, indexFind 
+//***************************************************************************** 
+void validateImportBatch(const listingStore& store, importBatch& batch)
+{
+	// variables 
+	vector<uint8_t> failed; 		// Whether each line broke the rule being checked 
+	vector<uint64_t> keys; 			// MLS number of each valid line above its position 
+	size_t count; 					// Lines in the batch 
+	size_t index; 					// Line being checked 
+
+	count = batch.mls.size(); 
+	failed.resize(count); 
+
+	for (index = 0; index < count; index++)
+		failed[index] = batch.price[index] <= 0; 
+
+	for (index = 0; index < count; index++)
+		if (failed[index] && batch.reason[index] == NULL)
+			batch.reason[index] = "price must be greater than $0.00"; 
+
+	for (index = 0; index < count; index++)
+		if (batch.reason[index] == NULL)
+			batch.reason[index] = checkCompanyName(batch.company[index]); 
+
+	for (index = 0; index < count; index++)
+		if (batch.reason[index] == NULL && indexFind(store, batch.mls[index]) != NO_ROW)
+			batch.reason[index] = "duplicate MLS number"; 
+
+	// Sorting puts the lines of each MLS number together, first line first 
+	keys.reserve(count); 
+
+	for (index = 0; index < count; index++)
+		if (batch.reason[index] == NULL)
+			keys.push_back(static_cast<uint64_t>(batch.mls[index]) << 32 | index); 
+
+	sort(keys.begin(), keys.end()); 
+
+	for (index = 1; index < keys.size(); index++)
+		if (keys[index] >> 32 == keys[index - 1] >> 32)
+			batch.reason[static_cast<uint32_t>(keys[index])] = "MLS number repeated in the file"; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: checkCompanyName
+// DESCRIPTION: Checks a realty company name against the rules of 
+// ValidateCompanyName: 1 to COMPANY_LENGTH characters, each a letter or a 
+// space. The characters are checked without branching, so the loop can be 
+// vectorized. 
+// INPUT: Parameters: name - company name 
+// OUTPUT: Return value: why the name breaks the rules, or NULL if it is valid 
+//***************************************************************************** 
+const char* checkCompanyName(string_view name)
+{
+	// variables 
+	unsigned int invalid = 0; 		// Nonzero once a character is not a letter or space 
+	unsigned char letter; 			// Character folded to lower case 
+	size_t index; 					// Character being checked 
+
+	if (name.empty())
+		return "missing realty company name"; 
+
+	if (name.size() > static_cast<size_t>(COMPANY_LENGTH))
+		return "realty company name longer than 20 characters"; 
+
+	for (index = 0; index < name.size(); index++)
+	{
+		letter = static_cast<unsigned char>(name[index]) | 0x20; 
+		invalid |= static_cast<unsigned char>(letter - 'a') >= 26 && name[index] != ' '; 
+	}
+
+	return invalid ? "realty company name may hold only letters and spaces" : NULL; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: titleCaseCompany
+// DESCRIPTION: Capitalizes the first letter of each word of a company name 
+// and puts the other letters in lower case.    
+// INPUT: Parameters: name - company name 
+// OUTPUT: reference parameter: name 
+//***************************************************************************** 
+void titleCaseCompany(string& name)
+{
+	// variables 
+	size_t index; 				// To store index of character being formatted 
+
+	if (name.empty())
+		return; 
+
+	name[0] = toupper(name[0]); 
+
+	for (index = 1; index < name.size(); index++)
+	{
+		if (isspace(name[index - 1]))
+			name[index] = toupper(name[index]); 
+		else
+			name[index] = tolower(name[index]); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeRejectsFile
+// DESCRIPTION: Writes the rejected lines of an import file, one 
+// "line<TAB>reason<TAB>text" line each in file order, replacing the file. 
+// The file is written even when no line was rejected, so it always describes 
+// the last import. 
+// INPUT: Parameters: fileName - name of the rejects file 
+// batch - lines of the import file 
+// OUTPUT: Output direct to file. 
+// Return value: false if the file could not be written 
+//***************************************************************************** 
+bool writeRejectsFile(const string& fileName, const importBatch& batch)
+{
+	// variables 
+	FILE *outputFile; 			// Rejects file 
+	string text; 				// Rejected lines formatted for the file 
+	size_t index; 				// Line of the batch being checked 
+	bool written; 				// Whether every write succeeded 
+
+	for (index = 0; index < batch.mls.size(); index++)
+	{
+		if (batch.reason[index] == NULL)
+			continue; 
+
+		text += to_string(batch.lines[index]); 
+		text += '\t'; 
+		text += batch.reason[index]; 
+		text += '\t'; 
+		text += batch.text[index]; 
+		text += '\n'; 
+	}
+
+	outputFile = fopen(fileName.c_str(), "w"); 
+
+	if (outputFile == NULL)
+		return false; 
+
+	written = fwrite(text.data(), 1, text.size(), outputFile) == text.size(); 
+	written = (fclose(outputFile) == 0) && written; 
+
+	return written; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: mapFile
+// DESCRIPTION: Maps a whole file into memory for reading. Where memory 
+// mapping is not available the file is read into a buffer instead.    
+// INPUT: Parameters: fileName - name of the file to map 
+// file - receives the mapping 
+// OUTPUT: reference parameter: file 
+// Return value: false if the file could not be opened or mapped 
+//***************************************************************************** 
+bool mapFile(const string& fileName, mappedFile& file)
+{
+	file.data = NULL; 
+	file.size = 0; 
+	file.mapped = false; 
+	
+#ifdef _WIN32
+	ifstream input(fileName.c_str(), ios::binary); 
+	
+	if (!input)
+		return false; 
+	
+	file.buffer.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>()); 
+	file.data = file.buffer.data(); 
+	file.size = file.buffer.size(); 
+#else
+	int descriptor; 			// Descriptor of the open file 
+	struct stat fileInfo; 		// To receive the size of the file 
+	void *address; 				// Start of the mapping 
+	
+	descriptor = open(fileName.c_str(), O_RDONLY); 
+	
+	if (descriptor < 0)
+		return false; 
+	
+	if (fstat(descriptor, &fileInfo) != 0)
+	{
+		close(descriptor); 
+		return false; 
+	}
+	
+	if (fileInfo.st_size > 0)
+	{
+		address = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0); 
 		
-		testFile.open(fileName.c_str());
+		if (address == MAP_FAILED)
+		{
+			close(descriptor); 
+			return false; 
+		}
 		
+		madvise(address, fileInfo.st_size, MADV_SEQUENTIAL); 
 		
-		if (testFile)
+		file.data = static_cast<const char*>(address); 
+		file.size = fileInfo.st_size; 
+		file.mapped = true; 
+	}
+	
+	close(descriptor); 
+#endif
+	
+	return true; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: unmapFile
+// DESCRIPTION: Releases a file mapped by mapFile.    
+// INPUT: Parameters: file - mapping to release 
+// OUTPUT: reference parameter: file 
+//***************************************************************************** 
+void unmapFile(mappedFile& file)
+{
+#ifndef _WIN32
+	if (file.mapped)
+		munmap(const_cast<char*>(file.data), file.size); 
+#endif
+	
+	vector<char>().swap(file.buffer); 
+	file.data = NULL; 
+	file.size = 0; 
+	file.mapped = false; 
+	
+}
+
+//*****************************************************************************
+// FUNCTION: writeSnapshotFile
+// DESCRIPTION: Writes the store to a binary snapshot file that can be loaded 
+// without parsing. The store is compacted first. After a snapshotHeader come 
+// these sections, each padded to SNAPSHOT_ALIGNMENT bytes: the mls, zip and 
+// company columns, the price column, the status column, the offsets of the 
+// company names (one more than there are names), the company name 
+// characters and the MLS index slots. Numbers are stored in the byte order 
+// of the machine writing the file. The checksum and size in the header are 
+// worked out first, so the file is written from start to end through the 
+// file I/O backend. 
+// INPUT: Parameters: fileName - name of the snapshot file 
+// store - listing store to save 
+// OUTPUT: reference parameter: store 
+// Output direct to file. 
+// Return value: false if the file could not be written 
+// CALLS TO: storeCompact, snapshotChecksum, snapshotAlign, ioWriterOpen, 
+// ioWriterWrite, writeSnapshotSection, ioWriterClose 
+//***************************************************************************** 
+bool writeSnapshotFile(const string& fileName, listingStore& store)
+{
+	// variables 
+	operationTimer timer(OPERATION_SNAPSHOT_SAVE, true); 	// Adds the snapshot to the metrics 
+	ioWriter output; 				// Snapshot file 
+	snapshotHeader header; 			// Header of the snapshot 
+	vector<uint32_t> nameOffsets; 	// Offset of each company name in the name characters 
+	string nameCharacters; 			// All company names, one after another 
+	uint32_t id; 					// Company name id being added 
+	const void *sections[SNAPSHOT_SECTIONS]; 	// First byte of each section 
+	size_t sectionBytes[SNAPSHOT_SECTIONS]; 	// Bytes in each section 
+	int section; 					// Section being checksummed or written 
+	bool written; 				// Whether every write succeeded 
+	size_t rows; 					// Listings in the snapshot 
+
+	storeCompact(store); 
+	rows = store.mls.size(); 
+
+	nameOffsets.reserve(store.companyNames.size() + 1); 
+
+	for (id = 0; id < store.companyNames.size(); id++)
+	{
+		nameOffsets.push_back(nameCharacters.size()); 
+		nameCharacters += store.companyNames[id]; 
+	}
+
+	nameOffsets.push_back(nameCharacters.size()); 
+
+	memset(&header, 0, sizeof(header)); 
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)); 
+	header.version = SNAPSHOT_VERSION; 
+	header.byteOrder = SNAPSHOT_BYTE_ORDER; 
+	header.recordCount = rows; 
+	header.companyCount = store.companyNames.size(); 
+	header.companyBytes = nameCharacters.size(); 
+	header.indexBits = store.indexBits; 
+	header.checksum = CHECKSUM_SEED; 
+	header.payloadBytes = 0; 
+
+	sections[0] = store.mls.data(); 
+	sectionBytes[0] = rows * sizeof(uint32_t); 
+	sections[1] = store.zip.data(); 
+	sectionBytes[1] = rows * sizeof(uint32_t); 
+	sections[2] = store.company.data(); 
+	sectionBytes[2] = rows * sizeof(uint32_t); 
+	sections[3] = store.price.data(); 
+	sectionBytes[3] = rows * sizeof(int64_t); 
+	sections[4] = store.status.data(); 
+	sectionBytes[4] = rows * sizeof(uint8_t); 
+	sections[5] = nameOffsets.data(); 
+	sectionBytes[5] = nameOffsets.size() * sizeof(uint32_t); 
+	sections[6] = nameCharacters.data(); 
+	sectionBytes[6] = nameCharacters.size(); 
+	sections[7] = store.indexSlots.data(); 
+	sectionBytes[7] = store.indexSlots.size() * sizeof(uint32_t); 
+
+	for (section = 0; section < SNAPSHOT_SECTIONS; section++)
+	{
+		header.checksum = snapshotChecksum(header.checksum, static_cast<const char*>(sections[section]), 
+		                                   sectionBytes[section]); 
+		header.payloadBytes += snapshotAlign(sectionBytes[section]); 
+	}
+
+	if (!ioWriterOpen(fileName, true, output))
+		return false; 
+
+	written = ioWriterWrite(output, reinterpret_cast<const char*>(&header), sizeof(header)); 
+
+	for (section = 0; section < SNAPSHOT_SECTIONS; section++)
+		written = written && writeSnapshotSection(output, sections[section], sectionBytes[section]); 
+
+	written = ioWriterClose(output, false) && written; 
+
+	timer.succeeded = written; 
+	timer.bytesWritten = sizeof(header) + header.payloadBytes; 
+	timer.recordsParsed = rows; 
+
+	return timer.succeeded; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeSnapshotSection
+// DESCRIPTION: Writes one section of a snapshot file, padded with zero bytes 
+// to SNAPSHOT_ALIGNMENT. 
+// INPUT: Parameters: output - snapshot file 
+// data - first byte of the section 
+// size - number of bytes in the section 
+// OUTPUT: reference parameter: output 
+// Return value: false if the section could not be written 
+// CALLS TO: ioWriterWrite, snapshotAlign 
+//***************************************************************************** 
+bool writeSnapshotSection(ioWriter& output, const void* data, size_t size)
+{
+	// variables 
+	const char padding[SNAPSHOT_ALIGNMENT] = {0}; 	// Zero bytes to pad the section with 
+
+	return ioWriterWrite(output, static_cast<const char*>(data), size) 
+	       && ioWriterWrite(output, padding, snapshotAlign(size) - size); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: loadSnapshotFile
+// DESCRIPTION: Empties the store and loads a snapshot file written by 
+// writeSnapshotFile. The file is memory-mapped, its header and checksum are 
+// checked, and each section is copied into the store in one step, including 
+// the MLS index, so no record is parsed or hashed. 
+// INPUT: Parameters: fileName - name of the snapshot file 
+// store - listing store to fill 
+// error - receives the reason the snapshot could not be loaded 
+// OUTPUT: reference parameters: store, error 
+// Return value: false if the snapshot could not be loaded 
+// CALLS TO: mapFile, unmapFile, snapshotChecksum, snapshotAlign, 
+// storeClear, internCompany 
+//***************************************************************************** 
+bool loadSnapshotFile(const string& fileName, listingStore& store, const char* &error)
+{
+	// variables 
+	operationTimer timer(OPERATION_SNAPSHOT_LOAD, true); 	// Adds the load to the metrics 
+	mappedFile input; 					// Mapped bytes of the snapshot 
+	snapshotHeader header; 				// Header of the snapshot 
+	const char *section; 				// Start of the section being read 
+	const uint32_t *nameOffsets; 		// Offset of each company name 
+	const char *nameCharacters; 		// All company names, one after another 
+	size_t rows; 						// Listings in the snapshot 
+	size_t expectedBytes; 				// Payload size implied by the header 
+	uint64_t id; 						// Company name id being added 
+
+	storeClear(store); 
+
+	if (!mapFile(fileName, input))
+	{
+		error = "file not found"; 
+		return false; 
+	}
+
+	if (input.size < sizeof(header))
+	{
+		unmapFile(input); 
+		error = "file is too short"; 
+		return false; 
+	}
+
+	memcpy(&header, input.data, sizeof(header)); 
+	rows = header.recordCount; 
+
+	if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+		error = "not a snapshot file"; 
+	else if (header.version != SNAPSHOT_VERSION)
+		error = "unsupported snapshot version"; 
+	else if (header.byteOrder != SNAPSHOT_BYTE_ORDER)
+		error = "written on a machine of another byte order"; 
+	else if (header.recordCount >= NO_ROW || header.companyCount >= NO_ROW 
+	         || header.indexBits < INDEX_MIN_BITS || header.indexBits > 31 
+	         || header.payloadBytes != input.size - sizeof(header))
+		error = "header is damaged"; 
+	else
+		error = NULL; 
+
+	if (error == NULL)
+	{
+		expectedBytes = 3 * snapshotAlign(rows * sizeof(uint32_t)) + snapshotAlign(rows * sizeof(int64_t)) 
+		              + snapshotAlign(rows) + snapshotAlign((header.companyCount + 1) * sizeof(uint32_t)) 
+		              + snapshotAlign(header.companyBytes) + (sizeof(uint32_t) << header.indexBits); 
+
+		if (expectedBytes != header.payloadBytes 
+		    || snapshotChecksum(CHECKSUM_SEED, input.data + sizeof(header), header.payloadBytes) != header.checksum)
+			error = "file is damaged"; 
+		else if (rows * STORE_ROW_BYTES > store.memoryBudget)
+			error = "memory budget too small"; 
+	}
+
+	if (error != NULL)
+	{
+		unmapFile(input); 
+		return false; 
+	}
+
+	try
+	{
+		section = input.data + sizeof(header); 
+
+		store.mls.assign(reinterpret_cast<const uint32_t*>(section), 
+		                 reinterpret_cast<const uint32_t*>(section) + rows); 
+		section += snapshotAlign(rows * sizeof(uint32_t)); 
+
+		store.zip.assign(reinterpret_cast<const uint32_t*>(section), 
+		                 reinterpret_cast<const uint32_t*>(section) + rows); 
+		section += snapshotAlign(rows * sizeof(uint32_t)); 
+
+		store.company.assign(reinterpret_cast<const uint32_t*>(section), 
+		                     reinterpret_cast<const uint32_t*>(section) + rows); 
+		section += snapshotAlign(rows * sizeof(uint32_t)); 
+
+		store.price.assign(reinterpret_cast<const int64_t*>(section), 
+		                   reinterpret_cast<const int64_t*>(section) + rows); 
+		section += snapshotAlign(rows * sizeof(int64_t)); 
+
+		store.status.assign(section, section + rows); 
+		section += snapshotAlign(rows); 
+
+		nameOffsets = reinterpret_cast<const uint32_t*>(section); 
+		section += snapshotAlign((header.companyCount + 1) * sizeof(uint32_t)); 
+		nameCharacters = section; 
+		section += snapshotAlign(header.companyBytes); 
+
+		for (id = 0; id < header.companyCount; id++)
+			internCompany(store, string_view(nameCharacters + nameOffsets[id], 
+			                                 nameOffsets[id + 1] - nameOffsets[id])); 
+
+		store.indexSlots.assign(reinterpret_cast<const uint32_t*>(section), 
+		                        reinterpret_cast<const uint32_t*>(section) + (1u << header.indexBits)); 
+
+		// The secondary indexes are cheaper to rebuild than to store 
+		secondaryRebuild(store); 
+	}
+	catch (bad_alloc&)
+	{
+		unmapFile(input); 
+		storeClear(store); 
+		error = "not enough memory"; 
+		return false; 
+	}
+
+	store.indexBits = header.indexBits; 
+	store.liveRows = rows; 
+	store.peakRows = rows; 
+
+	timer.bytesRead = input.size; 
+	timer.recordsParsed = rows; 
+	timer.succeeded = true; 
+	unmapFile(input); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: isSnapshotFile
+// DESCRIPTION: Checks whether a file begins with the snapshot magic. 
+// INPUT: Parameters: fileName - name of the file 
+// OUTPUT: Return value: true if the file is a snapshot file 
+//***************************************************************************** 
+bool isSnapshotFile(const string& fileName)
+{
+	// variables 
+	ifstream input; 						// File to check 
+	char magic[sizeof(SNAPSHOT_MAGIC)]; 	// First bytes of the file 
+
+	input.open(fileName.c_str(), ios::binary); 
+	input.read(magic, sizeof(magic)); 
+
+	return input && memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: snapshotIsCurrent
+// DESCRIPTION: Checks whether a listings file has a snapshot beside it that 
+// was written no earlier than the file was last changed. 
+// INPUT: Parameters: fileName - name of the listings file 
+// OUTPUT: Return value: true if the snapshot should be loaded instead 
+// CALLS TO: fileIdentity, isSnapshotFile 
+//***************************************************************************** 
+bool snapshotIsCurrent(const string& fileName)
+{
+	// variables 
+	uint64_t fileSize; 				// Size of the listings file 
+	int64_t fileModified; 			// Time the listings file was last changed 
+	uint64_t snapshotSize; 			// Size of the snapshot 
+	int64_t snapshotModified; 		// Time the snapshot was written 
+
+	if (!fileIdentity(fileName, fileSize, fileModified) 
+	    || !fileIdentity(fileName + SNAPSHOT_EXTENSION, snapshotSize, snapshotModified))
+		return false; 
+
+	return snapshotModified >= fileModified && isSnapshotFile(fileName + SNAPSHOT_EXTENSION); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: snapshotChecksum
+// DESCRIPTION: Adds bytes to the checksum of a snapshot, eight at a time. A 
+// final partial word is padded with zero bytes, so a section checksums the 
+// same as the padded section written to the file. 
+// INPUT: Parameters: checksum - checksum of the bytes before these 
+// data - first byte to add 
+// size - number of bytes to add 
+// OUTPUT: Return value: the new checksum 
+//***************************************************************************** 
+uint64_t snapshotChecksum(uint64_t checksum, const char* data, size_t size)
+{
+	// variables 
+	uint64_t word; 				// Eight bytes being added 
+	size_t position; 			// Offset of the word being added 
+
+	for (position = 0; position < size; position += sizeof(word))
+	{
+		word = 0; 
+		memcpy(&word, data + position, min(sizeof(word), size - position)); 
+
+		checksum = (checksum ^ word) * CHECKSUM_PRIME; 
+		checksum ^= checksum >> 29; 
+	}
+
+	return checksum; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: snapshotAlign
+// DESCRIPTION: Rounds a section size up to a multiple of SNAPSHOT_ALIGNMENT. 
+// INPUT: Parameters: size - number of bytes in the section 
+// OUTPUT: Return value: the padded size 
+//***************************************************************************** 
+size_t snapshotAlign(size_t size)
+{
+	return (size + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalOpen
+// DESCRIPTION: Starts journaling the changes made to a listings file that 
+// has just been loaded. Records left in the file's journal by an earlier 
+// session are replayed into the store first. A journal written against an 
+// older version of the listings file is set aside as <journal>.stale, and a 
+// record cut short by a crash is dropped. The MLS numbers with records in 
+// the journal are noted, so a reload of the file keeps their changes. 
+// Snapshot files named directly and shard directories are not journaled. 
+// INPUT: Parameters: store - listing store loaded from the file 
+// baseName - name of the listings file 
+// replayed - receives the number of records replayed 
+// error - receives the reason the journal could not be opened or replayed 
+// OUTPUT: reference parameters: store, replayed, error 
+// Return value: false if the journal could not be used as it was; error 
+// says why 
+// CALLS TO: journalClose, isSnapshotFile, isShardDirectory, fileIdentity, 
+// mapFile, unmapFile, 
+// journalReplay, journalReset 
+//***************************************************************************** 
+bool journalOpen(listingStore& store, const string& baseName, int& replayed, const char* &error)
+{
+	// variables 
+	listingJournal &journal = store.journal; 	// Journal of the store 
+	mappedFile input; 				// Mapped bytes of an existing journal 
+	journalHeader header; 			// Header of an existing journal 
+	size_t validBytes; 				// Bytes of the existing journal replayed 
+	vector<char> kept; 				// Replayed part of a journal whose end was cut short 
+	FILE *rewrite; 					// Journal being rewritten without its cut-short end 
+
+	journalClose(store); 
+	replayed = 0; 
+	error = NULL; 
+
+	if (isSnapshotFile(baseName) || isShardDirectory(baseName))
+		return true; 
+
+	journal.baseName = baseName; 
+	journal.fileName = baseName + JOURNAL_EXTENSION; 
+
+	if (!fileIdentity(baseName, header.baseSize, header.baseModified))
+	{
+		error = "listings file not found"; 
+		return false; 
+	}
+
+	journal.baseSize = header.baseSize; 
+	journal.baseModified = header.baseModified; 
+
+	try
+	{
+		journal.changed.assign(MLS_MAX / 64 + 1, 0); 
+	}
+	catch (bad_alloc&)
+	{
+		error = "not enough memory to journal the listings file"; 
+		return false; 
+	}
+
+	if (mapFile(journal.fileName, input) && input.size > 0)
+	{
+		memcpy(&header, input.data, min(input.size, sizeof(header))); 
+
+		if (input.size < sizeof(header) || memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 
+		    || header.version < JOURNAL_MIN_VERSION || header.version > JOURNAL_VERSION
+		    || header.baseSize != journal.baseSize
+		    || header.baseModified != journal.baseModified)
+		{
+			unmapFile(input); 
+			rename(journal.fileName.c_str(), (journal.fileName + JOURNAL_STALE_EXTENSION).c_str()); 
+			error = "journal does not match the listings file and was set aside"; 
+			journalReset(store); 
+
+			return false; 
+		}
+
+		// Price changes recovered from the journal join the history under its name 
+		store.history.source = journal.fileName; 
+		replayed = journalReplay(store, input.data + sizeof(header), input.size - sizeof(header), validBytes); 
+		validBytes += sizeof(header); 
+
+		if (validBytes < input.size)
+			kept.assign(input.data, input.data + validBytes); 
+
+		unmapFile(input); 
+
+		// A record cut short by a crash is dropped so later records follow whole ones 
+		if (!kept.empty())
+		{
+			rewrite = fopen(journal.fileName.c_str(), "wb"); 
+
+			if (rewrite == NULL || fwrite(kept.data(), 1, kept.size(), rewrite) != kept.size())
+				error = "journal could not be repaired"; 
+
+			if (rewrite != NULL)
+				fclose(rewrite); 
+		}
+
+		if (error == NULL)
+			journal.output = fopen(journal.fileName.c_str(), "ab"); 
+	}
+	else
+	{
+		unmapFile(input); 
+
+		if (!journalReset(store))
+			error = "journal could not be created"; 
+	}
+
+	if (error == NULL && journal.output == NULL)
+		error = "journal could not be opened"; 
+
+	return error == NULL; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalReplay
+// DESCRIPTION: Applies the records of a journal to the store, in the order 
+// they were written, stopping at the first record that is incomplete or 
+// fails its checksum. The MLS number of each record is marked as changed 
+// since the file was saved. 
+// INPUT: Parameters: store - listing store to apply the records to 
+// data - first byte after the journal header 
+// size - number of bytes after the journal header 
+// validBytes - receives the number of bytes holding whole, valid records 
+// OUTPUT: reference parameters: store, validBytes 
+// Return value: number of records applied 
+// CALLS TO: companyHash, dollarsToCents, indexFind, storeAppend, storeRemove, 
+// storeReprice, storeUpdate 
+//***************************************************************************** 
+int journalReplay(listingStore& store, const char* data, size_t size, size_t& validBytes)
+{
+	// variables 
+	size_t position; 			// Offset of the record being replayed 
+	size_t recordBytes; 		// Bytes in the record, without its checksum 
+	char type; 					// Kind of change the record holds 
+	uint16_t companyLength; 	// Characters in the company name of an added or changed listing 
+	uint32_t mls; 				// MLS number of the record 
+	double price; 				// Price of an added or repriced listing, in dollars 
+	int64_t priceCents; 		// That price in cents 
+	uint32_t zip; 				// Packed zip code of an added or changed listing 
+	uint8_t status; 			// Status of an added or changed listing 
+	uint32_t checksum; 			// Checksum stored after the record 
+	uint32_t row; 				// Row of the listing the record changes 
+	int replayed; 				// Records applied 
+
+	position = 0; 
+	replayed = 0; 
+
+	while (size - position >= JOURNAL_RECORD_BYTES)
+	{
+		type = data[position]; 
+		memcpy(&companyLength, data + position + 1, sizeof(companyLength)); 
+		recordBytes = JOURNAL_RECORD_BYTES - sizeof(checksum); 
+
+		if (type == JOURNAL_ADD || type == JOURNAL_CHANGE)
+			recordBytes += companyLength; 
+
+		if (size - position < recordBytes + sizeof(checksum))
+			break; 
+
+		memcpy(&checksum, data + position + recordBytes, sizeof(checksum)); 
+
+		if (checksum != companyHash(string_view(data + position, recordBytes)))
+			break; 
+
+		memcpy(&mls, data + position + 3, sizeof(mls)); 
+		memcpy(&price, data + position + 7, sizeof(price)); 
+		memcpy(&zip, data + position + 15, sizeof(zip)); 
+		status = data[position + 19]; 
+		row = indexFind(store, mls); 
+
+		if (!dollarsToCents(price, priceCents))
+			break; 
+
+		if ((type == JOURNAL_ADD || type == JOURNAL_CHANGE) && row == NO_ROW && status <= SOLD)
+			storeAppend(store, mls, priceCents, static_cast<statusOptions>(status), zip,
+			            string_view(data + position + JOURNAL_RECORD_BYTES - sizeof(checksum), companyLength)); 
+		else if (type == JOURNAL_CHANGE && row != NO_ROW && status <= SOLD)
+			storeUpdate(store, row, priceCents, static_cast<statusOptions>(status), zip,
+			            string_view(data + position + JOURNAL_RECORD_BYTES - sizeof(checksum), companyLength)); 
+		else if (type == JOURNAL_DELETE && row != NO_ROW)
+			storeRemove(store, row); 
+		else if (type == JOURNAL_PRICE && row != NO_ROW)
+			storeReprice(store, row, priceCents); 
+		else if (type != JOURNAL_ADD && type != JOURNAL_DELETE && type != JOURNAL_PRICE && type != JOURNAL_CHANGE)
+			break; 
+
+		if (mls <= MLS_MAX)
+			store.journal.changed[mls / 64] |= 1ull << (mls % 64); 
+
+		position += recordBytes + sizeof(checksum); 
+		replayed++; 
+	}
+
+	validBytes = position; 
+
+	return replayed; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalRecord
+// DESCRIPTION: Adds a record of a change to a row to the journal's buffer. 
+// Added, repriced and changed rows are recorded after the change and 
+// deleted rows before it. Nothing is recorded while the store is not 
+// journaled. 
+// INPUT: Parameters: store - listing store holding the journal 
+// type - JOURNAL_ADD, JOURNAL_DELETE, JOURNAL_PRICE or JOURNAL_CHANGE 
+// row - row that was added, repriced or changed, or is being deleted 
+// OUTPUT: reference parameter: store 
+// CALLS TO: journalAppend 
+//***************************************************************************** 
+void journalRecord(listingStore& store, char type, uint32_t row)
+{
+	// variables 
+	string_view company; 			// Company name of an added or changed listing 
+
+	if (store.journal.output == NULL)
+		return; 
+
+	if (type == JOURNAL_ADD || type == JOURNAL_CHANGE)
+		company = store.companyNames[store.company[row]]; 
+
+	journalAppend(store, type, store.mls[row], store.price[row], store.zip[row], store.status[row], company); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalAppend
+// DESCRIPTION: Adds a record holding the given fields to the journal's 
+// buffer and marks its MLS number as changed since the file was saved. 
+// Every record has the same fixed part, followed for an added or changed 
+// listing by its company name, and ends with a checksum: 
+//   type (1 byte), company name length (2), MLS number (4), price (8), 
+//   zip code (4), status (1), company name, checksum (4) 
+// The price is recorded as a double in dollars, as it was before prices 
+// were held in cents, so journals left by earlier versions still replay. 
+// Full buffers are written to the file; journalCommit makes them durable. 
+// INPUT: Parameters: store - listing store holding the journal 
+// type - JOURNAL_ADD, JOURNAL_DELETE, JOURNAL_PRICE or JOURNAL_CHANGE 
+// mls - MLS number of the listing 
+// price - price of the listing, in cents 
+// zip - packed zip code of the listing 
+// status - status of the listing 
+// company - company name of an added or changed listing, or empty 
+// OUTPUT: reference parameter: store 
+// CALLS TO: companyHash, journalFlush 
+//***************************************************************************** 
+void journalAppend(listingStore& store, char type, uint32_t mls, int64_t price, uint32_t zip, uint8_t status, string_view company)
+{
+	// variables 
+	listingJournal &journal = store.journal; 	// Journal of the store 
+	size_t start; 					// Offset of the record in the buffer 
+	char *record; 					// Fixed part of the record 
+	uint16_t companyLength; 		// Characters of the company name recorded 
+	uint32_t checksum; 				// Checksum of the record 
+	double dollars; 				// Price of the listing in dollars 
+
+	if (journal.output == NULL)
+		return; 
+
+	companyLength = min<size_t>(company.size(), UINT16_MAX); 
+
+	start = journal.pending.size(); 
+	journal.pending.resize(start + JOURNAL_RECORD_BYTES - sizeof(checksum)); 
+	record = journal.pending.data() + start; 
+
+	record[0] = type; 
+	memcpy(record + 1, &companyLength, sizeof(companyLength)); 
+	memcpy(record + 3, &mls, sizeof(mls)); 
+	dollars = static_cast<double>(price) / CENTS_PER_DOLLAR; 
+	memcpy(record + 7, &dollars, sizeof(dollars)); 
+	memcpy(record + 15, &zip, sizeof(zip)); 
+	record[19] = status; 
+
+	journal.pending.insert(journal.pending.end(), company.data(), company.data() + companyLength); 
+
+	checksum = companyHash(string_view(journal.pending.data() + start, journal.pending.size() - start)); 
+	journal.pending.insert(journal.pending.end(), reinterpret_cast<char*>(&checksum), 
+	                       reinterpret_cast<char*>(&checksum) + sizeof(checksum)); 
+
+	if (!journal.changed.empty())
+		journal.changed[mls / 64] |= 1ull << (mls % 64); 
+
+	if (journal.pending.size() >= JOURNAL_BUFFER_BYTES)
+		journalFlush(store, false); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalCommit
+// DESCRIPTION: Makes every change recorded so far durable, with one write 
+// and one sync to disk for the whole group. Each user action commits once. 
+// INPUT: Parameters: store - listing store holding the journal 
+// OUTPUT: reference parameter: store 
+// CALLS TO: journalFlush 
+//***************************************************************************** 
+void journalCommit(listingStore& store)
+{
+	if (store.journal.output != NULL && (store.journal.unsynced || !store.journal.pending.empty()))
+		journalFlush(store, true); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalFlush
+// DESCRIPTION: Writes the journal's buffer to the file, optionally syncing 
+// the file to disk. If the journal cannot be written the error is reported 
+// and journaling stops, since later records could not be replayed. 
+// INPUT: Parameters: store - listing store holding the journal 
+// sync - whether to wait for the file to reach the disk 
+// OUTPUT: reference parameter: store 
+// CALLS TO: syncFile, journalClose 
+//***************************************************************************** 
+void journalFlush(listingStore& store, bool sync)
+{
+	// variables 
+	listingJournal &journal = store.journal; 	// Journal of the store 
+	bool written; 					// Whether the buffer reached the file 
+
+	written = fwrite(journal.pending.data(), 1, journal.pending.size(), journal.output) == journal.pending.size(); 
+	journal.pending.clear(); 
+	journal.unsynced = true; 
+
+	if (written && sync)
+	{
+		written = syncFile(journal.output); 
+		journal.unsynced = false; 
+	}
+
+	if (!written)
+	{
+		cerr << "Error: journal " << journal.fileName << " could not be written. Changes from now on "
+		     << "are only kept by saving the file." << endl; 
+		journalClose(store); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalReset
+// DESCRIPTION: Empties the journal once the listings file holds every 
+// change, which folds the journal into the file, so no listing is then 
+// changed since the save. The new header records the size and time of the 
+// listings file as now written. 
+// INPUT: Parameters: store - listing store holding the journal 
+// OUTPUT: reference parameter: store 
+// Return value: false if the journal could not be rewritten 
+// CALLS TO: fileIdentity 
+//***************************************************************************** 
+bool journalReset(listingStore& store)
+{
+	// variables 
+	listingJournal &journal = store.journal; 	// Journal of the store 
+	journalHeader header; 			// Header of the emptied journal 
+
+	if (journal.output != NULL)
+		fclose(journal.output); 
+
+	journal.pending.clear(); 
+	journal.unsynced = false; 
+	fill(journal.changed.begin(), journal.changed.end(), 0); 
+
+	memset(&header, 0, sizeof(header)); 
+	memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic)); 
+	header.version = JOURNAL_VERSION; 
+	fileIdentity(journal.baseName, header.baseSize, header.baseModified); 
+	journal.baseSize = header.baseSize; 
+	journal.baseModified = header.baseModified; 
+
+	journal.output = fopen(journal.fileName.c_str(), "wb"); 
+
+	if (journal.output != NULL && fwrite(&header, sizeof(header), 1, journal.output) == 1)
+	{
+		journal.unsynced = true; 
+		journalCommit(store); 
+	}
+	else if (journal.output != NULL)
+	{
+		fclose(journal.output); 
+		journal.output = NULL; 
+	}
+
+	return journal.output != NULL; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: journalClose
+// DESCRIPTION: Commits any buffered records and stops journaling. A journal 
+// holding no records is removed, so a run that changes nothing, such as a 
+// load and a query, leaves no journal beside the listings file; the next 
+// load starts a new one. 
+// INPUT: Parameters: store - listing store holding the journal 
+// OUTPUT: reference parameter: store 
+// CALLS TO: journalCommit, fileSize 
+//***************************************************************************** 
+void journalClose(listingStore& store)
+{
+	// variables 
+	FILE *output; 				// Journal file to close 
+
+	journalCommit(store); 
+
+	output = store.journal.output; 
+	store.journal.output = NULL; 
+	store.journal.pending.clear(); 
+	store.journal.changed.clear(); 
+
+	if (output != NULL)
+	{
+		fclose(output); 
+
+		if (fileSize(store.journal.fileName) <= sizeof(journalHeader))
+			remove(store.journal.fileName.c_str()); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: fileIdentity
+// DESCRIPTION: Returns the size of a file and the time it was last changed, 
+// to the nanosecond where the system records it. 
+// INPUT: Parameters: fileName - name of the file 
+// size - receives the size of the file 
+// modified - receives the time the file was last changed 
+// OUTPUT: reference parameters: size, modified 
+// Return value: false if the file does not exist 
+//***************************************************************************** 
+bool fileIdentity(const string& fileName, uint64_t& size, int64_t& modified)
+{
+	// variables 
+	struct stat fileInfo; 		// Size and age of the file 
+
+	if (stat(fileName.c_str(), &fileInfo) != 0)
+	{
+		size = 0; 
+		modified = 0; 
+		return false; 
+	}
+
+	size = fileInfo.st_size; 
+
+#ifdef __linux__
+	modified = static_cast<int64_t>(fileInfo.st_mtim.tv_sec) * 1000000000 + fileInfo.st_mtim.tv_nsec; 
+#else
+	modified = static_cast<int64_t>(fileInfo.st_mtime) * 1000000000; 
+#endif
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeAppend
+// DESCRIPTION: Adds a listing to the store and to the MLS index. A row freed 
+// by a delete is reused if there is one; otherwise the listing goes at the 
+// end. Once a freed row has been reused, the rows of the listings added are 
+// listed in addedRows, so that they are still saved after the other 
+// listings, in the order added. The store only grows within its memory 
+// budget. If memory cannot be allocated, the store is left as it was. The 
+// listing is added to the secondary indexes, journaled and marked, with its 
+// shard, as changed since the last save. 
+// INPUT: Parameters: store - listing store to add to 
+// mls - MLS number of the listing; must not already be on file 
+// price - asking price of the listing, in cents 
+// status - status of the listing 
+// zip - zip code of the listing, packed by packZip 
+// company - realty company name of the listing 
+// OUTPUT: reference parameter: store 
+// Return value: row of the new listing, or NO_ROW if memory is full 
+// CALLS TO: internCompany, indexInsert, indexRemove, secondaryInsert, 
+// storeReserve, journalRecord, deltaMark, shardMark 
+//***************************************************************************** 
+uint32_t storeAppend(listingStore& store, int mls, int64_t price, statusOptions status, uint32_t zip, string_view company)
+{
+	// variables 
+	uint32_t row; 				// Row given to the new listing
+	uint32_t companyId; 		// Id of the realty company name
+	bool reused; 				// Whether the row came from the free list
+
+	try
+	{
+		companyId = internCompany(store, company); 
+	}
+	catch (bad_alloc&)
+	{
+		return NO_ROW; 
+	}
+
+	reused = !store.freeRows.empty(); 
+
+	if (reused)
+		row = store.freeRows.back(); 
+	else
+	{
+		row = store.mls.size(); 
+
+		if (row == store.mls.capacity() && !storeReserve(store, max<size_t>(row * 2, STORE_MIN_ROWS)))
+			return NO_ROW; 
+
+		// Room is reserved in every column, so these cannot allocate 
+		store.mls.push_back(0); 
+		store.price.push_back(0); 
+		store.status.push_back(STATUS_DELETED); 
+		store.zip.push_back(0); 
+		store.company.push_back(0); 
+	}
+
+	if (reused || !store.addedRows.empty())
+	{
+		try
+		{
+			store.addedRows.push_back(row); 
+		}
+		catch (bad_alloc&)
+		{
+			if (!reused)
+			{
+				store.mls.pop_back(); 
+				store.price.pop_back(); 
+				store.status.pop_back(); 
+				store.zip.pop_back(); 
+				store.company.pop_back(); 
+			}
+
+			return NO_ROW; 
+		}
+	}
+
+	store.mls[row] = mls; 
+	store.price[row] = price; 
+	store.status[row] = status; 
+	store.zip[row] = zip; 
+	store.company[row] = companyId; 
+
+	try
+	{
+		indexInsert(store, row); 
+
+		try
+		{
+			secondaryInsert(store, row); 
+		}
+		catch (bad_alloc&)
+		{
+			indexRemove(store, mls); 
+			throw; 
+		}
+	}
+	catch (bad_alloc&)
+	{
+		store.status[row] = STATUS_DELETED; 
+
+		if (reused || !store.addedRows.empty())
+			store.addedRows.pop_back(); 
+
+		if (!reused)
+		{
+			store.mls.pop_back(); 
+			store.price.pop_back(); 
+			store.status.pop_back(); 
+			store.zip.pop_back(); 
+			store.company.pop_back(); 
+		}
+
+		return NO_ROW; 
+	}
+
+	if (reused)
+	{
+		store.freeRows.pop_back(); 
+		store.deletedRows--; 
+	}
+
+	store.liveRows++; 
+
+	if (store.liveRows > store.peakRows)
+		store.peakRows = store.liveRows; 
+
+	journalRecord(store, JOURNAL_ADD, row); 
+	deltaMark(store.delta, mls, JOURNAL_ADD); 
+	shardMark(store.shards, zip); 
+
+	return row; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeRemove
+// DESCRIPTION: Marks a listing as deleted and removes it from the MLS index 
+// and the secondary indexes. 
+// The row keeps its place until the store is compacted, so the order of the 
+// remaining listings and the numbers of the other rows do not change. The 
+// row goes on the free list to be reused by the next listing added. The 
+// delete is journaled and marked as a change since the last save. 
+// INPUT: Parameters: store - listing store to delete from 
+// row - row of the listing to delete 
+// OUTPUT: reference parameter: store 
+// CALLS TO: indexRemove, secondaryRemove, storeMarkDeleted 
+//***************************************************************************** 
+void storeRemove(listingStore& store, uint32_t row)
+{
+	indexRemove(store, store.mls[row]); 
+	secondaryRemove(store, row); 
+	storeMarkDeleted(store, row); 
+
+	// A row that cannot be listed as free stays deleted until compaction 
+	try
+	{
+		store.freeRows.push_back(row); 
+	}
+	catch (bad_alloc&)
+	{
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeMarkDeleted
+// DESCRIPTION: Records the delete of a listing and marks its row deleted: 
+// the delete is journaled, marked as a change since the last save for the 
+// delta file and the listing's shard, and counted. The MLS index and the 
+// secondary indexes are left to the caller. Every way of deleting a 
+// listing goes through here, so none of these records can be missed. 
+// INPUT: Parameters: store - listing store to delete from 
+// row - row of the listing to delete 
+// OUTPUT: reference parameter: store 
+// CALLS TO: journalRecord, deltaMark, shardMark 
+//***************************************************************************** 
+void storeMarkDeleted(listingStore& store, uint32_t row)
+{
+	journalRecord(store, JOURNAL_DELETE, row); 
+	deltaMark(store.delta, store.mls[row], JOURNAL_DELETE); 
+	shardMark(store.shards, store.zip[row]); 
+
+	store.status[row] = STATUS_DELETED; 
+	store.liveRows--; 
+	store.deletedRows++; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeFileOrder
+// DESCRIPTION: Puts rows of listings, given in row order, into the order 
+// they are saved in. A listing added in a freed row is saved after the 
+// other listings, as if it had been added at the end, so the rows in 
+// addedRows go last, in the order their listings were added. A row reused 
+// more than once goes by the listing added to it last. 
+// INPUT: Parameters: store - listing store holding the listings 
+// rows - rows of live listings, in row order 
+// OUTPUT: reference parameter: rows 
+// Return value: place in rows of the first row moved to the end 
+//***************************************************************************** 
+size_t storeFileOrder(const listingStore& store, vector<uint32_t>& rows)
+{
+	// variables 
+	vector<pair<uint32_t, size_t> > added; 	// Each row of addedRows with its place there, by row 
+	vector<pair<size_t, uint32_t> > moved; 	// Place in addedRows and row of each row moved 
+	vector<pair<uint32_t, size_t> >::iterator found; 	// Last entry of addedRows for a row 
+	size_t index; 				// Row or entry being placed 
+	size_t kept; 				// Rows left in row order 
+
+	if (store.addedRows.empty())
+		return rows.size(); 
+
+	added.reserve(store.addedRows.size()); 
+
+	for (index = 0; index < store.addedRows.size(); index++)
+		added.push_back(make_pair(store.addedRows[index], index)); 
+
+	sort(added.begin(), added.end()); 
+	kept = 0; 
+
+	for (index = 0; index < rows.size(); index++)
+	{
+		found = upper_bound(added.begin(), added.end(), make_pair(rows[index], SIZE_MAX)); 
+
+		if (found != added.begin() && (found - 1)->first == rows[index])
+			moved.push_back(make_pair((found - 1)->second, rows[index])); 
+		else
+			rows[kept++] = rows[index]; 
+	}
+
+	sort(moved.begin(), moved.end()); 
+
+	for (index = 0; index < moved.size(); index++)
+		rows[kept + index] = moved[index].second; 
+
+	return kept; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeSavedRows
+// DESCRIPTION: Lists the rows of all live listings in the order they are 
+// saved in. 
+// INPUT: Parameters: store - listing store holding the listings 
+// rows - receives the rows 
+// OUTPUT: reference parameter: rows 
+// Return value: place in rows of the first row moved to the end 
+// CALLS TO: storeFileOrder 
+//***************************************************************************** 
+size_t storeSavedRows(const listingStore& store, vector<uint32_t>& rows)
+{
+	// variables 
+	uint32_t row; 				// Row being checked 
+
+	rows.clear(); 
+	rows.reserve(store.liveRows); 
+
+	for (row = 0; row < store.mls.size(); row++)
+		if (store.status[row] != STATUS_DELETED)
+			rows.push_back(row); 
+
+	return storeFileOrder(store, rows); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeCompact
+// DESCRIPTION: Drops deleted rows from the store, putting the remaining 
+// listings in the order they are saved in, and rebuilds the MLS index and 
+// secondary indexes for the new row numbers. Listings added in freed rows 
+// are moved to the end, so afterwards row order is file order again. 
+// INPUT: Parameters: store - listing store to compact 
+// OUTPUT: reference parameter: store 
+// CALLS TO: storeSavedRows, indexRebuild, secondaryRebuild 
+//***************************************************************************** 
+void storeCompact(listingStore& store)
+{
+	// variables 
+	vector<uint32_t> order; 	// Rows kept, in the order they are saved in 
+	size_t moved; 				// Place in order of the first row moved to the end 
+	vector<uint32_t> movedMls; 		// MLS numbers of the rows moved to the end 
+	vector<int64_t> movedPrice; 	// Asking prices of the rows moved to the end 
+	vector<uint8_t> movedStatus; 	// Statuses of the rows moved to the end 
+	vector<uint32_t> movedZip; 		// Zip codes of the rows moved to the end 
+	vector<uint32_t> movedCompany; 	// Company name ids of the rows moved to the end 
+	size_t writeRow; 			// Row the next listing kept is moved to 
+	uint32_t readRow; 			// Row being moved 
+
+	if (store.deletedRows == 0 && store.addedRows.empty())
+		return; 
+
+	moved = storeSavedRows(store, order); 
+
+	// Rows moved to the end may be overwritten before they are reached 
+	for (writeRow = moved; writeRow < order.size(); writeRow++)
+	{
+		movedMls.push_back(store.mls[order[writeRow]]); 
+		movedPrice.push_back(store.price[order[writeRow]]); 
+		movedStatus.push_back(store.status[order[writeRow]]); 
+		movedZip.push_back(store.zip[order[writeRow]]); 
+		movedCompany.push_back(store.company[order[writeRow]]); 
+	}
+
+	// The other rows keep their order, so each is read before it is overwritten 
+	for (writeRow = 0; writeRow < moved; writeRow++)
+	{
+		readRow = order[writeRow]; 
+		store.mls[writeRow] = store.mls[readRow]; 
+		store.price[writeRow] = store.price[readRow]; 
+		store.status[writeRow] = store.status[readRow]; 
+		store.zip[writeRow] = store.zip[readRow]; 
+		store.company[writeRow] = store.company[readRow]; 
+	}
+
+	for (writeRow = moved; writeRow < order.size(); writeRow++)
+	{
+		store.mls[writeRow] = movedMls[writeRow - moved]; 
+		store.price[writeRow] = movedPrice[writeRow - moved]; 
+		store.status[writeRow] = movedStatus[writeRow - moved]; 
+		store.zip[writeRow] = movedZip[writeRow - moved]; 
+		store.company[writeRow] = movedCompany[writeRow - moved]; 
+	}
+
+	store.mls.resize(order.size()); 
+	store.price.resize(order.size()); 
+	store.status.resize(order.size()); 
+	store.zip.resize(order.size()); 
+	store.company.resize(order.size()); 
+	store.deletedRows = 0; 
+	store.freeRows.clear(); 
+	store.addedRows.clear(); 
+
+	indexRebuild(store, store.liveRows); 
+	secondaryRebuild(store); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeClear
+// DESCRIPTION: Empties the store and releases the memory of its columns, 
+// company names and index in one step. The memory budget, thread setting 
+// and choice of shards to load are kept and the journal, if any, is closed. 
+// INPUT: Parameters: store - listing store to clear 
+// OUTPUT: reference parameter: store 
+// CALLS TO: journalClose 
+//***************************************************************************** 
+void storeClear(listingStore& store)
+{
+	// variables 
+	size_t budget; 				// Memory budget to keep
+	int threads; 				// Thread setting to keep
+	shardLayout shards; 		// Choice of shards to keep 
+
+	journalClose(store); 
+
+	budget = store.memoryBudget; 
+	threads = store.loadThreads; 
+	shards.partial = store.shards.partial; 
+	memcpy(shards.selected, store.shards.selected, sizeof(shards.selected)); 
+	store = listingStore(); 
+	store.memoryBudget = budget; 
+	store.loadThreads = threads; 
+	store.shards = shards; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeReserve
+// DESCRIPTION: Reserves room in every column for a number of rows, limited to 
+// the rows the memory budget allows. Room is also reserved for the price 
+// index, so that merging it does not allocate. 
+// INPUT: Parameters: store - listing store to reserve room in 
+// rows - number of rows wanted 
+// OUTPUT: reference parameter: store 
+// Return value: false if no room beyond the current rows could be reserved 
+// CALLS TO: priceDeltaCapacity 
+//***************************************************************************** 
+bool storeReserve(listingStore& store, size_t rows)
+{
+	// variables 
+	size_t maxRows; 			// Rows the memory budget allows
+
+	maxRows = store.memoryBudget / STORE_ROW_BYTES; 
+
+	if (maxRows > NO_ROW)
+		maxRows = NO_ROW; 
+
+	if (rows > maxRows)
+		rows = maxRows; 
+
+	if (rows <= store.mls.size())
+		return false; 
+
+	try
+	{
+		store.mls.reserve(rows); 
+		store.price.reserve(rows); 
+		store.status.reserve(rows); 
+		store.zip.reserve(rows); 
+		store.company.reserve(rows); 
+		store.priceDelta.reserve(priceDeltaCapacity(rows)); 
+		store.priceSorted.reserve(rows + store.priceDelta.capacity()); 
+	}
+	catch (bad_alloc&)
+	{
+		return false; 
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeFull
+// DESCRIPTION: Checks whether a listing can be added without going over the 
+// memory budget, either in a free row or in a new one. 
+// INPUT: Parameters: store - listing store to check 
+// OUTPUT: Return value: true if no more listings can be added 
+//***************************************************************************** 
+bool storeFull(const listingStore& store)
+{
+	return store.freeRows.empty() && store.mls.size() >= store.mls.capacity()
+	       && (store.mls.size() + 1) * STORE_ROW_BYTES > store.memoryBudget; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeMemoryUsed
+// DESCRIPTION: Adds up the bytes held by the store's columns, row lists, 
+// hash tables, secondary indexes, company names, file fingerprint, price 
+// history and change bitmaps. 
+// INPUT: Parameters: store - listing store to measure 
+// OUTPUT: Return value: bytes of memory held 
+//***************************************************************************** 
+size_t storeMemoryUsed(const listingStore& store)
+{
+	// variables 
+	size_t bytes; 				// Bytes counted so far
+	size_t id; 					// Company name being counted
+	size_t key; 				// Zip code being counted
+	int status; 				// Status bitmap being counted
+
+	bytes = store.mls.capacity() * sizeof(uint32_t)
+	      + store.price.capacity() * sizeof(int64_t)
+	      + store.status.capacity() * sizeof(uint8_t)
+	      + store.zip.capacity() * sizeof(uint32_t)
+	      + store.company.capacity() * sizeof(uint32_t)
+	      + (store.freeRows.capacity() + store.addedRows.capacity()) * sizeof(uint32_t)
+	      + store.indexSlots.capacity() * sizeof(uint32_t)
+	      + store.companySlots.capacity() * sizeof(uint32_t)
+	      + store.companyNames.capacity() * sizeof(string); 
+
+	for (id = 0; id < store.companyNames.size(); id++)
+		bytes += store.companyNames[id].capacity(); 
+
+	bytes += (store.zipPosition.capacity() + store.companyPosition.capacity() 
+	          + store.priceGeneration.capacity()) * sizeof(uint32_t)
+	       + (store.priceSorted.capacity() + store.priceDelta.capacity()) * sizeof(priceEntry)
+	       + (store.zipRows.capacity() + store.companyRows.capacity()) * sizeof(vector<uint32_t>); 
+
+	for (key = 0; key < store.zipRows.size(); key++)
+		bytes += store.zipRows[key].capacity() * sizeof(uint32_t); 
+
+	for (id = 0; id < store.companyRows.size(); id++)
+		bytes += store.companyRows[id].capacity() * sizeof(uint32_t); 
+
+	for (status = 0; status < STATUS_COUNT; status++)
+		bytes += store.statusBits[status].capacity() * sizeof(uint64_t); 
+
+	bytes += store.fingerprint.chunkHashes.capacity() * sizeof(uint64_t)
+	       + (store.fingerprint.chunkStart.capacity() + store.fingerprint.chunkMls.capacity()) * sizeof(uint32_t); 
+
+	bytes += store.history.encoded.capacity() + store.history.blocks.capacity() * sizeof(historyBlock)
+	       + store.history.sources.capacity() * sizeof(string)
+	       + (store.delta.dirty.capacity() + store.delta.added.capacity()
+	          + store.journal.changed.capacity()) * sizeof(uint64_t); 
+
+	return bytes; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: displayMemoryUsage
+// DESCRIPTION: Displays the number of live, free and peak records in the store 
+// with its memory use and budget. 
+// INPUT: Parameters: store - listing store to report on 
+// OUTPUT: Outputs counters directly to screen. 
+// CALLS TO: storeMemoryUsed 
+//***************************************************************************** 
+void displayMemoryUsage(const listingStore& store)
+{
+	cout << left; 
+	cout << setw(28) << "Listings stored:" << store.liveRows << endl; 
+	cout << setw(28) << "Free rows for reuse:" << store.freeRows.size() << endl; 
+	cout << setw(28) << "Peak listings stored:" << store.peakRows << endl; 
+	cout << setw(28) << "Rows reserved:" << store.mls.capacity() << endl; 
+	cout << setw(28) << "Company names:" << store.companyNames.size() << endl; 
+	cout << setw(28) << "Memory in use (KB):" << (storeMemoryUsed(store) + 1023) / 1024 << endl; 
+	cout << setw(28) << "Memory budget (MB):" << store.memoryBudget / MEGABYTE << endl << endl; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: internCompany
+// DESCRIPTION: Returns the id of a realty company name, adding the name to 
+// the store's name table if it is not already there. Names are found through 
+// an open-addressing hash table of ids that doubles when half full. 
+// INPUT: Parameters: store - listing store holding the name table 
+// name - realty company name 
+// OUTPUT: reference parameter: store 
+// Return value: id of the name 
+// CALLS TO: companyHash 
+//***************************************************************************** 
+uint32_t internCompany(listingStore& store, string_view name)
+{
+	// variables 
+	unsigned int mask; 			// To wrap slot numbers around the table
+	unsigned int slot; 			// Slot being probed
+	uint32_t id; 				// Id of the name
+	vector<uint32_t> newSlots; 	// Larger table while the table grows
+	int newBits; 				// log2 of the size of the larger table
+
+	if (store.companyBits > 0)
+	{
+		mask = (1u << store.companyBits) - 1; 
+		slot = (companyHash(name) * 2654435769u) >> (32 - store.companyBits); 
+
+		while (store.companySlots[slot] != NO_ROW)
+		{
+			if (store.companyNames[store.companySlots[slot]] == name)
+				return store.companySlots[slot]; 
+
+			slot = (slot + 1) & mask; 
+		}
+	}
+
+	id = store.companyNames.size(); 
+	store.companyNames.push_back(string(name)); 
+
+	if (store.companyBits == 0 || store.companyNames.size() * 2 > (1u << store.companyBits))
+	{
+		newBits = (store.companyBits == 0) ? COMPANY_MIN_BITS : store.companyBits + 1; 
+
+		try
+		{
+			newSlots.assign(1u << newBits, NO_ROW); 
+		}
+		catch (bad_alloc&)
+		{
+			store.companyNames.pop_back(); 
+			throw; 
+		}
+
+		store.companySlots.swap(newSlots); 
+		store.companyBits = newBits; 
+		mask = (1u << newBits) - 1; 
+
+		for (id = 0; id < store.companyNames.size(); id++)
+		{
+			slot = (companyHash(store.companyNames[id]) * 2654435769u) >> (32 - newBits); 
+
+			while (store.companySlots[slot] != NO_ROW)
+				slot = (slot + 1) & mask; 
+
+			store.companySlots[slot] = id; 
+		}
+
+		return store.companyNames.size() - 1; 
+	}
+
+	mask = (1u << store.companyBits) - 1; 
+	slot = (companyHash(name) * 2654435769u) >> (32 - store.companyBits); 
+
+	while (store.companySlots[slot] != NO_ROW)
+		slot = (slot + 1) & mask; 
+
+	store.companySlots[slot] = id; 
+
+	return id; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: companyHash
+// DESCRIPTION: Hashes a realty company name with 32-bit FNV-1a. 
+// INPUT: Parameters: name - realty company name 
+// OUTPUT: Return value: hash of the name 
+//***************************************************************************** 
+uint32_t companyHash(string_view name)
+{
+	// variables 
+	uint32_t hash = 2166136261u; 	// Running hash
+	size_t position; 				// Character being hashed
+
+	for (position = 0; position < name.size(); position++)
+		hash = (hash ^ static_cast<unsigned char>(name[position])) * 16777619u; 
+
+	return hash; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: packZip
+// DESCRIPTION: Packs a zip code of the form "#####-####" into an integer 
+// holding its nine digits, so 80513-2918 is stored as 805132918. 
+// INPUT: Parameters: text - zip code as text 
+// packed - receives the packed zip code 
+// OUTPUT: reference parameter: packed 
+// Return value: false if the text is not a zip code of that form 
+//***************************************************************************** 
+bool packZip(string_view text, uint32_t& packed)
+{
+	// variables 
+	uint32_t value = 0; 		// Digits packed so far
+	int position; 				// Character being packed
+
+	if (text.size() != ZIP_CODE_LENGTH || text[ZIP_DASH_POSITION] != '-')
+		return false; 
+
+	for (position = 0; position < ZIP_CODE_LENGTH; position++)
+	{
+		if (position == ZIP_DASH_POSITION)
+			continue; 
+
+		if (!isdigit(static_cast<unsigned char>(text[position])))
+			return false; 
+
+		value = value * 10 + (text[position] - '0'); 
+	}
+
+	packed = value; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: formatZip
+// DESCRIPTION: Formats a zip code packed by packZip as "#####-####". 
+// INPUT: Parameters: packed - packed zip code 
+// text - buffer of at least ZIP_CODE_LENGTH + 1 characters 
+// OUTPUT: reference parameter: text, terminated with a null character 
+//***************************************************************************** 
+void formatZip(uint32_t packed, char* text)
+{
+	// variables 
+	int position; 				// Character being written
+
+	for (position = ZIP_CODE_LENGTH - 1; position >= 0; position--)
+	{
+		if (position == ZIP_DASH_POSITION)
+			text[position] = '-'; 
+		else
+		{
+			text[position] = '0' + packed % 10; 
+			packed /= 10; 
+		}
+	}
+
+	text[ZIP_CODE_LENGTH] = '\0'; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: mlsHash
+// DESCRIPTION: Hashes an MLS number to a slot of a table of 2^bits slots. 
+// Fibonacci hashing spreads the sequential MLS numbers across the table. 
+// INPUT: Parameters: mls - MLS number 
+// bits - log2 of the number of slots 
+// OUTPUT: Return value: slot number 
+//***************************************************************************** 
+unsigned int mlsHash(uint32_t mls, int bits)
+{
+	return (mls * 2654435769u) >> (32 - bits); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: indexFind
+// DESCRIPTION: Looks up the row for an MLS number. Slots hold row numbers and 
+// are probed linearly from the hashed position until the number or an empty 
+// slot is found. 
+// INPUT: Parameters: store - listing store holding the MLS index 
+// mls - MLS number to look up 
+// OUTPUT: Return value: row holding the MLS number, or NO_ROW if not on file 
+// CALLS TO: mlsHash 
+//***************************************************************************** 
+uint32_t indexFind(const listingStore& store, int mls)
+{
+	// variables 
+	unsigned int mask; 			// To wrap slot numbers around the table
+	unsigned int slot; 			// Slot being probed
+
+	if (store.indexBits == 0)
+		return NO_ROW; 
+
+	mask = (1u << store.indexBits) - 1; 
+	slot = mlsHash(mls, store.indexBits); 
+
+	while (store.indexSlots[slot] != NO_ROW)
+	{
+		if (store.mls[store.indexSlots[slot]] == static_cast<uint32_t>(mls))
+			return store.indexSlots[slot]; 
+
+		slot = (slot + 1) & mask; 
+	}
+
+	return NO_ROW; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: indexInsert
+// DESCRIPTION: Adds a row to the MLS index. The table is rebuilt at double 
+// the size whenever it would become more than half full. 
+// INPUT: Parameters: store - listing store holding the MLS index 
+// row - row to add; its MLS number must not already be indexed and it must 
+// not yet be counted in liveRows 
+// OUTPUT: reference parameter: store 
+// CALLS TO: mlsHash, indexRebuild 
+//***************************************************************************** 
+void indexInsert(listingStore& store, uint32_t row)
+{
+	// variables 
+	unsigned int mask; 			// To wrap slot numbers around the table
+	unsigned int slot; 			// Slot being probed
+
+	if (store.indexBits == 0 || (store.liveRows + 1) * 2 > (1u << store.indexBits))
+	{
+		indexRebuild(store, store.liveRows + 1); 
+		return; 
+	}
+
+	mask = (1u << store.indexBits) - 1; 
+	slot = mlsHash(store.mls[row], store.indexBits); 
+
+	while (store.indexSlots[slot] != NO_ROW)
+		slot = (slot + 1) & mask; 
+
+	store.indexSlots[slot] = row; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: indexRemove
+// DESCRIPTION: Removes an MLS number from the MLS index. Later entries of the 
+// same probe run are shifted back so lookups never need tombstones. 
+// INPUT: Parameters: store - listing store holding the MLS index 
+// mls - MLS number to remove 
+// OUTPUT: reference parameter: store 
+// CALLS TO: mlsHash 
+//***************************************************************************** 
+void indexRemove(listingStore& store, int mls)
+{
+	// variables 
+	unsigned int mask; 			// To wrap slot numbers around the table
+	unsigned int slot; 			// Slot being emptied
+	unsigned int next; 			// Slot being checked for a shift back
+	unsigned int home; 			// Hashed position of the entry in the next slot
+
+	if (store.indexBits == 0)
+		return; 
+
+	mask = (1u << store.indexBits) - 1; 
+	slot = mlsHash(mls, store.indexBits); 
+
+	while (store.indexSlots[slot] == NO_ROW || store.mls[store.indexSlots[slot]] != static_cast<uint32_t>(mls))
+	{
+		if (store.indexSlots[slot] == NO_ROW)
+			return; 
+
+		slot = (slot + 1) & mask; 
+	}
+
+	next = (slot + 1) & mask; 
+
+	while (store.indexSlots[next] != NO_ROW)
+	{
+		home = mlsHash(store.mls[store.indexSlots[next]], store.indexBits); 
+
+		// Entry may move into the hole only if the hole lies on its probe path 
+		if (((next - home) & mask) >= ((next - slot) & mask))
+		{
+			store.indexSlots[slot] = store.indexSlots[next]; 
+			slot = next; 
+		}
+
+		next = (next + 1) & mask; 
+	}
+
+	store.indexSlots[slot] = NO_ROW; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: indexRebuild
+// DESCRIPTION: Rebuilds the MLS index from every row not marked as deleted. 
+// The table is sized to stay at most half full with the expected number of 
+// rows. If the new table cannot be allocated the old one is kept. 
+// INPUT: Parameters: store - listing store holding the MLS index 
+// expectedRows - number of rows the table must have room for 
+// OUTPUT: reference parameter: store 
+// CALLS TO: mlsHash 
+//***************************************************************************** 
+void indexRebuild(listingStore& store, uint32_t expectedRows)
+{
+	// variables 
+	int newBits; 				// log2 of the size of the new table
+	vector<uint32_t> newSlots; 	// New table
+	unsigned int mask; 			// To wrap slot numbers around the table
+	unsigned int slot; 			// Slot being probed
+	uint32_t row; 				// Row being added
+
+	newBits = INDEX_MIN_BITS; 
+
+	while (static_cast<uint64_t>(expectedRows) * 2 > (1ull << newBits))
+		newBits++; 
+
+	newSlots.assign(1u << newBits, NO_ROW); 
+	mask = (1u << newBits) - 1; 
+
+	for (row = 0; row < store.mls.size(); row++)
+	{
+		if (store.status[row] == STATUS_DELETED)
+			continue; 
+
+		slot = mlsHash(store.mls[row], newBits); 
+
+		while (newSlots[slot] != NO_ROW)
+			slot = (slot + 1) & mask; 
+
+		newSlots[slot] = row; 
+	}
+
+	store.indexSlots.swap(newSlots); 
+	store.indexBits = newBits; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: runBatch
+// DESCRIPTION: Runs the commands given on the command line in order, without 
+// any prompts. Each option "--name argument" is one command, and 
+// "--script file" runs the commands listed in a script file. Progress and 
+// the time taken by each command are written to the error stream. The run 
+// stops at the first command that fails. Either way the metrics are then 
+// written to the file named by METRICS_FILE_VARIABLE, if it is set, and 
+// the journal is closed. A run that ends cleanly first empties the 
+// journal, so changes it did not save are dropped rather than replayed by 
+// the next load; the journal is kept only when a command fails or the run 
+// is killed, for the next load to recover. 
+// INPUT: Parameters: argc, argv - command-line arguments 
+// store - listing store the commands act on 
+// OUTPUT: reference parameter: store 
+// Return value: 0 on success, EXIT_USAGE for a malformed command line or 
+// script, EXIT_FAILED if a command failed 
+// CALLS TO: readBatchScript, runBatchCommand, displayUsage, writeRunMetrics, 
+// journalClose, journalReset, storeClear 
+//***************************************************************************** 
+int runBatch(int argc, char* argv[], listingStore& store)
+{
+	// variables 
+	vector<batchCommand> commands;					// Commands to run in order 
+	batchCommand command;							// Command being read from the arguments 
+	int argIndex;									// Argument being read 
+	size_t commandIndex;							// Command being run 
+	string detail;									// Result of the command being run 
+	chrono::steady_clock::time_point runStart;		// When the first command started 
+	chrono::steady_clock::time_point commandStart;	// When the command being run started 
+	double elapsed;									// Milliseconds taken by the command 
+
+	for (argIndex = 1; argIndex < argc; argIndex++)
+	{
+		command.name = argv[argIndex]; 
+
+		if (command.name == "--help")
+		{
+			displayUsage(); 
+			return 0; 
+		}
+
+		if (command.name.compare(0, 2, "--") != 0 || argIndex + 1 >= argc)
+		{
+			cerr << "Invalid argument: " << command.name << endl << endl; 
+			displayUsage(); 
+			return EXIT_USAGE; 
+		}
+
+		command.name.erase(0, 2); 
+		command.argument = argv[++argIndex]; 
+		command.extraArguments.clear(); 
+
+		if (command.name == "stream")
+		{
+			if (argIndex + STREAM_EXTRA_ARGUMENTS >= argc)
+			{
+				cerr << "Invalid argument: --stream needs listings, changes and output files" << endl << endl; 
+				displayUsage(); 
+				return EXIT_USAGE; 
+			}
+
+			command.extraArguments.assign(argv + argIndex + 1, argv + argIndex + 1 + STREAM_EXTRA_ARGUMENTS); 
+			argIndex += STREAM_EXTRA_ARGUMENTS; 
+		}
+
+		if (command.name == "script")
+		{
+			if (!readBatchScript(command.argument, commands))
+				return EXIT_USAGE; 
+		}
+		else if (BATCH_COMMANDS.find(" " + command.name + " ") == string::npos)
+		{
+			cerr << "Unknown command: --" << command.name << endl << endl; 
+			displayUsage(); 
+			return EXIT_USAGE; 
+		}
+		else
+			commands.push_back(command); 
+	}
+
+	runStart = chrono::steady_clock::now(); 
+
+	for (commandIndex = 0; commandIndex < commands.size(); commandIndex++)
+	{
+		commandStart = chrono::steady_clock::now(); 
+
+		if (!runBatchCommand(store, commands[commandIndex], detail))
+		{
+			cerr << commands[commandIndex].name << " " << commands[commandIndex].argument
+			     << ": failed - " << detail << endl; 
+			writeRunMetrics(store); 
+			journalClose(store); 
+			return EXIT_FAILED; 
+		}
+
+		elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - commandStart).count(); 
+
+		cerr << commands[commandIndex].name << " " << commands[commandIndex].argument
+		     << ": " << detail << " (" << fixed << setprecision(3) << elapsed << " ms)" << endl; 
+	}
+
+	elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - runStart).count(); 
+
+	cerr << commands.size() << " command(s) completed in " << fixed << setprecision(3)
+	     << elapsed << " ms" << endl; 
+
+	writeRunMetrics(store); 
+
+	// An emptied journal is removed as the store is cleared 
+	if (store.journal.output != NULL)
+		journalReset(store); 
+
+	storeClear(store); 
+
+	return 0; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: readBatchScript
+// DESCRIPTION: Reads the commands of a batch script. Each line holds a 
+// command name and its argument, such as "apply CHANGES.TXT". Blank lines 
+// and lines starting with SCRIPT_COMMENT are ignored. The stream command 
+// takes three file names separated by spaces. 
+// INPUT: Parameters: fileName - name of the script file 
+// commands - vector to add the commands to 
+// OUTPUT: reference parameter: commands 
+// Return value: false if the script could not be read or is malformed 
+//***************************************************************************** 
+bool readBatchScript(const string& fileName, vector<batchCommand>& commands)
+{
+	// variables 
+	ifstream scriptFile;		// Variable for script file 
+	string line;				// Line being read 
+	int lineNumber = 0;			// Number of the line being read 
+	size_t start;				// Start of the command name or argument 
+	size_t split;				// End of the command name 
+	batchCommand command;		// Command read from the line 
+	istringstream fileNames;	// To split the file names of a stream command 
+	string extraName;			// File name split from a stream command 
+
+	scriptFile.open(fileName.c_str()); 
+
+	if (!scriptFile)
+	{
+		cerr << "Error: script file " << fileName << " not found." << endl; 
+		return false; 
+	}
+
+	while (getline(scriptFile, line))
+	{
+		lineNumber++; 
+
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1); 
+
+		start = line.find_first_not_of(" \t"); 
+
+		if (start == string::npos || line[start] == SCRIPT_COMMENT)
+			continue; 
+
+		split = line.find_first_of(" \t", start); 
+
+		if (split == string::npos)
+			split = line.size(); 
+
+		command.name = line.substr(start, split - start); 
+
+		if (command.name.compare(0, 2, "--") == 0)
+			command.name.erase(0, 2); 
+
+		start = line.find_first_not_of(" \t", split); 
+		command.argument = (start == string::npos) ? "" : line.substr(start); 
+		command.argument.erase(command.argument.find_last_not_of(" \t") + 1); 
+
+		command.extraArguments.clear(); 
+
+		if (command.name == "stream")
+		{
+			fileNames.clear(); 
+			fileNames.str(command.argument); 
+			fileNames >> command.argument; 
+
+			while (fileNames >> extraName)
+				command.extraArguments.push_back(extraName); 
+		}
+
+		if (BATCH_COMMANDS.find(" " + command.name + " ") == string::npos || command.argument.empty() 
+		    || command.extraArguments.size() != (command.name == "stream" ? STREAM_EXTRA_ARGUMENTS : 0))
+		{
+			cerr << fileName << " line " << lineNumber << ": invalid command \""
+			     << line << "\"" << endl; 
+			return false; 
+		}
+
+		commands.push_back(command); 
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: runBatchCommand
+// DESCRIPTION: Runs one batch command against the store. 
+// INPUT: Parameters: store - listing store the command acts on 
+// command - command to run 
+// detail - receives a one-line description of the result 
+// OUTPUT: reference parameters: store, detail 
+// Return value: false if the command failed 
+// CALLS TO: loadListingsFile, appendListingsMapped, importListingsFile, 
+// readChangesFile, applyPriceChanges, displayChangeSummary, deleteListingsFile, 
+// writeListingsFile, storeCompact, writeSnapshotFile, journalOpen, journalReset, 
+// streamPriceChanges, parsePageText, selectListings, parseQueryText, 
+// runQuery, displayListingHeader, displayListingRows, parseGroupBy, 
+// computeMarketStats, displayMarketStats, parseGeneratorText, 
+// generateListings, parseBenchSizes, runBenchmark, writeMetricsFile, 
+// runServer, reloadListingsFile, fingerprintListingsFile, saveHistoryFile, 
+// parseHistoryText, displayPriceHistory, writeDeltaFile, isShardTarget, 
+// writeShardDirectory, parseShardList 
+//*****************************************************************************
+bool runBatchCommand(listingStore& store, const batchCommand& command, string& detail)
+{
+	// variables 
+	loadSummary loaded;				// Results of loading a listings file 
+	vector<priceChange> changes;	// Records of a changes file 
+	changeSummary changed;			// Results of applying a changes file 
+	int deleted;					// Listings deleted 
+	int notFound;					// MLS numbers to delete that were not on file 
+	long megabytes;					// Memory budget given 
+	int replayed;					// Journaled changes recovered by a load 
+	const char *error;				// Reason the journal of a load could not be used 
+	streamSummary streamed;			// Results of a streaming job 
+	string streamError;				// Reason a streaming job failed 
+	string importError;				// Reason an import failed 
+	listingQuery query;				// Conditions of a query 
+	string queryError;				// Reason a query could not be read 
+	vector<uint32_t> matches;		// Rows of the listings matching a query 
+	listingPage page;				// Listings to display and their order 
+	int groupBy;					// Grouping of market statistics 
+	vector<marketGroup> groups;		// Market statistics of each group 
+	generatorSpec spec;				// Synthetic files to generate 
+	vector<uint64_t> sizes;			// Record counts to benchmark 
+	uint64_t requests;				// Requests a server answered 
+	reloadSummary reloaded;			// Results of reloading a changed listings file 
+	historyQuery history;			// Price changes to display 
+	size_t shown;					// Lines of price history displayed 
+	bool historySaved;				// Whether the price history was saved 
+	deltaSummary exported;			// Changes written to a delta file 
+	string deltaError;				// Reason a delta file was not written 
+	string saveName;				// File or shard directory saved to 
+	bool saveSharded;				// Whether the listings are saved as shards 
+	string shardError;				// Reason shards could not be saved or chosen 
+
+	if (command.name == "load" || command.name == "add")
+	{
+		if (command.name == "load" ? !loadListingsFile(command.argument, store, loaded)
+		                           : !appendListingsMapped(command.argument, store, loaded))
+		{
+			detail = "file could not be read"; 
+			return false; 
+		}
+
+		detail = to_string(loaded.recordsLoaded) + " listings " + command.name
+		       + "ed, " + to_string(loaded.recordsRejected) + " skipped"; 
+
+		if (loaded.memoryFull)
+			detail += ", memory full"; 
+
+		if (loaded.fromSnapshot)
+			detail += ", from snapshot"; 
+
+		if (command.name == "load" && !journalOpen(store, command.argument, replayed, error))
+			detail += string(", journal: ") + error; 
+
+		if (command.name == "load" && replayed > 0)
+			detail += ", " + to_string(replayed) + " journaled changes recovered"; 
+	}
+	else if (command.name == "reload")
+	{
+		if (!reloadListingsFile(command.argument, store, reloaded))
+		{
+			detail = "file could not be read"; 
+			return false; 
+		}
+
+		detail = to_string(reloaded.listingsAdded) + " listings added, " + to_string(reloaded.listingsRemoved)
+		       + " removed, " + to_string(reloaded.listingsChanged) + " changed, "
+		       + to_string(reloaded.recordsRejected) + " skipped, " + to_string(reloaded.chunksParsed)
+		       + " of " + to_string(reloaded.chunkCount) + " chunks parsed"; 
+
+		if (reloaded.memoryFull)
+			detail += ", memory full"; 
+
+		if (reloaded.unsavedKept > 0)
+			detail += ", " + to_string(reloaded.unsavedKept) + " unsaved changes kept"; 
+	}
+	else if (command.name == "import")
+	{
+		if (!importListingsFile(command.argument, store, loaded, importError))
+		{
+			detail = importError; 
+			return false; 
+		}
+
+		detail = to_string(loaded.recordsLoaded) + " listings imported, " + to_string(loaded.recordsRejected)
+		       + " rejected to " + command.argument + REJECTS_EXTENSION; 
+
+		if (loaded.memoryFull)
+			detail += ", memory full"; 
+	}
+	else if (command.name == "apply")
+	{
+		if (!readChangesFile(command.argument, changes, changed.recordsRejected))
+		{
+			detail = "file not found"; 
+			return false; 
+		}
+
+		store.history.source = command.argument; 
+		applyPriceChanges(store, changes, changed); 
+		displayChangeSummary(cerr, changed); 
+
+		detail = to_string(changed.recordsRead) + " changes, " + to_string(changed.recordsRejected) + " skipped, "
+		       + to_string(changed.listingsChanged) + " listings repriced, " + to_string(changed.unmatchedMLS.size())
+		       + " unmatched"; 
+	}
+	else if (command.name == "delete")
+	{
+		if (!deleteListingsFile(command.argument, store, deleted, notFound))
+		{
+			detail = "file not found"; 
+			return false; 
+		}
+
+		detail = to_string(deleted) + " listings deleted, " + to_string(notFound) + " not found"; 
+	}
+	else if (command.name == "save")
+	{
+		saveName = command.argument; 
+		saveSharded = isShardTarget(saveName); 
+
+		while (saveName.size() > 1 && saveName.back() == '/')
+			saveName.pop_back(); 
+
+		if (saveSharded ? !writeShardDirectory(saveName, store, shardError) : !writeListingsFile(saveName, store))
+		{
+			detail = saveSharded ? shardError : "file could not be written"; 
+			return false; 
+		}
+
+		// The saved file holds every journaled change, so the journal is emptied 
+		// whether or not the file saved is the one loaded 
+		if (store.journal.output != NULL)
+			journalReset(store); 
+
+		// Saving over the file loaded makes the file as saved the one a reload compares against 
+		if (saveName == store.fingerprint.fileName)
+			fingerprintListingsFile(saveName, store.fingerprint); 
+
+		historySaved = saveHistoryFile(saveName, store); 
+
+		// Saving over the file loaded exports the changes made since it was last saved 
+		exported.sequence = 0; 
+
+		if (saveName == store.delta.fileName 
+		    && !writeDeltaFile(saveName + DELTA_EXTENSION, store, exported, deltaError))
+			deltaError = ", changes could not be exported: " + deltaError; 
+		else
+			deltaError.clear(); 
+
+		// The rows of the listings deleted are reclaimed once they are saved 
+		storeCompact(store); 
+
+		detail = to_string(store.liveRows) + " listings saved"; 
+
+		if (!historySaved)
+			detail += ", price history could not be written"; 
+
+		if (exported.sequence != 0)
+			detail += ", " + to_string(exported.inserted + exported.updated + exported.deleted) + " changes exported"; 
+
+		detail += deltaError; 
+	}
+	else if (command.name == "snapshot")
+	{
+		if (!writeSnapshotFile(command.argument, store))
+		{
+			detail = "snapshot could not be written"; 
+			return false; 
+		}
+
+		detail = to_string(store.liveRows) + " listings written to snapshot"; 
+	}
+	else if (command.name == "stream")
+	{
+		if (!streamPriceChanges(command.argument, command.extraArguments[0], command.extraArguments[1], 
+		                        store.memoryBudget, streamed, streamError))
+		{
+			detail = streamError; 
+			return false; 
+		}
+
+		detail = to_string(streamed.listingsWritten) + " listings written to " + command.extraArguments[1] 
+		       + ", " + to_string(streamed.listingsChanged) + " repriced, " + to_string(streamed.unmatchedMLS) 
+		       + " unmatched, " + to_string(streamed.listings.recordsRejected) + " skipped, " 
+		       + to_string(streamed.changesRejected) + " changes skipped, " + to_string(streamed.runsSpilled) + " runs spilled, " + to_string(streamed.passes) + " pass(es)"; 
+	}
+	else if (command.name == "list")
+	{
+		if (!parsePageText(command.argument, page, queryError))
+		{
+			detail = queryError; 
+			return false; 
+		}
+
+		selectListings(store, page, matches); 
+
+		if (!matches.empty())
+			displayListingHeader(); 
+
+		displayListingRows(cout, store, matches, 0, matches.size()); 
+
+		detail = to_string(matches.size()) + " listings shown"; 
+	}
+	else if (command.name == "query")
+	{
+		if (!parseQueryText(command.argument, query, queryError))
+		{
+			detail = queryError; 
+			return false; 
+		}
+
+		runQuery(store, query, matches); 
+
+		if (!matches.empty())
+			displayListingHeader(); 
+
+		displayListingRows(cout, store, matches, 0, matches.size()); 
+
+		detail = to_string(matches.size()) + " listings matched"; 
+	}
+	else if (command.name == "stats")
+	{
+		if (!parseGroupBy(command.argument, groupBy))
+		{
+			detail = "group must be zip, zip3, status, company or all"; 
+			return false; 
+		}
+
+		computeMarketStats(store, groupBy, groups); 
+		displayMarketStats(cout, store, groupBy, groups); 
+
+		detail = to_string(groups.size()) + " groups"; 
+	}
+	else if (command.name == "history")
+	{
+		if (!parseHistoryText(command.argument, history, queryError))
+		{
+			detail = queryError; 
+			return false; 
+		}
+
+		shown = displayPriceHistory(cout, store, history); 
+		detail = to_string(shown) + (history.mls != 0 ? " price changes shown" : " listings shown"); 
+	}
+	else if (command.name == "delta")
+	{
+		if (!writeDeltaFile(command.argument, store, exported, deltaError))
+		{
+			detail = deltaError; 
+			return false; 
+		}
+
+		if (exported.sequence == 0)
+			detail = "no changes to export"; 
+		else
+			detail = "changes " + to_string(exported.sequence) + ": " + to_string(exported.inserted) + " added, "
+			       + to_string(exported.updated) + " changed, " + to_string(exported.deleted) + " deleted"; 
+	}
+	else if (command.name == "generate")
+	{
+		if (!parseGeneratorText(command.argument, spec, queryError) || !generateListings(spec, queryError))
+		{
+			detail = queryError; 
+			return false; 
+		}
+
+		detail = to_string(spec.records) + " listings lines written to " + spec.listingsFile; 
+	}
+	else if (command.name == "bench")
+	{
+		if (!parseBenchSizes(command.argument, sizes))
+		{
+			detail = "sizes must be positive numbers of records, or *"; 
+			return false; 
+		}
+
+		if (!runBenchmark(sizes, store, cout, queryError))
+		{
+			detail = queryError; 
+			return false; 
+		}
+
+		detail = to_string(sizes.size()) + " size(s) benchmarked"; 
+	}
+	else if (command.name == "serve")
+	{
+		if (!runServer(command.argument, store, requests, queryError))
+		{
+			detail = queryError; 
+			return false; 
+		}
+
+		detail = to_string(requests) + " requests served"; 
+	}
+	else if (command.name == "metrics")
+	{
+		if (!writeMetricsFile(command.argument, store))
+		{
+			detail = "metrics file could not be written"; 
+			return false; 
+		}
+
+		detail = "metrics written"; 
+	}
+	else if (command.name == "memory-mb")
+	{
+		megabytes = atol(command.argument.c_str()); 
+
+		if (megabytes <= 0)
+		{
+			detail = "budget must be a positive number of megabytes"; 
+			return false; 
+		}
+
+		store.memoryBudget = megabytes * MEGABYTE; 
+		detail = "memory budget set"; 
+	}
+	else if (command.name == "threads")
+	{
+		if (atoi(command.argument.c_str()) <= 0)
+		{
+			detail = "thread count must be a positive number"; 
+			return false; 
+		}
+
+		store.loadThreads = atoi(command.argument.c_str()); 
+		detail = "parsing threads set"; 
+	}
+	else if (command.name == "shards")
+	{
+		if (!parseShardList(command.argument, store.shards, shardError))
+		{
+			detail = shardError; 
+			return false; 
+		}
+
+		detail = store.shards.partial ? "shards chosen for the next load" : "every shard will be loaded"; 
+	}
+	else if (command.name == "io")
+	{
+		if (!parseIoBackend(command.argument, fileIO.kind))
+		{
+			detail = "I/O backend must be uring or blocking"; 
+			return false; 
+		}
+
+		detail = string("files read and written with ") + ioBackendName() + " I/O"; 
+	}
+	else
+	{
+		detail = "unknown command"; 
+		return false; 
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: deleteListingsFile
+// DESCRIPTION: Deletes every listing whose MLS number appears in a file of 
+// whitespace-separated MLS numbers. The file is mapped and parsed in place, 
+// and the listings are deleted in one pass by deleteListings. 
+// INPUT: Parameters: fileName - name of the file of MLS numbers 
+// store - listing store to delete from 
+// deleted - receives the number of listings deleted 
+// notFound - receives the number of MLS numbers not on file 
+// OUTPUT: reference parameters: store, deleted, notFound 
+// Return value: false if the file could not be opened 
+// CALLS TO: mapFile, unmapFile, parseMlsList, deleteListings 
+//***************************************************************************** 
+bool deleteListingsFile(const string& fileName, listingStore& store, int& deleted, int& notFound)
+{
+	// variables 
+	mappedFile mlsFile;			// Mapped bytes of the file of MLS numbers 
+	vector<uint32_t> mlsNumbers;	// MLS numbers read from the file 
+
+	if (!mapFile(fileName, mlsFile))
+		return false; 
+
+	parseMlsList(string_view(mlsFile.data, mlsFile.size), mlsNumbers); 
+	unmapFile(mlsFile); 
+
+	deleteListings(store, mlsNumbers, deleted, notFound); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: deleteListings
+// DESCRIPTION: Deletes the listings of a list of MLS numbers in one pass. 
+// The rows are looked up first and deleted in row order, which walks the 
+// columns in order. Deleted rows are tombstones until the store is 
+// compacted, which happens only once they are a large share of it. When 
+// the batch itself brings the store to that point, the rows are only 
+// marked deleted by storeMarkDeleted, and the compaction that follows 
+// rebuilds the indexes once, instead of removing every row from them 
+// first. An MLS number not on file, or repeated in the list, counts as 
+// not found. 
+// INPUT: Parameters: store - listing store to delete from 
+// mlsNumbers - MLS numbers of the listings to delete 
+// deleted - receives the number of listings deleted 
+// notFound - receives the number of MLS numbers not on file 
+// OUTPUT: reference parameters: store, deleted, notFound 
+// CALLS TO: indexFind, storeRemove, storeMarkDeleted, journalCommit, 
+// storeCompact 
+//***************************************************************************** 
+void deleteListings(listingStore& store, const vector<uint32_t>& mlsNumbers, int& deleted, int& notFound)
+{
+	// variables 
+	operationTimer timer(OPERATION_DELETE, false); 	// Adds the deletions to the metrics 
+	vector<uint32_t> rows; 		// Rows of the listings to delete 
+	uint32_t row; 				// Row of the listing being deleted 
+	size_t index; 				// MLS number or row being handled 
+	bool compactAfter; 			// Whether the batch leaves the store due for compaction 
+
+	rows.reserve(mlsNumbers.size()); 
+
+	for (index = 0; index < mlsNumbers.size(); index++)
+	{
+		row = indexFind(store, mlsNumbers[index]); 
+
+		if (row != NO_ROW)
+			rows.push_back(row); 
+	}
+
+	sort(rows.begin(), rows.end()); 
+	rows.erase(unique(rows.begin(), rows.end()), rows.end()); 
+
+	deleted = rows.size(); 
+	notFound = mlsNumbers.size() - rows.size(); 
+	compactAfter = (store.deletedRows + rows.size()) * COMPACT_DIVISOR > store.mls.size(); 
+
+	for (index = 0; index < rows.size(); index++)
+	{
+		row = rows[index]; 
+
+		if (!compactAfter)
+			storeRemove(store, row); 
+		else
+			storeMarkDeleted(store, row); 
+	}
+
+	journalCommit(store); 
+
+	if (compactAfter)
+		storeCompact(store); 
+
+	timer.recordsParsed = mlsNumbers.size(); 
+	timer.recordsRejected = notFound; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseMlsList
+// DESCRIPTION: Reads a list of MLS numbers separated by whitespace. A word 
+// that is not a number is passed over. 
+// INPUT: Parameters: text - list of MLS numbers 
+// mlsNumbers - receives the MLS numbers 
+// OUTPUT: reference parameter: mlsNumbers 
+//***************************************************************************** 
+void parseMlsList(string_view text, vector<uint32_t>& mlsNumbers)
+{
+	// variables 
+	const char *position; 		// Next character to read 
+	const char *end; 			// End of the text 
+	from_chars_result result; 	// Result of converting a number 
+	uint32_t mls; 				// MLS number read 
+
+	mlsNumbers.clear(); 
+	mlsNumbers.reserve(text.size() / (MLS_DIGITS + 1) + 1); 
+
+	position = text.data(); 
+	end = text.data() + text.size(); 
+
+	while (position < end)
+	{
+		while (position < end && isspace(static_cast<unsigned char>(*position)))
+			position++; 
+
+		if (position == end)
+			break; 
+
+		result = from_chars(position, end, mls); 
+
+		if (result.ec == errc() && (result.ptr == end || isspace(static_cast<unsigned char>(*result.ptr))))
+			mlsNumbers.push_back(mls); 
+
+		position = result.ptr; 
+
+		while (position < end && !isspace(static_cast<unsigned char>(*position)))
+			position++; 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: displayUsage
+// DESCRIPTION: Displays the command-line options of batch mode. 
+// OUTPUT: Outputs usage directly to screen. 
+//***************************************************************************** 
+void displayUsage()
+{
+	cout << "Usage: RealEstateTracker [--command argument]..." << endl << endl; 
+	cout << "With no arguments the program runs interactively. Otherwise the" << endl; 
+	cout << "commands run in the order given, without prompts:" << endl << endl; 
+	cout << "  --load FILE        Replace the listings with those in FILE, or its snapshot," << endl; 
+	cout << "                     or with the shards of the shard directory FILE" << endl; 
+	cout << "  --add FILE         Add the listings in FILE" << endl; 
+	cout << "  --reload FILE      Apply the changes in a new version of the listings file" << endl; 
+	cout << "                     loaded, parsing only the parts of it that changed" << endl; 
+	cout << "  --import FILE      Add the new listings in FILE that pass the rules for a" << endl; 
+	cout << "                     listing added by hand; rejected lines and the reasons" << endl; 
+	cout << "                     are written to FILE.rejects" << endl; 
+	cout << "  --apply FILE       Apply the price changes in FILE" << endl; 
+	cout << "  --delete FILE      Delete the listings whose MLS numbers are in FILE" << endl; 
+	cout << "  --save FILE        Save the listings to FILE, or to shards in FILE if it is a" << endl; 
+	cout << "                     directory or ends in '/'" << endl; 
+	cout << "  --snapshot FILE    Save the listings to the binary snapshot FILE" << endl; 
+	cout << "  --stream LISTINGS CHANGES OUTPUT" << endl; 
+	cout << "                     Apply CHANGES to LISTINGS and write OUTPUT without loading" << endl; 
+	cout << "                     them, within the memory limit" << endl; 
+	cout << "  --list PAGE        Display listings, such as \"sort=-price offset=100 limit=50\";" << endl; 
+	cout << "                     sort is file, mls, price or zip, with '-' for largest" << endl; 
+	cout << "                     first, and \"*\" shows every listing in file order" << endl; 
+	cout << "  --query CONDITIONS Display the listings matching CONDITIONS, such as" << endl; 
+	cout << "                     \"status=A zip=80513-* company=Metro Brokers\"; zip may" << endl; 
+	cout << "                     also be a 5-digit zip code or its first 3 digits; add" << endl; 
+	cout << "                     price=150000-250000 for a price range and top=N or" << endl; 
+	cout << "                     bottom=N for the N highest or lowest priced" << endl; 
+	cout << "  --stats GROUP      Display asking price statistics by zip, zip3, status," << endl; 
+	cout << "                     company, or for all listings" << endl; 
+	cout << "  --history QUERY    Display the price changes of a listing, \"mls=N\", or the" << endl; 
+	cout << "                     listings reduced at least N times in D days," << endl; 
+	cout << "                     \"reductions=N days=D\"" << endl; 
+	cout << "  --delta FILE       Append the listings added, changed and deleted since the last" << endl; 
+	cout << "                     save or export to the delta file FILE" << endl; 
+	cout << "  --generate SPEC    Write synthetic files, such as \"records=100000 listings=GEN.TXT" << endl; 
+	cout << "                     changes=GENCHANGES.TXT delete=GENDELETE.TXT import=GENNEW.TXT" << endl; 
+	cout << "                     seed=1\"; the same seed always gives the same files" << endl; 
+	cout << "  --bench SIZES      Time the main operations on synthetic files of each size," << endl; 
+	cout << "                     such as \"1000,100000\", or \"*\" for 10^3 to 10^7 records," << endl; 
+	cout << "                     writing one line of JSON per operation" << endl; 
+	cout << "  --metrics FILE     Write the operation metrics to FILE, as JSON if its name ends" << endl; 
+	cout << "                     in .json and in the Prometheus text format otherwise" << endl; 
+	cout << "  --serve SOCKET     Serve queries and changes to the listings over the Unix" << endl; 
+	cout << "                     domain socket SOCKET until a client sends \"shutdown\"" << endl; 
+	cout << "  --memory-mb N      Limit the listing store, or a stream job, to N megabytes" << endl; 
+	cout << "  --threads N        Parse large listings files on N threads" << endl; 
+	cout << "  --shards LIST      Load only these shards of a shard directory, by 3-digit zip" << endl; 
+	cout << "                     code prefix, such as \"800-809,972\", or \"*\" for all" << endl; 
+	cout << "  --io MODE          Read changes files and write listings files and snapshots" << endl; 
+	cout << "                     through io_uring (uring, the default where the system has" << endl; 
+	cout << "                     it) or with blocking calls (blocking)" << endl; 
+	cout << "  --script FILE      Run the commands in FILE, one \"command argument\" per line" << endl; 
+	cout << "  --help             Show this message" << endl << endl; 
+	cout << "Exit codes: 0 success, " << EXIT_USAGE << " invalid arguments, "
+	     << EXIT_FAILED << " a command failed." << endl; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: secondaryInsert
+// DESCRIPTION: Adds a row to the secondary indexes: the bitmap of its 
+// status, the row list of its 5-digit zip code, the row list of its 
+// realty company and the price index. The row's place in each list is 
+// kept so it can be removed in constant time. If memory runs out the 
+// indexes are left as they were. 
+// INPUT: Parameters: store - listing store holding the indexes 
+// row - row to add; its columns must already be filled 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceIndexInsert 
+//***************************************************************************** 
+void secondaryInsert(listingStore& store, uint32_t row)
+{
+	// variables 
+	vector<uint32_t> *zipList; 			// Rows with the same 5-digit zip code 
+	vector<uint32_t> *companyList; 		// Rows with the same realty company 
+	int status; 						// Status of the row 
+
+	// Growing these leaves the indexes unchanged if it fails 
+	if (store.zipRows.empty())
+		store.zipRows.resize(ZIP5_COUNT); 
+
+	if (store.companyRows.size() < store.companyNames.size())
+		store.companyRows.resize(store.companyNames.size()); 
+
+	if (store.zipPosition.size() < store.mls.size())
+	{
+		store.zipPosition.resize(store.mls.capacity()); 
+		store.companyPosition.resize(store.mls.capacity()); 
+	}
+
+	for (status = 0; status < STATUS_COUNT; status++)
+		if (store.statusBits[status].size() * 64 < store.mls.size())
+			store.statusBits[status].resize(store.mls.capacity() / 64 + 1); 
+
+	zipList = &store.zipRows[store.zip[row] / ZIP4_COUNT]; 
+	companyList = &store.companyRows[store.company[row]]; 
+
+	zipList->push_back(row); 
+
+	try
+	{
+		companyList->push_back(row); 
+	}
+	catch (bad_alloc&)
+	{
+		zipList->pop_back(); 
+		throw; 
+	}
+
+	try
+	{
+		priceIndexInsert(store, row); 
+	}
+	catch (bad_alloc&)
+	{
+		zipList->pop_back(); 
+		companyList->pop_back(); 
+		throw; 
+	}
+
+	store.zipPosition[row] = zipList->size() - 1; 
+	store.companyPosition[row] = companyList->size() - 1; 
+	store.statusBits[store.status[row]][row / 64] |= 1ull << (row % 64); 
+	store.statusCounts[store.status[row]]++; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: secondaryRemove
+// DESCRIPTION: Removes a row from the secondary indexes. The last row of 
+// each list takes the removed row's place. 
+// INPUT: Parameters: store - listing store holding the indexes 
+// row - row to remove; its columns must still be filled 
+// OUTPUT: reference parameter: store 
+// CALLS TO: removeFromRowList, priceIndexRemove 
+//***************************************************************************** 
+void secondaryRemove(listingStore& store, uint32_t row)
+{
+	removeFromRowList(store.zipRows[store.zip[row] / ZIP4_COUNT], store.zipPosition, row); 
+	removeFromRowList(store.companyRows[store.company[row]], store.companyPosition, row); 
+
+	store.statusBits[store.status[row]][row / 64] &= ~(1ull << (row % 64)); 
+	store.statusCounts[store.status[row]]--; 
+
+	priceIndexRemove(store, row); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: removeFromRowList
+// DESCRIPTION: Removes a row from a list of rows by moving the list's last 
+// row into its place and updating that row's recorded position. 
+// INPUT: Parameters: rows - list holding the row 
+// positions - position of each row in its list 
+// row - row to remove 
+// OUTPUT: reference parameters: rows, positions 
+//***************************************************************************** 
+void removeFromRowList(vector<uint32_t>& rows, vector<uint32_t>& positions, uint32_t row)
+{
+	// variables 
+	uint32_t moved; 			// Last row of the list 
+
+	moved = rows.back(); 
+	rows[positions[row]] = moved; 
+	positions[moved] = positions[row]; 
+	rows.pop_back(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: secondaryRebuild
+// DESCRIPTION: Rebuilds the secondary indexes from every row not marked as 
+// deleted, after rows have been renumbered or loaded in bulk. Each list is 
+// sized exactly before it is filled, in row order. 
+// INPUT: Parameters: store - listing store holding the indexes 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceIndexRebuild 
+//***************************************************************************** 
+void secondaryRebuild(listingStore& store)
+{
+	// variables 
+	vector<uint32_t> zipCounts; 		// Rows of each 5-digit zip code 
+	vector<uint32_t> companyCounts; 	// Rows of each realty company 
+	uint32_t row; 						// Row being added 
+	size_t key; 						// Zip code or company being sized 
+	int status; 						// Status being cleared 
+
+	zipCounts.assign(ZIP5_COUNT, 0); 
+	companyCounts.assign(store.companyNames.size(), 0); 
+
+	for (row = 0; row < store.mls.size(); row++)
+	{
+		if (store.status[row] == STATUS_DELETED)
+			continue; 
+
+		zipCounts[store.zip[row] / ZIP4_COUNT]++; 
+		companyCounts[store.company[row]]++; 
+	}
+
+	vector<vector<uint32_t> >(ZIP5_COUNT).swap(store.zipRows); 
+	vector<vector<uint32_t> >(store.companyNames.size()).swap(store.companyRows); 
+
+	for (key = 0; key < zipCounts.size(); key++)
+		store.zipRows[key].reserve(zipCounts[key]); 
+
+	for (key = 0; key < companyCounts.size(); key++)
+		store.companyRows[key].reserve(companyCounts[key]); 
+
+	store.zipPosition.assign(store.mls.capacity(), 0); 
+	store.companyPosition.assign(store.mls.capacity(), 0); 
+
+	for (status = 0; status < STATUS_COUNT; status++)
+	{
+		store.statusBits[status].assign(store.mls.capacity() / 64 + 1, 0); 
+		store.statusCounts[status] = 0; 
+	}
+
+	for (row = 0; row < store.mls.size(); row++)
+	{
+		if (store.status[row] == STATUS_DELETED)
+			continue; 
+
+		store.zipPosition[row] = store.zipRows[store.zip[row] / ZIP4_COUNT].size(); 
+		store.zipRows[store.zip[row] / ZIP4_COUNT].push_back(row); 
+		store.companyPosition[row] = store.companyRows[store.company[row]].size(); 
+		store.companyRows[store.company[row]].push_back(row); 
+		store.statusBits[store.status[row]][row / 64] |= 1ull << (row % 64); 
+		store.statusCounts[store.status[row]]++; 
+	}
+
+	priceIndexRebuild(store); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceIndexInsert
+// DESCRIPTION: Adds a row's current price to the price index. 
+// INPUT: Parameters: store - listing store holding the index 
+// row - row to add; its columns must already be filled 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceIndexAdd 
+//***************************************************************************** 
+void priceIndexInsert(listingStore& store, uint32_t row)
+{
+	// variables 
+	priceEntry entry; 			// Entry for the row 
+
+	if (store.priceGeneration.size() <= row)
+		store.priceGeneration.resize(max<size_t>(store.mls.capacity(), row + 1)); 
+
+	entry.price = store.price[row]; 
+	entry.row = row; 
+	entry.generation = store.priceGeneration[row]; 
+
+	priceIndexAdd(store, entry); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceIndexAdd
+// DESCRIPTION: Adds an entry to the delta buffer of the price index, first 
+// merging a full buffer into the sorted entries. The buffer is only 
+// allocated again if that merge fails for lack of memory, so the entry is 
+// either added or, if that allocation fails, the index is left as it was. 
+// INPUT: Parameters: store - listing store holding the index 
+// entry - entry to add 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceIndexMerge, comparePriceEntry 
+//***************************************************************************** 
+void priceIndexAdd(listingStore& store, const priceEntry& entry)
+{
+	if (!store.priceDelta.empty() && store.priceDelta.size() == store.priceDelta.capacity())
+		priceIndexMerge(store); 
+
+	if (!store.priceDelta.empty() && comparePriceEntry(entry, store.priceDelta.back()))
+		store.priceDeltaSorted = false; 
+
+	store.priceDelta.push_back(entry); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceIndexRemove
+// DESCRIPTION: Takes a row's price out of the price index by moving the row 
+// to a new generation, which leaves its entry stale. Stale entries are 
+// dropped by the next merge, which is made early once they are half of the 
+// index. 
+// INPUT: Parameters: store - listing store holding the index 
+// row - row to remove 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceIndexMerge 
+//***************************************************************************** 
+void priceIndexRemove(listingStore& store, uint32_t row)
+{
+	store.priceGeneration[row]++; 
+	store.priceStale++; 
+
+	if (store.priceStale > (store.priceSorted.size() + store.priceDelta.size()) / PRICE_STALE_DIVISOR)
+		priceIndexMerge(store); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceIndexMerge
+// DESCRIPTION: Merges the delta buffer of the price index into its sorted 
+// entries and drops the stale entries, in place. The sorted entries have 
+// room reserved for a full buffer, so this normally allocates nothing; if 
+// that room cannot be found the merge is put off. 
+// INPUT: Parameters: store - listing store holding the index 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceIndexSortDelta, priceEntryCurrent, comparePriceEntry 
+//***************************************************************************** 
+void priceIndexMerge(listingStore& store)
+{
+	// variables 
+	size_t middle; 				// First entry taken from the delta buffer 
+	size_t readIndex; 			// Entry being examined 
+	size_t writeIndex; 			// Place of the next entry kept 
+
+	priceIndexSortDelta(store); 
+
+	middle = store.priceSorted.size(); 
+
+	try
+	{
+		store.priceSorted.insert(store.priceSorted.end(), store.priceDelta.begin(), store.priceDelta.end()); 
+	}
+	catch (bad_alloc&)
+	{
+		return; 
+	}
+
+	inplace_merge(store.priceSorted.begin(), store.priceSorted.begin() + middle, 
+	              store.priceSorted.end(), comparePriceEntry); 
+
+	writeIndex = 0; 
+
+	for (readIndex = 0; readIndex < store.priceSorted.size(); readIndex++)
+		if (priceEntryCurrent(store, store.priceSorted[readIndex]))
+			store.priceSorted[writeIndex++] = store.priceSorted[readIndex]; 
+
+	store.priceSorted.resize(writeIndex); 
+	store.priceDelta.clear(); 
+	store.priceStale = 0; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceIndexSortDelta
+// DESCRIPTION: Sorts the delta buffer of the price index if entries have 
+// been added out of order since it was last sorted. 
+// INPUT: Parameters: store - listing store holding the index 
+// OUTPUT: reference parameter: store 
+// CALLS TO: comparePriceEntry 
+//***************************************************************************** 
+void priceIndexSortDelta(listingStore& store)
+{
+	if (store.priceDeltaSorted)
+		return; 
+
+	sort(store.priceDelta.begin(), store.priceDelta.end(), comparePriceEntry); 
+	store.priceDeltaSorted = true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceIndexRebuild
+// DESCRIPTION: Rebuilds the price index from every row not marked as 
+// deleted, with room for a full delta buffer. 
+// INPUT: Parameters: store - listing store holding the index 
+// OUTPUT: reference parameter: store 
+// CALLS TO: priceDeltaCapacity, comparePriceEntry 
+//***************************************************************************** 
+void priceIndexRebuild(listingStore& store)
+{
+	// variables 
+	vector<priceEntry> sorted; 		// New sorted entries 
+	vector<priceEntry> delta; 		// New, empty delta buffer 
+	priceEntry entry; 				// Entry for the row being added 
+	uint32_t row; 					// Row being added 
+
+	delta.reserve(priceDeltaCapacity(store.mls.capacity())); 
+	sorted.reserve(store.mls.capacity() + delta.capacity()); 
+	store.priceGeneration.assign(store.mls.capacity(), 0); 
+
+	entry.generation = 0; 
+
+	for (row = 0; row < store.mls.size(); row++)
+	{
+		if (store.status[row] == STATUS_DELETED)
+			continue; 
+
+		entry.price = store.price[row]; 
+		entry.row = row; 
+		sorted.push_back(entry); 
+	}
+
+	sort(sorted.begin(), sorted.end(), comparePriceEntry); 
+
+	store.priceSorted.swap(sorted); 
+	store.priceDelta.swap(delta); 
+	store.priceDeltaSorted = true; 
+	store.priceStale = 0; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceDeltaCapacity
+// DESCRIPTION: Returns the size of the price index's delta buffer for a 
+// number of rows. A buffer an eighth of the rows keeps the cost of merging 
+// it to a few entries per price added. 
+// INPUT: Parameters: rows - rows the store has room for 
+// OUTPUT: Return value: entries the delta buffer holds 
+//***************************************************************************** 
+size_t priceDeltaCapacity(size_t rows)
+{
+	return max<size_t>(PRICE_DELTA_MIN, rows / PRICE_DELTA_DIVISOR); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceEntryCurrent
+// DESCRIPTION: Checks whether a price index entry still holds the price of 
+// a listing, rather than one since changed or deleted. 
+// INPUT: Parameters: store - listing store holding the index 
+// entry - entry to check 
+// OUTPUT: Return value: true if the entry is current 
+//***************************************************************************** 
+bool priceEntryCurrent(const listingStore& store, const priceEntry& entry)
+{
+	return store.priceGeneration[entry.row] == entry.generation && store.status[entry.row] != STATUS_DELETED; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: comparePriceEntry
+// DESCRIPTION: Orders price index entries by price, then by row. 
+// INPUT: Parameters: left, right - entries to compare 
+// OUTPUT: Return value: true if left sorts before right 
+//***************************************************************************** 
+bool comparePriceEntry(const priceEntry& left, const priceEntry& right)
+{
+	if (left.price != right.price)
+		return left.price < right.price; 
+
+	return left.row < right.row; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceRangeSize
+// DESCRIPTION: Counts the price index entries within a price range, 
+// including stale ones, by binary search. 
+// INPUT: Parameters: store - listing store holding the index 
+// low, high - lowest and highest prices of the range 
+// OUTPUT: Return value: entries within the range 
+// CALLS TO: priceIndexSortDelta, comparePriceEntry 
+//***************************************************************************** 
+size_t priceRangeSize(listingStore& store, int64_t low, int64_t high)
+{
+	// variables 
+	priceEntry first; 			// Smallest entry in the range 
+	priceEntry last; 			// Largest entry in the range 
+
+	priceIndexSortDelta(store); 
+
+	first.price = low; 
+	first.row = 0; 
+	last.price = high; 
+	last.row = NO_ROW; 
+
+	return (upper_bound(store.priceSorted.begin(), store.priceSorted.end(), last, comparePriceEntry) 
+	        - lower_bound(store.priceSorted.begin(), store.priceSorted.end(), first, comparePriceEntry)) 
+	     + (upper_bound(store.priceDelta.begin(), store.priceDelta.end(), last, comparePriceEntry) 
+	        - lower_bound(store.priceDelta.begin(), store.priceDelta.end(), first, comparePriceEntry)); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: priceScan
+// DESCRIPTION: Finds the listings matching a query by walking the price 
+// index through the query's price range, lowest or highest price first, 
+// until the query's limit is reached. The sorted entries and the delta 
+// buffer are walked together, so the cost is a binary search plus the 
+// entries passed over. 
+// INPUT: Parameters: store - listing store to search 
+// query - conditions to match, with the order to walk in 
+// rows - receives the rows of the matching listings, in price order 
+// OUTPUT: reference parameters: store, rows 
+// CALLS TO: priceIndexSortDelta, comparePriceEntry, priceEntryCurrent, 
+// queryMatches 
+//***************************************************************************** 
+void priceScan(listingStore& store, const listingQuery& query, vector<uint32_t>& rows)
+{
+	// variables 
+	priceEntry first; 					// Smallest entry in the range 
+	priceEntry last; 					// Largest entry in the range 
+	size_t sortedBegin; 				// First sorted entry not yet walked 
+	size_t sortedEnd; 					// Sorted entry after the last not yet walked 
+	size_t deltaBegin; 					// First delta entry not yet walked 
+	size_t deltaEnd; 					// Delta entry after the last not yet walked 
+	const priceEntry *entry; 			// Entry being checked 
+	bool takeSorted; 					// Whether the next entry is a sorted one 
+
+	priceIndexSortDelta(store); 
+
+	first.price = query.minPrice; 
+	first.row = 0; 
+	last.price = query.maxPrice; 
+	last.row = NO_ROW; 
+
+	sortedBegin = lower_bound(store.priceSorted.begin(), store.priceSorted.end(), first, comparePriceEntry) 
+	            - store.priceSorted.begin(); 
+	sortedEnd = upper_bound(store.priceSorted.begin(), store.priceSorted.end(), last, comparePriceEntry) 
+	          - store.priceSorted.begin(); 
+	deltaBegin = lower_bound(store.priceDelta.begin(), store.priceDelta.end(), first, comparePriceEntry) 
+	           - store.priceDelta.begin(); 
+	deltaEnd = upper_bound(store.priceDelta.begin(), store.priceDelta.end(), last, comparePriceEntry) 
+	         - store.priceDelta.begin(); 
+
+	rows.clear(); 
+
+	while ((sortedBegin < sortedEnd || deltaBegin < deltaEnd) 
+	       && (query.limit == 0 || rows.size() < query.limit))
+	{
+		if (query.order == QUERY_HIGHEST)
+		{
+			takeSorted = deltaBegin == deltaEnd || (sortedBegin < sortedEnd 
+			             && comparePriceEntry(store.priceDelta[deltaEnd - 1], store.priceSorted[sortedEnd - 1])); 
+			entry = takeSorted ? &store.priceSorted[--sortedEnd] : &store.priceDelta[--deltaEnd]; 
+		}
+		else
+		{
+			takeSorted = deltaBegin == deltaEnd || (sortedBegin < sortedEnd 
+			             && comparePriceEntry(store.priceSorted[sortedBegin], store.priceDelta[deltaBegin])); 
+			entry = takeSorted ? &store.priceSorted[sortedBegin++] : &store.priceDelta[deltaBegin++]; 
+		}
+
+		if (priceEntryCurrent(store, *entry) && queryMatches(store, entry->row, query))
+			rows.push_back(entry->row); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeReprice
+// DESCRIPTION: Changes the asking price of a listing and moves it within 
+// the price index. The new entry is added before the old one is made stale, 
+// so if memory runs out the listing keeps its old price. The change is 
+// journaled, added to the price history under the history's current 
+// source and marked as a change since the last save. 
+// INPUT: Parameters: store - listing store holding the listing 
+// row - row of the listing 
+// price - new asking price, in cents 
+// OUTPUT: reference parameter: store 
+// Return value: false if memory ran out and the price was not changed 
+// CALLS TO: priceIndexAdd, priceIndexRemove, journalRecord, historyReserve, 
+// historyRecord, deltaMark, shardMark 
+//***************************************************************************** 
+bool storeReprice(listingStore& store, uint32_t row, int64_t price)
+{
+	// variables 
+	priceEntry entry; 			// Entry for the new price 
+
+	entry.price = price; 
+	entry.row = row; 
+	entry.generation = store.priceGeneration[row] + 1; 
+
+	try
+	{
+		historyReserve(store.history); 
+		priceIndexAdd(store, entry); 
+	}
+	catch (bad_alloc&)
+	{
+		return false; 
+	}
+
+	historyRecord(store.history, store.mls[row], store.price[row], price); 
+
+	// The row's old entry becomes stale and the new one current 
+	store.price[row] = price; 
+	priceIndexRemove(store, row); 
+
+	journalRecord(store, JOURNAL_PRICE, row); 
+	deltaMark(store.delta, store.mls[row], JOURNAL_PRICE); 
+	shardMark(store.shards, store.zip[row]); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: storeUpdate
+// DESCRIPTION: Changes the price, status, zip code and company of a listing 
+// in place, so that it keeps its row and its place in file order. The row 
+// is taken out of the secondary indexes and put back under its new values. 
+// A new price goes in the price history. The change is journaled as one 
+// record and marked, with the listing's old and new shards, as a change 
+// since the last save. If memory runs out the listing is deleted rather 
+// than left out of the indexes. 
+// INPUT: Parameters: store - listing store holding the listing 
+// row - row of the listing 
+// price - new asking price, in cents 
+// status - new status 
+// zip - new zip code, packed by packZip 
+// company - new realty company name 
+// OUTPUT: reference parameter: store 
+// Return value: false if memory ran out and the listing was deleted 
+// CALLS TO: shardMark, secondaryRemove, historyReserve, internCompany, 
+// secondaryInsert, indexRemove, storeMarkDeleted, historyRecord, 
+// journalRecord, deltaMark 
+//***************************************************************************** 
+bool storeUpdate(listingStore& store, uint32_t row, int64_t price, statusOptions status, uint32_t zip, string_view company)
+{
+	// variables 
+	int64_t oldPrice; 			// Asking price before the change 
+
+	oldPrice = store.price[row]; 
+	shardMark(store.shards, store.zip[row]); 
+	secondaryRemove(store, row); 
+
+	try
+	{
+		historyReserve(store.history); 
+		store.company[row] = internCompany(store, company); 
+		store.price[row] = price; 
+		store.status[row] = status; 
+		store.zip[row] = zip; 
+		secondaryInsert(store, row); 
+	}
+	catch (bad_alloc&)
+	{
+		indexRemove(store, store.mls[row]); 
+		storeMarkDeleted(store, row); 
+		return false; 
+	}
+
+	if (price != oldPrice)
+		historyRecord(store.history, store.mls[row], oldPrice, price); 
+
+	journalRecord(store, JOURNAL_CHANGE, row); 
+	deltaMark(store.delta, store.mls[row], JOURNAL_CHANGE); 
+	shardMark(store.shards, zip); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: generateListings
+// DESCRIPTION: Writes a synthetic listings file and, if named, a changes 
+// file, a file of MLS numbers to delete and a file of new listings to 
+// import, in the formats the program reads. The same seed always gives the 
+// same files. Zip code prefixes, zip codes and realty companies are drawn 
+// so that a few are common and most are rare, as in a real market; three 
+// in five listings are available, one in four under contract and the rest 
+// sold, and one price in fifty has cents. DUPLICATE_PERCENT of the listings 
+// repeat an earlier MLS number, as does every listing once all MLS_COUNT 
+// numbers are in use. MISSING_PERCENT of the changes and deletes name MLS 
+// numbers not on file, and INVALID_PERCENT of the import lines break a rule 
+// of a new listing. 
+// INPUT: Parameters: spec - sizes and names of the files 
+// error - receives the reason the files could not be written 
+// OUTPUT: Output direct to files; reference parameter: error 
+// Return value: false if a file could not be written 
+// CALLS TO: generatedCompanies, generateListing, generatedMls, 
+// formatListingLine, formatPrice, writeGeneratedText, nextRandom 
+//***************************************************************************** 
+bool generateListings(const generatorSpec& spec, string& error)
+{
+	// variables 
+	uint64_t state; 				// State of the random sequence 
+	vector<string> companies; 		// Realty company names 
+	uint64_t used; 					// Distinct MLS numbers given out so far 
+	uint64_t line; 					// Line being generated 
+	uint64_t index; 				// Sequence number of the line's MLS number 
+	uint64_t missing; 				// MLS numbers never given out 
+	uint32_t zip; 					// Zip code of the listing, packed 
+	int64_t price; 					// Price of the listing or reduction, in cents 
+	int status; 					// Status of the listing 
+	size_t company; 				// Realty company of the listing 
+	FILE *output; 					// File being written 
+	string text; 					// Lines not yet written 
+	char buffer[LINE_RESERVE_BYTES + COMPANY_LENGTH + 1]; 	// Line being formatted 
+	char *position; 				// End of the line being formatted 
+	bool written; 					// Whether every write succeeded 
+	int kind; 						// Rule an invalid import line breaks 
+
+	state = spec.seed; 
+	generatedCompanies(spec.records, companies); 
+	used = 0; 
+
+	output = fopen(spec.listingsFile.c_str(), "w"); 
+
+	if (output == NULL)
+	{
+		error = "listings file could not be written"; 
+		return false; 
+	}
+
+	written = true; 
+
+	for (line = 0; line < spec.records; line++)
+	{
+		if (used == 0 || (used < MLS_COUNT && nextRandom(state) % 100 >= static_cast<uint64_t>(DUPLICATE_PERCENT)))
+			index = used++; 
+		else
+			index = nextRandom(state) % used; 
+
+		generateListing(state, companies.size(), zip, price, status, company); 
+		position = formatListingLine(buffer, generatedMls(index), price, status, zip, companies[company]); 
+		text.append(buffer, position - buffer); 
+		written = writeGeneratedText(output, text, false) && written; 
+	}
+
+	written = writeGeneratedText(output, text, true) && written; 
+	written = (fclose(output) == 0) && written; 
+
+	// Missing MLS numbers come after the ones given out, wrapping once all are used 
+	missing = max<uint64_t>(MLS_COUNT - used, 1); 
+
+	if (written && !spec.changesFile.empty())
+	{
+		output = fopen(spec.changesFile.c_str(), "w"); 
+		written = output != NULL; 
+
+		for (line = 0; written && line < spec.changeRecords; line++)
+		{
+			if (used == 0 || nextRandom(state) % 100 < static_cast<uint64_t>(MISSING_PERCENT))
+				index = used + nextRandom(state) % missing; 
+			else
+				index = nextRandom(state) % used; 
+
+			price = (1 + nextRandom(state) % 400) * 50 * CENTS_PER_DOLLAR; 
+
+			if (nextRandom(state) % 20 == 0)
+				price += nextRandom(state) % CENTS_PER_DOLLAR; 
+
+			position = to_chars(buffer, buffer + sizeof(buffer), generatedMls(index)).ptr; 
+			*position++ = ' '; 
+			position = formatPrice(position, price, false); 
+			*position++ = '\n'; 
+			text.append(buffer, position - buffer); 
+			written = writeGeneratedText(output, text, false); 
+		}
+
+		if (output != NULL)
+		{
+			written = writeGeneratedText(output, text, true) && written; 
+			written = (fclose(output) == 0) && written; 
+		}
+
+		if (!written)
+			error = "changes file could not be written"; 
+	}
+
+	if (written && !spec.deleteFile.empty())
+	{
+		output = fopen(spec.deleteFile.c_str(), "w"); 
+		written = output != NULL; 
+
+		for (line = 0; written && line < spec.deleteRecords; line++)
+		{
+			if (used == 0 || nextRandom(state) % 100 < static_cast<uint64_t>(MISSING_PERCENT))
+				index = used + nextRandom(state) % missing; 
+			else
+				index = nextRandom(state) % used; 
+
+			position = to_chars(buffer, buffer + sizeof(buffer), generatedMls(index)).ptr; 
+			*position++ = '\n'; 
+			text.append(buffer, position - buffer); 
+			written = writeGeneratedText(output, text, false); 
+		}
+
+		if (output != NULL)
+		{
+			written = writeGeneratedText(output, text, true) && written; 
+			written = (fclose(output) == 0) && written; 
+		}
+
+		if (!written)
+			error = "delete file could not be written"; 
+	}
+
+	if (written && !spec.importFile.empty())
+	{
+		output = fopen(spec.importFile.c_str(), "w"); 
+		written = output != NULL; 
+
+		for (line = 0; written && line < spec.importRecords; line++)
+		{
+			generateListing(state, companies.size(), zip, price, status, company); 
+			index = used + line; 
+			kind = -1; 
+
+			if (nextRandom(state) % 100 < static_cast<uint64_t>(INVALID_PERCENT))
+				kind = nextRandom(state) % 4; 
+
+			// An invalid line has no price, a malformed zip code, a digit in 
+			// its company name, or the MLS number of a listing on file 
+			if (kind == 0)
+				price = 0; 
+
+			if (kind == 3 && used > 0)
+				index = nextRandom(state) % used; 
+
+			position = formatListingLine(buffer, generatedMls(index), price, status, zip, companies[company]); 
+
+			if (kind == 1)
+				*strchr(buffer, '-') = '0'; 
+
+			if (kind == 2)
+				position[-2] = '7'; 
+
+			text.append(buffer, position - buffer); 
+			written = writeGeneratedText(output, text, false); 
+		}
+
+		if (output != NULL)
+		{
+			written = writeGeneratedText(output, text, true) && written; 
+			written = (fclose(output) == 0) && written; 
+		}
+
+		if (!written)
+			error = "import file could not be written"; 
+	}
+	else if (!written && error.empty())
+		error = "listings file could not be written"; 
+
+	return written; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: generateListing
+// DESCRIPTION: Makes up the fields of one synthetic listing. The zip code 
+// prefix and the zip code within it are drawn by randomSkewed, so some zip 
+// codes are far more common than others, and the price depends on the 
+// prefix, so neighbourhoods differ in price as well as size. 
+// INPUT: Parameters: state - state of the random sequence 
+// companies - number of realty companies 
+// zip - receives the zip code, packed 
+// price - receives the price, in cents 
+// status - receives the status 
+// company - receives the realty company, counted from 0 
+// OUTPUT: reference parameters: state, zip, price, status, company 
+// CALLS TO: nextRandom, randomSkewed 
+//***************************************************************************** 
+void generateListing(uint64_t& state, size_t companies, uint32_t& zip, int64_t& price, int& status, size_t& company)
+{
+	// variables 
+	uint32_t zip3; 				// Zip code prefix 
+	uint32_t roll; 				// Random percentage deciding the status 
+	int64_t dollars; 			// Price in whole dollars 
+
+	zip3 = (randomSkewed(state, ZIP3_COUNT) * ZIP3_SCRAMBLE + 100) % ZIP3_COUNT; 
+	zip = (zip3 * (ZIP5_COUNT / ZIP3_COUNT) + randomSkewed(state, (ZIP5_COUNT / ZIP3_COUNT))) * ZIP4_COUNT + nextRandom(state) % ZIP4_COUNT; 
+
+	// The prefix sets the middle of the prices; each listing falls from half to 1.5 times it 
+	dollars = 60000 + (zip3 * 7919 % 500) * 1000; 
+	dollars = dollars * (50 + nextRandom(state) % 100) / 100 / 100 * 100; 
+	price = dollars * CENTS_PER_DOLLAR; 
+
+	if (nextRandom(state) % 50 == 0)
+		price += nextRandom(state) % CENTS_PER_DOLLAR; 
+
+	roll = nextRandom(state) % 100; 
+	status = (roll < 60) ? AVAILABLE : (roll < 85) ? CONTRACT : SOLD; 
+	company = randomSkewed(state, companies); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: generatedMls
+// DESCRIPTION: Returns the MLS number of the synthetic listing with a 
+// sequence number. The first MLS_COUNT sequence numbers give every MLS 
+// number once, in a scrambled order; later ones repeat them. 
+// INPUT: Parameters: index - sequence number 
+// OUTPUT: Return value: MLS number 
+//***************************************************************************** 
+uint32_t generatedMls(uint64_t index)
+{
+	return MLS_MIN + (index % MLS_COUNT * MLS_SCRAMBLE + 12345) % MLS_COUNT; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: generatedCompanies
+// DESCRIPTION: Makes up the realty company names of synthetic listings, one 
+// per LISTINGS_PER_COMPANY listings, but at least MIN_COMPANIES, from the 
+// combinations of COMPANY_WORDS and COMPANY_SUFFIXES no longer than 
+// COMPANY_LENGTH. 
+// INPUT: Parameters: records - number of synthetic listings 
+// names - receives the company names 
+// OUTPUT: reference parameter: names 
+//***************************************************************************** 
+void generatedCompanies(uint64_t records, vector<string>& names)
+{
+	// variables 
+	uint64_t wanted; 			// Company names to make 
+	size_t suffix; 				// Last word being combined 
+	size_t word; 				// First word being combined 
+	string name; 				// Name being made 
+
+	wanted = max(records / LISTINGS_PER_COMPANY, MIN_COMPANIES); 
+	names.clear(); 
+
+	for (suffix = 0; suffix < sizeof(COMPANY_SUFFIXES) / sizeof(COMPANY_SUFFIXES[0]); suffix++)
+	{
+		for (word = 0; word < sizeof(COMPANY_WORDS) / sizeof(COMPANY_WORDS[0]) && names.size() < wanted; word++)
+		{
+			name = string(COMPANY_WORDS[word]) + " " + COMPANY_SUFFIXES[suffix]; 
+
+			if (name.size() <= static_cast<size_t>(COMPANY_LENGTH))
+				names.push_back(name); 
+		}
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeGeneratedText
+// DESCRIPTION: Writes the text of a synthetic file once WRITE_BUFFER_BYTES 
+// have built up, or all of it when the file is finished. 
+// INPUT: Parameters: file - open output file 
+// text - lines not yet written 
+// finish - whether to write the text however short 
+// OUTPUT: reference parameter: text 
+// Return value: false if the text could not be written 
+//***************************************************************************** 
+bool writeGeneratedText(FILE* file, string& text, bool finish)
+{
+	// variables 
+	bool written = true; 		// Whether the write succeeded 
+
+	if (finish || text.size() >= WRITE_BUFFER_BYTES)
+	{
+		written = fwrite(text.data(), 1, text.size(), file) == text.size(); 
+		text.clear(); 
+	}
+
+	return written; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: nextRandom
+// DESCRIPTION: Returns the next number of a seeded random sequence 
+// (splitmix64). The sequence is the same on every platform, unlike the 
+// distributions of <random>, so synthetic files can be compared anywhere. 
+// INPUT: Parameters: state - state of the sequence 
+// OUTPUT: reference parameter: state 
+// Return value: next random number 
+//***************************************************************************** 
+uint64_t nextRandom(uint64_t& state)
+{
+	// variables 
+	uint64_t value; 			// Number being mixed 
+
+	state += 0x9E3779B97F4A7C15ull; 
+	value = state; 
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull; 
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull; 
+
+	return value ^ (value >> 31); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: randomSkewed
+// DESCRIPTION: Returns a random number below count, with small numbers far 
+// more likely than large ones: its logarithm is uniform, so each number is 
+// drawn about in inverse proportion to its size, as the sizes of towns and 
+// firms are. 
+// INPUT: Parameters: state - state of the random sequence 
+// count - numbers to choose from 
+// OUTPUT: reference parameter: state 
+// Return value: number from 0 to count - 1 
+// CALLS TO: nextRandom 
+//***************************************************************************** 
+uint64_t randomSkewed(uint64_t& state, uint64_t count)
+{
+	// variables 
+	double fraction; 			// Uniform random number from 0 to 1 
+	uint64_t value; 			// Number drawn 
+
+	fraction = (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0); 
+	value = static_cast<uint64_t>(pow(static_cast<double>(count) + 1, fraction)) - 1; 
+
+	return min(value, count - 1); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseGeneratorText
+// DESCRIPTION: Reads the sizes and names of synthetic files written as 
+// "name=value" terms separated by spaces, such as "records=100000 
+// listings=BIG.TXT changes=BIGCHANGES.TXT seed=7". records and listings are 
+// required; changes, delete and import name the other files, whose sizes 
+// default to 1/10, 1/20 and 1/20 of records and may be given as 
+// change-records, delete-records and import-records. 
+// INPUT: Parameters: text - text of the terms 
+// spec - receives the sizes and names 
+// error - receives the reason the text is not understood 
+// OUTPUT: reference parameters: spec, error 
+// Return value: false if the text is not understood 
+//***************************************************************************** 
+bool parseGeneratorText(const string& text, generatorSpec& spec, string& error)
+{
+	// variables 
+	istringstream words; 		// To split the text into words 
+	string word; 				// Word being read 
+	string name; 				// Name of the term 
+	string value; 				// Value of the term 
+	size_t equals; 				// Position of '=' in the word 
+	uint64_t number; 			// Value converted to a number 
+	from_chars_result result; 	// Result of converting a number 
+	bool changeSized = false; 	// Whether change-records was given 
+	bool deleteSized = false; 	// Whether delete-records was given 
+	bool importSized = false; 	// Whether import-records was given 
+
+	spec = generatorSpec(); 
+	words.str(text); 
+
+	while (words >> word)
+	{
+		equals = word.find('='); 
+
+		if (equals == string::npos || equals + 1 == word.size())
+		{
+			error = "expected name=value, found \"" + word + "\""; 
+			return false; 
+		}
+
+		name = word.substr(0, equals); 
+		value = word.substr(equals + 1); 
+
+		if (name == "listings")
+			spec.listingsFile = value; 
+		else if (name == "changes")
+			spec.changesFile = value; 
+		else if (name == "delete")
+			spec.deleteFile = value; 
+		else if (name == "import")
+			spec.importFile = value; 
+		else
+		{
+			result = from_chars(value.data(), value.data() + value.size(), number); 
+
+			if (result.ec != errc() || result.ptr != value.data() + value.size())
+			{
+				error = name + " must be a number"; 
+				return false; 
+			}
+
+			if (name == "records")
+				spec.records = number; 
+			else if (name == "seed")
+				spec.seed = number; 
+			else if (name == "change-records")
+			{
+				spec.changeRecords = number; 
+				changeSized = true; 
+			}
+			else if (name == "delete-records")
+			{
+				spec.deleteRecords = number; 
+				deleteSized = true; 
+			}
+			else if (name == "import-records")
+			{
+				spec.importRecords = number; 
+				importSized = true; 
+			}
+			else
+			{
+				error = "unknown term \"" + name + "\""; 
+				return false; 
+			}
+		}
+	}
+
+	if (spec.records == 0 || spec.listingsFile.empty())
+	{
+		error = "records=N and listings=FILE are required"; 
+		return false; 
+	}
+
+	if (!changeSized)
+		spec.changeRecords = spec.records / CHANGES_DIVISOR; 
+
+	if (!deleteSized)
+		spec.deleteRecords = spec.records / DELETES_DIVISOR; 
+
+	if (!importSized)
+		spec.importRecords = spec.records / IMPORTS_DIVISOR; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: runBenchmark
+// DESCRIPTION: Times the main operations of the program on synthetic files 
+// of each size given, in order: generating the files, loading them as 
+// readFile does, formatting every listing as displayAll does (into a stream 
+// that discards it), a zip code and status query, the highest priced 
+// listings, statistics by zip code prefix, applying a changes file as 
+// ChangeAskingPrices does, deleting a file of MLS numbers, importing new 
+// listings, publishing a copy of the store as the server does after each 
+// write group, saving as SaveToFile does, writing and loading a snapshot, and 
+// streaming the changes through the listings file. Each step is reported 
+// by reportBenchmarkStep as one line of JSON. The files are written where 
+// streaming jobs write their spill files and removed after each size. 
+// INPUT: Parameters: sizes - numbers of listings file lines to time 
+// settings - store whose memory budget and thread setting to use 
+// out - stream to report to 
+// error - receives the step that failed 
+// OUTPUT: Reports to out; reference parameter: error 
+// Return value: false if a step failed 
+// CALLS TO: tempFileBase, generateListings, loadListingsFile, 
+// selectListings, displayListingRows, runQuery, computeMarketStats, 
+// readChangesFile, applyPriceChanges, deleteListingsFile, 
+// importListingsFile, publishSnapshot, writeListingsFile, 
+// writeSnapshotFile, loadSnapshotFile, streamPriceChanges, storeClear, 
+// reportBenchmarkStep 
+//***************************************************************************** 
+bool runBenchmark(const vector<uint64_t>& sizes, const listingStore& settings, ostream& out, string& error)
+{
+	// variables 
+	size_t sizeIndex; 					// Size being timed 
+	uint64_t records; 					// Lines of the listings file 
+	string base; 						// Start of the names of the files 
+	generatorSpec spec; 				// Files to generate 
+	listingStore store; 				// Store the operations are timed on 
+	listingStore loaded; 				// Store the snapshot is loaded into 
+	loadSummary summary; 				// Results of a load or import 
+	discardBuffer discarded; 			// Drops displayed listings 
+	ostream screen(&discarded); 		// Stream the listings are displayed to 
+	vector<uint32_t> rows; 				// Rows displayed or found by a query 
+	listingQuery query; 				// Query being timed 
+	vector<marketGroup> groups; 		// Market statistics 
+	vector<priceChange> changes; 		// Records of the changes file 
+	changeSummary changed; 				// Results of applying the changes 
+	int deleted; 						// Listings deleted 
+	int notFound; 						// MLS numbers to delete not on file 
+	streamSummary streamed; 			// Results of streaming the changes 
+	serverState server; 				// Server the store's copy is published to 
+	const char *snapshotError; 			// Reason the snapshot could not be loaded 
+	chrono::steady_clock::time_point start; 	// When the step being timed began 
+	bool succeeded; 					// Whether every step so far succeeded 
+
+	succeeded = true; 
+
+	for (sizeIndex = 0; succeeded && sizeIndex < sizes.size(); sizeIndex++)
+	{
+		records = sizes[sizeIndex]; 
+		base = tempFileBase(BENCH_FILE_BASE + to_string(records)); 
+
+		spec = generatorSpec(); 
+		spec.records = records; 
+		spec.listingsFile = base + ".listings"; 
+		spec.changesFile = base + ".changes"; 
+		spec.deleteFile = base + ".delete"; 
+		spec.importFile = base + ".import"; 
+		spec.changeRecords = records / CHANGES_DIVISOR; 
+		spec.deleteRecords = records / DELETES_DIVISOR; 
+		spec.importRecords = records / IMPORTS_DIVISOR; 
+
+		store.memoryBudget = settings.memoryBudget; 
+		store.loadThreads = settings.loadThreads; 
+
+		start = chrono::steady_clock::now(); 
+		succeeded = generateListings(spec, error); 
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "generate", records, start, 0); 
+
+			start = chrono::steady_clock::now(); 
+			succeeded = loadListingsFile(spec.listingsFile, store, summary); 
+
+			if (!succeeded)
+				error = "listings file could not be loaded"; 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "load", records, start, store.liveRows); 
+
+			start = chrono::steady_clock::now(); 
+			selectListings(store, listingPage(), rows); 
+			displayListingRows(screen, store, rows, 0, rows.size()); 
+			reportBenchmarkStep(out, records, "display", rows.size(), start, store.liveRows); 
+
+			query = listingQuery(); 
+			query.status = AVAILABLE; 
+			query.zipDigits = 3; 
+			query.zipPrefix = store.liveRows > 0 ? store.zip[0] / (ZIP4_COUNT * (ZIP5_COUNT / ZIP3_COUNT)) : 0; 
+
+			start = chrono::steady_clock::now(); 
+			runQuery(store, query, rows); 
+			reportBenchmarkStep(out, records, "query", rows.size(), start, store.liveRows); 
+
+			query = listingQuery(); 
+			query.order = QUERY_HIGHEST; 
+			query.limit = TOP_LISTINGS; 
+
+			start = chrono::steady_clock::now(); 
+			runQuery(store, query, rows); 
+			reportBenchmarkStep(out, records, "top", rows.size(), start, store.liveRows); 
+
+			start = chrono::steady_clock::now(); 
+			computeMarketStats(store, GROUP_ZIP3, groups); 
+			reportBenchmarkStep(out, records, "stats", store.liveRows, start, store.liveRows); 
+
+			start = chrono::steady_clock::now(); 
+			succeeded = readChangesFile(spec.changesFile, changes, changed.recordsRejected); 
+
+			if (!succeeded)
+				error = "changes file could not be read"; 
+		}
+
+		if (succeeded)
+		{
+			// Reading the changes is part of applying them, so both steps start together 
+			reportBenchmarkStep(out, records, "read-changes", changes.size(), start, store.liveRows); 
+
+			store.history.source = spec.changesFile; 
+			applyPriceChanges(store, changes, changed); 
+			reportBenchmarkStep(out, records, "apply", changed.recordsRead, start, store.liveRows); 
+
+			start = chrono::steady_clock::now(); 
+			succeeded = deleteListingsFile(spec.deleteFile, store, deleted, notFound); 
+
+			if (!succeeded)
+				error = "delete file could not be read"; 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "delete", deleted + notFound, start, store.liveRows); 
+
+			start = chrono::steady_clock::now(); 
+			succeeded = importListingsFile(spec.importFile, store, summary, error); 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "import", summary.recordsLoaded + summary.recordsRejected, 
+			                    start, store.liveRows); 
+
+			// From the third copy on, the server writes each copy over one replaced before 
+			server.master = &store; 
+			publishSnapshot(server); 
+			publishSnapshot(server); 
+			start = chrono::steady_clock::now(); 
+			publishSnapshot(server); 
+			succeeded = server.published != NULL; 
+
+			if (!succeeded)
+				error = "store could not be copied for readers"; 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "publish", store.liveRows, start, store.liveRows); 
+			server.published.reset(); 
+			server.retired.reset(); 
+
+			start = chrono::steady_clock::now(); 
+			succeeded = writeListingsFile(base + ".saved", store); 
+
+			if (!succeeded)
+				error = "listings could not be saved"; 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "save", store.liveRows, start, store.liveRows); 
+
+			start = chrono::steady_clock::now(); 
+			succeeded = writeSnapshotFile(base + SNAPSHOT_EXTENSION, store); 
+
+			if (!succeeded)
+				error = "snapshot could not be written"; 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "snapshot-save", store.liveRows, start, store.liveRows); 
+			storeClear(store); 
+
+			loaded.memoryBudget = settings.memoryBudget; 
+			start = chrono::steady_clock::now(); 
+			succeeded = loadSnapshotFile(base + SNAPSHOT_EXTENSION, loaded, snapshotError); 
+
+			if (!succeeded)
+				error = string("snapshot could not be loaded: ") + snapshotError; 
+		}
+
+		if (succeeded)
+		{
+			reportBenchmarkStep(out, records, "snapshot-load", loaded.liveRows, start, loaded.liveRows); 
+			storeClear(loaded); 
+
+			error.clear(); 
+			start = chrono::steady_clock::now(); 
+			succeeded = streamPriceChanges(spec.listingsFile, spec.changesFile, base + ".streamed", 
+			                               settings.memoryBudget, streamed, error); 
+		}
+
+		if (succeeded)
+			reportBenchmarkStep(out, records, "stream", streamed.listingsWritten, start, 0); 
+		else
+			error += " at " + to_string(records) + " records"; 
+
+		storeClear(store); 
+		storeClear(loaded); 
+
+		remove(spec.listingsFile.c_str()); 
+		remove(spec.changesFile.c_str()); 
+		remove(spec.deleteFile.c_str()); 
+		remove(spec.importFile.c_str()); 
+		remove((spec.importFile + REJECTS_EXTENSION).c_str()); 
+		remove((base + ".saved").c_str()); 
+		remove((base + SNAPSHOT_EXTENSION).c_str()); 
+		remove((base + ".streamed").c_str()); 
+	}
+
+	return succeeded; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: reportBenchmarkStep
+// DESCRIPTION: Writes the timing of one benchmark step as a line of JSON, 
+// such as {"records":1000,"step":"load","items":1000,"ms":0.512, 
+// "items_per_second":1953125,"listings":990,"peak_rss_kb":4100,"io":"uring"}. 
+// items is what the step handled: lines, listings, changes or MLS numbers. 
+// peak_rss_kb is the most memory the program has held so far, so it never 
+// falls, and io is the file I/O backend. 
+// INPUT: Parameters: out - stream to report to 
+// records - lines of the listings file 
+// step - name of the step 
+// items - things the step handled 
+// start - when the step began 
+// listings - listings in the store after the step 
+// OUTPUT: Reports to out. 
+// CALLS TO: peakMemoryKB, ioBackendName 
+//***************************************************************************** 
+void reportBenchmarkStep(ostream& out, uint64_t records, const char* step, uint64_t items, 
+                         chrono::steady_clock::time_point start, uint32_t listings)
+{
+	// variables 
+	double elapsed; 			// Milliseconds the step took 
+
+	elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); 
+
+	out << "{\"records\":" << records << ",\"step\":\"" << step << "\",\"items\":" << items 
+	    << ",\"ms\":" << fixed << setprecision(3) << elapsed 
+	    << ",\"items_per_second\":" << setprecision(0) << (elapsed > 0 ? items * 1000.0 / elapsed : 0.0) 
+	    << ",\"listings\":" << listings << ",\"peak_rss_kb\":" << peakMemoryKB() 
+	    << ",\"io\":\"" << ioBackendName() << "\"}" << endl; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: peakMemoryKB
+// DESCRIPTION: Returns the most memory the program has held in RAM at once, 
+// its peak resident set size. 
+// OUTPUT: Return value: peak memory in kilobytes, or 0 where it is not known 
+//***************************************************************************** 
+long peakMemoryKB()
+{
+#ifdef _WIN32
+	return 0; 
+#else
+	// variables 
+	struct rusage usage; 		// Resource use of the program 
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0; 
+
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024; 
+#else
+	return usage.ru_maxrss; 
+#endif
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseBenchSizes
+// DESCRIPTION: Reads the numbers of listings file lines to benchmark, 
+// separated by spaces or commas, or "*" for 10^3 through 10^7. 
+// INPUT: Parameters: text - list of sizes 
+// sizes - receives the sizes 
+// OUTPUT: reference parameter: sizes 
+// Return value: false if a size is not a positive number 
+//***************************************************************************** 
+bool parseBenchSizes(const string& text, vector<uint64_t>& sizes)
+{
+	// variables 
+	istringstream words; 		// To split the text into words 
+	string word; 				// Word being read 
+	string spaced; 				// Text with commas replaced by spaces 
+	uint64_t size; 				// Size converted 
+	from_chars_result result; 	// Result of converting a size 
+
+	sizes.clear(); 
+
+	if (text == "*")
+	{
+		sizes.assign(BENCH_DEFAULT_SIZES, BENCH_DEFAULT_SIZES + sizeof(BENCH_DEFAULT_SIZES) / sizeof(BENCH_DEFAULT_SIZES[0])); 
+		return true; 
+	}
+
+	spaced = text; 
+	replace(spaced.begin(), spaced.end(), ',', ' '); 
+	words.str(spaced); 
+
+	while (words >> word)
+	{
+		result = from_chars(word.data(), word.data() + word.size(), size); 
+
+		if (result.ec != errc() || result.ptr != word.data() + word.size() || size == 0)
+			return false; 
+
+		sizes.push_back(size); 
+	}
+
+	return !sizes.empty(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: operationTimer::~operationTimer
+// DESCRIPTION: Adds a finished operation to its metrics: one more call, a 
+// failure unless it succeeded, the time it took and its latency bucket, and 
+// the bytes and records it counted. Each counter is one relaxed atomic add, 
+// so measuring costs a few nanoseconds per operation, not per record. 
+// OUTPUT: Adds to the metrics. 
+// CALLS TO: latencyBucket 
+//***************************************************************************** 
+operationTimer::~operationTimer()
+{
+	// variables 
+	uint64_t elapsed; 						// Nanoseconds the operation took 
+	operationMetrics& counters = metrics[operation]; 	// Metrics of the operation 
+
+	elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count(); 
+
+	counters.calls.fetch_add(1, memory_order_relaxed); 
+
+	if (!succeeded)
+		counters.failures.fetch_add(1, memory_order_relaxed); 
+
+	counters.nanoseconds.fetch_add(elapsed, memory_order_relaxed); 
+	counters.latency[latencyBucket(elapsed)].fetch_add(1, memory_order_relaxed); 
+	counters.bytesRead.fetch_add(bytesRead, memory_order_relaxed); 
+	counters.bytesWritten.fetch_add(bytesWritten, memory_order_relaxed); 
+	counters.recordsParsed.fetch_add(recordsParsed, memory_order_relaxed); 
+	counters.recordsRejected.fetch_add(recordsRejected, memory_order_relaxed); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: latencyBucket
+// DESCRIPTION: Returns the latency histogram bucket of an elapsed time: the 
+// first bucket whose bound in LATENCY_BOUNDS_US is not less than the time, 
+// or the last, unbounded bucket. 
+// INPUT: Parameters: nanoseconds - time an operation took 
+// OUTPUT: Return value: bucket from 0 to LATENCY_BUCKETS - 1 
+//***************************************************************************** 
+int latencyBucket(uint64_t nanoseconds)
+{
+	// variables 
+	uint64_t microseconds; 		// Time rounded up to whole microseconds 
+
+	microseconds = (nanoseconds + 999) / 1000; 
+
+	return lower_bound(LATENCY_BOUNDS_US, LATENCY_BOUNDS_US + LATENCY_BUCKETS - 1, microseconds) 
+	       - LATENCY_BOUNDS_US; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeMetricsFile
+// DESCRIPTION: Writes the operation metrics and the current size of the 
+// store to a file, as JSON if the name ends in METRICS_JSON_EXTENSION and 
+// in the Prometheus text exposition format otherwise. The file is written 
+// under a temporary name and renamed, so a scraper never reads half of it. 
+// INPUT: Parameters: fileName - name of the metrics file 
+// store - listing store whose size is reported 
+// OUTPUT: Output direct to file. 
+// Return value: false if the file could not be written 
+// CALLS TO: formatMetricsJson, formatMetricsPrometheus, syncFile, 
+// replaceFile 
+//***************************************************************************** 
+bool writeMetricsFile(const string& fileName, const listingStore& store)
+{
+	// variables 
+	ostringstream text; 		// Formatted metrics 
+	string formatted; 			// Text of the formatted metrics 
+	string tempName; 			// Name of the file written before the rename 
+	FILE *outputFile; 			// Metrics file 
+	bool written; 				// Whether every write succeeded 
+
+	if (fileName.size() >= METRICS_JSON_EXTENSION.size() 
+	    && fileName.compare(fileName.size() - METRICS_JSON_EXTENSION.size(), string::npos, METRICS_JSON_EXTENSION) == 0)
+		formatMetricsJson(text, store); 
+	else
+		formatMetricsPrometheus(text, store); 
+
+	formatted = text.str(); 
+	tempName = fileName + TEMP_EXTENSION; 
+	outputFile = fopen(tempName.c_str(), "w"); 
+
+	if (outputFile == NULL)
+		return false; 
+
+	written = fwrite(formatted.data(), 1, formatted.size(), outputFile) == formatted.size(); 
+	written = syncFile(outputFile) && written; 
+	written = (fclose(outputFile) == 0) && written; 
+
+	if (!written || !replaceFile(tempName, fileName))
+	{
+		remove(tempName.c_str()); 
+		return false; 
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: formatMetricsPrometheus
+// DESCRIPTION: Formats the metrics in the Prometheus text exposition format: 
+// a counter of calls, failures, bytes and records and a latency histogram 
+// for each operation, labelled operation="name", and gauges of the 
+// listings stored, the store's memory in use and the peak memory of the 
+// program. Latency bounds are in seconds and the buckets are cumulative, 
+// as the format requires. 
+// INPUT: Parameters: out - stream to write to 
+// store - listing store whose size is reported 
+// OUTPUT: Writes to out. 
+// CALLS TO: storeMemoryUsed, peakMemoryKB 
+//***************************************************************************** 
+void formatMetricsPrometheus(ostream& out, const listingStore& store)
+{
+	// variables 
+	int operation; 				// Operation being written 
+	int bucket; 				// Latency bucket being written 
+	uint64_t cumulative; 		// Operations in this bucket and those below it 
+	const char *names[] = {"operations_total", "operation_failures_total", "bytes_read_total", 
+	                       "bytes_written_total", "records_parsed_total", "records_rejected_total"}; 	// Counter names 
+	const char *help[] = {"Operations run.", "Operations that failed.", "Bytes of files read.", 
+	                      "Bytes of files or screen output written.", "Records read, including rejected ones.", 
+	                      "Records rejected as malformed, duplicate or unmatched."}; 	// Counter descriptions 
+	size_t counter; 			// Counter being written 
+	uint64_t value; 			// Value of the counter 
+
+	for (counter = 0; counter < sizeof(names) / sizeof(names[0]); counter++)
+	{
+		out << "# HELP realestate_" << names[counter] << " " << help[counter] << "\n"; 
+		out << "# TYPE realestate_" << names[counter] << " counter\n"; 
+
+		for (operation = 0; operation < OPERATION_COUNT; operation++)
+		{
+			switch (counter)
+			{
+			case 0: value = metrics[operation].calls.load(memory_order_relaxed); break; 
+			case 1: value = metrics[operation].failures.load(memory_order_relaxed); break; 
+			case 2: value = metrics[operation].bytesRead.load(memory_order_relaxed); break; 
+			case 3: value = metrics[operation].bytesWritten.load(memory_order_relaxed); break; 
+			case 4: value = metrics[operation].recordsParsed.load(memory_order_relaxed); break; 
+			default: value = metrics[operation].recordsRejected.load(memory_order_relaxed); break; 
+			}
+
+			out << "realestate_" << names[counter] << "{operation=\"" << OPERATION_NAMES[operation] << "\"} " 
+			    << value << "\n"; 
+		}
+	}
+
+	out << "# HELP realestate_operation_duration_seconds Time taken by operations.\n"; 
+	out << "# TYPE realestate_operation_duration_seconds histogram\n"; 
+
+	for (operation = 0; operation < OPERATION_COUNT; operation++)
+	{
+		cumulative = 0; 
+
+		for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+		{
+			cumulative += metrics[operation].latency[bucket].load(memory_order_relaxed); 
+			out << "realestate_operation_duration_seconds_bucket{operation=\"" << OPERATION_NAMES[operation] 
+			    << "\",le=\""; 
+
+			if (bucket < LATENCY_BUCKETS - 1)
+				out << LATENCY_BOUNDS_US[bucket] / 1e6; 
+			else
+				out << "+Inf"; 
+
+			out << "\"} " << cumulative << "\n"; 
+		}
+
+		out << "realestate_operation_duration_seconds_sum{operation=\"" << OPERATION_NAMES[operation] << "\"} " 
+		    << metrics[operation].nanoseconds.load(memory_order_relaxed) / 1e9 << "\n"; 
+		out << "realestate_operation_duration_seconds_count{operation=\"" << OPERATION_NAMES[operation] << "\"} " 
+		    << cumulative << "\n"; 
+	}
+
+	out << "# HELP realestate_listings Listings in the store.\n"; 
+	out << "# TYPE realestate_listings gauge\n"; 
+	out << "realestate_listings " << store.liveRows << "\n"; 
+	out << "# HELP realestate_memory_bytes Memory held by the listing store.\n"; 
+	out << "# TYPE realestate_memory_bytes gauge\n"; 
+	out << "realestate_memory_bytes " << storeMemoryUsed(store) << "\n"; 
+	out << "# HELP realestate_memory_budget_bytes Memory the listing store may grow to.\n"; 
+	out << "# TYPE realestate_memory_budget_bytes gauge\n"; 
+	out << "realestate_memory_budget_bytes " << store.memoryBudget << "\n"; 
+	out << "# HELP realestate_peak_rss_bytes Most memory the program has held at once.\n"; 
+	out << "# TYPE realestate_peak_rss_bytes gauge\n"; 
+	out << "realestate_peak_rss_bytes " << peakMemoryKB() * 1024 << "\n"; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: formatMetricsJson
+// DESCRIPTION: Formats the metrics as one JSON object: the listings stored, 
+// memory in use, memory budget and peak memory, and for each operation its 
+// calls, failures, total seconds, bytes, records and latency buckets, each 
+// bucket holding the operations no faster than the bucket below it and no 
+// slower than its bound "le_us" in microseconds (null for the last). 
+// INPUT: Parameters: out - stream to write to 
+// store - listing store whose size is reported 
+// OUTPUT: Writes to out. 
+// CALLS TO: storeMemoryUsed, peakMemoryKB 
+//***************************************************************************** 
+void formatMetricsJson(ostream& out, const listingStore& store)
+{
+	// variables 
+	int operation; 				// Operation being written 
+	int bucket; 				// Latency bucket being written 
+	const operationMetrics *counters; 	// Metrics of the operation 
+
+	out << "{\"listings\":" << store.liveRows << ",\"memory_bytes\":" << storeMemoryUsed(store) 
+	    << ",\"memory_budget_bytes\":" << store.memoryBudget << ",\"peak_rss_bytes\":" << peakMemoryKB() * 1024 
+	    << ",\"operations\":{"; 
+
+	for (operation = 0; operation < OPERATION_COUNT; operation++)
+	{
+		counters = &metrics[operation]; 
+
+		out << (operation > 0 ? "," : "") << "\"" << OPERATION_NAMES[operation] << "\":{" 
+		    << "\"calls\":" << counters->calls.load(memory_order_relaxed) 
+		    << ",\"failures\":" << counters->failures.load(memory_order_relaxed) 
+		    << ",\"seconds\":" << counters->nanoseconds.load(memory_order_relaxed) / 1e9 
+		    << ",\"bytes_read\":" << counters->bytesRead.load(memory_order_relaxed) 
+		    << ",\"bytes_written\":" << counters->bytesWritten.load(memory_order_relaxed) 
+		    << ",\"records_parsed\":" << counters->recordsParsed.load(memory_order_relaxed) 
+		    << ",\"records_rejected\":" << counters->recordsRejected.load(memory_order_relaxed) 
+		    << ",\"latency\":["; 
+
+		for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+		{
+			out << (bucket > 0 ? "," : "") << "{\"le_us\":"; 
+
+			if (bucket < LATENCY_BUCKETS - 1)
+				out << LATENCY_BOUNDS_US[bucket]; 
+			else
+				out << "null"; 
+
+			out << ",\"count\":" << counters->latency[bucket].load(memory_order_relaxed) << "}"; 
+		}
+
+		out << "]}"; 
+	}
+
+	out << "}}\n"; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: WriteMetrics
+// DESCRIPTION: Asks whether to write the operation metrics in the Prometheus 
+// text format or as JSON, and writes them to FILE_METRICS with the matching 
+// extension. 
+// INPUT: Parameters: store - listing store whose size is reported 
+// OUTPUT: Output direct to file; confirmation to screen. 
+// CALLS TO: writeMetricsFile 
+//***************************************************************************** 
+void WriteMetrics(const listingStore& store)
+{
+	// variables 
+	char format; 				// P for Prometheus text, J for JSON 
+	string fileName; 			// Name of the metrics file 
+
+	do
+	{
+		cout << "Write metrics as P - Prometheus text or J - JSON?: "; 
+		cin >> format; 
+		cout << endl; 
+
+		format = toupper(format); 
+
+		if (format != 'P' && format != 'J')
+			cout << "Invalid entry: Must be 'P' or 'J'." << endl << endl; 
+	}
+	while (format != 'P' && format != 'J'); 
+
+	fileName = FILE_METRICS + (format == 'J' ? METRICS_JSON_EXTENSION : METRICS_PROMETHEUS_EXTENSION); 
+
+	if (writeMetricsFile(fileName, store))
+		cout << "Metrics written to " << fileName << "." << endl << endl; 
+	else
+		cout << "Error: " << fileName << " could not be written." << endl << endl; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeRunMetrics
+// DESCRIPTION: Writes the operation metrics at the end of a batch run, 
+// whether or not it succeeded, to the file named by the 
+// METRICS_FILE_VARIABLE environment variable, if that is set, so a monitor 
+// can collect them after every run. 
+// INPUT: Parameters: store - listing store whose size is reported 
+// OUTPUT: Output direct to file; errors to the error stream. 
+// CALLS TO: writeMetricsFile 
+//***************************************************************************** 
+void writeRunMetrics(const listingStore& store)
+{
+	// variables 
+	const char *fileName; 		// Metrics file named by the environment 
+
+	fileName = getenv(METRICS_FILE_VARIABLE); 
+
+	if (fileName != NULL && *fileName != '\0' && !writeMetricsFile(fileName, store))
+		cerr << "Metrics file " << fileName << " could not be written." << endl; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: addListingText
+// DESCRIPTION: Adds one listing written as a listings file line, after 
+// checking it against the rules of a listing entered by hand, as an 
+// import does. 
+// INPUT: Parameters: store - listing store to add to 
+// text - the listing, "MLS price status zip company" 
+// error - receives the reason the listing was not added 
+// OUTPUT: reference parameters: store, error 
+// Return value: false if the listing was not added 
+// CALLS TO: appendImportLine, validateImportBatch, titleCaseCompany, 
+// storeAppend, journalCommit 
+//***************************************************************************** 
+bool addListingText(listingStore& store, string_view text, string& error)
+{
+	// variables 
+	importBatch batch; 			// The listing, as a batch of one 
+	string companyName; 		// Company name of the listing 
+
+	if (!appendImportLine(batch, text, 1))
+	{
+		error = "listing expected"; 
+		return false; 
+	}
+
+	validateImportBatch(store, batch); 
+
+	if (batch.reason[0] != NULL)
+	{
+		error = batch.reason[0]; 
+		return false; 
+	}
+
+	companyName.assign(batch.company[0]); 
+	titleCaseCompany(companyName); 
+
+	if (storeAppend(store, batch.mls[0], batch.price[0], static_cast<statusOptions>(batch.status[0]), 
+	                batch.zip[0], companyName) == NO_ROW)
+	{
+		error = "memory full"; 
+		return false; 
+	}
+
+	journalCommit(store); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseRepriceText
+// DESCRIPTION: Reads price changes given in a request as pairs of an MLS 
+// number and a reduction in dollars, such as "123456 5000 234567 1250.50", 
+// the same fields as the lines of a changes file. 
+// INPUT: Parameters: text - the pairs, separated by spaces 
+// changes - receives the change records in the order given 
+// OUTPUT: reference parameter: changes 
+// Return value: false if no pair was given or a pair is malformed 
+// CALLS TO: dollarsToCents 
+//***************************************************************************** 
+bool parseRepriceText(const string& text, vector<priceChange>& changes)
+{
+	// variables 
+	istringstream words; 		// To split the text into words 
+	priceChange change; 		// Change being read 
+	double reduction; 			// Reduction read, in dollars 
+
+	changes.clear(); 
+	words.str(text); 
+
+	while (words >> change.numberMLS)
+	{
+		if (!(words >> reduction) || !dollarsToCents(reduction, change.reduction))
+			return false; 
+
+		changes.push_back(change); 
+	}
+
+	return words.eof() && !changes.empty(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: appendListingLines
+// DESCRIPTION: Formats listings as lines of a listings file, so a client 
+// can read them as it would the file. 
+// INPUT: Parameters: out - text to append to 
+// store - listing store holding the listings 
+// rows - rows of the listings, in the order to write them 
+// OUTPUT: reference parameter: out 
+// CALLS TO: formatListingLine 
+//***************************************************************************** 
+void appendListingLines(string& out, const listingStore& store, const vector<uint32_t>& rows)
+{
+	// variables 
+	const string *company; 		// Company name of the listing 
+	size_t lineStart; 			// Where the listing's line starts in out 
+	char *lineEnd; 				// End of the formatted line 
+	size_t index; 				// Listing being formatted 
+
+	for (index = 0; index < rows.size(); index++)
+	{
+		company = &store.companyNames[store.company[rows[index]]]; 
+		lineStart = out.size(); 
+
+		// Every field but the company name fits in LINE_RESERVE_BYTES 
+		out.resize(lineStart + LINE_RESERVE_BYTES + company->size()); 
+		lineEnd = formatListingLine(&out[lineStart], store.mls[rows[index]], store.price[rows[index]], 
+		                            store.status[rows[index]], store.zip[rows[index]], *company); 
+		out.resize(lineEnd - out.data()); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: runServer
+// DESCRIPTION: Serves the store to clients connecting to a Unix domain 
+// socket, until a client sends "shutdown". Each connection has its own 
+// thread. Clients send one request per line and receive any result lines 
+// followed by a line starting "OK" or "ERROR". Queries are answered from a 
+// published copy of the store without locking, so they run in parallel 
+// and never wait for a write; writes are queued to a single writer thread 
+// that applies each group of them to the store, publishes a new copy and 
+// only then answers, so a client always sees its own changes. A stale 
+// socket file left by a server that has stopped is replaced. The listings 
+// file the store was loaded from is watched, and reloaded whenever another 
+// program changes it. 
+// INPUT: Parameters: socketPath - file name of the socket 
+// store - listing store to serve 
+// requests - receives the number of requests answered 
+// error - receives the reason the server could not start 
+// OUTPUT: reference parameters: store, requests, error 
+// Return value: false if the server could not start 
+// CALLS TO: openServerSocket, publishSnapshot, serverWriter, 
+// serveConnection, serverWatcher 
+//*****************************************************************************
+bool runServer(const string& socketPath, listingStore& store, uint64_t& requests, string& error)
+{
+#ifdef _WIN32
+	error = "not supported on this system"; 
+	return false; 
+#else
+	// variables 
+	serverState server; 		// State shared with the server threads 
+	int listener; 				// Listening socket 
+	int client; 				// Socket of a newly accepted client 
+	pollfd waiting; 			// Listening socket to wait on 
+	thread writer; 				// Writer thread 
+	thread watcher; 			// Thread watching the listings file 
+
+	listener = openServerSocket(socketPath, error); 
+
+	if (listener < 0)
+		return false; 
+
+	// A client that hangs up mid-response must not end the server 
+	signal(SIGPIPE, SIG_IGN); 
+
+	server.master = &store; 
+	publishSnapshot(server); 
+
+	if (!store.fingerprint.fileName.empty())
+	{
+		watcher = thread(serverWatcher, &server, store.fingerprint.fileName); 
+		cerr << "Watching " << store.fingerprint.fileName << " for changes" << endl; 
+	}
+
+	writer = thread(serverWriter, &server); 
+
+	cerr << "Serving " << store.liveRows << " listings on " << socketPath << endl; 
+
+	waiting.fd = listener; 
+	waiting.events = POLLIN; 
+
+	while (!server.stopping)
+	{
+		if (poll(&waiting, 1, SERVER_POLL_MS) <= 0)
+			continue; 
+
+		client = accept(listener, NULL, NULL); 
+
+		if (client < 0)
+			continue; 
+
+		{
+			lock_guard<mutex> guard(server.connectionLock); 
+			server.connections++; 
+		}
+
+		try
+		{
+			thread(serveConnection, &server, client).detach(); 
+		}
+		catch (system_error&)
+		{
+			close(client); 
+			lock_guard<mutex> guard(server.connectionLock); 
+			server.connections--; 
+		}
+	}
+
+	close(listener); 
+	unlink(socketPath.c_str()); 
+
+	// Connections notice the shutdown within SERVER_POLL_MS; the writer runs 
+	// until they are gone, so none is left waiting for a write 
+	{
+		unique_lock<mutex> guard(server.connectionLock); 
+
+		while (server.connections > 0)
+			server.connectionClosed.wait(guard); 
+	}
+
+	if (watcher.joinable())
+		watcher.join(); 
+
+	{
+		lock_guard<mutex> guard(server.queueLock); 
+		server.writerStop = true; 
+	}
+
+	server.queueReady.notify_one(); 
+	writer.join(); 
+
+	requests = server.requests; 
+
+	return true; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: openServerSocket
+// DESCRIPTION: Creates a Unix domain socket, binds it to a file name and 
+// listens on it. A socket file no server answers on is removed first; one 
+// a server answers on is left alone and reported. 
+// INPUT: Parameters: socketPath - file name of the socket 
+// error - receives the reason the socket could not be opened 
+// OUTPUT: reference parameter: error 
+// Return value: listening socket, or -1 if it could not be opened 
+//***************************************************************************** 
+int openServerSocket(const string& socketPath, string& error)
+{
+#ifdef _WIN32
+	error = "not supported on this system"; 
+	return -1; 
+#else
+	// variables 
+	sockaddr_un address; 		// Socket file name 
+	int listener; 				// Listening socket 
+	int probe; 					// Socket to check for a running server 
+
+	memset(&address, 0, sizeof(address)); 
+	address.sun_family = AF_UNIX; 
+
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+	{
+		error = "socket path must be 1 to " + to_string(sizeof(address.sun_path) - 1) + " characters"; 
+		return -1; 
+	}
+
+	memcpy(address.sun_path, socketPath.c_str(), socketPath.size()); 
+
+	probe = socket(AF_UNIX, SOCK_STREAM, 0); 
+
+	if (probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+	{
+		close(probe); 
+		error = "a server is already listening on " + socketPath; 
+		return -1; 
+	}
+
+	if (probe >= 0)
+		close(probe); 
+
+	unlink(socketPath.c_str()); 
+
+	listener = socket(AF_UNIX, SOCK_STREAM, 0); 
+
+	if (listener < 0)
+	{
+		error = "socket could not be created"; 
+		return -1; 
+	}
+
+	if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 
+	    || listen(listener, SERVER_BACKLOG) != 0)
+	{
+		close(listener); 
+		error = "socket could not be bound to " + socketPath; 
+		return -1; 
+	}
+
+	return listener; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: serveConnection
+// DESCRIPTION: Reads the request lines of one client and sends each 
+// response, until the client hangs up, sends a line longer than 
+// SERVER_LINE_LIMIT, or the server shuts down. Runs on its own thread and 
+// closes the socket when done. 
+// INPUT: Parameters: server - state shared by the server threads 
+// socket - socket of the client 
+// OUTPUT: Responses to the client. 
+// CALLS TO: handleServerRequest, sendAll 
+//***************************************************************************** 
+void serveConnection(serverState* server, int socket)
+{
+#ifndef _WIN32
+	// variables 
+	vector<char> received; 		// Bytes received at once 
+	string pending; 			// Bytes received but not yet handled 
+	string line; 				// Request line being handled 
+	string response; 			// Response to the request 
+	size_t lineStart; 			// Start of the next request line in pending 
+	size_t lineEnd; 			// End of the request line 
+	ssize_t count; 				// Bytes received 
+	pollfd waiting; 			// Socket to wait on 
+	bool open; 					// Whether the connection is still open 
+
+	received.resize(SERVER_RECEIVE_BYTES); 
+	waiting.fd = socket; 
+	waiting.events = POLLIN; 
+	open = true; 
+
+	while (open && !server->stopping)
+	{
+		if (poll(&waiting, 1, SERVER_POLL_MS) <= 0)
+			continue; 
+
+		count = recv(socket, received.data(), received.size(), 0); 
+
+		if (count <= 0)
+			break; 
+
+		pending.append(received.data(), count); 
+		lineStart = 0; 
+
+		while (open && (lineEnd = pending.find('\n', lineStart)) != string::npos)
+		{
+			line.assign(pending, lineStart, lineEnd - lineStart); 
+			lineStart = lineEnd + 1; 
+
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back(); 
+
+			handleServerRequest(*server, line, response); 
+			open = sendAll(socket, response); 
+		}
+
+		pending.erase(0, lineStart); 
+
+		if (pending.size() > SERVER_LINE_LIMIT)
+		{
+			sendAll(socket, "ERROR request line too long\n"); 
+			open = false; 
+		}
+	}
+
+	close(socket); 
+
+	lock_guard<mutex> guard(server->connectionLock); 
+	server->connections--; 
+	server->connectionClosed.notify_all(); 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: handleServerRequest
+// DESCRIPTION: Answers one request line, "request argument". query, list, 
+// stats and metrics take the same arguments as the batch commands of those 
+// names and are answered from the published copy of the store; query and 
+// list write the listings as listings file lines, and "metrics json" 
+// writes the metrics as JSON rather than Prometheus text. history takes 
+// the query of the batch command of that name. Write requests 
+// are queued for the writer thread and answered once it has published 
+// them. "shutdown" stops the server. Blank lines get no response. 
+// INPUT: Parameters: server - state shared by the server threads 
+// line - the request line 
+// response - receives the result lines and the closing OK or ERROR line 
+// OUTPUT: reference parameters: server, response 
+// CALLS TO: parseQueryText, runQuery, parsePageText, selectListings, 
+// appendListingLines, parseGroupBy, computeMarketStats, 
+// displayMarketStats, formatMetricsJson, formatMetricsPrometheus, 
+// parseHistoryText, displayPriceHistory 
+//***************************************************************************** 
+void handleServerRequest(serverState& server, const string& line, string& response)
+{
+	// variables 
+	string name; 						// Request name 
+	string argument; 					// Rest of the request line 
+	size_t space; 						// Position of the space after the name 
+	shared_ptr<listingStore> snapshot; 	// Copy of the store the request reads 
+	listingQuery query; 				// Conditions of a query 
+	listingPage page; 					// Page of a list request 
+	int groupBy; 						// Grouping of a stats request 
+	vector<marketGroup> groups; 		// Market statistics of each group 
+	vector<uint32_t> rows; 				// Rows of the listings to send 
+	ostringstream text; 				// Formatted statistics or metrics 
+	string error; 						// Reason an argument is not understood 
+	serverWrite write; 					// Write request for the writer thread 
+	future<string> written; 			// Response of the writer thread 
+	historyQuery history; 				// Price changes of a history request 
+	size_t shown; 						// Lines of price history sent 
+
+	response.clear(); 
+	space = line.find(' '); 
+	name = line.substr(0, space); 
+	argument = (space == string::npos) ? "" : line.substr(space + 1); 
+
+	if (name.empty())
+		return; 
+
+	server.requests++; 
+
+	if (SERVER_READ_REQUESTS.find(" " + name + " ") != string::npos)
+	{
+		snapshot = atomic_load(&server.published); 
+
+		if (name == "query" && !parseQueryText(argument, query, error))
+			response = "ERROR " + error + "\n"; 
+		else if (name == "query")
+		{
+			runQuery(*snapshot, query, rows); 
+			appendListingLines(response, *snapshot, rows); 
+			response += "OK " + to_string(rows.size()) + " listings\n"; 
+		}
+		else if (name == "list" && !parsePageText(argument, page, error))
+			response = "ERROR " + error + "\n"; 
+		else if (name == "list")
+		{
+			selectListings(*snapshot, page, rows); 
+			appendListingLines(response, *snapshot, rows); 
+			response += "OK " + to_string(rows.size()) + " listings\n"; 
+		}
+		else if (name == "stats" && !parseGroupBy(argument, groupBy))
+			response = "ERROR group must be zip, zip3, status, company or all\n"; 
+		else if (name == "stats")
+		{
+			computeMarketStats(*snapshot, groupBy, groups); 
+			displayMarketStats(text, *snapshot, groupBy, groups); 
+			response = text.str() + "OK " + to_string(groups.size()) + " groups\n"; 
+		}
+		else if (name == "history" && !parseHistoryText(argument, history, error))
+			response = "ERROR " + error + "\n"; 
+		else if (name == "history")
+		{
+			shown = displayPriceHistory(text, *snapshot, history); 
+			response = text.str() + "OK " + to_string(shown) + (history.mls != 0 ? " price changes\n" : " listings\n"); 
+		}
+		else
+		{
+			if (argument == "json")
+				formatMetricsJson(text, *snapshot); 
+			else
+				formatMetricsPrometheus(text, *snapshot); 
+
+			response = text.str() + "OK metrics\n"; 
+		}
+	}
+	else if (SERVER_WRITE_REQUESTS.find(" " + name + " ") != string::npos)
+	{
+		write.request = line; 
+		written = write.response.get_future(); 
+
+		{
+			lock_guard<mutex> guard(server.queueLock); 
+			server.queue.push_back(&write); 
+		}
+
+		server.queueReady.notify_one(); 
+		response = written.get(); 
+	}
+	else if (name == "shutdown")
+	{
+		server.stopping = true; 
+		response = "OK shutting down\n"; 
+	}
+	else
+		response = "ERROR unknown request \"" + name + "\"\n"; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: serverWriter
+// DESCRIPTION: The server's only writer. Takes every write request queued 
+// so far, applies them to the store in order, publishes one new copy of 
+// the store for the whole group if any of them changed it, and then 
+// answers them. A long write holds up only the writes queued behind it; 
+// queries go on reading the previous copy. Returns once told to stop and 
+// the queue is empty. 
+// INPUT: Parameters: server - state shared by the server threads 
+// OUTPUT: Changes the store; answers the queued requests. 
+// CALLS TO: applyServerWrite, publishSnapshot 
+//***************************************************************************** 
+void serverWriter(serverState* server)
+{
+	// variables 
+	deque<serverWrite*> group; 		// Requests being applied together 
+	vector<string> responses; 		// Response to each request of the group 
+	size_t index; 					// Request being applied 
+	bool changed; 					// Whether any request changed the store 
+
+	for (;;)
+	{
+		{
+			unique_lock<mutex> guard(server->queueLock); 
+
+			while (server->queue.empty() && !server->writerStop)
+				server->queueReady.wait(guard); 
+
+			if (server->queue.empty())
+				return; 
+
+			group.swap(server->queue); 
+		}
+
+		responses.resize(group.size()); 
+		changed = false; 
+
+		for (index = 0; index < group.size(); index++)
+			changed = applyServerWrite(*server->master, group[index]->request, responses[index]) || changed; 
+
+		if (changed)
+			publishSnapshot(*server); 
+
+		for (index = 0; index < group.size(); index++)
+			group[index]->response.set_value(responses[index]); 
+
+		group.clear(); 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: applyServerWrite
+// DESCRIPTION: Applies one write request to the store: "add LISTING" adds 
+// a listing written as a listings file line, "remove MLS..." deletes 
+// listings, and "reprice MLS REDUCTION..." applies price reductions. 
+// import, apply, delete, save, snapshot, reload and delta take a file name 
+// and run the batch commands of those names. 
+// INPUT: Parameters: store - the server's store 
+// line - the request line 
+// response - receives the closing OK or ERROR line 
+// OUTPUT: reference parameters: store, response 
+// Return value: whether the store may have changed 
+// CALLS TO: addListingText, parseMlsList, deleteListings, 
+// parseRepriceText, applyPriceChanges, runBatchCommand 
+//***************************************************************************** 
+bool applyServerWrite(listingStore& store, const string& line, string& response)
+{
+	// variables 
+	batchCommand command; 			// Request as a batch command 
+	size_t space; 					// Position of the space after the name 
+	string error; 					// Reason the request failed 
+	vector<uint32_t> mlsNumbers; 	// MLS numbers to delete 
+	int deleted; 					// Listings deleted 
+	int notFound; 					// MLS numbers to delete not on file 
+	vector<priceChange> changes; 	// Price changes to apply 
+	changeSummary changed; 			// Results of applying the changes 
+
+	space = line.find(' '); 
+	command.name = line.substr(0, space); 
+	command.argument = (space == string::npos) ? "" : line.substr(space + 1); 
+
+	if (command.name == "add")
+	{
+		if (!addListingText(store, command.argument, error))
+		{
+			response = "ERROR " + error + "\n"; 
+			return false; 
+		}
+
+		response = "OK listing added\n"; 
+	}
+	else if (command.name == "remove")
+	{
+		parseMlsList(command.argument, mlsNumbers); 
+
+		if (mlsNumbers.empty())
+		{
+			response = "ERROR MLS numbers expected\n"; 
+			return false; 
+		}
+
+		deleteListings(store, mlsNumbers, deleted, notFound); 
+		response = "OK " + to_string(deleted) + " listings deleted, " + to_string(notFound) + " not found\n"; 
+	}
+	else if (command.name == "reprice")
+	{
+		if (!parseRepriceText(command.argument, changes))
+		{
+			response = "ERROR pairs of an MLS number and a reduction expected\n"; 
+			return false; 
+		}
+
+		store.history.source = "server"; 
+		applyPriceChanges(store, changes, changed); 
+		response = "OK " + to_string(changed.listingsChanged) + " listings repriced, " 
+		         + to_string(changed.unmatchedMLS.size()) + " unmatched\n"; 
+	}
+	else if (command.argument.empty())
+	{
+		response = "ERROR file name expected\n"; 
+		return false; 
+	}
+	else if (!runBatchCommand(store, command, error))
+	{
+		response = "ERROR " + error + "\n"; 
+		return true; 
+	}
+	else
+		response = "OK " + error + "\n"; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: publishSnapshot
+// DESCRIPTION: Copies the server's store and makes the copy the one new 
+// queries read. Queries already running keep the copy they started with. 
+// The copy replaced is kept, and once no query is reading it the next copy 
+// is written over it, so its buffers are reused rather than allocated, 
+// touched for the first time and freed on every write group; otherwise a 
+// new copy is made. The copy's price index is put in order first, so 
+// queries never need to change it. Only what queries read is copied: the 
+// MLS and company name hash tables, the places of rows in the secondary 
+// index lists, the free list, journal, file fingerprint, change bitmaps 
+// and shard layout are set aside while the store is copied, since only 
+// the writer's store is changed, written, reloaded or exported. The copy 
+// is still a full copy of the columns and query indexes, taken once per 
+// write group. If there is not enough memory for the copy, queries go on 
+// reading the previous one. 
+// INPUT: Parameters: server - state shared by the server threads 
+// OUTPUT: reference parameter: server 
+// CALLS TO: priceIndexSortDelta, swapWriterMembers 
+//***************************************************************************** 
+void publishSnapshot(serverState& server)
+{
+	// variables 
+	shared_ptr<listingStore> snapshot; 	// New copy of the store 
+	listingStore aside; 				// Members only the writer uses, while the store is copied 
+
+	priceIndexSortDelta(*server.master); 
+	swapWriterMembers(*server.master, aside); 
+
+	// No query can start on the retired copy, so one holder means no query is reading it 
+	if (server.retired.use_count() == 1)
+	{
+		atomic_thread_fence(memory_order_acquire); 
+		snapshot.swap(server.retired); 
+	}
+
+	server.retired.reset(); 
+
+	try
+	{
+		if (snapshot)
+			*snapshot = *server.master; 
+		else
+			snapshot = make_shared<listingStore>(*server.master); 
+	}
+	catch (bad_alloc&)
+	{
+		snapshot.reset(); 
+		cerr << "Not enough memory to publish the changes to readers." << endl; 
+	}
+
+	swapWriterMembers(*server.master, aside); 
+
+	if (snapshot)
+		server.retired = atomic_exchange(&server.published, snapshot); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: swapWriterMembers
+// DESCRIPTION: Swaps the members of a store that only the server's writer 
+// uses with those of another store, so that they can be set aside while 
+// the store is copied for readers and put back after. Queries never look 
+// up a row by MLS number or company name, or remove a row from an index. 
+// INPUT: Parameters: store - store to swap the members of 
+// aside - store holding the members set aside 
+// OUTPUT: reference parameters: store, aside 
+//***************************************************************************** 
+void swapWriterMembers(listingStore& store, listingStore& aside)
+{
+	swap(store.indexSlots, aside.indexSlots); 
+	swap(store.companySlots, aside.companySlots); 
+	swap(store.zipPosition, aside.zipPosition); 
+	swap(store.companyPosition, aside.companyPosition); 
+	swap(store.freeRows, aside.freeRows); 
+	swap(store.journal, aside.journal); 
+	swap(store.fingerprint, aside.fingerprint); 
+	swap(store.delta, aside.delta); 
+	swap(store.shards, aside.shards); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: sendAll
+// DESCRIPTION: Sends all of a response to a client, however many calls it 
+// takes. 
+// INPUT: Parameters: socket - socket of the client 
+// data - the response 
+// OUTPUT: Sends to the client. 
+// Return value: false if the client has hung up 
+//***************************************************************************** 
+bool sendAll(int socket, const string& data)
+{
+#ifdef _WIN32
+	return false; 
+#else
+	// variables 
+	size_t sent; 				// Bytes sent so far 
+	ssize_t count; 				// Bytes sent by one call 
+
+	for (sent = 0; sent < data.size(); sent += count)
+	{
+		count = send(socket, data.data() + sent, data.size() - sent, 0); 
+
+		if (count <= 0)
+			return false; 
+	}
+
+	return true; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: reloadListingsFile
+// DESCRIPTION: Brings the store up to date with a new version of the 
+// listings file it was loaded from, without loading the file again. The 
+// new file is split into chunks as the old one was when it was loaded, and 
+// only the chunks whose checksums the old file did not have are parsed. 
+// Their lines are listings added or changed; the MLS numbers of old chunks 
+// that are gone, and not found again, are listings removed. If the old 
+// chunks are not known, as after a load from a snapshot, every line is 
+// parsed. A line repeating an MLS number of an unchanged chunk is skipped 
+// as a duplicate. A changed listing is updated in place by storeReprice or 
+// storeUpdate, so it keeps its row and its place in file order. 
+// When the store is journaled against the file, a listing with a record in 
+// the journal, one added, deleted or changed since the last save, keeps 
+// that change whatever the new file holds for it, and every other listing 
+// ends up as the new file has it, whichever chunks were parsed. The 
+// journal is then restarted against the new file with a record for each 
+// listing kept, so the changes not yet saved stay recoverable. Without a 
+// journal the changes since the last save are not known, so every line is 
+// parsed and the store is made to match the file. Reloading the file 
+// changes are tracked against does not add the file's own changes to 
+// those exported. 
+// INPUT: Parameters: fileName - name of the new version of the listings file 
+// store - listing store loaded from the old version 
+// summary - receives the counts of listings added, removed and changed 
+// OUTPUT: reference parameters: store, summary 
+// Return value: false if the file could not be read 
+// CALLS TO: fileIdentity, mapFile, unmapFile, chunkListings, 
+// parseListingLine, reportLoadError, packZip, indexFind, storeAppend, 
+// storeRemove, storeReprice, storeUpdate, journalReset, journalRecord, 
+// journalAppend, journalCommit 
+//***************************************************************************** 
+bool reloadListingsFile(const string& fileName, listingStore& store, reloadSummary& summary)
+{
+	// variables 
+	operationTimer timer(OPERATION_RELOAD, true); 	// Adds the reload to the metrics 
+	fileFingerprint &previous = store.fingerprint; 	// Chunks of the file as it was loaded 
+	fileFingerprint fingerprint; 	// Chunks of the file as it is now 
+	bool incremental; 			// Whether the old chunks are known 
+	mappedFile input; 			// Mapped bytes of the file 
+	vector<size_t> offsets; 		// Offset of each chunk of the file, then its size 
+	vector<int> firstLines; 		// Line number of the first line of each chunk 
+	vector<pair<uint64_t, uint32_t> > oldChunks; 	// Checksum and number of each old chunk, in checksum order 
+	vector<pair<uint64_t, uint32_t> >::iterator found; 	// Old chunk with a new chunk's checksum 
+	vector<bool> oldMatched; 		// Whether each old chunk is still in the file 
+	vector<bool> changed; 		// Whether each new chunk must be parsed 
+	vector<uint64_t> kept; 		// Bitmap of the MLS numbers of unchanged chunks 
+	vector<uint64_t> seen; 		// Bitmap of the MLS numbers of the lines parsed 
+	vector<uint64_t> unsaved; 	// Bitmap of the MLS numbers changed since the last save 
+	vector<uint32_t> candidates; 	// MLS numbers that may have been removed 
+	size_t chunk; 				// Chunk being compared or parsed 
+	size_t index; 				// MLS number of a chunk being marked 
+	const char *position; 		// Start of the line being parsed 
+	const char *end; 			// End of the chunk being parsed 
+	const char *lineEnd; 		// End of the line being parsed 
+	int lineNumber; 			// Line number of the line being parsed 
+	parsedListing record; 		// Fields of the line being parsed 
+	const char *error; 			// Reason a line could not be parsed 
+	uint32_t packedZip; 		// Zip code of the line packed for the store 
+	uint32_t row; 				// Row of the listing with the line's MLS number 
+	uint32_t mls; 				// MLS number being checked 
+	loadSummary parsed; 		// Lines skipped, as counted by reportLoadError 
+	bool reloadingBase; 		// Whether the store is journaled against this file 
+	FILE *journalOutput; 		// Journal file, set aside while reloading 
+
+	summary.listingsAdded = 0; 
+	summary.listingsRemoved = 0; 
+	summary.listingsChanged = 0; 
+	summary.recordsRejected = 0; 
+	summary.chunksParsed = 0; 
+	summary.chunkCount = 0; 
+	summary.memoryFull = false; 
+	summary.unsavedKept = 0; 
+
+	if (!fileIdentity(fileName, fingerprint.size, fingerprint.modified))
+		return false; 
+
+	// A file seen before with the same size and time has not changed 
+	if (previous.fileName == fileName && previous.size == fingerprint.size
+		&& previous.modified == fingerprint.modified)
+	{
+		summary.chunkCount = previous.chunkHashes.size(); 
+		timer.succeeded = true; 
+		return true; 
+	}
+
+	if (!mapFile(fileName, input))
+		return false; 
+
+	// The changes are already in the new file, so they are not journaled 
+	reloadingBase = fileName == store.journal.baseName && store.journal.output != NULL; 
+	journalOutput = store.journal.output; 
+
+	if (reloadingBase)
+	{
+		unsaved = store.journal.changed; 
+		store.journal.output = NULL; 
+	}
+
+	chunkListings(input.data, input.size, fingerprint, offsets, firstLines); 
+	incremental = previous.fileName == fileName && !previous.chunkStart.empty() && reloadingBase; 
+
+	summary.chunkCount = fingerprint.chunkHashes.size(); 
+	changed.assign(fingerprint.chunkHashes.size(), true); 
+	kept.assign(MLS_MAX / 64 + 1, 0); 
+	seen.assign(MLS_MAX / 64 + 1, 0); 
+
+	// Each new chunk is matched to an old chunk with the same checksum 
+	if (incremental)
+	{
+		for (chunk = 0; chunk < previous.chunkHashes.size(); chunk++)
+			oldChunks.push_back(make_pair(previous.chunkHashes[chunk], static_cast<uint32_t>(chunk))); 
+
+		sort(oldChunks.begin(), oldChunks.end()); 
+		oldMatched.assign(oldChunks.size(), false); 
+
+		for (chunk = 0; chunk < fingerprint.chunkHashes.size(); chunk++)
+		{
+			found = lower_bound(oldChunks.begin(), oldChunks.end(), make_pair(fingerprint.chunkHashes[chunk], 0u)); 
+
+			while (found != oldChunks.end() && found->first == fingerprint.chunkHashes[chunk]
+				   && oldMatched[found->second])
+				found++; 
+
+			if (found != oldChunks.end() && found->first == fingerprint.chunkHashes[chunk])
+			{
+				oldMatched[found->second] = true; 
+				changed[chunk] = false; 
+
+				for (index = fingerprint.chunkStart[chunk]; index < fingerprint.chunkStart[chunk + 1]; index++)
+					kept[fingerprint.chunkMls[index] / 64] |= 1ull << (fingerprint.chunkMls[index] % 64); 
+			}
+		}
+
+		for (chunk = 0; chunk < previous.chunkHashes.size(); chunk++)
+			if (!oldMatched[chunk])
+				candidates.insert(candidates.end(), previous.chunkMls.begin() + previous.chunkStart[chunk],
+								  previous.chunkMls.begin() + previous.chunkStart[chunk + 1]); 
+	}
+	else
+	{
+		for (row = 0; row < store.mls.size(); row++)
+			if (store.status[row] != STATUS_DELETED)
+				candidates.push_back(store.mls[row]); 
+	}
+
+	parsed.recordsRejected = 0; 
+	store.history.source = fileName; 
+	store.delta.paused = (fileName == store.delta.fileName); 
+
+	for (chunk = 0; chunk < changed.size(); chunk++)
+	{
+		if (!changed[chunk])
+			continue; 
+
+		summary.chunksParsed++; 
+		position = input.data + offsets[chunk]; 
+		end = input.data + offsets[chunk + 1]; 
+		lineNumber = firstLines[chunk]; 
+
+		while (position < end)
+		{
+			lineEnd = static_cast<const char*>(memchr(position, '\n', end - position)); 
+
+			if (lineEnd == NULL)
+				lineEnd = end; 
+
+			timer.recordsParsed++; 
+
+			if (!parseListingLine(string_view(position, lineEnd - position), record, error))
+				reportLoadError(parsed, lineNumber, error); 
+			else if (record.numberMLS == 0)
+				timer.recordsParsed--; 
+			else if (!packZip(record.zipCode, packedZip))
+				reportLoadError(parsed, lineNumber, "invalid zip code"); 
+			else if ((kept[record.numberMLS / 64] | seen[record.numberMLS / 64]) & (1ull << (record.numberMLS % 64)))
+				reportLoadError(parsed, lineNumber, "duplicate MLS number"); 
+			else
+			{
+				seen[record.numberMLS / 64] |= 1ull << (record.numberMLS % 64); 
+				row = indexFind(store, record.numberMLS); 
+
+				// A listing changed since the last save keeps the change over its line 
+				if (!unsaved.empty() && (unsaved[record.numberMLS / 64] & (1ull << (record.numberMLS % 64))))
+				{
+					if (row == NO_ROW || store.price[row] != record.price || store.status[row] != record.status
+						|| store.zip[row] != packedZip || store.companyNames[store.company[row]] != record.realtyCompany)
+						summary.unsavedKept++; 
+				}
+				else if (row == NO_ROW)
+				{
+					if (storeAppend(store, record.numberMLS, record.price, record.status,
+									packedZip, record.realtyCompany) == NO_ROW)
+						summary.memoryFull = true; 
+					else
+						summary.listingsAdded++; 
+				}
+				else if (store.status[row] == record.status && store.zip[row] == packedZip
+						 && store.companyNames[store.company[row]] == record.realtyCompany)
+				{
+					if (store.price[row] == record.price)
+						; 
+					else if (storeReprice(store, row, record.price))
+						summary.listingsChanged++; 
+					else
+						summary.memoryFull = true; 
+				}
+				else if (storeUpdate(store, row, record.price, record.status, packedZip, record.realtyCompany))
+					summary.listingsChanged++; 
+				else
+				{
+					summary.memoryFull = true; 
+					summary.listingsRemoved++; 
+				}
+			}
+
+			position = lineEnd + 1; 
+			lineNumber++; 
+		}
+	}
+
+	for (index = 0; index < candidates.size(); index++)
+	{
+		mls = candidates[index]; 
+
+		if ((kept[mls / 64] | seen[mls / 64]) & (1ull << (mls % 64)))
+			continue; 
+
+		row = indexFind(store, mls); 
+
+		if (row == NO_ROW)
+			continue; 
+
+		if (!unsaved.empty() && (unsaved[mls / 64] & (1ull << (mls % 64))))
+			summary.unsavedKept++; 
+		else
+		{
+			storeRemove(store, row); 
+			summary.listingsRemoved++; 
+		}
+	}
+
+	timer.bytesRead = input.size; 
+	unmapFile(input); 
+
+	// Lines that could not be added are compared again by the next reload 
+	if (summary.memoryFull)
+		fingerprint.chunkStart.clear(); 
+
+	fingerprint.fileName = fileName; 
+	store.fingerprint = fingerprint; 
+	store.delta.paused = false; 
+
+	// Each listing changed since the last save is journaled again as it is now 
+	if (reloadingBase)
+	{
+		store.journal.output = journalOutput; 
+		journalReset(store); 
+
+		for (index = 0; index < unsaved.size(); index++)
+			for (mls = index * 64; unsaved[index] != 0; mls++, unsaved[index] >>= 1)
+				if (unsaved[index] & 1)
+				{
+					row = indexFind(store, mls); 
+
+					if (row != NO_ROW)
+						journalRecord(store, JOURNAL_CHANGE, row); 
+					else
+						journalAppend(store, JOURNAL_DELETE, mls, 0, 0, 0, string_view()); 
+				}
+	}
+
+	journalCommit(store); 
+
+	summary.recordsRejected = parsed.recordsRejected; 
+	timer.recordsRejected = parsed.recordsRejected; 
+	timer.succeeded = true; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: fingerprintListingsFile
+// DESCRIPTION: Checksums the chunks of lines of a listings file and notes 
+// its size and time, for a later reload of the file to compare against. 
+// If the file cannot be read its chunks are left unknown. 
+// INPUT: Parameters: fileName - name of the listings file 
+// fingerprint - receives the checksums of the file 
+// OUTPUT: reference parameter: fingerprint 
+// Return value: false if the file could not be read 
+// CALLS TO: fileIdentity, mapFile, unmapFile, chunkListings 
+//***************************************************************************** 
+bool fingerprintListingsFile(const string& fileName, fileFingerprint& fingerprint)
+{
+	// variables 
+	mappedFile input; 			// Mapped bytes of the file 
+	vector<size_t> offsets; 		// Offset of each chunk, not needed here 
+	vector<int> firstLines; 		// First line of each chunk, not needed here 
+
+	fingerprint = fileFingerprint(); 
+	fingerprint.fileName = fileName; 
+	fileIdentity(fileName, fingerprint.size, fingerprint.modified); 
+
+	if (!mapFile(fileName, input))
+		return false; 
+
+	chunkListings(input.data, input.size, fingerprint, offsets, firstLines); 
+	unmapFile(input); 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: chunkListings
+// DESCRIPTION: Splits the text of a listings file into chunks of whole 
+// lines and checksums each chunk. A chunk ends after a line whose own 
+// checksum has its low bits clear, or after RELOAD_CHUNK_MAX_LINES lines, 
+// so where chunks end depends on the lines themselves: a changed line 
+// changes only the chunk holding it, and lines added or removed do not 
+// shift the chunks after them. The MLS number at the start of each line 
+// is kept for each chunk. 
+// INPUT: Parameters: data - text of the file 
+// size - bytes of text 
+// fingerprint - receives the checksums and MLS numbers of the chunks 
+// offsets - receives the offset of each chunk, followed by the size 
+// firstLines - receives the line number of the first line of each chunk 
+// OUTPUT: reference parameters: fingerprint, offsets, firstLines 
+// CALLS TO: snapshotChecksum 
+//***************************************************************************** 
+void chunkListings(const char* data, size_t size, fileFingerprint& fingerprint, vector<size_t>& offsets,
+				   vector<int>& firstLines)
+{
+	// variables 
+	const char *position; 		// Start of the line being checksummed 
+	const char *end; 			// End of the text 
+	const char *lineEnd; 		// End of the line being checksummed 
+	const char *number; 		// Start of the line's MLS number 
+	uint64_t lineHash; 			// Checksum of the line 
+	uint64_t chunkHash; 		// Checksum of the chunk so far 
+	int lines; 				// Lines in the chunk so far 
+	int lineNumber; 			// Line number of the line being checksummed 
+	int mls; 					// MLS number at the start of the line 
+	from_chars_result result; 	// Result of reading the MLS number 
+
+	fingerprint.chunkHashes.clear(); 
+	fingerprint.chunkStart.assign(1, 0); 
+	fingerprint.chunkMls.clear(); 
+	offsets.assign(1, 0); 
+	firstLines.assign(1, 1); 
+
+	position = data; 
+	end = data + size; 
+	chunkHash = CHECKSUM_SEED; 
+	lines = 0; 
+	lineNumber = 0; 
+
+	while (position < end)
+	{
+		lineEnd = static_cast<const char*>(memchr(position, '\n', end - position)); 
+
+		if (lineEnd == NULL)
+			lineEnd = end; 
+
+		lineHash = snapshotChecksum(CHECKSUM_SEED, position, lineEnd - position); 
+		chunkHash = snapshotChecksum(chunkHash, reinterpret_cast<const char*>(&lineHash), sizeof(lineHash)); 
+
+		number = position; 
+
+		while (number < lineEnd && isspace(static_cast<unsigned char>(*number)))
+			number++; 
+
+		result = from_chars(number, lineEnd, mls); 
+
+		if (result.ec == errc() && mls >= MLS_MIN && mls <= MLS_MAX)
+			fingerprint.chunkMls.push_back(mls); 
+
+		lines++; 
+		lineNumber++; 
+		position = (lineEnd == end) ? end : lineEnd + 1; 
+
+		if ((lineHash & RELOAD_CHUNK_MASK) == 0 || lines == RELOAD_CHUNK_MAX_LINES || position == end)
+		{
+			fingerprint.chunkHashes.push_back(chunkHash); 
+			fingerprint.chunkStart.push_back(fingerprint.chunkMls.size()); 
+			offsets.push_back(position - data); 
+			firstLines.push_back(lineNumber + 1); 
+			chunkHash = CHECKSUM_SEED; 
+			lines = 0; 
+		}
+	}
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: watchOpen
+// DESCRIPTION: Starts watching a listings file for changes. On Linux an 
+// inotify watch on the file's directory reports files there being written 
+// or renamed into place, which catches the file being rewritten as well as 
+// replaced by a new one. Elsewhere, or if inotify cannot be used, the 
+// file's size and time are checked each time watchChanged is called. 
+// INPUT: Parameters: fileName - file to watch 
+// watch - receives the watch 
+// OUTPUT: reference parameter: watch 
+// CALLS TO: fileIdentity 
+//***************************************************************************** 
+void watchOpen(const string& fileName, fileWatch& watch)
+{
+	// variables 
+	size_t slash; 				// Position of the last '/' of the file name 
+
+	slash = fileName.rfind('/'); 
+	watch.fileName = fileName; 
+	watch.baseName = (slash == string::npos) ? fileName : fileName.substr(slash + 1); 
+	watch.descriptor = -1; 
+	fileIdentity(fileName, watch.size, watch.modified); 
+
+#ifdef __linux__
+	string directory; 			// Directory holding the file 
+
+	directory = (slash == string::npos) ? "." : fileName.substr(0, max<size_t>(slash, 1)); 
+	watch.descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); 
+
+	if (watch.descriptor >= 0
+		&& inotify_add_watch(watch.descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(watch.descriptor); 
+		watch.descriptor = -1; 
+	}
+#endif
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: watchChanged
+// DESCRIPTION: Waits up to a given time for a watched file to change. A 
+// file is often written in several steps, so once it changes this waits 
+// until it has been left alone for WATCH_SETTLE_MS. Only a change in the 
+// file's size or time counts, so a file closed without being changed is 
+// not reported. 
+// INPUT: Parameters: watch - the watch 
+// timeoutMs - longest time to wait, in milliseconds; 0 to only check 
+// OUTPUT: reference parameter: watch 
+// Return value: whether the file has changed since it was last checked 
+// CALLS TO: watchEvents, fileIdentity 
+//***************************************************************************** 
+bool watchChanged(fileWatch& watch, int timeoutMs)
+{
+	// variables 
+	uint64_t size; 				// Size of the file now 
+	int64_t modified; 			// Time the file was last changed now 
+
+	if (watch.descriptor >= 0)
+	{
+		if (!watchEvents(watch, timeoutMs))
+			return false; 
+
+		while (watchEvents(watch, WATCH_SETTLE_MS))
+			; 
+	}
+	else if (timeoutMs > 0)
+		this_thread::sleep_for(chrono::milliseconds(timeoutMs)); 
+
+	fileIdentity(watch.fileName, size, modified); 
+
+	if (size == watch.size && modified == watch.modified)
+		return false; 
+
+	watch.size = size; 
+	watch.modified = modified; 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: watchEvents
+// DESCRIPTION: Waits up to a given time for inotify events and reads every 
+// event reported so far. Events for other files of the directory are 
+// ignored. 
+// INPUT: Parameters: watch - the watch 
+// timeoutMs - longest time to wait, in milliseconds 
+// OUTPUT: Return value: whether an event was for the watched file 
+//***************************************************************************** 
+bool watchEvents(fileWatch& watch, int timeoutMs)
+{
+#ifdef __linux__
+	// variables 
+	pollfd waiting; 			// inotify instance to wait on 
+	alignas(inotify_event) char buffer[WATCH_EVENT_BYTES]; 	// Events read at once 
+	ssize_t length; 			// Bytes of events read 
+	ssize_t offset; 			// Offset of the event being checked 
+	const inotify_event *event; 	// Event being checked 
+	bool found; 				// Whether an event was for the watched file 
+
+	waiting.fd = watch.descriptor; 
+	waiting.events = POLLIN; 
+	found = false; 
+
+	if (poll(&waiting, 1, timeoutMs) <= 0)
+		return false; 
+
+	while ((length = read(watch.descriptor, buffer, sizeof(buffer))) > 0)
+		for (offset = 0; offset < length; offset += sizeof(inotify_event) + event->len)
+		{
+			event = reinterpret_cast<const inotify_event*>(buffer + offset); 
+
+			if (event->len > 0 && watch.baseName == event->name)
+				found = true; 
+		}
+
+	return found; 
+#else
+	return false; 
+#endif
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: watchClose
+// DESCRIPTION: Stops watching a file. 
+// INPUT: Parameters: watch - the watch 
+// OUTPUT: reference parameter: watch 
+//***************************************************************************** 
+void watchClose(fileWatch& watch)
+{
+#ifndef _WIN32
+	if (watch.descriptor >= 0)
+		close(watch.descriptor); 
+#endif
+
+	watch.descriptor = -1; 
+	watch.fileName.clear(); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: serverWatcher
+// DESCRIPTION: Watches the listings file the server's store was loaded 
+// from. Each time another program changes it, a reload of the file is 
+// queued for the writer thread as a client's write request would be, so 
+// queries see the new listings once they are published. Returns once the 
+// server is stopping. 
+// INPUT: Parameters: server - state shared by the server threads 
+// fileName - listings file to watch 
+// OUTPUT: Queues reload requests; reports their results to standard error. 
+// CALLS TO: watchOpen, watchChanged, watchClose 
+//***************************************************************************** 
+void serverWatcher(serverState* server, string fileName)
+{
+	// variables 
+	fileWatch watch; 			// Watch on the listings file 
+	serverWrite write; 			// Reload request for the writer thread 
+	future<string> written; 		// Response of the writer thread 
+
+	watchOpen(fileName, watch); 
+
+	while (!server->stopping)
+	{
+		if (!watchChanged(watch, SERVER_POLL_MS))
+			continue; 
+
+		write.request = "reload " + fileName; 
+		write.response = promise<string>(); 
+		written = write.response.get_future(); 
+
+		{
+			lock_guard<mutex> guard(server->queueLock); 
+			server->queue.push_back(&write); 
+		}
+
+		server->queueReady.notify_one(); 
+		cerr << fileName << " changed on disk: " << written.get(); 
+	}
+
+	watchClose(watch); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: ReloadListings
+// DESCRIPTION: Reloads the listings file after another program has changed 
+// it, applying only the listings added, removed or changed, and tells the 
+// user what changed. 
+// INPUT: Parameters: store - listing store loaded from the file 
+// OUTPUT: reference parameter: store; outputs the changes to screen 
+// CALLS TO: reloadListingsFile 
+//***************************************************************************** 
+void ReloadListings(listingStore& store)
+{
+	// variables 
+	reloadSummary summary; 		// Results of the reload 
+	string fileName; 			// Listings file reloaded 
+
+	fileName = store.fingerprint.fileName; 
+
+	if (!reloadListingsFile(fileName, store, summary))
+	{
+		cout << "Warning: " << fileName << " was changed on disk but could not be read." << endl << endl; 
+		return; 
+	}
+
+	if (summary.listingsAdded + summary.listingsRemoved + summary.listingsChanged + summary.recordsRejected
+		+ summary.unsavedKept == 0)
+		return; 
+
+	cout << fileName << " was changed on disk and has been reloaded: " << summary.listingsAdded
+		 << " listing(s) added, " << summary.listingsRemoved << " removed, "
+		 << summary.listingsChanged << " changed." << endl << endl; 
+
+	if (summary.recordsRejected > 0)
+		cout << summary.recordsRejected << " record(s) were skipped." << endl << endl; 
+
+	if (summary.memoryFull)
+		cout << "Memory is full. Some listings could not be added." << endl << endl; 
+
+	if (summary.unsavedKept > 0)
+		cout << summary.unsavedKept << " listing(s) changed since the last save kept those changes"
+			 << " over the file's." << endl << endl; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: historyReserve
+// DESCRIPTION: Makes room to record one more price change, and a new block 
+// for it, from the history's current source, so that historyRecord cannot 
+// run out of memory. The buffers grow by doubling. 
+// INPUT: Parameters: history - price history to make room in 
+// OUTPUT: reference parameter: history; throws bad_alloc if memory is full 
+//***************************************************************************** 
+void historyReserve(priceHistory& history)
+{
+	// variables 
+	uint32_t id; 				// Place of a source name in sources 
+
+	if (history.encoded.capacity() < history.encoded.size() + HISTORY_CHANGE_MAX_BYTES)
+		history.encoded.reserve(max(history.encoded.capacity() * 2, HISTORY_MIN_BYTES)); 
+
+	if (history.blocks.size() == history.blocks.capacity())
+		history.blocks.reserve(max(history.blocks.capacity() * 2, HISTORY_MIN_BLOCKS)); 
+
+	if (history.sourceId < history.sources.size() && history.sources[history.sourceId] == history.source)
+		return; 
+
+	for (id = 0; id < history.sources.size() && history.sources[id] != history.source; id++)
+		; 
+
+	if (id == history.sources.size())
+		history.sources.push_back(history.source); 
+
+	history.sourceId = id; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: historyRecord
+// DESCRIPTION: Records a change of asking price. Changes are grouped into 
+// blocks, each holding the changes from one source within one second, and 
+// a block no longer grows once it is saved. Within a block each change is 
+// packed as three varints: the difference from the MLS number of the 
+// change before it, the old price and the difference between the new price 
+// and the old, the last two zigzag-encoded so small reductions take one or 
+// two bytes. A change of a batch sorted by MLS number takes seven bytes or 
+// so. historyReserve must be called first. 
+// INPUT: Parameters: history - price history to record the change in 
+// mls - MLS number of the listing 
+// oldPrice - asking price before the change, in cents 
+// newPrice - asking price after the change, in cents 
+// OUTPUT: reference parameter: history 
+// CALLS TO: appendVarint 
+//***************************************************************************** 
+void historyRecord(priceHistory& history, uint32_t mls, int64_t oldPrice, int64_t newPrice)
+{
+	// variables 
+	historyBlock block; 		// New block for the change 
+	int64_t delta; 				// Difference from the MLS number of the change before 
+
+	if (oldPrice == newPrice)
+		return; 
+
+	block.time = time(NULL); 
+
+	if (history.blocks.size() <= history.savedBlocks || history.blocks.back().time != block.time
+	    || history.blocks.back().source != history.sourceId)
+	{
+		block.source = history.sourceId; 
+		block.changes = 0; 
+		block.offset = history.encoded.size(); 
+		history.blocks.push_back(block); 
+		history.lastMls = 0; 
+	}
+
+	delta = static_cast<int64_t>(mls) - history.lastMls; 
+	appendVarint(history.encoded, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)); 
+	appendVarint(history.encoded, (static_cast<uint64_t>(oldPrice) << 1) ^ static_cast<uint64_t>(oldPrice >> 63)); 
+	delta = newPrice - oldPrice; 
+	appendVarint(history.encoded, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)); 
+
+	history.blocks.back().changes++; 
+	history.lastMls = mls; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: appendVarint
+// DESCRIPTION: Appends a number packed seven bits to a byte, lowest bits 
+// first, with the top bit of each byte set while more bytes follow. 
+// INPUT: Parameters: bytes - bytes to append to 
+// value - number to append 
+// OUTPUT: reference parameter: bytes 
+//***************************************************************************** 
+void appendVarint(vector<uint8_t>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back(static_cast<uint8_t>(value) | 0x80); 
+		value >>= 7; 
+	}
+
+	bytes.push_back(static_cast<uint8_t>(value)); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: readVarint
+// DESCRIPTION: Reads a number packed by appendVarint. 
+// INPUT: Parameters: position - first byte of the number; moved past it 
+// end - end of the bytes that may be read 
+// value - receives the number 
+// OUTPUT: reference parameters: position, value 
+// Return value: false if the bytes end within the number or it is too long 
+//***************************************************************************** 
+bool readVarint(const uint8_t*& position, const uint8_t* end, uint64_t& value)
+{
+	// variables 
+	int shift; 				// Place of the next seven bits 
+
+	value = 0; 
+
+	for (shift = 0; position < end && shift < 64; shift += 7)
+	{
+		value |= static_cast<uint64_t>(*position & 0x7f) << shift; 
+
+		if ((*position++ & 0x80) == 0)
+			return true; 
+	}
+
+	return false; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: readHistoryChange
+// DESCRIPTION: Reads one price change packed by historyRecord. 
+// INPUT: Parameters: position - first byte of the change; moved past it 
+// end - end of the block's changes 
+// mls - MLS number of the change before, or 0 for a block's first change; 
+// receives the change's MLS number 
+// oldPrice, newPrice - receive the prices before and after the change 
+// OUTPUT: reference parameters: position, mls, oldPrice, newPrice 
+// Return value: false if the change is cut short 
+// CALLS TO: readVarint 
+//***************************************************************************** 
+bool readHistoryChange(const uint8_t*& position, const uint8_t* end, uint32_t& mls, int64_t& oldPrice,
+                       int64_t& newPrice)
+{
+	// variables 
+	uint64_t value; 			// Zigzag-encoded number read 
+
+	if (!readVarint(position, end, value))
+		return false; 
+
+	mls += static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); 
+
+	if (!readVarint(position, end, value))
+		return false; 
+
+	oldPrice = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); 
+
+	if (!readVarint(position, end, value))
+		return false; 
+
+	newPrice = oldPrice + (static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1)); 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: encodeHistoryBlock
+// DESCRIPTION: Appends a block of price changes as it is kept in a history 
+// file: as varints, its time (zigzag-encoded), the length of its source's 
+// name and the name, its number of changes and their length in bytes; 
+// then the packed changes, and a 4-byte checksum of all of it. 
+// INPUT: Parameters: history - price history holding the block 
+// block - place of the block in history.blocks 
+// bytes - bytes to append to 
+// OUTPUT: reference parameter: bytes 
+// CALLS TO: appendVarint, companyHash 
+//***************************************************************************** 
+void encodeHistoryBlock(const priceHistory& history, size_t block, vector<uint8_t>& bytes)
+{
+	// variables 
+	size_t start; 				// Offset of the block in bytes 
+	size_t end; 				// Offset in history.encoded of the end of the block's changes 
+	const historyBlock &entry = history.blocks[block]; 	// Block being packed 
+	const string &source = history.sources[entry.source]; 	// Name of the block's source 
+	uint32_t checksum; 			// Checksum of the packed block 
+
+	start = bytes.size(); 
+	end = (block + 1 < history.blocks.size()) ? history.blocks[block + 1].offset : history.encoded.size(); 
+
+	appendVarint(bytes, (static_cast<uint64_t>(entry.time) << 1) ^ static_cast<uint64_t>(entry.time >> 63)); 
+	appendVarint(bytes, source.size()); 
+	bytes.insert(bytes.end(), source.begin(), source.end()); 
+	appendVarint(bytes, entry.changes); 
+	appendVarint(bytes, end - entry.offset); 
+	bytes.insert(bytes.end(), history.encoded.begin() + entry.offset, history.encoded.begin() + end); 
+
+	checksum = companyHash(string_view(reinterpret_cast<const char*>(bytes.data()) + start, bytes.size() - start)); 
+	bytes.insert(bytes.end(), reinterpret_cast<uint8_t*>(&checksum), reinterpret_cast<uint8_t*>(&checksum) + sizeof(checksum)); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: saveHistoryFile
+// DESCRIPTION: Saves the price history beside a listings file, in the file 
+// named by adding HISTORY_EXTENSION. The file is a header followed by the 
+// blocks of changes. If it is the file the history was read from and is 
+// as the history left it, only the blocks made since are appended to it; 
+// otherwise the whole history is written to a temporary file that is 
+// renamed over it. Nothing is written while there is no history. 
+// INPUT: Parameters: fileName - name of the listings file saved 
+// store - listing store holding the history 
+// OUTPUT: reference parameter: store 
+// Return value: false if the file could not be written 
+// CALLS TO: fileSize, encodeHistoryBlock, syncFile, replaceFile 
+//***************************************************************************** 
+bool saveHistoryFile(const string& fileName, listingStore& store)
+{
+	// variables 
+	priceHistory &history = store.history; 	// History to save 
+	string historyName; 			// Name of the history file 
+	string tempName; 			// Name of a new history file before the rename 
+	bool appending; 			// Whether only new blocks are written 
+	vector<uint8_t> bytes; 		// Header and blocks to write 
+	historyHeader header; 		// Header of a new history file 
+	size_t block; 				// Block being packed 
+	FILE *output; 				// History file being written 
+	bool written; 				// Whether every write succeeded 
+
+	historyName = fileName + HISTORY_EXTENSION; 
+	appending = history.fileName == historyName && fileSize(historyName) == history.savedBytes; 
+
+	if (history.blocks.empty() || (appending && history.savedBlocks == history.blocks.size()))
+		return true; 
+
+	if (!appending)
+	{
+		memset(&header, 0, sizeof(header)); 
+		memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic)); 
+		header.version = HISTORY_VERSION; 
+		bytes.insert(bytes.end(), reinterpret_cast<uint8_t*>(&header), reinterpret_cast<uint8_t*>(&header) + sizeof(header)); 
+	}
+
+	for (block = appending ? history.savedBlocks : 0; block < history.blocks.size(); block++)
+		encodeHistoryBlock(history, block, bytes); 
+
+	tempName = historyName + TEMP_EXTENSION; 
+	output = fopen(appending ? historyName.c_str() : tempName.c_str(), appending ? "ab" : "wb"); 
+
+	if (output == NULL)
+		return false; 
+
+	written = fwrite(bytes.data(), 1, bytes.size(), output) == bytes.size(); 
+	written = syncFile(output) && written; 
+	written = fclose(output) == 0 && written; 
+
+	if (!written || (!appending && !replaceFile(tempName, historyName)))
+	{
+		if (!appending)
+			remove(tempName.c_str()); 
+
+		return false; 
+	}
+
+	history.savedBytes = (appending ? history.savedBytes : 0) + bytes.size(); 
+	history.savedBlocks = history.blocks.size(); 
+	history.fileName = historyName; 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: loadHistoryFile
+// DESCRIPTION: Reads the price history saved beside a listings file into an 
+// empty history. Reading stops at the first block that is cut short or 
+// fails its checksum, as the last block of a save that was interrupted 
+// would; the next save then writes the file afresh. A listings file with 
+// no history file has an empty history. 
+// INPUT: Parameters: fileName - name of the listings file 
+// history - empty price history to fill 
+// OUTPUT: reference parameter: history 
+// Return value: false if the history file is not a price history file 
+// CALLS TO: mapFile, unmapFile, readVarint, readHistoryChange, companyHash 
+//***************************************************************************** 
+bool loadHistoryFile(const string& fileName, priceHistory& history)
+{
+	// variables 
+	mappedFile input; 			// Mapped bytes of the history file 
+	historyHeader header; 		// Header of the file 
+	const uint8_t *position; 		// Next byte to read 
+	const uint8_t *end; 			// End of the file 
+	const uint8_t *start; 		// First byte of the block being read 
+	const uint8_t *changesEnd; 	// End of the block's changes 
+	const uint8_t *change; 		// Change being checked 
+	uint64_t time; 				// Time of the block, zigzag-encoded 
+	uint64_t length; 			// Length of the source name, then of the changes 
+	uint64_t changes; 			// Changes in the block 
+	uint64_t counted; 			// Changes found in the block 
+	uint32_t checksum; 			// Checksum stored after the block 
+	string source; 				// Name of the block's source 
+	historyBlock block; 		// Block read 
+	uint32_t mls; 				// MLS number of a change 
+	int64_t oldPrice; 			// Price before a change 
+	int64_t newPrice; 			// Price after a change 
+
+	history = priceHistory(); 
+
+	if (!mapFile(fileName + HISTORY_EXTENSION, input))
+		return true; 
+
+	memcpy(&header, input.data, min(input.size, sizeof(header))); 
+
+	if (input.size < sizeof(header) || memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) != 0
+	    || header.version != HISTORY_VERSION)
+	{
+		unmapFile(input); 
+		return false; 
+	}
+
+	position = reinterpret_cast<const uint8_t*>(input.data) + sizeof(header); 
+	end = reinterpret_cast<const uint8_t*>(input.data) + input.size; 
+
+	for (;;)
+	{
+		start = position; 
+
+		if (!readVarint(position, end, time) || !readVarint(position, end, length)
+		    || static_cast<uint64_t>(end - position) < length)
+			break; 
+
+		source.assign(reinterpret_cast<const char*>(position), length); 
+		position += length; 
+
+		if (!readVarint(position, end, changes) || !readVarint(position, end, length)
+		    || static_cast<uint64_t>(end - position) < length + sizeof(checksum))
+			break; 
+
+		changesEnd = position + length; 
+		memcpy(&checksum, changesEnd, sizeof(checksum)); 
+
+		if (checksum != companyHash(string_view(reinterpret_cast<const char*>(start), changesEnd - start)))
+			break; 
+
+		// Every change must unpack, so later queries can trust the block 
+		mls = 0; 
+		counted = 0; 
+
+		for (change = position; change < changesEnd && readHistoryChange(change, changesEnd, mls, oldPrice, newPrice); )
+			counted++; 
+
+		if (change != changesEnd || counted != changes)
+			break; 
+
+		history.source = source; 
+		historyReserve(history); 
+
+		block.time = static_cast<int64_t>(time >> 1) ^ -static_cast<int64_t>(time & 1); 
+		block.source = history.sourceId; 
+		block.changes = changes; 
+		block.offset = history.encoded.size(); 
+		history.blocks.push_back(block); 
+		history.encoded.insert(history.encoded.end(), position, changesEnd); 
+
+		position = changesEnd + sizeof(checksum); 
+	}
+
+	history.source.clear(); 
+	history.fileName = fileName + HISTORY_EXTENSION; 
+	history.savedBlocks = history.blocks.size(); 
+	history.savedBytes = start - reinterpret_cast<const uint8_t*>(input.data); 
+
+	unmapFile(input); 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: parseHistoryText
+// DESCRIPTION: Reads a price history query, either "mls=N" for every price 
+// change of one listing, or "reductions=N days=D" for the listings whose 
+// price was cut at least N times in the last D days (30 unless given). 
+// INPUT: Parameters: text - query text 
+// query - receives the query 
+// error - receives the reason the text is not a valid query 
+// OUTPUT: reference parameters: query, error 
+// Return value: false if the text is not a valid query 
+//***************************************************************************** 
+bool parseHistoryText(const string& text, historyQuery& query, string& error)
+{
+	// variables 
+	istringstream words; 		// To split the text into words 
+	string word; 				// Word being read 
+	string name; 				// Name of the condition 
+	long value; 				// Value of the condition 
+	size_t equals; 				// Position of '=' in the word 
+
+	query = historyQuery(); 
+	words.str(text); 
+
+	while (words >> word)
+	{
+		equals = word.find('='); 
+		name = word.substr(0, equals); 
+		value = (equals == string::npos) ? 0 : atol(word.c_str() + equals + 1); 
+
+		if (name == "mls" && value >= MLS_MIN && value <= MLS_MAX)
+			query.mls = value; 
+		else if (name == "reductions" && value > 0)
+			query.reductions = value; 
+		else if (name == "days" && value > 0)
+			query.days = value; 
+		else
+		{
+			error = "expected mls=N, or reductions=N and days=D, found \"" + word + "\""; 
+			return false; 
+		}
+	}
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: displayPriceHistory
+// DESCRIPTION: Displays the price changes a history query asks for. For an 
+// MLS number, each change of its price is shown, oldest first, with when it 
+// was made and where it came from. Otherwise the blocks of the last days 
+// are read, newest back to the first older than the query allows, and each 
+// listing with enough reductions among them is shown in MLS order with the 
+// number of reductions, its price before the first of them and its price 
+// after the last. 
+// INPUT: Parameters: out - stream to display on 
+// store - listing store holding the history 
+// query - price changes to display 
+// OUTPUT: Outputs the changes or listings to out 
+// Return value: number of lines displayed 
+// CALLS TO: readHistoryChange, formatHistoryTime, formatPrice 
+//***************************************************************************** 
+size_t displayPriceHistory(ostream& out, const listingStore& store, const historyQuery& query)
+{
+	// variables 
+	const priceHistory &history = store.history; 	// History to search 
+	size_t block; 				// Block being read 
+	size_t first; 				// First block of the days asked for 
+	const uint8_t *position; 		// Next change of the block 
+	const uint8_t *end; 			// End of the block's changes 
+	uint32_t mls; 				// MLS number of a change 
+	int64_t oldPrice; 			// Price before a change 
+	int64_t newPrice; 			// Price after a change 
+	vector<priceChange> reductions; 	// Reductions found, oldest first, as MLS number and place 
+	vector<int64_t> prices; 		// Old and new price of each reduction found 
+	size_t index; 				// Reduction being grouped 
+	size_t group; 				// First reduction of the listing being grouped 
+	size_t shown; 				// Lines displayed 
+	char line[LINE_RESERVE_BYTES * 2]; 	// Line being formatted 
+	char *cursor; 				// End of the text of the line 
+
+	shown = 0; 
+	first = 0; 
+
+	if (query.mls == 0)
+		for (first = history.blocks.size(); first > 0
+			 && history.blocks[first - 1].time >= time(NULL) - query.days * SECONDS_PER_DAY; first--)
+			; 
+
+	for (block = first; block < history.blocks.size(); block++)
+	{
+		position = history.encoded.data() + history.blocks[block].offset; 
+		end = history.encoded.data() + ((block + 1 < history.blocks.size()) ? history.blocks[block + 1].offset
+																			: history.encoded.size()); 
+		mls = 0; 
+
+		while (position < end && readHistoryChange(position, end, mls, oldPrice, newPrice))
+		{
+			if (query.mls != 0 && mls == query.mls)
+			{
+				cursor = formatHistoryTime(line, history.blocks[block].time); 
+				*cursor++ = ' '; 
+				cursor = formatPrice(cursor, oldPrice, true); 
+				memcpy(cursor, " -> ", 4); 
+				cursor = formatPrice(cursor + 4, newPrice, true); 
+				out << string_view(line, cursor - line) << ' ' << history.sources[history.blocks[block].source] << '\n'; 
+				shown++; 
+			}
+			else if (query.mls == 0 && newPrice < oldPrice)
+			{
+				reductions.push_back(priceChange()); 
+				reductions.back().numberMLS = mls; 
+				reductions.back().reduction = prices.size(); 
+				prices.push_back(oldPrice); 
+				prices.push_back(newPrice); 
+			}
+		}
+	}
+
+	// Reductions of the same listing end up together, still oldest first 
+	stable_sort(reductions.begin(), reductions.end(), compareChangeMLS); 
+
+	for (group = 0; group < reductions.size(); group = index)
+	{
+		for (index = group; index < reductions.size() && reductions[index].numberMLS == reductions[group].numberMLS; index++)
+			; 
+
+		if (index - group < static_cast<size_t>(query.reductions))
+			continue; 
+
+		cursor = to_chars(line, line + sizeof(line), reductions[group].numberMLS).ptr; 
+		cursor += snprintf(cursor, line + sizeof(line) - cursor, " %zu reductions ", index - group); 
+		cursor = formatPrice(cursor, prices[reductions[group].reduction], true); 
+		memcpy(cursor, " -> ", 4); 
+		cursor = formatPrice(cursor + 4, prices[reductions[index - 1].reduction + 1], true); 
+		out << string_view(line, cursor - line) << '\n'; 
+		shown++; 
+	}
+
+	return shown; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: formatHistoryTime
+// DESCRIPTION: Formats a time in seconds since 1970 as a UTC date and time, 
+// such as "2026-10-16T09:30:00Z". The date is worked out directly rather 
+// than with gmtime, which server threads could not share. 
+// INPUT: Parameters: position - where the text goes; room for 24 characters 
+// seconds - time to format 
+// OUTPUT: Return value: the position after the text 
+//***************************************************************************** 
+char* formatHistoryTime(char* position, int64_t seconds)
+{
+	// variables 
+	int64_t days; 				// Days since 1970 
+	int64_t clock; 				// Seconds since midnight 
+	int64_t era; 					// 400-year cycle since March 1, year 0 
+	int64_t dayOfEra; 			// Day within the cycle 
+	int64_t yearOfEra; 			// Year within the cycle 
+	int64_t dayOfYear; 			// Day within the year starting March 1 
+	int64_t monthIndex; 		// Month of the year starting March, from 0 
+	int64_t year; 				// Year of the date 
+	int month; 					// Month of the date 
+	int day; 					// Day of the month 
+
+	days = seconds / SECONDS_PER_DAY; 
+	clock = seconds % SECONDS_PER_DAY; 
+
+	if (clock < 0)
+	{
+		clock += SECONDS_PER_DAY; 
+		days--; 
+	}
+
+	// Days are counted from March 1, so leap days fall at the end of a year 
+	days += 719468; 
+	era = (days >= 0 ? days : days - 146096) / 146097; 
+	dayOfEra = days - era * 146097; 
+	yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365; 
+	dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100); 
+	monthIndex = (5 * dayOfYear + 2) / 153; 
+	day = dayOfYear - (153 * monthIndex + 2) / 5 + 1; 
+	month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9; 
+	year = yearOfEra + era * 400 + (month <= 2); 
+
+	return position + snprintf(position, 24, "%04d-%02d-%02dT%02d:%02d:%02dZ", static_cast<int>(year), month, day,
+							   static_cast<int>(clock / 3600), static_cast<int>(clock / 60 % 60),
+							   static_cast<int>(clock % 60)); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: PriceHistory
+// DESCRIPTION: Allows user to display every price change of a listing, or 
+// the listings reduced at least a number of times within a number of days. 
+// INPUT: Parameters: store - listing store holding the price history 
+// OUTPUT: Outputs the price changes or listings directly to screen. 
+// CALLS TO: displayPriceHistory 
+//***************************************************************************** 
+void PriceHistory(const listingStore& store)
+{
+	// variables 
+	historyQuery query; 		// Price changes to display 
+	long input; 				// To receive user input 
+	size_t shown; 				// Lines displayed 
+
+	if (store.history.blocks.empty())
+	{
+		cout << "No price changes have been recorded." << endl << endl; 
+		return; 
+	}
+
+	do
+	{
+		cout << "MLS number to show the price history of, or 0 to find listings reduced repeatedly: "; 
+		cin >> input; 
+		cout << endl; 
+
+		if (!cin || (input != 0 && (input < MLS_MIN || input > MLS_MAX)))
+		{
+			cout << "Invalid input - Must be an MLS number or 0." << endl << endl; 
+			cin.clear(); 
+			cin.ignore(numeric_limits<streamsize>::max(), '\n'); 
+			input = -1; 
+		}
+	}
+	while (input < 0); 
+
+	query.mls = input; 
+
+	if (query.mls == 0)
+	{
+		do
+		{
+			cout << "Fewest reductions a listing must have had: "; 
+			cin >> query.reductions; 
+			cout << endl; 
+
+			if (!cin || query.reductions <= 0)
+			{
+				cout << "Invalid input - Must be a positive number." << endl << endl; 
+				cin.clear(); 
+				cin.ignore(numeric_limits<streamsize>::max(), '\n'); 
+				query.reductions = 0; 
+			}
+		}
+		while (query.reductions <= 0); 
+
+		do
+		{
+			cout << "Within how many days: "; 
+			cin >> query.days; 
+			cout << endl; 
+
+			if (!cin || query.days <= 0)
+			{
+				cout << "Invalid input - Must be a positive number." << endl << endl; 
+				cin.clear(); 
+				cin.ignore(numeric_limits<streamsize>::max(), '\n'); 
+				query.days = 0; 
+			}
+		}
+		while (query.days <= 0); 
+	}
+
+	shown = displayPriceHistory(cout, store, query); 
+
+	if (shown == 0)
+		cout << "No price changes match." << endl << endl; 
+	else
+		cout << endl << shown << (query.mls != 0 ? " price change(s) shown." : " listing(s) found.") << endl << endl; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: deltaMark
+// DESCRIPTION: Notes that a listing was added, deleted or repriced since the 
+// listings file was last saved. Each MLS number has a dirty bit, and an 
+// added bit for a listing that was not on file at the save; a listing added 
+// and deleted again since then is no change at all. The bitmaps are 
+// allocated on the first change. If memory runs out the changes can no 
+// longer all be exported. 
+// INPUT: Parameters: delta - changes tracked since the last save 
+// mls - MLS number of the listing 
+// change - JOURNAL_ADD, JOURNAL_DELETE, JOURNAL_PRICE or JOURNAL_CHANGE 
+// OUTPUT: reference parameter: delta 
+//***************************************************************************** 
+void deltaMark(deltaTracker& delta, uint32_t mls, char change)
+{
+	// variables 
+	uint64_t bit; 				// Bit of the MLS number in its word 
+
+	if (delta.paused || delta.incomplete)
+		return; 
+
+	if (delta.dirty.empty())
+	{
+		try
+		{
+			delta.dirty.assign(MLS_MAX / 64 + 1, 0); 
+			delta.added.assign(MLS_MAX / 64 + 1, 0); 
+		}
+		catch (bad_alloc&)
+		{
+			delta.dirty.clear(); 
+			delta.incomplete = true; 
+			return; 
+		}
+	}
+
+	bit = 1ull << (mls % 64); 
+
+	if ((delta.dirty[mls / 64] & bit) == 0)
+	{
+		delta.dirty[mls / 64] |= bit; 
+		delta.count++; 
+
+		if (change == JOURNAL_ADD)
+			delta.added[mls / 64] |= bit; 
+	}
+	else if (change == JOURNAL_DELETE && (delta.added[mls / 64] & bit) != 0)
+	{
+		delta.dirty[mls / 64] &= ~bit; 
+		delta.added[mls / 64] &= ~bit; 
+		delta.count--; 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeDeltaFile
+// DESCRIPTION: Appends the listings added, changed and deleted since the 
+// last save or export to a delta file, so a program keeping a copy of the 
+// listings can apply them rather than read the whole file again. The first 
+// line of the file holds the sequence number of the last changes written, 
+// and is updated before they are appended. Each group of changes starts 
+// with "@ SEQUENCE TIME ADDED CHANGED DELETED", followed, in MLS order, by 
+// "+ " and a listings file line for a listing added, "= " and its line for 
+// a listing changed and "- MLS" for a listing deleted, so a group cut short 
+// can be told by its counts. Nothing is written if nothing changed. Once 
+// written, the changes are no longer tracked. 
+// INPUT: Parameters: fileName - name of the delta file 
+// store - listing store holding the changes 
+// summary - receives the sequence number and counts of the changes 
+// error - receives the reason the file was not written 
+// OUTPUT: reference parameters: store, summary, error 
+// Return value: false if the file could not be written 
+// CALLS TO: indexFind, formatListingLine, formatHistoryTime, syncFile 
+//***************************************************************************** 
+bool writeDeltaFile(const string& fileName, listingStore& store, deltaSummary& summary, string& error)
+{
+	// variables 
+	operationTimer timer(OPERATION_DELTA, true); 	// Adds the export to the metrics 
+	deltaTracker &delta = store.delta; 	// Changes to write 
+	FILE *output; 				// Delta file 
+	char header[64]; 			// First line of the file 
+	size_t headerBytes; 		// Length of the first line 
+	string records; 			// Lines of the changes 
+	size_t word; 				// Word of the bitmaps being read 
+	uint64_t bits; 				// Dirty bits of the word not yet written 
+	uint32_t mls; 				// MLS number of a change 
+	uint32_t row; 				// Row of the listing, or NO_ROW if it was deleted 
+	const string *company; 		// Company name of the listing 
+	size_t lineStart; 			// Where the listing's line starts in records 
+	char line[LINE_RESERVE_BYTES]; 	// Line starting the group of changes 
+	char *cursor; 				// End of the text of that line 
+	bool written; 				// Whether every write succeeded 
+
+	summary.sequence = 0; 
+	summary.inserted = 0; 
+	summary.updated = 0; 
+	summary.deleted = 0; 
+
+	if (delta.incomplete)
+	{
+		error = "memory ran out while tracking changes; read the whole listings file instead"; 
+		return false; 
+	}
+
+	if (delta.count == 0)
+	{
+		timer.succeeded = true; 
+		return true; 
+	}
+
+	output = fopen(fileName.c_str(), "r+b"); 
+	headerBytes = DELTA_SIGNATURE.size() + DELTA_SEQUENCE_DIGITS + 1; 
+
+	if (output != NULL)
+	{
+		if (fread(header, 1, headerBytes, output) != headerBytes
+			|| memcmp(header, DELTA_SIGNATURE.data(), DELTA_SIGNATURE.size()) != 0)
+		{
+			fclose(output); 
+			error = "not a delta file"; 
+			return false; 
+		}
+
+		summary.sequence = strtoull(header + DELTA_SIGNATURE.size(), NULL, 10); 
+	}
+	else
+		output = fopen(fileName.c_str(), "w+b"); 
+
+	if (output == NULL)
+	{
+		error = "file could not be opened"; 
+		return false; 
+	}
+
+	for (word = 0; word < delta.dirty.size(); word++)
+		for (bits = delta.dirty[word]; bits != 0; bits &= bits - 1)
+		{
+			mls = word * 64 + __builtin_ctzll(bits); 
+			row = indexFind(store, mls); 
+
+			if (row == NO_ROW)
+			{
+				records += "- " + to_string(mls) + "\n"; 
+				summary.deleted++; 
+				continue; 
+			}
+
+			if (delta.added[word] & (bits & -bits))
+			{
+				records += "+ "; 
+				summary.inserted++; 
+			}
+			else
+			{
+				records += "= "; 
+				summary.updated++; 
+			}
+
+			// Every field but the company name fits in LINE_RESERVE_BYTES 
+			company = &store.companyNames[store.company[row]]; 
+			lineStart = records.size(); 
+			records.resize(lineStart + LINE_RESERVE_BYTES + company->size()); 
+			records.resize(formatListingLine(&records[lineStart], mls, store.price[row], store.status[row],
+											 store.zip[row], *company) - records.data()); 
+		}
+
+	// The sequence number is taken before the changes are added, so it is never used twice 
+	summary.sequence++; 
+	snprintf(header, sizeof(header), "%s%0*llu\n", DELTA_SIGNATURE.c_str(), DELTA_SEQUENCE_DIGITS,
+			 static_cast<unsigned long long>(summary.sequence)); 
+	written = fseek(output, 0, SEEK_SET) == 0 && fwrite(header, 1, headerBytes, output) == headerBytes
+			  && syncFile(output); 
+
+	cursor = line + snprintf(line, sizeof(line), "@ %llu ", static_cast<unsigned long long>(summary.sequence)); 
+	cursor = formatHistoryTime(cursor, time(NULL)); 
+	cursor += snprintf(cursor, line + sizeof(line) - cursor, " %u %u %u\n", summary.inserted, summary.updated,
+					   summary.deleted); 
+
+	written = written && fseek(output, 0, SEEK_END) == 0 && fwrite(line, 1, cursor - line, output) == size_t(cursor - line)
+			  && fwrite(records.data(), 1, records.size(), output) == records.size(); 
+	written = syncFile(output) && written; 
+	written = fclose(output) == 0 && written; 
+
+	if (!written)
+	{
+		error = "file could not be written"; 
+		return false; 
+	}
+
+	fill(delta.dirty.begin(), delta.dirty.end(), 0); 
+	fill(delta.added.begin(), delta.added.end(), 0); 
+	delta.count = 0; 
+
+	timer.bytesWritten = (cursor - line) + records.size(); 
+	timer.recordsParsed = summary.inserted + summary.updated + summary.deleted; 
+	timer.succeeded = true; 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: ExportChanges
+// DESCRIPTION: Allows user to write the listings added, changed and deleted 
+// since the last save or export to the delta file beside the listings file 
+// loaded, without saving the whole file. 
+// INPUT: Parameters: store - listing store holding the changes 
+// OUTPUT: Summary of the changes written, output to screen. 
+// CALLS TO: writeDeltaFile 
+//***************************************************************************** 
+void ExportChanges(listingStore& store)
+{
+	// variables 
+	string fileName; 			// Name of the delta file 
+	deltaSummary summary; 		// Changes written 
+	string error; 				// Reason the file was not written 
+
+	fileName = (store.delta.fileName.empty() ? FILE_NAME : store.delta.fileName) + DELTA_EXTENSION; 
+
+	if (!writeDeltaFile(fileName, store, summary, error))
+		cout << "Delta file " << fileName << ": " << error << "." << endl << endl; 
+	else if (summary.sequence == 0)
+		cout << "There are no changes since the last save or export." << endl << endl; 
+	else
+		cout << "Changes " << summary.sequence << " written to " << fileName << ": " << summary.inserted
+			 << " added, " << summary.updated << " changed, " << summary.deleted << " deleted." << endl << endl; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: shardMark
+// DESCRIPTION: Notes that a listing of a zip code prefix was added, deleted 
+// or repriced, so the next save to the shard directory rewrites its shard. 
+// INPUT: Parameters: shards - shards changed since the last save 
+// zip - packed zip code of the listing 
+// OUTPUT: reference parameter: shards 
+//***************************************************************************** 
+void shardMark(shardLayout& shards, uint32_t zip)
+{
+	// variables 
+	uint32_t prefix; 				// 3-digit zip code prefix of the listing 
+
+	prefix = zip / (ZIP4_COUNT * (ZIP5_COUNT / ZIP3_COUNT)); 
+	shards.dirty[prefix / 64] |= 1ull << (prefix % 64); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: isShardDirectory
+// DESCRIPTION: Checks whether a name is a directory holding a shard manifest. 
+// INPUT: Parameters: name - name of the file or directory 
+// OUTPUT: Return value: true if the name is a shard directory 
+//***************************************************************************** 
+bool isShardDirectory(const string& name)
+{
+	// variables 
+	struct stat fileInfo; 		// Kind of file the name is 
+
+	if (stat(name.c_str(), &fileInfo) != 0 || (fileInfo.st_mode & S_IFMT) != S_IFDIR)
+		return false; 
+
+	return stat((name + "/" + SHARD_MANIFEST).c_str(), &fileInfo) == 0; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: isShardTarget
+// DESCRIPTION: Checks whether listings saved under a name are saved as 
+// shards: the name is an existing directory or ends in '/'. 
+// INPUT: Parameters: name - name the listings are saved under 
+// OUTPUT: Return value: true if the listings are saved as shards 
+//***************************************************************************** 
+bool isShardTarget(const string& name)
+{
+	// variables 
+	struct stat fileInfo; 		// Kind of file the name is 
+
+	if (!name.empty() && name.back() == '/')
+		return true; 
+
+	return stat(name.c_str(), &fileInfo) == 0 && (fileInfo.st_mode & S_IFMT) == S_IFDIR; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: shardFileName
+// DESCRIPTION: Names the shard file of a 3-digit zip code prefix, such as 
+// "DIR/072.TXT". 
+// INPUT: Parameters: directory - shard directory 
+// prefix - zip code prefix of the shard 
+// OUTPUT: Return value: name of the shard file 
+//***************************************************************************** 
+string shardFileName(const string& directory, uint32_t prefix)
+{
+	// variables 
+	char digits[4]; 				// Prefix with its leading zeros 
+
+	snprintf(digits, sizeof(digits), "%03u", prefix); 
+
+	return directory + "/" + digits + SHARD_EXTENSION; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: parseShardList
+// DESCRIPTION: Reads the shards a regional session loads, as a list of 
+// 3-digit zip code prefixes and ranges of them such as "800-809,972", or "*" 
+// for every shard. The choice applies to the loads of shard directories 
+// that follow. 
+// INPUT: Parameters: text - list of prefixes 
+// shards - receives the choice 
+// error - receives the reason the list is not valid 
+// OUTPUT: reference parameters: shards, error 
+// Return value: false if the list is not valid 
+//***************************************************************************** 
+bool parseShardList(const string& text, shardLayout& shards, string& error)
+{
+	// variables 
+	uint64_t selected[SHARD_WORDS]; 	// Prefixes in the list 
+	const char *end; 				// End of the list 
+	unsigned first; 				// First prefix of a range 
+	unsigned last; 				// Last prefix of a range 
+	unsigned prefix; 				// Prefix being chosen 
+	from_chars_result result; 	// Result of converting a prefix 
+
+	if (text == "*")
+	{
+		shards.partial = false; 
+		memset(shards.selected, 0, sizeof(shards.selected)); 
+		return true; 
+	}
+
+	memset(selected, 0, sizeof(selected)); 
+	end = text.data() + text.size(); 
+	result.ptr = text.data(); 
+
+	for (;;)
+	{
+		result = from_chars(result.ptr, end, first); 
+		last = first; 
+
+		if (result.ec == errc() && result.ptr < end && *result.ptr == '-')
+			result = from_chars(result.ptr + 1, end, last); 
+
+		if (result.ec != errc() || first > last || last >= ZIP3_COUNT
+		    || (result.ptr < end && *result.ptr != ','))
+		{
+			error = "expected zip code prefixes from 000 to 999, such as 800-809,972, or *"; 
+			return false; 
+		}
+
+		for (prefix = first; prefix <= last; prefix++)
+			selected[prefix / 64] |= 1ull << (prefix % 64); 
+
+		if (result.ptr == end)
+			break; 
+
+		result.ptr++; 
+	}
+
+	shards.partial = true; 
+	memcpy(shards.selected, selected, sizeof(selected)); 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: readShardManifest
+// DESCRIPTION: Reads the manifest of a shard directory: SHARD_SIGNATURE, then 
+// a "prefix listings" line for each shard file. A directory without a 
+// manifest has no shards. 
+// INPUT: Parameters: directory - shard directory 
+// counts - receives the listings in each prefix's shard, or -1 where the 
+// prefix has no shard 
+// OUTPUT: reference parameter: counts 
+// Return value: false if the manifest is not valid 
+//***************************************************************************** 
+bool readShardManifest(const string& directory, vector<int64_t>& counts)
+{
+	// variables 
+	ifstream input; 				// Manifest file 
+	string line; 				// Signature line of the manifest 
+	int prefix; 					// Prefix of a shard 
+	int64_t listings; 			// Listings in the shard 
+
+	counts.assign(ZIP3_COUNT, -1); 
+	input.open((directory + "/" + SHARD_MANIFEST).c_str()); 
+
+	if (!input)
+		return true; 
+
+	getline(input, line); 
+
+	if (!line.empty() && line.back() == '\r')
+		line.pop_back(); 
+
+	if (line != SHARD_SIGNATURE)
+		return false; 
+
+	while (input >> prefix >> listings)
+	{
+		if (prefix < 0 || prefix >= static_cast<int>(ZIP3_COUNT) || listings < 0 || counts[prefix] >= 0)
+			return false; 
+
+		counts[prefix] = listings; 
+	}
+
+	return input.eof(); 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: loadShardDirectory
+// DESCRIPTION: Empties the store and loads the shards of a shard directory 
+// into it: every shard, or only those chosen for a regional session. The 
+// shards are mapped together and parsed as one run of chunks on several 
+// threads, with lines numbered from the start of each shard. MLS numbers 
+// are checked for repeats only among the shards loaded. 
+// INPUT: Parameters: directory - shard directory 
+// store - listing store to fill, holding the choice of shards 
+// summary - counts of records loaded and skipped to update 
+// OUTPUT: reference parameters: store, summary 
+// Return value: false if the manifest or a shard could not be read 
+// CALLS TO: storeClear, readShardManifest, shardFileName, mapFile, 
+// splitListingsChunks, storeReserve, loadThreadCount, 
+// appendListingsParallel, unmapFile 
+//***************************************************************************** 
+bool loadShardDirectory(const string& directory, listingStore& store, loadSummary& summary)
+{
+	// variables 
+	vector<int64_t> counts; 		// Listings in each prefix's shard, or -1 
+	vector<uint32_t> prefixes; 	// Prefixes of the shards to load 
+	vector<mappedFile> inputs; 	// Mapped bytes of each shard 
+	vector<parsedChunk> chunks; 	// Chunks of the shards in order 
+	uint64_t listings; 			// Listings the manifest counts in the shards 
+	uint32_t prefix; 				// Prefix being checked 
+	size_t index; 				// Shard being mapped or released 
+	bool mapped; 				// Whether every shard was mapped 
+
+	storeClear(store); 
+
+	if (!readShardManifest(directory, counts))
+	{
+		cerr << "Shards " << directory << ": " << SHARD_MANIFEST << " is not a valid manifest." << endl; 
+		return false; 
+	}
+
+	listings = 0; 
+
+	for (prefix = 0; prefix < ZIP3_COUNT; prefix++)
+		if (counts[prefix] >= 0 && (!store.shards.partial || ((store.shards.selected[prefix / 64] >> (prefix % 64)) & 1) != 0))
+		{
+			prefixes.push_back(prefix); 
+			listings += counts[prefix]; 
+		}
+
+	inputs.resize(prefixes.size()); 
+	mapped = true; 
+
+	for (index = 0; index < prefixes.size() && mapped; index++)
+	{
+		mapped = mapFile(shardFileName(directory, prefixes[index]), inputs[index]); 
+
+		if (mapped)
+			splitListingsChunks(inputs[index], chunks); 
+		else
+			cerr << "Shard " << shardFileName(directory, prefixes[index]) << ": could not be read." << endl; 
+	}
+
+	if (mapped)
+	{
+		// Presizing the columns avoids copying them each time they would grow 
+		storeReserve(store, listings + 1); 
+		appendListingsParallel(chunks, loadThreadCount(store), store, summary); 
+	}
+
+	for (index = 0; index < inputs.size(); index++)
+		unmapFile(inputs[index]); 
+
+	if (!mapped)
+		return false; 
+
+	store.shards.directory = directory; 
+
+	for (prefix = 0; prefix < ZIP3_COUNT; prefix++)
+		if (!store.shards.partial || ((store.shards.selected[prefix / 64] >> (prefix % 64)) & 1) != 0)
+			store.shards.loaded[prefix / 64] |= 1ull << (prefix % 64); 
+
+	// The listings just loaded are the shards, not changes to them 
+	memset(store.shards.dirty, 0, sizeof(store.shards.dirty)); 
+
+	return true; 
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: writeShardDirectory
+// DESCRIPTION: Saves the listings to a shard directory: one file per 3-digit 
+// zip code prefix, and a manifest counting the listings of each. Saving to 
+// the directory the listings were loaded from rewrites only the shards 
+// changed since the load or the last save, and merges a changed shard that 
+// was not loaded with its file. Saving elsewhere writes every shard, removes 
+// the target's shards that are left empty, and needs every shard loaded. 
+// The shards are written on several threads, and the manifest is replaced 
+// once they are all written. 
+// INPUT: Parameters: directory - shard directory, created if need be 
+// store - listing store to save 
+// error - receives the reason the listings could not be saved 
+// OUTPUT: reference parameters: store, error 
+// Return value: false if the listings could not be saved 
+// CALLS TO: readShardManifest, storeFileOrder, loadThreadCount, 
+// writeShardsWorker, shardFileName, syncFile, replaceFile 
+//***************************************************************************** 
+bool writeShardDirectory(const string& directory, listingStore& store, string& error)
+{
+	// variables 
+	operationTimer timer(OPERATION_SAVE, true); 	// Adds the save to the metrics 
+	struct stat fileInfo; 		// Kind of file the directory name is 
+	bool created; 				// Whether the directory could be created 
+	bool sameDirectory; 		// Whether the listings were loaded from the directory 
+	vector<int64_t> counts; 		// Listings in each prefix's shard, or -1 
+	vector<vector<uint32_t> > prefixRows; 	// Rows of the live listings of each prefix 
+	shardSave job; 				// Shards to write 
+	vector<thread> workers; 		// Writing threads 
+	int threads; 				// Threads to write the shards with 
+	int worker; 					// Worker being started 
+	uint32_t prefix; 				// Prefix being checked 
+	uint32_t row; 				// Row being sorted into its prefix 
+	size_t index; 				// Shard written 
+	bool loaded; 				// Whether the prefix's shard was loaded 
+	string manifest; 			// Text of the new manifest 
+	char line[32]; 				// One line of the manifest 
+	string tempName; 			// Name of the manifest written before the rename 
+	FILE *outputFile; 			// Manifest being written 
+	bool written; 				// Whether every write succeeded 
+
+	sameDirectory = !store.shards.directory.empty() && directory == store.shards.directory; 
+
+	// Shards not loaded cannot be copied to another directory 
+	if (!sameDirectory && !store.shards.directory.empty())
+		for (prefix = 0; prefix < ZIP3_COUNT; prefix++)
+			if (((store.shards.loaded[prefix / 64] >> (prefix % 64)) & 1) == 0)
+			{
+				error = "only some shards of " + store.shards.directory + " are loaded, so they can only be saved there"; 
+				return false; 
+			}
+
+	if (stat(directory.c_str(), &fileInfo) != 0)
+	{
+#ifdef _WIN32
+		created = _mkdir(directory.c_str()) == 0; 
+#else
+		created = mkdir(directory.c_str(), 0777) == 0; 
+#endif
+
+		if (!created)
+		{
+			error = "directory " + directory + " could not be created"; 
+			return false; 
+		}
+	}
+	else if ((fileInfo.st_mode & S_IFMT) != S_IFDIR)
+	{
+		error = directory + " is not a directory"; 
+		return false; 
+	}
+
+	if (!readShardManifest(directory, counts))
+	{
+		error = directory + "/" + SHARD_MANIFEST + " is not a valid manifest"; 
+		return false; 
+	}
+
+	prefixRows.resize(ZIP3_COUNT); 
+
+	for (row = 0; row < store.mls.size(); row++)
+		if (store.status[row] != STATUS_DELETED)
+			prefixRows[store.zip[row] / (ZIP4_COUNT * (ZIP5_COUNT / ZIP3_COUNT))].push_back(row); 
+
+	for (prefix = 0; prefix < ZIP3_COUNT; prefix++)
+	{
+		loaded = ((store.shards.loaded[prefix / 64] >> (prefix % 64)) & 1) != 0; 
+
+		// Unchanged shards of the directory loaded are left as they are 
+		if (sameDirectory ? ((store.shards.dirty[prefix / 64] >> (prefix % 64)) & 1) == 0
+		                  : (prefixRows[prefix].empty() && counts[prefix] < 0))
+			continue; 
+
+		job.prefixes.push_back(prefix); 
+		job.rows.push_back(vector<uint32_t>()); 
+		job.rows.back().swap(prefixRows[prefix]); 
+		storeFileOrder(store, job.rows.back()); 
+		job.merge.push_back(sameDirectory && !loaded && counts[prefix] >= 0); 
+	}
+
+	job.store = &store; 
+	job.directory = directory; 
+	job.listings.assign(job.prefixes.size(), 0); 
+	job.bytes.assign(job.prefixes.size(), 0); 
+	job.written.assign(job.prefixes.size(), false); 
+	job.next = 0; 
+	threads = min(loadThreadCount(store), static_cast<int>(job.prefixes.size())); 
+
+	for (worker = 0; worker < threads; worker++)
+		workers.push_back(thread(writeShardsWorker, ref(job))); 
+
+	for (worker = 0; worker < threads; worker++)
+		workers[worker].join(); 
+
+	for (index = 0; index < job.prefixes.size(); index++)
+	{
+		if (!job.written[index])
+		{
+			error = shardFileName(directory, job.prefixes[index]) + " could not be written"; 
+			return false; 
+		}
+
+		counts[job.prefixes[index]] = job.listings[index]; 
+		timer.bytesWritten += job.bytes[index]; 
+
+		// A shard left with no listings is removed 
+		if (job.listings[index] == 0)
+		{
+			remove(shardFileName(directory, job.prefixes[index]).c_str()); 
+			counts[job.prefixes[index]] = -1; 
+		}
+	}
+
+	manifest = SHARD_SIGNATURE + "\n"; 
+
+	for (prefix = 0; prefix < ZIP3_COUNT; prefix++)
+		if (counts[prefix] >= 0)
+		{
+			snprintf(line, sizeof(line), "%03u %lld\n", prefix, static_cast<long long>(counts[prefix])); 
+			manifest += line; 
+		}
+
+	tempName = directory + "/" + SHARD_MANIFEST + TEMP_EXTENSION; 
+	outputFile = fopen(tempName.c_str(), "w"); 
+
+	if (outputFile == NULL)
+	{
+		error = "manifest could not be written"; 
+		return false; 
+	}
+
+	written = fwrite(manifest.data(), 1, manifest.size(), outputFile) == manifest.size(); 
+	written = syncFile(outputFile) && written; 
+	written = (fclose(outputFile) == 0) && written; 
+
+	if (!written || !replaceFile(tempName, directory + "/" + SHARD_MANIFEST))
+	{
+		remove(tempName.c_str()); 
+		error = "manifest could not be written"; 
+		return false; 
+	}
+
+	if (sameDirectory)
+	{
+		// A listing saved to a shard not loaded is dropped from it by a later 
+		// save if it has since been deleted 
+		for (index = 0; index < job.prefixes.size(); index++)
+			if (((store.shards.loaded[job.prefixes[index] / 64] >> (job.prefixes[index] % 64)) & 1) == 0)
+				for (row = 0; row < job.rows[index].size(); row++)
+					store.shards.merged.push_back(store.mls[job.rows[index][row]]); 
+
+		sort(store.shards.merged.begin(), store.shards.merged.end()); 
+		store.shards.merged.erase(unique(store.shards.merged.begin(), store.shards.merged.end()), 
+		                         store.shards.merged.end()); 
+		memset(store.shards.dirty, 0, sizeof(store.shards.dirty)); 
+	}
+
+	timer.recordsParsed = store.liveRows; 
+	timer.succeeded = true; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: writeShardsWorker
+// DESCRIPTION: Writes shards of a save on a worker thread, taking the next 
+// shard not yet taken until none are left. 
+// INPUT: Parameters: job - shards to write 
+// OUTPUT: reference parameter: job 
+// CALLS TO: writeShardFile, shardFileName 
+//***************************************************************************** 
+void writeShardsWorker(shardSave& job)
+{
+	// variables 
+	size_t index; 				// Shard being written 
+
+	for (;;)
+	{
+		{
+			lock_guard<mutex> guard(job.lock); 
+
+			if (job.next == job.prefixes.size())
+				return; 
+
+			index = job.next++; 
+		}
+
+		job.written[index] = writeShardFile(shardFileName(job.directory, job.prefixes[index]), *job.store, 
+		                                   job.rows[index], job.merge[index], job.listings[index], 
+		                                   job.bytes[index]); 
+	}
+
+}
+
+
+//*****************************************************************************
+// FUNCTION: writeShardFile
+// DESCRIPTION: Writes the listings of one shard, through a temporary file 
+// that is synced to disk and renamed over the shard file. A merged shard 
+// keeps the lines of its file, except those of listings in the store and 
+// those saved to it earlier in the session, which are replaced by the 
+// store's listings or dropped if they have been deleted. 
+// INPUT: Parameters: fileName - name of the shard file 
+// store - listing store holding the listings 
+// rows - rows of the shard's live listings 
+// merge - whether to keep the lines of the file 
+// listings - receives the number of listings written 
+// bytes - receives the number of bytes written 
+// OUTPUT: reference parameters: listings, bytes 
+// Return value: false if the shard could not be read or written 
+// CALLS TO: mapFile, unmapFile, indexFind, appendListingLines, ioWriterOpen, 
+// ioWriterWrite, ioWriterClose, replaceFile 
+//***************************************************************************** 
+bool writeShardFile(const string& fileName, const listingStore& store, const vector<uint32_t>& rows, bool merge,
+                    int64_t& listings, uint64_t& bytes)
+{
+	// variables 
+	mappedFile input; 			// Mapped bytes of the shard file being merged 
+	const char *position; 		// Start of the line being checked 
+	const char *end; 				// End of the mapped bytes 
+	const char *lineEnd; 			// End of the line being checked 
+	const char *number; 			// Start of the line's MLS number 
+	size_t length; 				// Length of the line without its line end 
+	int mls; 					// MLS number at the start of the line 
+	from_chars_result result; 	// Result of reading the MLS number 
+	string out; 				// Lines to write 
+	string tempName; 			// Name of the file written before the rename 
+	ioWriter outputFile; 		// Shard file being written 
+	bool written; 				// Whether every write succeeded 
+
+	listings = 0; 
+	bytes = 0; 
+
+	if (merge)
+	{
+		if (!mapFile(fileName, input))
+			return false; 
+
+		position = input.data; 
+		end = input.data + input.size; 
+
+		while (position < end)
+		{
+			lineEnd = static_cast<const char*>(memchr(position, '\n', end - position)); 
+
+			if (lineEnd == NULL)
+				lineEnd = end; 
+
+			length = lineEnd - position; 
+
+			if (length > 0 && position[length - 1] == '\r')
+				length--; 
+
+			number = position; 
+
+			while (number < position + length && isspace(static_cast<unsigned char>(*number)))
+				number++; 
+
+			result = from_chars(number, position + length, mls); 
+
+			// Lines that do not hold a listing are kept for the next load to report 
+			if (number < position + length
+			    && (result.ec != errc() || mls < MLS_MIN || mls > MLS_MAX
+			        || (indexFind(store, mls) == NO_ROW
+			            && !binary_search(store.shards.merged.begin(), store.shards.merged.end(), 
+			                              static_cast<uint32_t>(mls)))))
+			{
+				out.append(position, length); 
+				out += '\n'; 
+				listings++; 
+			}
+
+			position = (lineEnd == end) ? end : lineEnd + 1; 
+		}
+
+		unmapFile(input); 
+	}
+
+	appendListingLines(out, store, rows); 
+	listings += rows.size(); 
+	tempName = fileName + TEMP_EXTENSION; 
+
+	if (!ioWriterOpen(tempName, false, outputFile))
+		return false; 
+
+	written = ioWriterWrite(outputFile, out.data(), out.size()); 
+	written = ioWriterClose(outputFile, true) && written; 
+
+	if (!written || !replaceFile(tempName, fileName))
+	{
+		remove(tempName.c_str()); 
+		return false; 
+	}
+
+	bytes = out.size(); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: parseIoBackend
+// DESCRIPTION: Reads the name of a file I/O backend: "uring" for io_uring, 
+// used where the system offers it, or "blocking" for blocking calls. 
+// INPUT: Parameters: text - name of the backend 
+// kind - receives IO_URING or IO_BLOCKING 
+// OUTPUT: reference parameter: kind 
+// Return value: false if the name is not a backend 
+//***************************************************************************** 
+bool parseIoBackend(const string& text, int& kind)
+{
+	if (text == "uring")
+		kind = IO_URING; 
+	else if (text == "blocking")
+		kind = IO_BLOCKING; 
+	else
+		return false; 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioBackendName
+// DESCRIPTION: Names the file I/O backend files are read and written with: 
+// "uring" only if io_uring was chosen and the ring could be set up. 
+// OUTPUT: Return value: "uring" or "blocking" 
+// CALLS TO: ioRingAcquire, ioRingRelease 
+//***************************************************************************** 
+const char* ioBackendName()
+{
+	if (!ioRingAcquire())
+		return "blocking"; 
+
+	ioRingRelease(); 
+
+	return "uring"; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingAcquire
+// DESCRIPTION: Takes the program's io_uring ring for one file, setting it up 
+// the first time. The ring serves one file at a time; a file opened while 
+// it is busy, or where it cannot be set up, uses blocking calls instead. 
+// OUTPUT: Return value: true if the ring was taken 
+// CALLS TO: ioRingOpen 
+//***************************************************************************** 
+bool ioRingAcquire()
+{
+	if (fileIO.kind != IO_URING || !fileIO.lock.try_lock())
+		return false; 
+
+	// ready and failed are only read with the lock held, as shard files are 
+	// written from several threads at once 
+	if (!fileIO.ready && !fileIO.failed)
+	{
+		fileIO.ready = ioRingOpen(fileIO.ring); 
+		fileIO.failed = !fileIO.ready; 
+	}
+
+	if (fileIO.failed)
+	{
+		fileIO.lock.unlock(); 
+		return false; 
+	}
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingRelease
+// DESCRIPTION: Gives back the ring taken by ioRingAcquire. 
+//***************************************************************************** 
+void ioRingRelease()
+{
+	fileIO.lock.unlock(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingOpen
+// DESCRIPTION: Sets up an io_uring ring through its system calls: maps the 
+// submission and completion queues shared with the kernel and registers 
+// IO_BLOCKS buffers of IO_BLOCK_BYTES with it, so reads and writes into them 
+// need not map the pages each time. If the buffers cannot be registered, as 
+// when the locked memory limit is too low, they are used unregistered. 
+// INPUT: Parameters: ring - ring to set up 
+// OUTPUT: reference parameter: ring 
+// Return value: false if the system offers no io_uring 
+// CALLS TO: ioRingClose 
+//***************************************************************************** 
+bool ioRingOpen(ioRing& ring)
+{
+#ifdef __linux__
+	// variables 
+	io_uring_params params; 		// Sizes and offsets of the queues, from the kernel 
+	iovec vectors[IO_BLOCKS]; 		// Buffers to register 
+	void *mapped; 				// Start of a mapping 
+	int block; 					// Buffer being registered 
+
+	ring = ioRing(); 
+	memset(&params, 0, sizeof(params)); 
+	ring.descriptor = syscall(__NR_io_uring_setup, IO_BLOCKS, &params); 
+
+	if (ring.descriptor < 0)
+		return false; 
+
+	ring.sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned); 
+	ring.cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe); 
+	ring.sqeBytes = params.sq_entries * sizeof(io_uring_sqe); 
+
+	mapped = mmap(NULL, ring.sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.descriptor, 
+	             IORING_OFF_SQ_RING); 
+	ring.sqRing = (mapped == MAP_FAILED) ? NULL : static_cast<char*>(mapped); 
+	mapped = mmap(NULL, ring.cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.descriptor, 
+	             IORING_OFF_CQ_RING); 
+	ring.cqRing = (mapped == MAP_FAILED) ? NULL : static_cast<char*>(mapped); 
+	mapped = mmap(NULL, ring.sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.descriptor, 
+	             IORING_OFF_SQES); 
+	ring.sqes = (mapped == MAP_FAILED) ? NULL : static_cast<io_uring_sqe*>(mapped); 
+	mapped = mmap(NULL, IO_BLOCKS * IO_BLOCK_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); 
+	ring.buffers = (mapped == MAP_FAILED) ? NULL : static_cast<char*>(mapped); 
+
+	if (ring.sqRing == NULL || ring.cqRing == NULL || ring.sqes == NULL || ring.buffers == NULL)
+	{
+		ioRingClose(ring); 
+		return false; 
+	}
+
+	ring.sqHead = reinterpret_cast<unsigned*>(ring.sqRing + params.sq_off.head); 
+	ring.sqTail = reinterpret_cast<unsigned*>(ring.sqRing + params.sq_off.tail); 
+	ring.sqMask = *reinterpret_cast<unsigned*>(ring.sqRing + params.sq_off.ring_mask); 
+	ring.sqArray = reinterpret_cast<unsigned*>(ring.sqRing + params.sq_off.array); 
+	ring.cqHead = reinterpret_cast<unsigned*>(ring.cqRing + params.cq_off.head); 
+	ring.cqTail = reinterpret_cast<unsigned*>(ring.cqRing + params.cq_off.tail); 
+	ring.cqMask = *reinterpret_cast<unsigned*>(ring.cqRing + params.cq_off.ring_mask); 
+	ring.cqes = reinterpret_cast<io_uring_cqe*>(ring.cqRing + params.cq_off.cqes); 
+
+	for (block = 0; block < IO_BLOCKS; block++)
+	{
+		vectors[block].iov_base = ring.buffers + block * IO_BLOCK_BYTES; 
+		vectors[block].iov_len = IO_BLOCK_BYTES; 
+	}
+
+	ring.registered = syscall(__NR_io_uring_register, ring.descriptor, IORING_REGISTER_BUFFERS, vectors, 
+	                          IO_BLOCKS) == 0; 
+
+	return true; 
+#else
+	ring = ioRing(); 
+	return false; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingClose
+// DESCRIPTION: Releases the mappings and descriptor of a ring that could not 
+// be fully set up. 
+// INPUT: Parameters: ring - ring to release 
+// OUTPUT: reference parameter: ring 
+//***************************************************************************** 
+void ioRingClose(ioRing& ring)
+{
+#ifdef __linux__
+	if (ring.buffers != NULL)
+		munmap(ring.buffers, IO_BLOCKS * IO_BLOCK_BYTES); 
+
+	if (ring.sqes != NULL)
+		munmap(ring.sqes, ring.sqeBytes); 
+
+	if (ring.cqRing != NULL)
+		munmap(ring.cqRing, ring.cqRingBytes); 
+
+	if (ring.sqRing != NULL)
+		munmap(ring.sqRing, ring.sqRingBytes); 
+
+	if (ring.descriptor >= 0)
+		close(ring.descriptor); 
+#endif
+
+	ring = ioRing(); 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingQueue
+// DESCRIPTION: Adds a read or write of one of the ring's buffers to the 
+// submission queue, as a fixed-buffer operation if the buffers are 
+// registered. The buffer number comes back with its completion. 
+// INPUT: Parameters: ring - the ring 
+// write - whether to write the buffer rather than read into it 
+// descriptor - file to read or write 
+// block - buffer to read into or write 
+// bytes - bytes to read or write 
+// offset - where in the file to read or write 
+// OUTPUT: reference parameter: ring 
+//***************************************************************************** 
+void ioRingQueue(ioRing& ring, bool write, int descriptor, int block, size_t bytes, uint64_t offset)
+{
+#ifdef __linux__
+	// variables 
+	unsigned tail; 				// Submission queue position of the entry 
+	io_uring_sqe *entry; 			// Entry being filled 
+
+	tail = *ring.sqTail; 
+	entry = &ring.sqes[tail & ring.sqMask]; 
+	memset(entry, 0, sizeof(*entry)); 
+
+	if (ring.registered)
+		entry->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED; 
+	else
+		entry->opcode = write ? IORING_OP_WRITE : IORING_OP_READ; 
+
+	entry->fd = descriptor; 
+	entry->off = offset; 
+	entry->addr = reinterpret_cast<uint64_t>(ring.buffers + block * IO_BLOCK_BYTES); 
+	entry->len = bytes; 
+	entry->buf_index = block; 
+	entry->user_data = block; 
+	ring.sqArray[tail & ring.sqMask] = tail & ring.sqMask; 
+
+	// The kernel may read the entry as soon as it sees the new tail 
+	__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE); 
+	ring.pending++; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingSubmit
+// DESCRIPTION: Hands the queued reads and writes to the kernel, which starts 
+// them without waiting for them to finish. 
+// INPUT: Parameters: ring - the ring 
+// OUTPUT: reference parameter: ring 
+// Return value: false if the kernel refused them 
+//***************************************************************************** 
+bool ioRingSubmit(ioRing& ring)
+{
+#ifdef __linux__
+	// variables 
+	long submitted; 				// Entries taken by the kernel 
+
+	while (ring.pending > 0)
+	{
+		submitted = syscall(__NR_io_uring_enter, ring.descriptor, ring.pending, 0, 0, NULL, 0); 
+
+		if (submitted < 0 && errno != EINTR)
+			return false; 
+
+		if (submitted > 0)
+			ring.pending -= submitted; 
+	}
+
+	return true; 
+#else
+	return false; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioRingWait
+// DESCRIPTION: Waits for the next read or write of the ring to finish. 
+// INPUT: Parameters: ring - the ring 
+// block - receives the buffer number of the operation 
+// result - receives the bytes read or written, or a negative error number 
+// OUTPUT: reference parameters: ring, block, result 
+// Return value: false if waiting failed 
+//***************************************************************************** 
+bool ioRingWait(ioRing& ring, int& block, int& result)
+{
+#ifdef __linux__
+	// variables 
+	unsigned head; 				// Completion queue position of the next completion 
+	const io_uring_cqe *completion; 	// Completion taken 
+
+	head = *ring.cqHead; 
+
+	while (head == __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE))
+		if (syscall(__NR_io_uring_enter, ring.descriptor, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+		    && errno != EINTR)
+			return false; 
+
+	completion = &ring.cqes[head & ring.cqMask]; 
+	block = completion->user_data; 
+	result = completion->res; 
+
+	// The kernel may reuse the entry once the head has passed it 
+	__atomic_store_n(ring.cqHead, head + 1, __ATOMIC_RELEASE); 
+
+	return true; 
+#else
+	return false; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioReaderOpen
+// DESCRIPTION: Opens a file to be read a block at a time by ioReaderNext. 
+// With io_uring the reads of the first IO_BLOCKS blocks are queued at once, 
+// so the disk is kept busy while the caller works on each block. 
+// INPUT: Parameters: fileName - name of the file 
+// reader - receives the open file 
+// OUTPUT: reference parameter: reader 
+// Return value: false if the file could not be opened 
+// CALLS TO: ioRingAcquire, ioRingRelease, ioReaderQueue, ioRingSubmit 
+//***************************************************************************** 
+bool ioReaderOpen(const string& fileName, ioReader& reader)
+{
+	reader.file = NULL; 
+	reader.descriptor = -1; 
+	reader.size = 0; 
+	reader.queued = 0; 
+	reader.delivered = 0; 
+	reader.block = -1; 
+	reader.inFlight = 0; 
+	reader.failed = false; 
+
+#ifdef __linux__
+	// variables 
+	struct stat fileInfo; 		// To receive the size of the file 
+	int block; 					// Buffer being marked free 
+
+	if (ioRingAcquire())
+	{
+		reader.descriptor = open(fileName.c_str(), O_RDONLY); 
+
+		if (reader.descriptor < 0 || fstat(reader.descriptor, &fileInfo) != 0)
 		{
-			cout << "File already exists." << endl;  
-			cout << "Do you wish to overwrite existing file ('E') or choose another file ('A')?" 
-			<< endl << endl; 
-			
-			do
-			{
-				cout << "Please enter choice: "; 
-				cin >> fileOption; 
-				cout << endl; 
-			
-				fileOption = toupper(fileOption); 
-			
-				if (fileOption != EXISTING_FILE && fileOption != ANOTHER_FILE) 
-					cout << "Invalid Input - Must be 'E' or 'A'" << endl << endl;
-			}
-			while (fileOption != EXISTING_FILE && fileOption != ANOTHER_FILE); 
-			
+			if (reader.descriptor >= 0)
+				close(reader.descriptor); 
+
+			reader.descriptor = -1; 
+			ioRingRelease(); 
+			return false; 
 		}
-		
-		testFile.close();
-		testFile.clear(); 	
-		
+
+		reader.size = fileInfo.st_size; 
+
+		for (block = 0; block < IO_BLOCKS; block++)
+			reader.length[block] = 0; 
+
+		while (reader.queued < reader.size && reader.inFlight < IO_BLOCKS)
+			ioReaderQueue(reader); 
+
+		reader.failed = !ioRingSubmit(fileIO.ring); 
+
+		return true; 
+	}
+#endif
+
+	reader.file = fopen(fileName.c_str(), "rb"); 
+
+	if (reader.file == NULL)
+		return false; 
+
+	reader.buffer.resize(IO_BLOCK_BYTES); 
+
+	return true; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioReaderQueue
+// DESCRIPTION: Queues the read of the next block of a file into the ring 
+// buffer of its position. 
+// INPUT: Parameters: reader - file being read 
+// OUTPUT: reference parameter: reader 
+// CALLS TO: ioRingQueue 
+//***************************************************************************** 
+void ioReaderQueue(ioReader& reader)
+{
+	// variables 
+	int block; 					// Buffer of the block 
+	size_t bytes; 				// Bytes of the block 
+
+	block = (reader.queued / IO_BLOCK_BYTES) % IO_BLOCKS; 
+	bytes = min<uint64_t>(IO_BLOCK_BYTES, reader.size - reader.queued); 
+
+	ioRingQueue(fileIO.ring, false, reader.descriptor, block, bytes, reader.queued); 
+	reader.length[block] = -1; 
+	reader.queued += bytes; 
+	reader.inFlight++; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioReaderNext
+// DESCRIPTION: Hands out the next block of a file opened by ioReaderOpen. 
+// The block stays valid until the next call. With io_uring the buffer of 
+// the block handed out before is given the next read, and the call waits 
+// only if the block's own read has not finished; a short read is finished 
+// with a blocking one. 
+// INPUT: Parameters: reader - file being read 
+// data - receives the first byte of the block 
+// size - receives the bytes in the block 
+// OUTPUT: reference parameters: reader, data, size 
+// Return value: false at the end of the file or if a read failed 
+// CALLS TO: ioReaderQueue, ioRingSubmit, ioRingWait 
+//***************************************************************************** 
+bool ioReaderNext(ioReader& reader, const char*& data, size_t& size)
+{
+#ifdef __linux__
+	// variables 
+	int block; 					// Buffer of the block handed out 
+	int finished; 				// Buffer of a read that finished 
+	int result; 					// Bytes read, or a negative error number 
+	size_t expected; 			// Bytes the block should hold 
+	ssize_t bytes; 				// Bytes of a blocking read 
+
+	if (reader.descriptor >= 0)
+	{
+		// The buffer handed out last is free again for the next block 
+		if (reader.block >= 0 && reader.queued < reader.size && !reader.failed)
+		{
+			ioReaderQueue(reader); 
+			reader.failed = !ioRingSubmit(fileIO.ring); 
 		}
-		while(fileOption == ANOTHER_FILE); 
-		
-		
-		if(fileOption == EXISTING_FILE)
+
+		reader.block = -1; 
+
+		if (reader.failed || reader.delivered >= reader.size)
+			return false; 
+
+		block = (reader.delivered / IO_BLOCK_BYTES) % IO_BLOCKS; 
+
+		while (reader.length[block] < 0 && !reader.failed)
 		{
-			outputFile.open(fileName.c_str());
-			
-			
-			current = first; 
-			
-			while(current != NULL)
-			{
-				outputFile << fixed << setprecision(0)
-			   	   		   << current->numberMLS << " " 
-			   	           << current->price << " "
-			               << current->status << " "
-			               << current->zipCode << " "
-			               << current->realtyCompany << endl;
-				
-				current = current->link; 
-				
+			if (!ioRingWait(fileIO.ring, finished, result))
+			{
+				fileIO.failed = true; 
+				reader.failed = true; 
+			}
+			else
+			{
+				reader.inFlight--; 
+				reader.length[finished] = max(result, 0); 
+				reader.failed = reader.failed || result < 0; 
 			}
-			
-			outputFile.close();		
 		}
-			    
+
+		expected = min<uint64_t>(IO_BLOCK_BYTES, reader.size - reader.delivered); 
+		bytes = 1; 
+
+		while (!reader.failed && static_cast<size_t>(reader.length[block]) < expected && bytes > 0)
+		{
+			bytes = pread(reader.descriptor, fileIO.ring.buffers + block * IO_BLOCK_BYTES + reader.length[block], 
+			             expected - reader.length[block], reader.delivered + reader.length[block]); 
+			reader.failed = bytes < 0; 
+
+			if (bytes > 0)
+				reader.length[block] += bytes; 
+		}
+
+		if (reader.failed || reader.length[block] == 0)
+			return false; 
+
+		data = fileIO.ring.buffers + block * IO_BLOCK_BYTES; 
+		size = reader.length[block]; 
+		reader.delivered += expected; 
+		reader.block = block; 
+
+		return true; 
 	}
-	else
-		do
+#endif
+
+	size = fread(reader.buffer.data(), 1, reader.buffer.size(), reader.file); 
+	data = reader.buffer.data(); 
+	reader.failed = (size == 0 && ferror(reader.file) != 0); 
+
+	return size > 0; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioReaderClose
+// DESCRIPTION: Closes a file opened by ioReaderOpen, first waiting for any 
+// reads still in flight so the ring is left idle. 
+// INPUT: Parameters: reader - file being read 
+// OUTPUT: reference parameter: reader 
+// CALLS TO: ioRingWait, ioRingRelease 
+//***************************************************************************** 
+void ioReaderClose(ioReader& reader)
+{
+#ifdef __linux__
+	// variables 
+	int finished; 				// Buffer of a read that finished 
+	int result; 					// Bytes read, or a negative error number 
+
+	if (reader.descriptor >= 0)
+	{
+		while (reader.inFlight > 0 && !fileIO.failed)
 		{
-			cout << "All changes will be lost. Proceed (Y/N)?: "; 
-			cin >> confirm; 
-			cout << endl << endl; 
-	
-			confirm = toupper(confirm); 
-	
-			if (confirm != YES && confirm != NO) 
-			cout << "Invalid Input - Must be 'Y' or 'N'" << endl << endl;
+			if (ioRingWait(fileIO.ring, finished, result))
+				reader.inFlight--; 
+			else
+				fileIO.failed = true; 
 		}
-		while (confirm != YES && confirm != NO);
-	
+
+		close(reader.descriptor); 
+		reader.descriptor = -1; 
+		ioRingRelease(); 
 	}
-	while (confirm != YES && saveOption != YES); 	
-	
+#endif
+
+	if (reader.file != NULL)
+		fclose(reader.file); 
+
+	reader.file = NULL; 
+	vector<char>().swap(reader.buffer); 
+
 }
 
+//*****************************************************************************
+// FUNCTION: ioWriterOpen
+// DESCRIPTION: Creates or empties a file to be written by ioWriterWrite. 
+// With io_uring the written bytes are gathered in the ring's buffers and 
+// each full buffer is written while the caller goes on. 
+// INPUT: Parameters: fileName - name of the file 
+// binary - whether to write the bytes as they are; otherwise text mode keeps 
+// the line endings of the system, as ofstream did 
+// writer - receives the open file 
+// OUTPUT: reference parameter: writer 
+// Return value: false if the file could not be created 
+// CALLS TO: ioRingAcquire, ioRingRelease 
+//***************************************************************************** 
+bool ioWriterOpen(const string& fileName, bool binary, ioWriter& writer)
+{
+	// variables 
+	int block; 					// Buffer being marked free 
+
+	writer.file = NULL; 
+	writer.descriptor = -1; 
+	writer.offset = 0; 
+	writer.block = 0; 
+	writer.used = 0; 
+	writer.inFlight = 0; 
+	writer.failed = false; 
+
+	for (block = 0; block < IO_BLOCKS; block++)
+		writer.blockBytes[block] = 0; 
+
+#ifdef __linux__
+	if (ioRingAcquire())
+	{
+		writer.descriptor = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666); 
+
+		if (writer.descriptor >= 0)
+			return true; 
+
+		ioRingRelease(); 
+		return false; 
+	}
+#endif
+
+	writer.file = fopen(fileName.c_str(), binary ? "wb" : "w"); 
+
+	return writer.file != NULL; 
+
+}
 
 //*****************************************************************************
-// FUNCTION: ChangeAskingPrices
-// DESCRIPTION: Allows user to apply price changes from file.    
-// INPUT: Parameters: first - Pointer variable for first node in linked list.  
-// last - Pointer variable for last node in linked list. 
-// OUTPUT: Output direct to file.   
+// FUNCTION: ioWriterWrite
+// DESCRIPTION: Adds bytes to a file opened by ioWriterOpen. With io_uring 
+// they are copied into the ring buffer being filled, and a buffer still 
+// being written is waited for only when it is needed again. 
+// INPUT: Parameters: writer - file being written 
+// data - first byte to write 
+// size - bytes to write 
+// OUTPUT: reference parameter: writer 
+// Return value: false if a write failed 
+// CALLS TO: ioWriterWait, ioWriterFlush 
 //***************************************************************************** 
-void ChangeAskingPrices(listingsInfo* first, listingsInfo* last)
+bool ioWriterWrite(ioWriter& writer, const char* data, size_t size)
 {
-	// Function local variables
-	ifstream changesFile; 		 // To receive changes file 
-	int matchesFound = 0;		 // Counter to track the number of matches found 
-	bool found;					 // To track whether MLS number exists in list   			
-	int mlsToSearch;			 // To store MLS to search during each loop pass
-	double reduction; 			 // To store reduction amount 
- 
-	listingsInfo *searchNode;	 // To hold node to search during each loop pass 
-	
-	changesFile.open(FILE_CHANGES.c_str());
-	
-	if(!changesFile)
-	   cout << "Changes file does not exist" << endl << endl;  
-	else
-	{ 
-	
-		if(first == NULL)
-			cout << "There are no records currently on file to search." << endl << endl; 
-		else
-		{		
-			changesFile >> mlsToSearch; 
-			
-			while(changesFile)
+#ifdef __linux__
+	// variables 
+	size_t copied; 				// Bytes copied into the buffer 
+
+	if (writer.descriptor >= 0)
+	{
+		while (size > 0 && !writer.failed)
+		{
+			if (writer.blockBytes[writer.block] > 0)
 			{
-			   found = false; 
-	   
-	   		   searchNode = first;	
-				
-			   changesFile >> reduction; 
-			
-			   while(searchNode != NULL && !found)
-			   { 
-	   
-	   				if (searchNode->numberMLS == mlsToSearch)
-	   				{
-	   					found = true;
-						   
-						searchNode->price = searchNode->price - reduction;    
-						    
-	   					matchesFound++; 
-						   
-						if (matchesFound == 1)	
-						{
-							cout << right << "MLS number" << setw(21) << "New Asking Price" << endl;
-							cout << "----------" << setw(21) << "----------------" << endl; 
-						}
-					
-						cout << searchNode->numberMLS << setw(15) << searchNode->price << endl; 	
-						
-	   				}
-	   				else 
-	   				{
-	   					searchNode = searchNode->link;	   
-					}
-				
-			   }
-			
-			changesFile >> mlsToSearch;
-			
+				ioWriterWait(writer); 
+				continue; 
 			}
-			
-			if (matchesFound == 0)
-				cout << "No matches were found for the file. No price reductions were made" << endl; 
-			
+
+			copied = min(size, IO_BLOCK_BYTES - writer.used); 
+			memcpy(fileIO.ring.buffers + writer.block * IO_BLOCK_BYTES + writer.used, data, copied); 
+			writer.used += copied; 
+			data += copied; 
+			size -= copied; 
+
+			if (writer.used == IO_BLOCK_BYTES)
+				ioWriterFlush(writer); 
 		}
-		
-	cout << endl; 	
-		
-	}	
+
+		return !writer.failed; 
+	}
+#endif
+
+	writer.failed = writer.failed || fwrite(data, 1, size, writer.file) != size; 
+
+	return !writer.failed; 
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioWriterFlush
+// DESCRIPTION: Queues the write of the ring buffer being filled and moves on 
+// to the next buffer. 
+// INPUT: Parameters: writer - file being written 
+// OUTPUT: reference parameter: writer 
+// CALLS TO: ioRingQueue, ioRingSubmit 
+//***************************************************************************** 
+void ioWriterFlush(ioWriter& writer)
+{
+	if (writer.used == 0 || writer.failed)
+		return; 
+
+	ioRingQueue(fileIO.ring, true, writer.descriptor, writer.block, writer.used, writer.offset); 
+	writer.blockOffset[writer.block] = writer.offset; 
+	writer.blockBytes[writer.block] = writer.used; 
+	writer.inFlight++; 
+	writer.offset += writer.used; 
+	writer.block = (writer.block + 1) % IO_BLOCKS; 
+	writer.used = 0; 
+
+	if (!ioRingSubmit(fileIO.ring))
+	{
+		fileIO.failed = true; 
+		writer.failed = true; 
+	}
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioWriterWait
+// DESCRIPTION: Waits for one write of a file to finish and frees its buffer. 
+// A short write is finished with a blocking one. 
+// INPUT: Parameters: writer - file being written 
+// OUTPUT: reference parameter: writer 
+// CALLS TO: ioRingWait 
+//***************************************************************************** 
+void ioWriterWait(ioWriter& writer)
+{
+#ifdef __linux__
+	// variables 
+	int block; 					// Buffer of the write that finished 
+	int result; 					// Bytes written, or a negative error number 
+	size_t written; 				// Bytes of the buffer written so far 
+	ssize_t bytes; 				// Bytes of a blocking write 
+
+	if (!ioRingWait(fileIO.ring, block, result))
+	{
+		fileIO.failed = true; 
+		writer.failed = true; 
+		return; 
+	}
+
+	writer.inFlight--; 
+	written = max(result, 0); 
+	writer.failed = writer.failed || result < 0; 
+
+	while (!writer.failed && written < writer.blockBytes[block])
+	{
+		bytes = pwrite(writer.descriptor, fileIO.ring.buffers + block * IO_BLOCK_BYTES + written, 
+		              writer.blockBytes[block] - written, writer.blockOffset[block] + written); 
+		writer.failed = bytes <= 0; 
+
+		if (bytes > 0)
+			written += bytes; 
+	}
+
+	writer.blockBytes[block] = 0; 
+#endif
+
+}
+
+//*****************************************************************************
+// FUNCTION: ioWriterClose
+// DESCRIPTION: Finishes a file opened by ioWriterOpen: writes what is left, 
+// waits for every write, optionally waits for the file to reach the disk, 
+// and closes it. 
+// INPUT: Parameters: writer - file being written 
+// sync - whether to wait for the file to reach the disk 
+// OUTPUT: reference parameter: writer 
+// Return value: false if the file could not be written, synced or closed 
+// CALLS TO: ioWriterFlush, ioWriterWait, ioRingRelease, syncFile 
+//***************************************************************************** 
+bool ioWriterClose(ioWriter& writer, bool sync)
+{
+	// variables 
+	bool written; 				// Whether every write succeeded 
+
+#ifdef __linux__
+	if (writer.descriptor >= 0)
+	{
+		ioWriterFlush(writer); 
+
+		while (writer.inFlight > 0 && !fileIO.failed)
+			ioWriterWait(writer); 
+
+		written = !writer.failed && writer.inFlight == 0; 
+		written = (!sync || fsync(writer.descriptor) == 0) && written; 
+		written = (close(writer.descriptor) == 0) && written; 
+		writer.descriptor = -1; 
+		ioRingRelease(); 
+
+		return written; 
+	}
+#endif
+
+	written = !writer.failed; 
+	written = (!sync || syncFile(writer.file)) && written; 
+	written = (fclose(writer.file) == 0) && written; 
+	writer.file = NULL; 
+
+	return written; 
+
 }
 
+//*****************************************************************************
+// FUNCTION: parseChangeRecords
+// DESCRIPTION: Reads change records, an MLS number and a reduction in 
+// dollars separated by white space, from part of a changes file, as 
+// operator>> would read them from a stream. A number running to the end of 
+// the part may go on in the next part, so it is left for the caller to 
+// join to it unless the part is the last. A record whose reduction is out 
+// of range is skipped and counted, and reading goes on with the next. 
+// INPUT: Parameters: position - first byte of the part 
+// end - end of the part 
+// last - whether the part ends the file 
+// change - record being read, whose MLS number may already be read 
+// haveMLS - whether the MLS number of change has been read 
+// changes - vector to receive the records read 
+// rejected - number of records skipped, to add to 
+// rest - receives the start of a number left unread, or end 
+// OUTPUT: reference parameters: change, haveMLS, changes, rejected, rest 
+// Return value: false if a malformed record ends the file 
+// CALLS TO: dollarsToCents 
+//***************************************************************************** 
+bool parseChangeRecords(const char* position, const char* end, bool last, priceChange& change, bool& haveMLS,
+                        vector<priceChange>& changes, int& rejected, const char*& rest)
+{
+	// variables 
+	const char *tokenEnd; 		// End of the number being read 
+	double reduction; 			// Reduction read, in dollars 
+	from_chars_result result; 	// Result of converting a number 
+
+	for (;;)
+	{
+		while (position < end && isspace(static_cast<unsigned char>(*position)))
+			position++; 
+
+		rest = position; 
+
+		if (position == end)
+			return true; 
 
+		tokenEnd = position; 
 
+		while (tokenEnd < end && !isspace(static_cast<unsigned char>(*tokenEnd)))
+			tokenEnd++; 
 
+		if (tokenEnd == end && !last)
+			return true; 
 
+		// A leading '+' is read as operator>> reads it 
+		if (*position == '+' && position + 1 < end && *(position + 1) != '-')
+			position++; 
+
+		if (haveMLS)
+			result = from_chars(position, end, reduction); 
+		else
+			result = from_chars(position, end, change.numberMLS); 
+
+		if (result.ec != errc())
+			return false; 
+
+		if (haveMLS && dollarsToCents(reduction, change.reduction))
+			changes.push_back(change); 
+		else if (haveMLS)
+			rejected++; 
+
+		haveMLS = !haveMLS; 
+		position = result.ptr; 
+	}
+
+}